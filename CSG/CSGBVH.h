@@ -0,0 +1,362 @@
+#pragma once
+/**
+CSGBVH.h : host side flattened SAH bounding volume hierarchy over AABB
+=========================================================================
+
+Used by CSGQuery::trace to provide logarithmic CPU ray casts against
+the full geometry on nodes without GPUs, following the OptiX two level
+structure:
+
+* one CSGBVH per CSGSolid (GAS) over the CSGPrim AABB in the solid frame
+* one CSGBVH (IAS) over the world frame AABB of every instance transform
+
+Build is binned SAH (NUM_BIN bins along the largest centroid extent axis),
+with leaves of up to MAX_LEAF items. SAH gives no depth bound as skewed
+centroid spacing can peel off a few items per level, so below MAX_SAH_DEPTH
+median splits are forced, which halve the items and keep the depth and hence
+the traversal stack use below STACK_SIZE for any int number of items. Nodes are flattened depth first into
+32 byte CSGBVH::Node (two per cache line) with the left child immediately
+following its parent, so traversal mostly walks forwards through memory.
+
+* leaf     : count > 0, items are item[offset:offset+count]
+* interior : count <= 0, split axis is -count, right child at offset
+
+Traversal visits the near child first, chosen by the sign of the ray direction
+along the split axis, and prunes nodes beyond the closest hit so far.
+The per item callback is given the item index and the current t_max
+and must return true (and lower t_max) only for hits closer than t_max.
+
+No CUDA, no other CSG dependency.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+#include "scuda.h"
+
+struct CSGBVH
+{
+    static constexpr const int NUM_BIN = 16 ;
+    static constexpr const int MAX_LEAF = 4 ;
+    static constexpr const int STACK_SIZE = 64 ;
+    static constexpr const int MAX_SAH_DEPTH = STACK_SIZE - 32 ;  // then median splits : at most 31 more levels
+
+    struct Node
+    {
+        float mn[3] ;
+        int   offset ;
+        float mx[3] ;
+        int   count ;
+    };
+
+    std::vector<Node>  node ;
+    std::vector<int>   item ;
+    std::vector<float> aabb ;      // copy of the input item AABB, 6 floats per item
+    int                max_depth ;
+
+    CSGBVH();
+    void build( const float* aabb, int num );
+    int  build_r( int i0, int i1, const std::vector<float>& cen, int depth );
+
+    bool is_empty() const ;
+    bool get_bounds( float* aabb ) const ;  // 6 floats of root AABB, false when empty
+    int  num_item() const ;
+
+    static bool Slab( const Node& nd, const float3& origin, const float3& inv_dir, float t_min, float t_max, float& t_enter );
+
+    template<typename F>
+    bool traverse( const float3& origin, const float3& direction, float t_min, float& t_max, F& intersect_item ) const ;
+
+    std::string desc() const ;
+};
+
+inline CSGBVH::CSGBVH()
+    :
+    max_depth(0)
+{
+}
+
+inline bool CSGBVH::is_empty() const { return node.size() == 0 ; }
+inline int CSGBVH::num_item() const { return item.size() ; }
+
+inline bool CSGBVH::get_bounds( float* bb ) const
+{
+    if(is_empty()) return false ;
+    for(int a=0 ; a < 3 ; a++)
+    {
+        bb[a]   = node[0].mn[a] ;
+        bb[3+a] = node[0].mx[a] ;
+    }
+    return true ;
+}
+
+/**
+CSGBVH::build
+---------------
+
+*aabb* holds 6 floats per item : mn.x mn.y mn.z mx.x mx.y mx.z
+
+**/
+
+inline void CSGBVH::build( const float* aabb_, int num )
+{
+    node.clear();
+    item.resize(num);
+    aabb.assign( aabb_, aabb_ + 6*num );
+    max_depth = 0 ;
+    if( num == 0 ) return ;
+
+    std::vector<float> cen(3*num) ;
+    for(int i=0 ; i < num ; i++)
+    {
+        item[i] = i ;
+        for(int a=0 ; a < 3 ; a++) cen[3*i+a] = 0.5f*( aabb[6*i+a] + aabb[6*i+3+a] ) ;
+    }
+    node.reserve( 2*num );
+    build_r( 0, num, cen, 0 );
+    assert( max_depth < STACK_SIZE && "CSGBVH::build depth exceeds traversal stack" );
+}
+
+/**
+CSGBVH::build_r
+-----------------
+
+Creates the node for item[i0:i1] and its subtree, returning the node index.
+The split with the lowest SAH cost over the bin boundaries is used unless
+a leaf is cheaper, with degenerate centroid bounds falling back to a median
+split when the range is too large for a leaf. From MAX_SAH_DEPTH on only
+median splits are used.
+
+**/
+
+inline int CSGBVH::build_r( int i0, int i1, const std::vector<float>& cen, int depth )
+{
+    max_depth = std::max( max_depth, depth );
+
+    int idx = node.size() ;
+    node.push_back( {} );
+
+    float mn[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX } ;
+    float mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX } ;
+    float cmn[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX } ;
+    float cmx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX } ;
+
+    for(int i=i0 ; i < i1 ; i++)
+    {
+        int it = item[i] ;
+        for(int a=0 ; a < 3 ; a++)
+        {
+            mn[a] = std::min( mn[a], aabb[6*it+a] );
+            mx[a] = std::max( mx[a], aabb[6*it+3+a] );
+            cmn[a] = std::min( cmn[a], cen[3*it+a] );
+            cmx[a] = std::max( cmx[a], cen[3*it+a] );
+        }
+    }
+    for(int a=0 ; a < 3 ; a++)
+    {
+        node[idx].mn[a] = mn[a] ;
+        node[idx].mx[a] = mx[a] ;
+    }
+
+    int n = i1 - i0 ;
+    int axis = 0 ;
+    for(int a=1 ; a < 3 ; a++) if( cmx[a] - cmn[a] > cmx[axis] - cmn[axis] ) axis = a ;
+    float extent = cmx[axis] - cmn[axis] ;
+
+    bool median = depth >= MAX_SAH_DEPTH ;
+    bool leaf = n <= 1 || ( n <= MAX_LEAF && ( extent <= 0.f || median ) ) ;
+    int mid = -1 ;
+
+    if(!leaf && extent > 0.f && !median)
+    {
+        int   bin_count[NUM_BIN] = {} ;
+        float bin_mn[NUM_BIN][3] ;
+        float bin_mx[NUM_BIN][3] ;
+        for(int b=0 ; b < NUM_BIN ; b++) for(int a=0 ; a < 3 ; a++) { bin_mn[b][a] = FLT_MAX ; bin_mx[b][a] = -FLT_MAX ; }
+
+        const float scale = float(NUM_BIN)/extent ;
+        for(int i=i0 ; i < i1 ; i++)
+        {
+            int it = item[i] ;
+            int b = std::min( NUM_BIN - 1, int( (cen[3*it+axis] - cmn[axis])*scale ) );
+            bin_count[b] += 1 ;
+            for(int a=0 ; a < 3 ; a++)
+            {
+                bin_mn[b][a] = std::min( bin_mn[b][a], aabb[6*it+a] );
+                bin_mx[b][a] = std::max( bin_mx[b][a], aabb[6*it+3+a] );
+            }
+        }
+
+        auto area = [](const float* lo, const float* hi){ float dx = hi[0]-lo[0], dy = hi[1]-lo[1], dz = hi[2]-lo[2] ; return dx*dy + dy*dz + dz*dx ; } ;
+
+        // sweep from the right accumulating area and count of the right side of each boundary
+        float right_area[NUM_BIN] ;
+        int   right_count[NUM_BIN] ;
+        float rmn[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX } ;
+        float rmx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX } ;
+        int rc = 0 ;
+        for(int b=NUM_BIN-1 ; b > 0 ; b--)
+        {
+            rc += bin_count[b] ;
+            for(int a=0 ; a < 3 ; a++) { rmn[a] = std::min(rmn[a], bin_mn[b][a]) ; rmx[a] = std::max(rmx[a], bin_mx[b][a]) ; }
+            right_count[b] = rc ;
+            right_area[b] = rc > 0 ? area(rmn, rmx) : 0.f ;
+        }
+
+        float lmn[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX } ;
+        float lmx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX } ;
+        int lc = 0 ;
+        float best_cost = FLT_MAX ;
+        int best_b = -1 ;
+        for(int b=1 ; b < NUM_BIN ; b++)
+        {
+            lc += bin_count[b-1] ;
+            for(int a=0 ; a < 3 ; a++) { lmn[a] = std::min(lmn[a], bin_mn[b-1][a]) ; lmx[a] = std::max(lmx[a], bin_mx[b-1][a]) ; }
+            if( lc == 0 || right_count[b] == 0 ) continue ;
+            float cost = lc*area(lmn, lmx) + right_count[b]*right_area[b] ;
+            if( cost < best_cost ) { best_cost = cost ; best_b = b ; }
+        }
+
+        // unit cost for traversal and for item intersect, all costs scaled by the node area
+        float leaf_cost = n*area(mn, mx) ;
+        bool sah_leaf = n <= MAX_LEAF && leaf_cost <= best_cost + area(mn, mx) ;
+
+        if( best_b > 0 && !sah_leaf )
+        {
+            int* p = std::partition( item.data() + i0, item.data() + i1,
+                  [&](int it){ return std::min( NUM_BIN - 1, int( (cen[3*it+axis] - cmn[axis])*scale ) ) < best_b ; } );
+            mid = int(p - item.data()) ;
+        }
+        leaf = sah_leaf ;
+    }
+
+    if(!leaf && ( mid <= i0 || mid >= i1 ))   // degenerate or beyond MAX_SAH_DEPTH : median split on the axis
+    {
+        mid = (i0 + i1)/2 ;
+        std::nth_element( item.data() + i0, item.data() + mid, item.data() + i1,
+                  [&](int a, int b){ return cen[3*a+axis] < cen[3*b+axis] ; } );
+    }
+
+    if( leaf )
+    {
+        node[idx].offset = i0 ;
+        node[idx].count = n ;
+    }
+    else
+    {
+        build_r( i0, mid, cen, depth + 1 );
+        int right = build_r( mid, i1, cen, depth + 1 );
+        node[idx].offset = right ;
+        node[idx].count = -axis ;
+    }
+    return idx ;
+}
+
+/**
+CSGBVH::Slab
+--------------
+
+Ray slab test against node bounds, with t_enter set to the entry distance.
+NaN from 0*inf with origin on a slab plane is dropped by fminf/fmaxf.
+
+**/
+
+inline bool CSGBVH::Slab( const Node& nd, const float3& o, const float3& inv, float t_min, float t_max, float& t_enter ) // static
+{
+    float tx0 = (nd.mn[0] - o.x)*inv.x ;
+    float tx1 = (nd.mx[0] - o.x)*inv.x ;
+    float ty0 = (nd.mn[1] - o.y)*inv.y ;
+    float ty1 = (nd.mx[1] - o.y)*inv.y ;
+    float tz0 = (nd.mn[2] - o.z)*inv.z ;
+    float tz1 = (nd.mx[2] - o.z)*inv.z ;
+
+    float t0 = fmaxf( fmaxf( fminf(tx0, tx1), fminf(ty0, ty1) ), fmaxf( fminf(tz0, tz1), t_min ) );
+    float t1 = fminf( fminf( fmaxf(tx0, tx1), fmaxf(ty0, ty1) ), fminf( fmaxf(tz0, tz1), t_max ) );
+    t_enter = t0 ;
+    return t0 <= t1 ;
+}
+
+/**
+CSGBVH::traverse
+------------------
+
+Returns true when *intersect_item* reports any hit, with *t_max* then
+the closest hit distance.
+
+**/
+
+template<typename F>
+inline bool CSGBVH::traverse( const float3& origin, const float3& direction, float t_min, float& t_max, F& intersect_item ) const
+{
+    if(is_empty()) return false ;
+
+    const float3 inv = make_float3( 1.f/direction.x, 1.f/direction.y, 1.f/direction.z );
+    const int neg[3] = { direction.x < 0.f, direction.y < 0.f, direction.z < 0.f } ;
+
+    int stack[STACK_SIZE] ;
+    int sp = 0 ;
+    bool hit = false ;
+    float t_enter ;
+
+    int idx = Slab( node[0], origin, inv, t_min, t_max, t_enter ) ? 0 : -1 ;
+
+    while( idx > -1 )
+    {
+        const Node& nd = node[idx] ;
+        if( nd.count > 0 )
+        {
+            for(int i=0 ; i < nd.count ; i++) if(intersect_item( item[nd.offset+i], t_max )) hit = true ;
+            idx = -1 ;
+        }
+        else
+        {
+            int axis = -nd.count ;
+            int first  = neg[axis] ? nd.offset : idx + 1 ;
+            int second = neg[axis] ? idx + 1 : nd.offset ;
+
+            float t_first, t_second ;
+            bool h_first  = Slab( node[first],  origin, inv, t_min, t_max, t_first );
+            bool h_second = Slab( node[second], origin, inv, t_min, t_max, t_second );
+
+            if( h_first && h_second )
+            {
+                if( t_second < t_first ) std::swap( first, second ) ;
+                assert( sp < STACK_SIZE );
+                stack[sp++] = second ;
+                idx = first ;
+            }
+            else
+            {
+                idx = h_first ? first : ( h_second ? second : -1 ) ;
+            }
+        }
+
+        while( idx == -1 && sp > 0 )   // pop, skipping nodes beyond the closest hit found since the push
+        {
+            int j = stack[--sp] ;
+            if(Slab( node[j], origin, inv, t_min, t_max, t_enter )) idx = j ;
+        }
+    }
+    return hit ;
+}
+
+inline std::string CSGBVH::desc() const
+{
+    int num_leaf = 0 ;
+    for(unsigned i=0 ; i < node.size() ; i++) if( node[i].count > 0 ) num_leaf += 1 ;
+    std::stringstream ss ;
+    ss << "CSGBVH::desc"
+       << " num_item " << num_item()
+       << " num_node " << node.size()
+       << " num_leaf " << num_leaf
+       << " max_depth " << max_depth
+       << " sizeof(Node) " << sizeof(Node)
+       ;
+    std::string str = ss.str();
+    return str ;
+}
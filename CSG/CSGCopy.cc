@@ -52,6 +52,7 @@ CSGFoundry* CSGCopy::Select(const CSGFoundry* src, const SBitSet* elv )
 {
     CSGCopy cpy(src, elv); 
     cpy.copy(); 
+    cpy.dst->initInstIndex(); 
     LOG(LEVEL) << cpy.desc(); 
     return cpy.dst ; 
 }
@@ -317,7 +318,7 @@ void CSGCopy::copyNode(AABB& prim_bb, unsigned nodeIdx )
     {
         tra = src->getTran(sTranIdx-1u) ; 
         itr = src->getItra(sTranIdx-1u) ; 
-        dTranIdx = 1u + dst->addTran( tra, itr ) ;
+        dTranIdx = 1u + dst->addTranDedup( tra, itr ) ;
     }
 
     CSGNode nd = {} ; 
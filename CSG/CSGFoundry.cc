@@ -16,6 +16,7 @@
 #include "ssys.h"
 #include "sproc.h"
 #include "SProf.hh"
+#include "stimeline.h"
 
 #include "smeta.h"
 #include "SSim.hh"
@@ -49,6 +50,7 @@
 #include "CSGCopy.h"
 
 const unsigned CSGFoundry::IMAX = 50000 ; 
+const bool CSGFoundry::DEDUP_TRAN = ssys::getenvbool("CSGFoundry__DEDUP_TRAN") ; 
 
 const plog::Severity CSGFoundry::LEVEL = SLOG::EnvLevel("CSGFoundry", "DEBUG" ); 
 const int CSGFoundry::VERBOSE = ssys::getenvint("VERBOSE", 0); 
@@ -58,6 +60,8 @@ std::string CSGFoundry::descComp() const
     std::stringstream ss ; 
     ss << "CSGFoundry::descComp"
        << " sim " << ( sim ? sim->desc() : "" )
+       << std::endl 
+       << descTranDedup()
        ;  
     std::string s = ss.str(); 
     return s ; 
@@ -103,6 +107,7 @@ CSGFoundry::CSGFoundry()
     target(new CSGTarget(this)),
     maker(new CSGMaker(this)),
     deepcopy_everynode_transform(true),
+    dedup_tran(DEDUP_TRAN),
     last_added_solid(nullptr),
     last_added_prim(nullptr),
     mtime(s_time::EpochSeconds()),
@@ -1528,6 +1533,7 @@ void CSGFoundry::importSim()
 {
     assert(sim); 
     import->import(); 
+    initInstIndex(); 
 }
 
 
@@ -1787,7 +1793,7 @@ unsigned CSGFoundry::addTran_( const Tran<T>* tr  )
 {
     qat4 t(glm::value_ptr(tr->t));  // narrowing when T=double
     qat4 v(glm::value_ptr(tr->v)); 
-    unsigned idx = addTran(&t, &v); 
+    unsigned idx = addTranDedup(&t, &v); 
     return idx ; 
 }
 
@@ -1816,10 +1822,26 @@ unsigned CSGFoundry::addTran()
     t.init(); 
     qat4 v ; 
     v.init(); 
-    unsigned idx = addTran(&t, &v); 
+    unsigned idx = addTranDedup(&t, &v); 
     return idx ; 
 }
 
+/**
+CSGFoundry::addTranDedup
+--------------------------
+
+When dedup_tran is enabled (envvar CSGFoundry__DEDUP_TRAN) the index 
+of an existing bitwise identical tran+itra pair is returned if there is one, 
+otherwise the pair is added. Used from the imports via addTran_ and from CSGCopy. 
+Note that addDeepCopySolid uses addTran directly as it needs fresh transforms. 
+
+**/
+
+unsigned CSGFoundry::addTranDedup( const qat4* tr, const qat4* it )
+{
+    return dedup_tran ? tran_pool.add( tran, itra, *tr, *it ) : addTran(tr, it) ; 
+}
+
 /**
 CSGFoundry::addTranPlaceholder
 -------------------------------
@@ -1837,6 +1859,53 @@ void CSGFoundry::addTranPlaceholder()
     }
 }
 
+/**
+CSGFoundry::dedupTran
+-----------------------
+
+Compacts the tran and itra arrays of a geometry created or loaded without 
+deduplication to unique tran+itra pairs and remaps the 1-based gtransformIdx
+of every node, keeping the complement bit. The CSGPrim tranOffset 
+(only informational) are left as they were. Returns the number of pairs removed.
+Called from CSGFoundry::load when dedup_tran is enabled. 
+
+**/
+
+unsigned CSGFoundry::dedupTran()
+{
+    std::vector<unsigned> remap ; 
+    unsigned removed = tran_pool.dedup( tran, itra, remap ); 
+
+    for(unsigned i=0 ; i < node.size() ; i++)
+    {
+        CSGNode& nd = node[i] ; 
+        unsigned tranIdx = nd.gtransformIdx() ; 
+        if( tranIdx == 0 ) continue ; 
+        assert( tranIdx - 1 < remap.size() ); 
+        nd.setTransformComplement( 1 + remap[tranIdx-1], nd.is_complement() ); 
+    }
+    LOG(LEVEL) << descTranDedup() ; 
+    return removed ; 
+}
+
+std::string CSGFoundry::descTranDedup() const 
+{
+    unsigned num_ref = 0 ; 
+    for(unsigned i=0 ; i < node.size() ; i++) if(node[i].gtransformIdx() > 0) num_ref += 1 ; 
+
+    std::stringstream ss ; 
+    ss << "CSGFoundry::descTranDedup"
+       << " dedup_tran " << ( dedup_tran ? "Y" : "N" )
+       << " num_node_with_tran " << num_ref 
+       << " num_tran " << tran.size()
+       << " bytes tran+itra " << 2*tran.size()*sizeof(qat4)
+       << std::endl 
+       << tran_pool.desc(tran.size())
+       ;  
+    std::string s = ss.str(); 
+    return s ; 
+}
+
 
 
 /**
@@ -2676,6 +2745,9 @@ void CSGFoundry::load( const char* dir_ )
     loadArray( plan  , dir, "plan.npy" , true );  
     // plan.npy loading optional, as only geometries with convexpolyhedrons such as trapezoids, tetrahedrons etc.. have them 
 
+    if(dedup_tran) dedupTran(); 
+    initInstIndex(); 
+
     // REMOVE THIS SECOND SSim LOAD
     // LOG(LEVEL) << "[ SSim::Load " ;  
     // sim = NP::Exists(dir, "SSim") ? SSim::Load(dir, SSim::RELDIR ) : nullptr ; 
@@ -2853,6 +2925,7 @@ bool CSGFoundry::Load_saveAlt = ssys::getenvbool("CSGFoundry_Load_saveAlt") ;
 
 CSGFoundry* CSGFoundry::Load() // static
 {
+    STIMELINE_SCOPE("CSGFoundry::Load"); 
     SProf::Add("CSGFoundry__Load_HEAD"); 
 
     LOG(LEVEL) << "[ argumentless " ; 
@@ -3076,6 +3149,7 @@ TODO: recall this was optimized down to under 1s, check this.
 
 void CSGFoundry::upload()
 { 
+    initInstIndex(); 
     
     LOG(LEVEL) << "[ inst_find_unique " ; 
     inst_find_unique(); 
@@ -3146,26 +3220,73 @@ void CSGFoundry::getInstanceTransformsIAS(std::vector<qat4>& select_inst, int ia
 }
 
 
+/**
+CSGFoundry::initInstIndex
+---------------------------
+
+Builds the per GAS CSR and sensor_identifier index over inst. 
+Must be called after instances are added, it is called from load, 
+importSim, CSGCopy::Select, upload and the other geometry creation paths : 
+CSG_GGeo_Convert::Translate, CSGMaker::MakeGeom, CSGMaker::makeDemoGrid, DemoGeo and DemoGrid. 
+The GAS accessors below use the index in place of the 
+qat4::count_gas/select_instances_gas/find_instance_gas linear scans over inst. 
+
+**/
+
+void CSGFoundry::initInstIndex() 
+{
+    inst_index.build(inst); 
+    LOG(LEVEL) << inst_index.desc() ; 
+}
+
+/**
+CSGFoundry::getInstIndex
+--------------------------
+
+The index is not rebuilt here as the const accessors may be called 
+concurrently, instead it is asserted to be fresh : built from the current 
+inst with no instances added or reallocation since. 
+
+**/
+
+const CSGInstanceIndex& CSGFoundry::getInstIndex() const 
+{
+    bool fresh = inst_index.is_built_for(inst) ; 
+    LOG_IF(fatal, !fresh) 
+        << " inst index is stale, call CSGFoundry::initInstIndex after adding instances "
+        << " inst.size " << inst.size()
+        << " " << inst_index.desc() 
+        ; 
+    assert( fresh ); 
+    return inst_index ; 
+}
+
 unsigned CSGFoundry::getNumInstancesGAS(int gas_idx) const
 {
-    return qat4::count_gas(inst, gas_idx );  
+    return getInstIndex().count_gas(gas_idx) ;  
 }
 
 void CSGFoundry::getInstanceTransformsGAS(std::vector<qat4>& select_qv, int gas_idx ) const 
 {
-    qat4::select_instances_gas(inst, select_qv, gas_idx ) ;
+    const CSGInstanceIndex& ii = getInstIndex() ; 
+    int num = ii.count_gas(gas_idx) ; 
+    const int* idx = ii.begin_gas(gas_idx) ; 
+    for(int i=0 ; i < num ; i++) select_qv.push_back( inst[idx[i]] ) ;
 }
 
 void CSGFoundry::getInstancePointersGAS(std::vector<const qat4*>& select_qi, int gas_idx ) const 
 {
-    qat4::select_instance_pointers_gas(inst, select_qi, gas_idx ) ;
+    const CSGInstanceIndex& ii = getInstIndex() ; 
+    int num = ii.count_gas(gas_idx) ; 
+    const int* idx = ii.begin_gas(gas_idx) ; 
+    for(int i=0 ; i < num ; i++) select_qi.push_back( inst.data() + idx[i] ) ;
 }
 
 /**
 CSGFoundry::getInstanceIndex
 ------------------------------
 
-Via searching the inst vector this returns teh absolute instance index of the ordinal-th 
+Via the inst index this returns the absolute instance index of the ordinal-th 
 instance with the provided gas_idx or -1 if not found.  
 
 Note that this does not help with globals as they are all clumped into instance zero. 
@@ -3177,7 +3298,7 @@ within occurences of the gas_idx_ GAS/compositeSolid
 **/
 int CSGFoundry::getInstanceIndex(int gas_idx_ , unsigned ordinal) const 
 {
-    return qat4::find_instance_gas(inst, gas_idx_, ordinal);
+    return getInstIndex().find_instance_gas(gas_idx_, ordinal);
 }
 
 /**
@@ -3197,6 +3318,26 @@ const qat4* CSGFoundry::getInstance_with_GAS_ordinal(int gas_idx_ , unsigned ord
     return index > -1 ? &inst[index] : nullptr ; 
 }
 
+/**
+CSGFoundry::getInstanceIndex_with_sensor_identifier
+-----------------------------------------------------
+
+Absolute instance index of the instance with the sensor_identifier 
+(CPU convention, not the +1 held in inst) or -1 if not found.
+
+**/
+
+int CSGFoundry::getInstanceIndex_with_sensor_identifier(int sensor_identifier) const 
+{
+    return getInstIndex().find_instance_sensor(sensor_identifier) ; 
+}
+
+const qat4* CSGFoundry::getInstance_with_sensor_identifier(int sensor_identifier) const 
+{
+    int index = getInstanceIndex_with_sensor_identifier(sensor_identifier); 
+    return index > -1 ? &inst[index] : nullptr ; 
+}
+
 std::string CSGFoundry::descGAS() const 
 {
     std::stringstream ss ; 
@@ -27,6 +27,8 @@ struct CSGImport ;
 #include "CSGSolid.h"
 #include "CSGPrim.h"
 #include "CSGNode.h"
+#include "CSGInstanceIndex.h"
+#include "CSGTranPool.h"
 
 
 #include "CSG_API_EXPORT.hh"
@@ -89,6 +91,7 @@ struct CSG_API CSGFoundry : public SGeo
     static const plog::Severity LEVEL ; 
     static const int  VERBOSE ; 
     static const unsigned IMAX ; 
+    static const bool DEDUP_TRAN ; 
     static const char* BASE ; 
     static const char* RELDIR ; 
     static const constexpr unsigned UNDEFINED = ~0u ; 
@@ -275,7 +278,10 @@ struct CSG_API CSGFoundry : public SGeo
     template<typename T> unsigned addTran_( const Tran<T>* tr  );
     unsigned addTran( const qat4* tr, const qat4* it ) ;
     unsigned addTran() ;
+    unsigned addTranDedup( const qat4* tr, const qat4* it ) ;
     void     addTranPlaceholder(); 
+    unsigned dedupTran(); 
+    std::string descTranDedup() const ; 
 
     // adds transform and associates it with the node
     template<typename T> const qat4* addNodeTran(CSGNode* nd, const Tran<T>* tr, bool transform_node_aabb  ); 
@@ -345,6 +351,11 @@ struct CSG_API CSGFoundry : public SGeo
     int       getInstanceIndex(int gas_idx_ , unsigned ordinal) const ; 
     const qat4* getInstance_with_GAS_ordinal(int gas_idx_ , unsigned ordinal=0) const  ;
 
+    void initInstIndex() ; 
+    const CSGInstanceIndex& getInstIndex() const ; 
+    int         getInstanceIndex_with_sensor_identifier(int sensor_identifier) const ; 
+    const qat4* getInstance_with_sensor_identifier(int sensor_identifier) const ; 
+
     // id 
     void parseMOI(int& midx, int& mord, int& iidx, const char* moi) const ; 
     const char* getName(unsigned midx) const ;  
@@ -413,6 +424,8 @@ struct CSG_API CSGFoundry : public SGeo
     std::vector<qat4>      tran ;  
     std::vector<qat4>      itra ;  
     std::vector<qat4>      inst ;  
+    CSGInstanceIndex inst_index ;  // per GAS and sensor_identifier index over inst, built eagerly by initInstIndex
+    CSGTranPool            tran_pool ;   // content hashed index over tran+itra pairs, used when dedup_tran 
 
 
     CSGPrim*    d_prim ; 
@@ -431,6 +444,7 @@ struct CSG_API CSGFoundry : public SGeo
     CSGTarget*  target ; 
     CSGMaker*   maker ; 
     bool        deepcopy_everynode_transform ; 
+    bool        dedup_tran ;   // share identical tran+itra pairs between nodes, default from CSGFoundry__DEDUP_TRAN
 
     CSGSolid*   last_added_solid ; 
     CSGPrim*    last_added_prim ; 
@@ -0,0 +1,178 @@
+#pragma once
+/**
+CSGInstanceIndex.h : per GAS CSR index and sensor_identifier map over CSGFoundry::inst
+=========================================================================================
+
+Replaces the linear scans over the inst vector of the sqat4.h statics
+qat4::count_gas, qat4::select_instances_gas, qat4::select_instance_pointers_gas
+and qat4::find_instance_gas with lookups into an index built with one pass.
+
+gas_offset, gas_inst
+    compressed sparse row grouping of instance indices by gas_idx :
+    the instances of gas_idx are gas_inst[gas_offset[g]:gas_offset[g+1]]
+    with g = gas_idx - gas_min, in ascending instance index order
+    so selections are ordered as the linear scans found them
+
+sensor
+    sensor_identifier to instance index, using the CPU convention where -1
+    is not-a-sensor : inst holds sensor_identifier+1 (see CSGFoundry::addInstance)
+    so the key is q2.i.w - 1 for q2.i.w > 0. When a sensor_identifier
+    occurs more than once the first instance is kept and num_sensor_dup counted.
+
+The index records the size and data pointer of the inst it was built from
+allowing CSGFoundry::getInstIndex to assert that it is not stale.
+
+No CUDA, no other CSG dependency.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <climits>
+#include "sqat4.h"
+
+struct CSGInstanceIndex
+{
+    const qat4*      base ;
+    size_t           num ;
+    int              gas_min ;
+    std::vector<int> gas_offset ;
+    std::vector<int> gas_inst ;
+    std::unordered_map<int,int> sensor ;
+    int              num_sensor_dup ;
+
+    CSGInstanceIndex();
+
+    void clear();
+    void build( const std::vector<qat4>& inst );
+    bool is_built_for( const std::vector<qat4>& inst ) const ;
+
+    int  num_gas() const ;
+    int  count_gas( int gas_idx ) const ;
+    const int* begin_gas( int gas_idx ) const ;
+    int  find_instance_gas( int gas_idx, unsigned ordinal ) const ;
+    int  find_instance_sensor( int sensor_identifier ) const ;
+
+    std::string desc() const ;
+};
+
+inline CSGInstanceIndex::CSGInstanceIndex()
+    :
+    base(nullptr),
+    num(0),
+    gas_min(0),
+    num_sensor_dup(0)
+{
+}
+
+inline void CSGInstanceIndex::clear()
+{
+    base = nullptr ;
+    num = 0 ;
+    gas_min = 0 ;
+    gas_offset.clear();
+    gas_inst.clear();
+    sensor.clear();
+    num_sensor_dup = 0 ;
+}
+
+/**
+CSGInstanceIndex::build
+-------------------------
+
+Counting sort of the instance indices by gas_idx, then the sensor map.
+
+**/
+
+inline void CSGInstanceIndex::build( const std::vector<qat4>& inst )
+{
+    clear();
+    base = inst.data() ;
+    num = inst.size() ;
+    if( num == 0 ) return ;
+
+    int gas_max = INT_MIN ;
+    gas_min = INT_MAX ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        int gas_idx = inst[i].q1.i.w ;
+        gas_min = std::min( gas_min, gas_idx );
+        gas_max = std::max( gas_max, gas_idx );
+    }
+
+    int ng = gas_max - gas_min + 1 ;
+    gas_offset.assign( ng + 1, 0 );
+    for(size_t i=0 ; i < num ; i++) gas_offset[inst[i].q1.i.w - gas_min + 1] += 1 ;
+    for(int g=0 ; g < ng ; g++) gas_offset[g+1] += gas_offset[g] ;
+
+    std::vector<int> fill( gas_offset.begin(), gas_offset.end() - 1 ) ;
+    gas_inst.resize( num );
+    for(size_t i=0 ; i < num ; i++) gas_inst[fill[inst[i].q1.i.w - gas_min]++] = int(i) ;
+
+    sensor.reserve( num );
+    for(size_t i=0 ; i < num ; i++)
+    {
+        int sensor_identifier_u = inst[i].q2.i.w ;
+        if( sensor_identifier_u <= 0 ) continue ;
+        bool inserted = sensor.insert( std::make_pair( sensor_identifier_u - 1, int(i) ) ).second ;
+        if(!inserted) num_sensor_dup += 1 ;
+    }
+}
+
+inline bool CSGInstanceIndex::is_built_for( const std::vector<qat4>& inst ) const
+{
+    return base == inst.data() && num == inst.size() ;
+}
+
+inline int CSGInstanceIndex::num_gas() const
+{
+    return gas_offset.empty() ? 0 : int(gas_offset.size()) - 1 ;
+}
+
+inline int CSGInstanceIndex::count_gas( int gas_idx ) const
+{
+    int g = gas_idx - gas_min ;
+    return g < 0 || g >= num_gas() ? 0 : gas_offset[g+1] - gas_offset[g] ;
+}
+
+inline const int* CSGInstanceIndex::begin_gas( int gas_idx ) const
+{
+    int g = gas_idx - gas_min ;
+    return g < 0 || g >= num_gas() ? nullptr : gas_inst.data() + gas_offset[g] ;
+}
+
+/**
+CSGInstanceIndex::find_instance_gas
+-------------------------------------
+
+Absolute instance index of the ordinal-th instance with the gas_idx or -1 if not found,
+as qat4::find_instance_gas.
+
+**/
+
+inline int CSGInstanceIndex::find_instance_gas( int gas_idx, unsigned ordinal ) const
+{
+    return ordinal < unsigned(count_gas(gas_idx)) ? begin_gas(gas_idx)[ordinal] : -1 ;
+}
+
+inline int CSGInstanceIndex::find_instance_sensor( int sensor_identifier ) const
+{
+    std::unordered_map<int,int>::const_iterator it = sensor.find(sensor_identifier) ;
+    return it == sensor.end() ? -1 : it->second ;
+}
+
+inline std::string CSGInstanceIndex::desc() const
+{
+    std::stringstream ss ;
+    ss << "CSGInstanceIndex::desc"
+       << " num " << num
+       << " gas_min " << gas_min
+       << " num_gas " << num_gas()
+       << " num_sensor " << sensor.size()
+       << " num_sensor_dup " << num_sensor_dup
+       ;
+    std::string str = ss.str() ;
+    return str ;
+}
@@ -194,6 +194,7 @@ void CSGMaker::makeDemoGrid()
     }   
     }   
     }   
+    fd->initInstIndex(); 
 }
 
 
@@ -1438,6 +1439,7 @@ CSGFoundry*  CSGMaker::MakeGeom(const char* geom) // static
 
     fd->addTranPlaceholder();  
     fd->addInstancePlaceholder(); 
+    fd->initInstIndex(); 
 
     // avoid tripping some checks 
     fd->addMeshName(geom);   
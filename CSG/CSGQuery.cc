@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "SLOG.hh"
 #include "SSys.hh"
 #include "SPath.hh"
@@ -7,6 +8,7 @@
 #include "SName.h"
 #include "CSGQuery.h"
 #include "CSGGrid.h"
+#include "CSGSparseGrid.h"
 
 #ifdef DEBUG_RECORD
 #include "CSGRecord.h"
@@ -24,6 +26,7 @@
 #include "csg_intersect_leaf.h"
 #include "csg_intersect_node.h"
 #include "csg_intersect_tree.h"
+#include "csg_intersect_packet.h"
 
 
 const plog::Severity CSGQuery::LEVEL = SLOG::EnvLevel("CSGQuery", "DEBUG") ; 
@@ -44,11 +47,46 @@ CSGQuery::CSGQuery( const CSGFoundry* fd_ )
     select_root_node(nullptr),   // set by selectPrim
     select_root_typecode(CSG_ZERO),
     select_root_subNum(0),
-    select_is_tree(true)
+    select_is_tree(true),
+    sdf_cache(nullptr),
+    sdf_cache_prim(nullptr),
+    bvh(this)
 {
     init(); 
 }
 
+/**
+CSGQuery::CSGQuery(const CSGQuery* parent)
+---------------------------------------------
+
+Thread copy of *parent* with the same prim selection and distance cache
+sharing the read only BVH of the parent, so CSGQuery::trace from the copy
+does not duplicate gas_bvh, ias_bvh and ias_itra. The parent must outlive the copy
+and must not have initBVH called while copies are in use.
+
+**/
+
+CSGQuery::CSGQuery( const CSGQuery* parent ) 
+    :
+    fd(parent->fd),
+    prim0(parent->prim0),
+    node0(parent->node0),
+    plan0(parent->plan0),
+    itra0(parent->itra0),
+    select_prim(parent->select_prim),
+    select_prim_ce(parent->select_prim_ce),
+    select_nodeOffset(parent->select_nodeOffset),
+    select_prim_numNode(parent->select_prim_numNode),
+    select_root_node(parent->select_root_node),
+    select_root_typecode(parent->select_root_typecode),
+    select_root_subNum(parent->select_root_subNum),
+    select_is_tree(parent->select_is_tree),
+    sdf_cache(parent->sdf_cache),
+    sdf_cache_prim(parent->sdf_cache_prim),
+    bvh(parent->bvh)
+{
+}
+
 /**
 CSGQuery::init
 ----------------
@@ -168,6 +206,33 @@ float CSGQuery::operator()(const float3& position ) const
     return distance(position); 
 }
 
+/**
+CSGQuery::distance_cached
+---------------------------
+
+When a narrow band cache for the selected prim has been set with setDistanceCache
+the interpolated distance is returned for positions within the band that are
+further from the surface than the interpolation error bound, so the sign 
+and SD_CUT decisions are the same as with exact evaluation. 
+Otherwise the full CSG tree distance is evaluated. 
+
+Only useful for off-surface positions such as repeated distance scans.
+Intersect positions are on the surface where the cache never applies,
+so CSGQuery::intersect, intersect_again_packet and IsSpurious checks
+all use the exact distance and are not sped up by the cache. 
+
+**/
+
+float CSGQuery::distance_cached(const float3& position ) const
+{
+    if( sdf_cache && sdf_cache_prim == select_prim )
+    {
+        float sd = 0.f ; 
+        if( sdf_cache->query( sd, position ) && fabsf(sd) > sdf_cache->err_bound() + fabsf(SD_CUT) ) return sd ; 
+    }
+    return distance(position) ; 
+}
+
 /**
 CSGQuery::intersect
 ----------------------
@@ -412,7 +477,398 @@ bool CSGQuery::simtrace( quad4& p ) const
 }
 
 
-void CSGQuery::post(const char* outdir) 
+/**
+CSGQuery::simtrace_packet
+---------------------------
+
+Equivalent to calling CSGQuery::simtrace for each of the *num* simtrace items, 
+but the rays are intersected in packets of CSG_PACKET_WIDTH using csg_intersect_packet.h 
+Returns the number of valid intersects.
+
+**/
+
+int CSGQuery::simtrace_packet( quad4* pp, int num ) const 
+{
+    const int W = CSG_PACKET_WIDTH ; 
+    csg_packet<W> pk ; 
+    int num_intersect = 0 ; 
+
+    for(int i0=0 ; i0 < num ; i0 += W )
+    {
+        pk.num = std::min( W, num - i0 ) ; 
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            const quad4& p = pp[i0+l] ; 
+            pk.ray.set(l, *p.v2(), *p.v3() ); 
+            pk.tmin[l] = p.q1.f.w ; 
+            pk.isect.set(l, p.q0.f ); 
+        }
+        pk.fill(); 
+
+        intersect_packet_prim<W>( pk.isect, select_root_node, plan0, itra0, pk.tmin, pk.ray ); 
+
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            quad4& p = pp[i0+l] ; 
+            p.q0.f = pk.isect.get(l) ; 
+            if( pk.isect.valid[l] == 0 ) continue ; 
+
+            float t = p.q0.f.w ; 
+            float3 ipos = (*p.v2()) + t*(*p.v3()) ;   
+            p.q1.f.x = ipos.x ;
+            p.q1.f.y = ipos.y ;
+            p.q1.f.z = ipos.z ;
+            num_intersect += 1 ; 
+        }
+    }
+    return num_intersect ; 
+}
+
+/**
+CSGQuery::simtrace_trace
+--------------------------
+
+Simtrace against the whole CSGFoundry geometry rather than the selected prim 
+using CSGQuery::trace, so requires CSGQuery::initBVH. 
+The simtrace item is filled as sevent::add_simtrace does on device 
+with the boundary and identity of the closest intersect (or the miss values). 
+Returns true for a hit.
+
+**/
+
+bool CSGQuery::simtrace_trace( quad4& p ) const 
+{
+    const float3 ray_origin = *p.v2() ; 
+    const float3 ray_direction = *p.v3() ; 
+    float t_min = p.q1.f.w ;   
+
+    quad2 prd ; 
+    bool hit = trace( &prd, ray_origin, ray_direction, t_min ); 
+
+    float t = prd.distance() ; 
+    float3 ipos = ray_origin + t*ray_direction ;   
+
+    p.q0.f = prd.q0.f ;          // intersect normal and distance 
+    p.q1.f.x = ipos.x ;          // intersect position 
+    p.q1.f.y = ipos.y ;
+    p.q1.f.z = ipos.z ;
+    p.q2.u.w = prd.boundary() ; 
+    p.q3.u.w = prd.identity() ; 
+    return hit ; 
+}
+
+/**
+CSGQuery::intersect_again_packet
+----------------------------------
+
+Equivalent to calling CSGQuery::intersect_again for each of the *num* 
+prev_isect, writing into *isect* and *valid* arrays of the same length.
+Returns the number of valid intersects.
+
+**/
+
+int CSGQuery::intersect_again_packet( quad4* isect, const quad4* prev, bool* valid, int num ) const 
+{
+    const int W = CSG_PACKET_WIDTH ; 
+    csg_packet<W> pk ; 
+    int num_intersect = 0 ; 
+
+    for(int i0=0 ; i0 < num ; i0 += W )
+    {
+        pk.num = std::min( W, num - i0 ) ; 
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            const quad4& p = prev[i0+l] ; 
+            const float3& ray_origin = *p.v2() ;  
+            const float3& ray_direction = *p.v3() ;  
+            const float t_min = p.q1.f.w ; 
+
+            quad4& q = isect[i0+l] ; 
+            q.zero(); 
+            q.q2.f.x = ray_origin.x ; 
+            q.q2.f.y = ray_origin.y ; 
+            q.q2.f.z = ray_origin.z ;
+            q.q2.f.w = t_min ;          
+            q.q3.f.x = ray_direction.x ; 
+            q.q3.f.y = ray_direction.y ; 
+            q.q3.f.z = ray_direction.z ;
+            q.q3.u.w = p.q3.u.w ;  
+
+            pk.ray.set(l, ray_origin, ray_direction ); 
+            pk.tmin[l] = t_min ; 
+            pk.isect.set(l, q.q0.f ); 
+        }
+        pk.fill(); 
+
+        intersect_packet_prim<W>( pk.isect, select_root_node, plan0, itra0, pk.tmin, pk.ray ); 
+
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            quad4& q = isect[i0+l] ; 
+            q.q0.f = pk.isect.get(l) ; 
+            valid[i0+l] = pk.isect.valid[l] != 0 ; 
+            if( !valid[i0+l] ) continue ; 
+
+            float t = q.q0.f.w ; 
+            float3 ipos = (*q.v2()) + t*(*q.v3()) ;   
+            q.q1.f.x = ipos.x ;
+            q.q1.f.y = ipos.y ;
+            q.q1.f.z = ipos.z ;
+            q.q1.f.w = distance(ipos) ; 
+            num_intersect += 1 ; 
+        }
+    }
+    return num_intersect ;
+}
+
+
+/**
+CSGQuery::initBVH
+-------------------
+
+Builds the host side acceleration structure used by CSGQuery::trace,
+mirroring the OptiX geometry with one IAS over all instances
+referencing one GAS per CSGSolid:
+
+1. CSGBVH for each solid over the CSGPrim AABB in the solid frame
+2. inverse of each instance transform, used to bring rays into the instance frame
+3. CSGBVH over the world frame AABB of each instance, from the transformed solid bounds
+
+Instances of solids without prims get inverted bounds that are never hit.
+
+**/
+
+void CSGQuery::initBVH()
+{
+    assert( bvh == this && "CSGQuery::initBVH not allowed on thread copy sharing the BVH of its parent" );
+    unsigned num_solid = fd->getNumSolidTotal() ;
+    gas_bvh.resize(num_solid);
+
+    std::vector<float> aabb ;
+    for(unsigned i=0 ; i < num_solid ; i++)
+    {
+        const CSGSolid* so = fd->getSolid(i);
+        aabb.resize( 6*so->numPrim );
+        for(int p=0 ; p < so->numPrim ; p++)
+        {
+            const CSGPrim* pr = prim0 + so->primOffset + p ;
+            memcpy( aabb.data() + 6*p, pr->AABB(), 6*sizeof(float) );
+        }
+        gas_bvh[i].build( aabb.data(), so->numPrim );
+    }
+
+    int num_inst = fd->inst.size() ;
+    ias_itra.resize(num_inst);
+    aabb.resize( 6*num_inst );
+
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        const qat4& ins = fd->inst[i] ;
+        int ins_idx, gas_idx, sensor_identifier, sensor_index ;
+        ins.getIdentity(ins_idx, gas_idx, sensor_identifier, sensor_index );
+        assert( gas_idx > -1 && gas_idx < int(num_solid) );
+
+        float* bb = aabb.data() + 6*i ;
+        if(gas_bvh[gas_idx].get_bounds(bb))
+        {
+            qat4 t(ins.cdata()) ;
+            t.clearIdentity();
+            t.transform_aabb_inplace(bb);
+        }
+        else
+        {
+            for(int a=0 ; a < 3 ; a++) { bb[a] = FLT_MAX ; bb[3+a] = -FLT_MAX ; }
+        }
+
+        bool invertible = ins.inverse_affine( ias_itra[i] );
+        LOG_IF(fatal, !invertible) << " singular instance transform " << i ;
+        assert( invertible );
+    }
+    ias_bvh.build( aabb.data(), num_inst );
+
+    LOG(LEVEL) << descBVH() ;
+}
+
+/**
+CSGQuery::trace
+-----------------
+
+CPU equivalent of the OptiX trace from CSGOptiX7.cu, filling the quad2 *prd*
+with the closest intersect in the same way as __intersection__is, __closesthit__ch
+and __miss__ms. The IAS CSGBVH finds candidate instances, the ray is brought
+into the instance frame and the GAS CSGBVH of its solid finds candidate prims
+that are intersected with intersect_prim. As the transforms are affine the
+distance along the ray is the same in both frames, so the closest hit t_max
+prunes the traversal of both levels.
+
+Requires CSGQuery::initBVH. Returns true for a hit.
+
+The instance index set with prd->set_iindex is the index into CSGFoundry::inst,
+which matches optixGetInstanceIndex when all instances are enabled into the IAS.
+
+**/
+
+bool CSGQuery::trace( quad2* prd, const float3& ray_origin, const float3& ray_direction, float t_min, float t_max ) const
+{
+    assert( bvh->gas_bvh.size() > 0 && "CSGQuery::trace requires CSGQuery::initBVH" );
+
+    float4 isect = make_float4( 0.f, 0.f, 0.f, 0.f ) ;
+    int primIdx = -1 ;
+    int insIdx = -1 ;
+
+    auto intersect_instance_ = [&]( int i, float& t_max_ ) -> bool
+    {
+        int p = -1 ;
+        bool hit = intersect_instance( isect, p, t_max_, i, ray_origin, ray_direction, t_min, false ) ;
+        if(hit) primIdx = p ;
+        if(hit) insIdx = i ;
+        return hit ;
+    };
+
+    bvh->ias_bvh.traverse( ray_origin, ray_direction, t_min, t_max, intersect_instance_ );
+
+    set_prd( prd, isect, primIdx, insIdx, ray_origin, ray_direction );
+    return insIdx > -1 ;
+}
+
+/**
+CSGQuery::trace_linear
+------------------------
+
+Reference for CSGQuery::trace that intersects every prim of every
+instance without using the CSGBVH, giving the same results.
+
+**/
+
+bool CSGQuery::trace_linear( quad2* prd, const float3& ray_origin, const float3& ray_direction, float t_min, float t_max ) const
+{
+    float4 isect = make_float4( 0.f, 0.f, 0.f, 0.f ) ;
+    int primIdx = -1 ;
+    int insIdx = -1 ;
+
+    int num_inst = bvh->ias_itra.size() ;
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        int p = -1 ;
+        if(intersect_instance( isect, p, t_max, i, ray_origin, ray_direction, t_min, true ))
+        {
+            primIdx = p ;
+            insIdx = i ;
+        }
+    }
+    set_prd( prd, isect, primIdx, insIdx, ray_origin, ray_direction );
+    return insIdx > -1 ;
+}
+
+/**
+CSGQuery::intersect_instance
+------------------------------
+
+Intersects the prims of instance *insIdx* with the ray brought into the instance frame.
+When an intersect closer than *t_max* is found *isect* with the instance frame normal,
+*primIdx* (absolute) and *t_max* are updated and true is returned.
+
+**/
+
+bool CSGQuery::intersect_instance( float4& isect, int& primIdx, float& t_max, int insIdx, const float3& ray_origin, const float3& ray_direction, float t_min, bool linear ) const
+{
+    const qat4& v = bvh->ias_itra[insIdx] ;
+    const float3 o = v.right_multiply( ray_origin, 1.f );
+    const float3 d = v.right_multiply( ray_direction, 0.f );
+
+    int gas_idx = fd->inst[insIdx].q1.i.w ;
+    const CSGSolid* so = fd->getSolid(gas_idx);
+    const CSGPrim* pr0 = prim0 + so->primOffset ;
+
+    auto intersect_prim_ = [&]( int p, float& t_max_ ) -> bool
+    {
+        float4 is = make_float4( 0.f, 0.f, 0.f, 0.f ) ;
+        const CSGNode* node = node0 + pr0[p].nodeOffset() ;
+        bool valid = intersect_prim( is, node, plan0, itra0, t_min, o, d ) ;
+        if( !valid || !( is.w < t_max_ )) return false ;
+        t_max_ = is.w ;
+        isect = is ;
+        primIdx = so->primOffset + p ;
+        return true ;
+    };
+
+    bool hit = false ;
+    if( linear )
+    {
+        for(int p=0 ; p < so->numPrim ; p++) if(intersect_prim_(p, t_max)) hit = true ;
+    }
+    else
+    {
+        hit = bvh->gas_bvh[gas_idx].traverse( o, d, t_min, t_max, intersect_prim_ );
+    }
+    return hit ;
+}
+
+/**
+CSGQuery::set_prd
+-------------------
+
+Hit : as __intersection__is and __closesthit__ch, normal transformed
+from instance frame to world frame with the transpose of the inverse
+(left_multiply of the inverse), as optixTransformNormalFromObjectToWorldSpace.
+Normal is not normalized.
+
+Miss : as __miss__ms with boundary 0xffff and identity 0xffffffff
+
+**/
+
+void CSGQuery::set_prd( quad2* prd, const float4& isect, int primIdx, int insIdx, const float3& ray_origin, const float3& ray_direction ) const
+{
+    if( insIdx < 0 )
+    {
+        prd->q0.f = make_float4( 0.f, 0.f, 0.f, 0.f ) ;
+        prd->q1.u = make_uint4( 0u, 0u, 0u, 0u ) ;
+        prd->set_boundary(0xffffu) ;
+        prd->set_identity(0xffffffffu) ;
+        prd->set_lposcost(0.f) ;
+        return ;
+    }
+
+    const qat4& v = bvh->ias_itra[insIdx] ;
+    const float3 o = v.right_multiply( ray_origin, 1.f );
+    const float3 d = v.right_multiply( ray_direction, 0.f );
+    const float3 local_normal = make_float3( isect.x, isect.y, isect.z );
+
+    const CSGNode* node = node0 + prim0[primIdx].nodeOffset() ;
+    const qat4& ins = fd->inst[insIdx] ;
+
+    prd->q0.f = make_float4( v.left_multiply( local_normal, 0.f ), isect.w ) ;
+    prd->q1.u = make_uint4( 0u, 0u, 0u, 0u ) ;
+    prd->set_boundary( node->boundary() ) ;
+    prd->set_lposcost( normalize_z( o + isect.w*d ) ) ;
+    prd->set_identity( ins.get_IAS_OptixInstance_instanceId() ) ;
+    prd->set_iindex( insIdx ) ;
+}
+
+std::string CSGQuery::descBVH() const
+{
+    int num_gas_node = 0 ;
+    int max_gas_depth = 0 ;
+    for(unsigned i=0 ; i < bvh->gas_bvh.size() ; i++)
+    {
+        num_gas_node += bvh->gas_bvh[i].node.size() ;
+        max_gas_depth = std::max( max_gas_depth, bvh->gas_bvh[i].max_depth );
+    }
+
+    std::stringstream ss ;
+    ss << "CSGQuery::descBVH"
+       << " num_gas " << bvh->gas_bvh.size()
+       << " num_gas_node " << num_gas_node
+       << " max_gas_depth " << max_gas_depth
+       << std::endl
+       << " ias " << bvh->ias_bvh.desc()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+
+void CSGQuery::post(const char* outdir)
 {
 #ifdef DEBUG_CYLINDER
     if(outdir)
@@ -501,6 +957,38 @@ CSGGrid* CSGQuery::scanPrim(int resolution) const
     return grid ;
 }
 
+/**
+CSGQuery::scanPrimSparse
+--------------------------
+
+Narrow band alternative to scanPrim with sample spacing *h* 
+storing only samples within *band* of the surface of the selected prim.
+Use with setDistanceCache to have distance_cached use it. 
+
+**/
+
+CSGSparseGrid* CSGQuery::scanPrimSparse(float h, float band, int num_threads) const 
+{
+    const CSGPrim* pr = select_prim ;
+    if( pr == nullptr )
+    {
+        LOG(fatal) << " no prim is selected " ;
+        return nullptr ;
+    }
+
+    const float4 ce =  pr->ce() ;
+    CSGSparseGrid* sg = new CSGSparseGrid( ce, h, band );
+    sg->build( [this](const float3& p){ return distance(p) ; }, num_threads ) ;
+    LOG(LEVEL) << " ce " << ce << " " << sg->desc() ;  
+    return sg ;
+}
+
+void CSGQuery::setDistanceCache(const CSGSparseGrid* cache)
+{
+    sdf_cache = cache ; 
+    sdf_cache_prim = cache ? select_prim : nullptr ; 
+}
+
 
 
 std::string CSGQuery::descPrim() const
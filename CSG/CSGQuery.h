@@ -1,18 +1,21 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "plog/Severity.h"
 
 struct CSGFoundry ; 
 struct CSGPrim ; 
 struct CSGNode ; 
-struct float4 ; 
-struct float3 ; 
-struct quad4 ; 
-struct qat4 ; 
 struct CSGGrid ; 
+struct CSGSparseGrid ; 
 struct SCanvas ; 
 
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "CSGBVH.h"
+
 #include "CSG_API_EXPORT.hh"
 
 struct CSG_API CSGQuery 
@@ -24,6 +27,9 @@ struct CSG_API CSGQuery
     static std::string Desc( const quad4& isect, const char* label, bool* valid_intersect=nullptr  ); 
 
     CSGQuery(const CSGFoundry* fd); 
+    CSGQuery(const CSGQuery* parent); 
+    CSGQuery(const CSGQuery& other) = delete ; 
+    CSGQuery& operator=(const CSGQuery& other) = delete ; 
 
     void     init(); 
     void     selectPrim(unsigned solidIdx, unsigned primIdxRel );
@@ -41,10 +47,13 @@ struct CSG_API CSGQuery
     std::string descPrim() const ; 
     void     dumpPrim(const char* msg="CSGQuery::dumpPrim") const ;
     CSGGrid* scanPrim(int resolution) const ;
+    CSGSparseGrid* scanPrimSparse(float h, float band, int num_threads=0) const ;
+    void     setDistanceCache(const CSGSparseGrid* cache); 
 
 
     float distance(const float3& position ) const ; 
     float operator()(const float3& position) const ;
+    float distance_cached(const float3& position ) const ; 
     void distance( quad4& isect,  const float3& ray_origin ) const ; 
 
     bool intersect( quad4& isect,  float t_min, const quad4& p ) const ;
@@ -53,6 +62,17 @@ struct CSG_API CSGQuery
     bool simtrace( quad4& isect ) const ; 
     bool intersect_again( quad4& isect, const quad4& prev_isect ) const ; 
 
+    int  simtrace_packet( quad4* pp, int num ) const ; 
+    bool simtrace_trace( quad4& p ) const ; 
+    int  intersect_again_packet( quad4* isect, const quad4* prev_isect, bool* valid, int num ) const ; 
+
+    void initBVH(); 
+    bool trace( quad2* prd, const float3& ray_origin, const float3& ray_direction, float t_min, float t_max=1e16f ) const ; 
+    bool trace_linear( quad2* prd, const float3& ray_origin, const float3& ray_direction, float t_min, float t_max=1e16f ) const ; 
+    bool intersect_instance( float4& isect, int& primIdx, float& t_max, int insIdx, const float3& ray_origin, const float3& ray_direction, float t_min, bool linear ) const ; 
+    void set_prd( quad2* prd, const float4& isect, int primIdx, int insIdx, const float3& ray_origin, const float3& ray_direction ) const ; 
+    std::string descBVH() const ; 
+
     void post(const char* outdir); 
 
     static bool IsSpurious( const quad4& isect ); 
@@ -73,6 +93,13 @@ struct CSG_API CSGQuery
     int            select_root_subNum ; 
     bool           select_is_tree ; 
 
+    const CSGSparseGrid* sdf_cache ;       // narrow band distance cache, only used for sdf_cache_prim  
+    const CSGPrim*       sdf_cache_prim ; 
+
+    const CSGQuery*     bvh ;       // this or the parent query whose BVH is shared by a thread copy 
+    std::vector<CSGBVH> gas_bvh ;   // per solid over prim AABB in solid frame, populated by initBVH 
+    CSGBVH              ias_bvh ;   // over world frame AABB of all instances 
+    std::vector<qat4>   ias_itra ;  // world to instance frame transforms with identity cleared 
  
 
 };
@@ -7,9 +7,19 @@
 #include "CSGSimtrace.hh"
 #include "CSGQuery.h"
 #include "CSGDraw.h"
+#include "SFrameGenstep.hh"
 #include "NP.hh"
 
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+
 const plog::Severity CSGSimtrace::LEVEL = SLOG::EnvLevel("CSGSimtrace", "DEBUG"); 
+const bool CSGSimtrace::SCALAR = SSys::getenvbool("CSGSimtrace__SCALAR") ; 
+const bool CSGSimtrace::FOUNDRY = SSys::getenvbool("CSGSimtrace__FOUNDRY") ; 
+const bool CSGSimtrace::STREAM = SSys::getenvbool("CSGSimtrace__STREAM") ; 
+const int  CSGSimtrace::BLOCK = 4096 ;   // simtrace items taken by a thread at a time, multiple of CSG_PACKET_WIDTH
 
 int CSGSimtrace::Preinit()    // static
 {
@@ -17,6 +27,16 @@ int CSGSimtrace::Preinit()    // static
     return 0 ; 
 }
 
+int CSGSimtrace::NumThreads()  // static
+{
+#if defined(DEBUG_RECORD) || defined(DEBUG_CYLINDER)
+    return 1 ;   // intersect recording into static vectors is not thread safe
+#endif
+    int nt = SSys::getenvint("CSGSimtrace__THREADS", 0) ; 
+    if( nt <= 0 ) nt = int(std::thread::hardware_concurrency()) ; 
+    return nt < 1 ? 1 : nt ; 
+}
+
 CSGSimtrace::CSGSimtrace()
     :   
     prc(Preinit()),
@@ -31,7 +51,10 @@ CSGSimtrace::CSGSimtrace()
     selection(SSys::getenvintvec("SELECTION",',')),  // when no envvar gives nullptr  
     num_selection(selection && selection->size() > 0 ? selection->size() : 0 ), 
     selection_simtrace(num_selection > 0 ? NP::Make<float>(num_selection, 4, 4) : nullptr ), 
-    qss(selection_simtrace ? (quad4*)selection_simtrace->bytes() : nullptr)
+    qss(selection_simtrace ? (quad4*)selection_simtrace->bytes() : nullptr),
+    stream(STREAM && qss == nullptr),
+    scalar(SCALAR || q->select_is_tree),
+    num_threads(NumThreads())
 {
     init(); 
 }
@@ -40,34 +63,62 @@ void CSGSimtrace::init()
 {
     LOG(LEVEL) << d->desc();
 
-    frame.set_hostside_simtrace();  
-    frame.ce = q->select_prim_ce ; 
-    LOG(LEVEL) << " frame.ce " << frame.ce << " SELECTION " << SELECTION << " num_selection " << num_selection << " outdir " << outdir ; 
+    if(FOUNDRY) q->initBVH(); 
+
+    if(!stream) frame.set_hostside_simtrace();   // otherwise simtrace items generated by simtrace_stream
+    frame.ce = FOUNDRY ? fd->iasCE(0) : q->select_prim_ce ; 
+    LOG(LEVEL) 
+        << " frame.ce " << frame.ce 
+        << " SELECTION " << SELECTION 
+        << " num_selection " << num_selection 
+        << " outdir " << outdir 
+        << " FOUNDRY " << FOUNDRY 
+        << " stream " << stream 
+        << " num_threads " << num_threads 
+        ; 
     evt->setFrame(frame);  
 
+    qq.push_back(q); 
+    for(int t=1 ; t < num_threads ; t++) qq.push_back(new CSGQuery(q)) ;   // shares the BVH of q 
+
     if(selection_simtrace)
     {
         selection_simtrace->set_meta<std::string>("SELECTION", SELECTION) ; 
     }
 }
 
+CSGSimtrace::~CSGSimtrace()
+{
+    for(size_t t=1 ; t < qq.size() ; t++) delete qq[t] ; 
+}
+
 int CSGSimtrace::simtrace()
 {
     int num_intersect = qss ? simtrace_selection() : simtrace_all() ; 
     return num_intersect ; 
 }
 
+/**
+CSGSimtrace::simtrace_all
+---------------------------
+
+Uses the packet intersection of CSGQuery::simtrace_packet when the 
+selected prim is a single leaf unless CSGSimtrace__SCALAR is defined, 
+the results are the same. Trees use the scalar CSGQuery::simtrace.
+
+**/
+
 int CSGSimtrace::simtrace_all()
 {
+    if(stream) return simtrace_stream() ; 
+
     int num_simtrace = evt->simtrace.size() ;
-    int num_intersect = 0 ; 
-    for(int i=0 ; i < num_simtrace ; i++)
-    {
-        quad4& p = evt->simtrace[i] ; 
-        bool valid_intersect = q->simtrace(p); 
-        if(valid_intersect) num_intersect += 1 ;
-    }
+    int num_intersect = simtrace_range( evt->simtrace.data(), num_simtrace, scalar ); 
     LOG(LEVEL) 
+        << " SCALAR " << SCALAR
+        << " scalar " << scalar
+        << " FOUNDRY " << FOUNDRY
+        << " num_threads " << num_threads
         << " num_simtrace " << num_simtrace 
         << " num_intersect " << num_intersect 
         ; 
@@ -76,16 +127,12 @@ int CSGSimtrace::simtrace_all()
 
 int CSGSimtrace::simtrace_selection()
 {
-    int num_intersect = 0 ; 
     for(int i=0 ; i < num_selection ; i++)
     {
         int j = (*selection)[i] ; 
-        const quad4& p0 = evt->simtrace[j] ; 
-        quad4& p = qss[i] ; 
-        p = p0 ;   
-        bool valid_intersect = q->simtrace(p); 
-        if(valid_intersect) num_intersect += 1 ;
+        qss[i] = evt->simtrace[j] ; 
     }
+    int num_intersect = simtrace_range( qss, num_selection, true ); 
     LOG(LEVEL) 
         << " num_selection " << num_selection 
         << " num_intersect " << num_intersect 
@@ -93,6 +140,105 @@ int CSGSimtrace::simtrace_selection()
     return num_intersect ; 
 }
 
+/**
+CSGSimtrace::simtrace_stream
+------------------------------
+
+Generates the simtrace items from the gensteps added by SEvt::setFrame 
+in chunks which are intersected in place within the SEvt simtrace vector 
+while the next chunk is being generated. 
+
+This only overlaps generation with intersection, it does not reduce memory:
+the SEvt simtrace vector is sized for all items by hostside_running_resize
+as the whole array is saved by saveEvent, in addition to the chunk buffer
+of the generator. 
+
+**/
+
+int CSGSimtrace::simtrace_stream()
+{
+    NP* gs = evt->gatherGenstep(); 
+    unsigned num_simtrace = evt->getNumPhotonFromGenstep(); 
+    evt->setNumSimtrace( num_simtrace ); 
+    evt->hostside_running_resize(); 
+    assert( evt->simtrace.size() == num_simtrace ); 
+
+    quad4* ss = evt->simtrace.data() ; 
+    int num_intersect = 0 ; 
+    int num_chunk = 0 ; 
+
+    auto consumer = [&](const quad4* pp, int64_t offset, int64_t num)
+    {
+        memcpy( ss + offset, pp, num*sizeof(quad4) ); 
+        num_intersect += simtrace_range( ss + offset, num, scalar ); 
+        num_chunk += 1 ; 
+    };
+    SFrameGenstep::GenerateSimtracePhotons_stream( gs, consumer ); 
+    delete gs ; 
+
+    LOG(LEVEL) 
+        << " num_simtrace " << num_simtrace 
+        << " num_chunk " << num_chunk 
+        << " num_intersect " << num_intersect 
+        ; 
+    return num_intersect ; 
+}
+
+/**
+CSGSimtrace::simtrace_range
+-----------------------------
+
+Intersects the *num* simtrace items in place using *num_threads* threads
+that take BLOCK items at a time, balancing the load across threads 
+as the cost varies greatly between rays. Each thread uses its own CSGQuery
+from *qq*. With FOUNDRY every item is intersected with CSGQuery::simtrace_trace 
+otherwise with the selected prim by CSGQuery::simtrace or CSGQuery::simtrace_packet.  
+Returns the number of valid intersects.
+
+**/
+
+int CSGSimtrace::simtrace_range( quad4* pp, int64_t num, bool scalar_ )
+{
+    int num_block = int( ( num + BLOCK - 1 )/BLOCK ) ; 
+    int nt = std::max( 1, std::min( num_threads, num_block ) ) ; 
+
+    std::atomic<int> next(0) ; 
+    std::vector<int> count(nt, 0) ; 
+
+    auto worker = [&](int t)
+    {
+        const CSGQuery* tq = qq[t] ; 
+        int n = 0 ; 
+        for(int b = next++ ; b < num_block ; b = next++ )
+        {
+            int64_t i0 = int64_t(b)*BLOCK ; 
+            int64_t i1 = std::min( num, i0 + BLOCK ) ; 
+            if( FOUNDRY )
+            {
+                for(int64_t i=i0 ; i < i1 ; i++) n += int(tq->simtrace_trace(pp[i])) ; 
+            }
+            else if( scalar_ )
+            {
+                for(int64_t i=i0 ; i < i1 ; i++) n += int(tq->simtrace(pp[i])) ; 
+            }
+            else
+            {
+                n += tq->simtrace_packet( pp + i0, int(i1 - i0) ); 
+            }
+        }
+        count[t] = n ; 
+    };
+
+    std::vector<std::thread> threads ; 
+    for(int t=1 ; t < nt ; t++) threads.emplace_back( worker, t ); 
+    worker(0); 
+    for(size_t t=0 ; t < threads.size() ; t++) threads[t].join(); 
+
+    int num_intersect = 0 ; 
+    for(int t=0 ; t < nt ; t++) num_intersect += count[t] ; 
+    return num_intersect ; 
+}
+
 
 void CSGSimtrace::saveEvent()
 {
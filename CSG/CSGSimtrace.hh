@@ -7,11 +7,34 @@ Canonical usage from tests/CSGSimtraceTest.cc
 
 The heart of this is CSGQuery on CPU intersect functionality using the csg headers
 
+Envvars:
+
+CSGSimtrace__THREADS
+    number of threads, default std::thread::hardware_concurrency. 
+    Blocks of simtrace items are taken by the threads from a shared counter 
+    and intersected in place, each thread using its own copy of the CSGQuery 
+    sharing the BVH of *q*, so the output ordering is the same for any number of threads. 
+    Debug builds recording intersects (DEBUG_RECORD DEBUG_CYLINDER) always use 1 thread. 
+
+CSGSimtrace__FOUNDRY
+    intersect against the whole CSGFoundry geometry with CSGQuery::trace 
+    instead of the single prim selected by SOPR, the frame is then the whole geometry 
+
+CSGSimtrace__STREAM
+    generate the simtrace items from the gensteps in chunks with SFrameGenstep::GenerateSimtracePhotons_stream 
+    intersecting each chunk while the next is generated. This only overlaps generation with intersection,
+    the full SEvt simtrace array is still allocated for saving so memory is not reduced 
+
+CSGSimtrace__SCALAR
+    use CSGQuery::simtrace rather than CSGQuery::simtrace_packet for the selected prim 
+    even when it is a single leaf, trees always use CSGQuery::simtrace as 
+    packets of tree intersects are slower than the scalar loop 
     
 **/
 
 #include "plog/Severity.h"
 #include <vector>
+#include <cstdint>
 #include "sframe.h"
 
 struct CSGFoundry ; 
@@ -27,7 +50,12 @@ struct quad4 ;
 struct CSG_API CSGSimtrace
 {
     static const plog::Severity LEVEL ; 
+    static const bool SCALAR ; 
+    static const bool FOUNDRY ; 
+    static const bool STREAM ; 
+    static const int  BLOCK ; 
     static int Preinit(); 
+    static int NumThreads(); 
 
     int prc ; 
     const char* geom ;
@@ -46,12 +74,20 @@ struct CSG_API CSGSimtrace
     NP* selection_simtrace ; 
     quad4* qss ; 
 
+    bool stream ;    // STREAM without SELECTION 
+    bool scalar ;    // SCALAR or selected prim is a tree, otherwise packet intersects of the leaf 
+    int num_threads ; 
+    std::vector<CSGQuery*> qq ;  // per-thread query, qq[0] is q 
+
     CSGSimtrace();  
+    ~CSGSimtrace();  
     void init(); 
 
     int simtrace();
     int simtrace_all();
     int simtrace_selection();
+    int simtrace_stream();
+    int simtrace_range( quad4* pp, int64_t num, bool scalar_ ); 
 
     void saveEvent();  
 }; 
@@ -1,6 +1,7 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>
 #include <cstdlib>
 #include <csignal>
 
@@ -22,6 +23,7 @@
 #include "SLOG.hh"
 
 const plog::Severity CSGSimtraceRerun::LEVEL = SLOG::EnvLevel("CSGSimtraceRerun", "DEBUG") ; 
+const bool CSGSimtraceRerun::SCALAR = ssys::getenvbool("CSGSimtraceRerun__SCALAR") ; 
 
 
 CSGSimtraceRerun::CSGSimtraceRerun()
@@ -97,6 +99,11 @@ std::string CSGSimtraceRerun::Desc(const quad4& isect1, const quad4& isect0) //
 unsigned  CSGSimtraceRerun::intersect_again(quad4& isect1, const quad4& isect0 )
 {
     bool valid_isect = q->intersect_again(isect1, isect0); 
+    return record_code(valid_isect, isect1, isect0); 
+}
+
+unsigned  CSGSimtraceRerun::record_code(bool valid_isect, const quad4& isect1, const quad4& isect0 )
+{
     bool valid_isect0 = isect0.q0.f.w > isect0.q1.f.w ;   // dist > tmin
     bool valid_isect1 = isect1.q0.f.w > isect1.q1.f.w ;   // dist > tmin
     unsigned code = ( unsigned(valid_isect0) << 1 ) | unsigned(valid_isect1) ;  
@@ -130,6 +137,42 @@ void CSGSimtraceRerun::intersect_again(unsigned idx, bool dump)
     }
 }
 
+/**
+CSGSimtraceRerun::intersect_again_packet
+------------------------------------------
+
+Packet intersection of *num* items starting from *i0* using CSGQuery::intersect_again_packet
+with the same code recording and dumping as the above CSGSimtraceRerun::intersect_again.
+Only used when the selected prim is a single leaf, trees are faster with the scalar loop. 
+
+**/
+
+void CSGSimtraceRerun::intersect_again_packet(unsigned i0, unsigned num)
+{
+    assert( num <= CHUNK ); 
+    bool valid[CHUNK] ; 
+    q->intersect_again_packet( qq1 + i0, qq0 + i0, valid, num ); 
+
+    for(unsigned j=0 ; j < num ; j++)
+    {
+        unsigned idx = i0 + j ; 
+        const quad4& isect0 = qq0[idx] ; 
+        const quad4& isect1 = qq1[idx] ;
+        unsigned code = record_code(valid[j], isect1, isect0); 
+        if( code == 1 || code == 2 )  
+        {
+            std::cout 
+                << "CSGSimtraceRerun::intersect_again_packet"
+                << " idx " << std::setw(7) << idx 
+                << " code " << code 
+                << std::endl  
+                << Desc(isect1, isect0) 
+                << std::endl 
+                ; 
+        }
+    }
+}
+
 /**
 CSGSimtraceRerun::intersect_again_selection
 -----------------------------------------------
@@ -166,6 +209,13 @@ void CSGSimtraceRerun::intersect_again()
                                     (simtrace0 ? simtrace0->shape[0] : 0u ) 
                                 ;
  
+    bool packet = !with_selection && !SCALAR && !q->select_is_tree ;  // packets only help single leaf prims 
+    if( packet )
+    {
+        for(unsigned i=0 ; i < n ; i += CHUNK) intersect_again_packet(i, std::min(n - i, unsigned(CHUNK)) ); 
+        return ; 
+    }
+
     for(unsigned i=0 ; i < n ; i++) 
     {
         if( with_selection )
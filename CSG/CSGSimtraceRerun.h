@@ -22,6 +22,8 @@ struct CSGDraw ;
 struct CSG_API CSGSimtraceRerun
 { 
     static const plog::Severity LEVEL ; 
+    static const bool SCALAR ; 
+    static constexpr const int CHUNK = 1024 ; 
 
     SSim* sim ; 
     const CSGFoundry* fd ; 
@@ -53,6 +55,8 @@ struct CSG_API CSGSimtraceRerun
     static std::string Desc(const quad4& isect1, const quad4& isect0); 
 
     unsigned intersect_again(quad4& isect1, const quad4& isect0 ); 
+    unsigned record_code(bool valid_isect, const quad4& isect1, const quad4& isect0 ); 
+    void intersect_again_packet(unsigned i0, unsigned num); 
     void intersect_again(unsigned idx, bool dump); 
     void intersect_again_selection(unsigned i, bool dump); 
     void intersect_again(); 
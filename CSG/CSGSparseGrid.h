@@ -0,0 +1,400 @@
+#pragma once
+/**
+CSGSparseGrid.h : block sparse narrow band signed distance cache
+===================================================================
+
+Unlike the dense CSGGrid this only stores samples of the signed distance
+within *band* of the surface, so fine resolutions are practical for large solids.
+Used via CSGQuery::scanPrimSparse and CSGQuery::distance_cached to avoid
+re-evaluating the full CSG tree for repeated off-surface distance samples.
+The cache never applies on the surface, so it is not used by the intersect
+distance checks or CSGQuery::IsSpurious which evaluate exact distances.
+
+Lattice
+    samples at origin + h*(i,j,k) covering ce.xyz +- margin*ce.w,
+    grouped into blocks of B*B*B cells
+
+Blocks
+    each active block stores S*S*S samples with S=B+1, the extra apron layer
+    duplicates the first samples of the neighbouring blocks so that all eight
+    corners needed for trilinear interpolation within a block are in that block.
+
+Index
+    two levels of dense tables, as in VDB : a top table over tiles of T*T*T blocks 
+    holding offsets into tile tables of block indices that are only allocated 
+    for tiles with active blocks, so lookups are two array reads 
+
+Build
+    1. octree style culling over ranges of blocks : a range is rejected
+       when the distance at its center exceeds its half diagonal plus band,
+       which is safe for distance functions with Lipschitz constant <= 1
+       (leaf distances and their fminf/fmaxf CSG combinations)
+    2. sampling of the active blocks in parallel, threads claiming blocks
+       from an atomic counter so results do not depend on the thread count
+
+Query
+    *query* returns false for positions outside the band, where the caller needs
+    to fall back to exact evaluation. 
+
+Error
+    For a distance function with Lipschitz constant <= 1 the trilinear value 
+    is within sqrt(3)/2*h of the exact distance : the interpolation weights w_c sum to one
+    so the error is at most sum w_c|p-c| <= sqrt( sum w_c|p-c|^2 ) <= sqrt(3)/2*h.
+    CSGQuery::distance_cached uses this *err_bound* to only take cached values 
+    that are far enough from the surface for the sign to be certain. 
+
+No CUDA, no other CSG dependency.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include "scuda.h"
+#include "NP.hh"
+
+struct CSGSparseGrid
+{
+    static constexpr const int B = 8 ;       // cells per block edge
+    static constexpr const int S = B + 1 ;   // samples per block edge, including apron
+    static constexpr const int SSS = S*S*S ;
+    static constexpr const int T = 8 ;       // blocks per tile edge
+    static constexpr const int TTT = T*T*T ;
+
+    float3 origin ;
+    float  h ;
+    float  band ;
+    int    nb[3] ;          // number of blocks along each axis
+    int    nt[3] ;          // number of tiles along each axis
+
+    std::vector<int>   top ;      // per tile : offset into tile or -1 
+    std::vector<int>   tile ;     // TTT per allocated tile : block index or -1
+    std::vector<int>   coord ;    // 3 per block
+    std::vector<float> value ;    // SSS per block, x fastest
+
+    long num_eval ;
+
+    CSGSparseGrid( const float4& ce, float h, float band, float margin=1.2f );
+    CSGSparseGrid( const float3& origin, float h, float band, const int* nb );
+
+    void init_index(); 
+    void add_block( int i, int j, int k );
+    float3 blockOrigin( int i, int j, int k ) const ;
+
+    void build( std::function<float(const float3&)> sdf, int num_threads=0 );
+    void cull_r( std::function<float(const float3&)>& sdf, int i0, int j0, int k0, int i1, int j1, int k1 );
+    void sample( std::function<float(const float3&)>& sdf, int b );
+
+    int  find( int i, int j, int k ) const ;
+    bool query( float& sd, const float3& p ) const ;
+    float interpolate( const float* v, int ci, int cj, int ck, float tx, float ty, float tz ) const ;
+
+    int  num_block() const ;
+    float err_bound() const ;
+    std::string desc() const ;
+
+    void save( const char* fold ) const ;
+    static CSGSparseGrid* Load( const char* fold );
+};
+
+inline CSGSparseGrid::CSGSparseGrid( const float4& ce, float h_, float band_, float margin )
+    :
+    h(h_),
+    band(band_),
+    num_eval(0)
+{
+    float half = margin*ce.w ;
+    int n = std::max( 1, int(ceilf( 2.f*half/(float(B)*h) )) ) ;
+    nb[0] = n ;
+    nb[1] = n ;
+    nb[2] = n ;
+    float half_lattice = 0.5f*float(n*B)*h ;   // centered on ce, slightly larger than margin*ce.w
+    origin = make_float3( ce.x - half_lattice, ce.y - half_lattice, ce.z - half_lattice );
+    init_index(); 
+}
+
+inline CSGSparseGrid::CSGSparseGrid( const float3& origin_, float h_, float band_, const int* nb_ )
+    :
+    origin(origin_),
+    h(h_),
+    band(band_),
+    num_eval(0)
+{
+    for(int a=0 ; a < 3 ; a++) nb[a] = nb_[a] ;
+    init_index(); 
+}
+
+inline void CSGSparseGrid::init_index()
+{
+    for(int a=0 ; a < 3 ; a++) nt[a] = (nb[a] + T - 1)/T ;
+    top.assign( size_t(nt[0])*nt[1]*nt[2], -1 ); 
+    tile.clear(); 
+}
+
+inline void CSGSparseGrid::add_block( int i, int j, int k )
+{
+    int& t = top[ (size_t(k/T)*nt[1] + j/T)*nt[0] + i/T ] ; 
+    if( t < 0 )
+    {
+        t = int(tile.size()) ; 
+        tile.resize( tile.size() + TTT, -1 ); 
+    }
+    tile[ t + ((k%T)*T + j%T)*T + i%T ] = num_block() ;  
+    coord.push_back(i);
+    coord.push_back(j);
+    coord.push_back(k);
+}
+
+inline float3 CSGSparseGrid::blockOrigin( int i, int j, int k ) const
+{
+    return make_float3( origin.x + float(i*B)*h, origin.y + float(j*B)*h, origin.z + float(k*B)*h );
+}
+
+/**
+CSGSparseGrid::build
+----------------------
+
+*sdf* must be safe to call concurrently, as CSGQuery::distance is.
+CSGSparseGridTest checks the samples are identical for any thread count 
+and prints the 1 thread and *num_threads* build times, the speedup 
+is only meaningful when run on a multi-core machine. 
+
+**/
+
+inline void CSGSparseGrid::build( std::function<float(const float3&)> sdf, int num_threads )
+{
+    init_index(); 
+    coord.clear();
+    value.clear();
+    num_eval = 0 ;
+
+    cull_r( sdf, 0, 0, 0, nb[0], nb[1], nb[2] );
+
+    int num = num_block() ;
+    value.resize( size_t(num)*SSS );
+
+    if( num_threads <= 0 ) num_threads = std::max( 1u, std::thread::hardware_concurrency() ) ;
+    num_threads = std::min( num_threads, std::max(1, num) );
+
+    std::atomic<int> next(0) ;
+    auto worker = [&]()
+    {
+        for( int b = next++ ; b < num ; b = next++ ) sample( sdf, b );
+    };
+
+    if( num_threads == 1 )
+    {
+        worker();
+    }
+    else
+    {
+        std::vector<std::thread> threads ;
+        for(int t=0 ; t < num_threads ; t++) threads.push_back( std::thread(worker) );
+        for(auto& t : threads) t.join();
+    }
+    num_eval += long(num)*SSS ;
+}
+
+/**
+CSGSparseGrid::cull_r
+-----------------------
+
+Recursively halves the range of blocks [i0,i1)x[j0,j1)x[k0,k1) along each axis,
+rejecting ranges that cannot contain any position within band of the surface.
+
+**/
+
+inline void CSGSparseGrid::cull_r( std::function<float(const float3&)>& sdf, int i0, int j0, int k0, int i1, int j1, int k1 )
+{
+    float3 lo = blockOrigin(i0, j0, k0) ;
+    float3 hi = blockOrigin(i1, j1, k1) ;
+    float3 ce = 0.5f*(lo + hi) ;
+    float half_diagonal = 0.5f*length( hi - lo ) ;
+
+    float sd = sdf(ce) ;
+    num_eval += 1 ;
+    if( fabsf(sd) > half_diagonal + band ) return ;
+
+    if( i1 - i0 == 1 && j1 - j0 == 1 && k1 - k0 == 1 )
+    {
+        add_block( i0, j0, k0 );
+        return ;
+    }
+
+    int im = i1 - i0 > 1 ? (i0 + i1)/2 : i1 ;
+    int jm = j1 - j0 > 1 ? (j0 + j1)/2 : j1 ;
+    int km = k1 - k0 > 1 ? (k0 + k1)/2 : k1 ;
+
+    int ii[3] = { i0, im, i1 } ;
+    int jj[3] = { j0, jm, j1 } ;
+    int kk[3] = { k0, km, k1 } ;
+
+    for(int a=0 ; a < 2 ; a++)
+    for(int b=0 ; b < 2 ; b++)
+    for(int c=0 ; c < 2 ; c++)
+    {
+        if( ii[a] == ii[a+1] || jj[b] == jj[b+1] || kk[c] == kk[c+1] ) continue ;
+        cull_r( sdf, ii[a], jj[b], kk[c], ii[a+1], jj[b+1], kk[c+1] );
+    }
+}
+
+inline void CSGSparseGrid::sample( std::function<float(const float3&)>& sdf, int b )
+{
+    const int* c = coord.data() + 3*b ;
+    float3 bo = blockOrigin( c[0], c[1], c[2] ) ;
+    float* v = value.data() + size_t(b)*SSS ;
+
+    for(int k=0 ; k < S ; k++)
+    for(int j=0 ; j < S ; j++)
+    for(int i=0 ; i < S ; i++)
+    {
+        float3 p = make_float3( bo.x + float(i)*h, bo.y + float(j)*h, bo.z + float(k)*h ) ;
+        v[(k*S + j)*S + i] = sdf(p) ;
+    }
+}
+
+inline int CSGSparseGrid::find( int i, int j, int k ) const
+{
+    int t = top[ (size_t(k/T)*nt[1] + j/T)*nt[0] + i/T ] ; 
+    return t < 0 ? -1 : tile[ t + ((k%T)*T + j%T)*T + i%T ] ;
+}
+
+inline float CSGSparseGrid::interpolate( const float* v, int ci, int cj, int ck, float tx, float ty, float tz ) const
+{
+    const float* c = v + (ck*S + cj)*S + ci ;
+    float c00 = c[0]       + tx*( c[1]         - c[0] ) ;
+    float c10 = c[S]       + tx*( c[S+1]       - c[S] ) ;
+    float c01 = c[S*S]     + tx*( c[S*S+1]     - c[S*S] ) ;
+    float c11 = c[S*S+S]   + tx*( c[S*S+S+1]   - c[S*S+S] ) ;
+    float c0 = c00 + ty*( c10 - c00 ) ;
+    float c1 = c01 + ty*( c11 - c01 ) ;
+    return c0 + tz*( c1 - c0 ) ;
+}
+
+/**
+CSGSparseGrid::query
+----------------------
+
+Trilinear interpolated signed distance at *p*, returning false when *p* is
+outside the lattice or in a block that was culled as beyond the band.
+
+**/
+
+inline bool CSGSparseGrid::query( float& sd, const float3& p ) const
+{
+    float fx = (p.x - origin.x)/h ;
+    float fy = (p.y - origin.y)/h ;
+    float fz = (p.z - origin.z)/h ;
+    if( !( fx >= 0.f && fy >= 0.f && fz >= 0.f ) ) return false ;    // also rejects nan
+    if( !( fx < float(nb[0]*B) && fy < float(nb[1]*B) && fz < float(nb[2]*B) ) ) return false ;
+
+    int ix = int(fx) ;
+    int iy = int(fy) ;
+    int iz = int(fz) ;
+    int bi = ix/B ;
+    int bj = iy/B ;
+    int bk = iz/B ;
+
+    int b = find( bi, bj, bk ) ;
+    if( b < 0 ) return false ;
+
+    sd = interpolate( value.data() + size_t(b)*SSS, ix - bi*B, iy - bj*B, iz - bk*B, fx - float(ix), fy - float(iy), fz - float(iz) ) ;
+    return true ;
+}
+
+inline int CSGSparseGrid::num_block() const
+{
+    return int(coord.size()/3) ;
+}
+
+inline float CSGSparseGrid::err_bound() const
+{
+    return 0.8660254f*h ;   // sqrt(3)/2*h
+}
+
+inline std::string CSGSparseGrid::desc() const
+{
+    long dense = long(nb[0]*B+1)*long(nb[1]*B+1)*long(nb[2]*B+1) ;
+    long sparse = long(num_block())*SSS ;
+    std::stringstream ss ;
+    ss << "CSGSparseGrid::desc"
+       << " h " << h
+       << " band " << band
+       << " nb (" << nb[0] << " " << nb[1] << " " << nb[2] << ")"
+       << " num_block " << num_block()
+       << " sparse_samples " << sparse
+       << " dense_samples " << dense
+       << " fraction " << std::fixed << std::setprecision(4) << double(sparse)/double(dense)
+       << " num_eval " << num_eval
+       << " err_bound " << err_bound()
+       ;
+    std::string str = ss.str() ;
+    return str ;
+}
+
+inline void CSGSparseGrid::save( const char* fold ) const
+{
+    int num = num_block() ;
+
+    NP* a = NP::Make<float>( num, S, S, S ) ;
+    if(num > 0) memcpy( a->bytes(), value.data(), a->arr_bytes() );
+    a->set_meta<float>("ox", origin.x );
+    a->set_meta<float>("oy", origin.y );
+    a->set_meta<float>("oz", origin.z );
+    a->set_meta<float>("h", h );
+    a->set_meta<float>("band", band );
+    a->set_meta<int>("nbx", nb[0] );
+    a->set_meta<int>("nby", nb[1] );
+    a->set_meta<int>("nbz", nb[2] );
+    a->save(fold, "sparse_sdf.npy");
+
+    NP* c = NP::Make<int>( num, 3 ) ;
+    if(num > 0) memcpy( c->bytes(), coord.data(), c->arr_bytes() );
+    c->save(fold, "sparse_coord.npy");
+
+    delete a ;
+    delete c ;
+}
+
+inline CSGSparseGrid* CSGSparseGrid::Load( const char* fold ) // static
+{
+    NP* a = NP::Exists(fold, "sparse_sdf.npy")   ? NP::Load(fold, "sparse_sdf.npy")   : nullptr ;
+    NP* c = NP::Exists(fold, "sparse_coord.npy") ? NP::Load(fold, "sparse_coord.npy") : nullptr ;
+
+    bool a_expect = a && a->shape.size() == 4 && a->shape[1] == S && a->shape[2] == S && a->shape[3] == S ;
+    bool c_expect = c && c->shape.size() == 2 && c->shape[1] == 3 ;
+    bool expect = a_expect && c_expect && a->shape[0] == c->shape[0] ;
+    if(!expect)
+    {
+        std::cerr
+            << "CSGSparseGrid::Load FAILED from " << fold
+            << " a " << ( a ? a->sstr() : "-" )
+            << " c " << ( c ? c->sstr() : "-" )
+            << std::endl
+            ;
+        delete a ;
+        delete c ;
+        return nullptr ;
+    }
+
+    float3 o = make_float3( a->get_meta<float>("ox"), a->get_meta<float>("oy"), a->get_meta<float>("oz") );
+    int nb[3] = { a->get_meta<int>("nbx"), a->get_meta<int>("nby"), a->get_meta<int>("nbz") } ;
+
+    CSGSparseGrid* sg = new CSGSparseGrid( o, a->get_meta<float>("h"), a->get_meta<float>("band"), nb ) ;
+    int num = c->shape[0] ;
+    const int* cc = c->cvalues<int>() ;
+    for(int b=0 ; b < num ; b++) sg->add_block( cc[3*b+0], cc[3*b+1], cc[3*b+2] ); 
+    sg->value.assign( a->cvalues<float>(), a->cvalues<float>() + size_t(num)*SSS );
+
+    delete a ;
+    delete c ;
+    return sg ;
+}
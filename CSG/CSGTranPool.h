@@ -0,0 +1,196 @@
+#pragma once
+/**
+CSGTranPool.h : content hashed pool of CSGFoundry node transforms for deduplication
+=====================================================================================
+
+CSGFoundry::addTran appends a (tran, itra) pair for every transformed node
+even when the same transform is repeated across nodes, prims and solids.
+The pool maps a hash of the 32 float bit patterns of each pair to the 0-based
+index of the pair in the tran/itra vectors so that identical pairs are
+added once and shared by all the nodes that use them.
+
+Entries are compared bitwise after matching hashes, so only exactly identical
+transforms are shared (+0.f and -0.f are different), hence the intersects
+are unchanged.
+
+add
+    returns the index of an existing identical pair or appends the pair
+
+dedup
+    compacts tran/itra vectors that were filled without the pool, giving
+    the old to new index remap for updating the node references,
+    the pool is rebuilt over the compacted vectors
+
+Enabled in CSGFoundry by envvar CSGFoundry__DEDUP_TRAN, see CSGFoundry::dedupTran
+
+No CUDA, no other CSG dependency.
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <unordered_map>
+#include "sqat4.h"
+
+struct CSGTranPool
+{
+    std::unordered_multimap<uint64_t, unsigned> pool ;
+    unsigned num_add ;       // pairs offered to add
+    unsigned num_reuse ;     // of which were already present
+    unsigned num_removed ;   // by dedup
+
+    CSGTranPool();
+
+    void clear();
+    static uint64_t Hash( const qat4& tr, const qat4& it );
+    static bool Same( const qat4& a, const qat4& b );
+
+    int      find( const std::vector<qat4>& tran, const std::vector<qat4>& itra, const qat4& tr, const qat4& it, uint64_t h ) const ;
+    unsigned add( std::vector<qat4>& tran, std::vector<qat4>& itra, const qat4& tr, const qat4& it );
+    unsigned dedup( std::vector<qat4>& tran, std::vector<qat4>& itra, std::vector<unsigned>& remap );
+
+    std::string desc( unsigned num_tran ) const ;
+};
+
+inline CSGTranPool::CSGTranPool()
+    :
+    num_add(0),
+    num_reuse(0),
+    num_removed(0)
+{
+}
+
+inline void CSGTranPool::clear()
+{
+    pool.clear();
+    num_add = 0 ;
+    num_reuse = 0 ;
+    num_removed = 0 ;
+}
+
+/**
+CSGTranPool::Hash
+-------------------
+
+FNV-1a over the bit patterns of the 16 floats of tran then the 16 of itra.
+
+**/
+
+inline uint64_t CSGTranPool::Hash( const qat4& tr, const qat4& it ) // static
+{
+    uint32_t w[32] ;
+    memcpy( w,      tr.cdata(), 16*sizeof(float) );
+    memcpy( w + 16, it.cdata(), 16*sizeof(float) );
+
+    uint64_t h = 14695981039346656037ull ;
+    for(int i=0 ; i < 32 ; i++)
+    {
+        h ^= w[i] ;
+        h *= 1099511628211ull ;
+    }
+    return h ;
+}
+
+inline bool CSGTranPool::Same( const qat4& a, const qat4& b ) // static
+{
+    return memcmp( a.cdata(), b.cdata(), 16*sizeof(float) ) == 0 ;
+}
+
+/**
+CSGTranPool::find
+-------------------
+
+0-based index of the pair identical to (tr, it) with hash h or -1 if not in the pool.
+
+**/
+
+inline int CSGTranPool::find( const std::vector<qat4>& tran, const std::vector<qat4>& itra, const qat4& tr, const qat4& it, uint64_t h ) const
+{
+    auto range = pool.equal_range(h) ;
+    for(auto i = range.first ; i != range.second ; i++)
+    {
+        unsigned idx = i->second ;
+        if( Same(tran[idx], tr) && Same(itra[idx], it) ) return int(idx) ;
+    }
+    return -1 ;
+}
+
+inline unsigned CSGTranPool::add( std::vector<qat4>& tran, std::vector<qat4>& itra, const qat4& tr, const qat4& it )
+{
+    assert( tran.size() == itra.size() );
+    num_add += 1 ;
+    uint64_t h = Hash(tr, it) ;
+    int found = find( tran, itra, tr, it, h );
+    if( found > -1 )
+    {
+        num_reuse += 1 ;
+        return unsigned(found) ;
+    }
+    unsigned idx = tran.size() ;
+    tran.push_back(tr);
+    itra.push_back(it);
+    pool.insert( std::make_pair(h, idx) );
+    return idx ;
+}
+
+/**
+CSGTranPool::dedup
+--------------------
+
+Compacts tran and itra keeping the first of each set of identical pairs
+in the original order. remap[old] gives the new 0-based index.
+Returns the number of pairs removed.
+
+**/
+
+inline unsigned CSGTranPool::dedup( std::vector<qat4>& tran, std::vector<qat4>& itra, std::vector<unsigned>& remap )
+{
+    assert( tran.size() == itra.size() );
+    unsigned num = tran.size() ;
+    remap.resize(num) ;
+    pool.clear();
+
+    unsigned n = 0 ;
+    for(unsigned i=0 ; i < num ; i++)
+    {
+        uint64_t h = Hash( tran[i], itra[i] ) ;
+        int found = find( tran, itra, tran[i], itra[i], h );   // searches only the compacted [0,n)
+        if( found > -1 )
+        {
+            remap[i] = found ;
+            continue ;
+        }
+        if( n != i )
+        {
+            tran[n] = tran[i] ;
+            itra[n] = itra[i] ;
+        }
+        pool.insert( std::make_pair(h, n) );
+        remap[i] = n ;
+        n += 1 ;
+    }
+    tran.resize(n) ;
+    itra.resize(n) ;
+
+    unsigned removed = num - n ;
+    num_removed += removed ;
+    return removed ;
+}
+
+inline std::string CSGTranPool::desc( unsigned num_tran ) const
+{
+    std::stringstream ss ;
+    ss << "CSGTranPool::desc"
+       << " num_tran " << num_tran
+       << " num_pool " << pool.size()
+       << " num_add " << num_add
+       << " num_reuse " << num_reuse
+       << " num_removed " << num_removed
+       ;
+    std::string str = ss.str() ;
+    return str ;
+}
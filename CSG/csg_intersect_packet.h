@@ -0,0 +1,637 @@
+#pragma once
+/**
+csg_intersect_packet.h : CPU intersection of ray packets with a single CSGPrim
+===============================================================================
+
+Host only structure-of-arrays equivalent of *intersect_prim* from csg_intersect_tree.h
+for packets of CSG_PACKET_WIDTH rays (8 or 16). Used by CSGQuery::simtrace_packet
+and CSGQuery::intersect_again_packet to speed up CSGSimtrace and CSGSimtraceRerun
+which intersect very large numbers of rays with the same prim.
+
+csg_rays
+    packet of ray origins and directions, one array per component
+
+csg_isect
+    packet of isect float4 (normal, t) and validity flags
+
+intersect_packet_sphere
+intersect_packet_zsphere
+intersect_packet_cylinder
+intersect_packet_box3
+intersect_packet_convexpolyhedron
+    lane loops following the arithmetic of the scalar intersect_leaf_* functions
+    with the branches and fminf/fmaxf replaced by bitmask selects, so the compiler
+    can vectorize them (-O3 or -O2 -ftree-vectorize, plus -fno-math-errno for sqrtf)
+    without any dependency on intrinsics.
+    Results are bitwise identical to the scalar functions, see tests/csg_intersect_packet_test.sh
+
+intersect_packet_leaf
+    applies the node gtransform to the packet, dispatches to the above packet
+    functions or to scalar intersect_leaf lane by lane for other typecodes,
+    then transforms the normals and handles complement like *intersect_leaf*
+
+intersect_packet_prim
+    leaf prims use intersect_packet_leaf, CSG trees and list nodes fall back
+    to scalar *intersect_prim* lane by lane
+
+As with the scalar functions the isect of lanes without a valid intersect
+is left unchanged, other than the complement signalling in isect.x.
+Lanes beyond the number of active rays must hold harmless rays, see csg_packet.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+#include <cassert>
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+#ifndef CSG_PACKET_WIDTH
+#define CSG_PACKET_WIDTH 8
+#endif
+
+
+template<int W>
+struct csg_rays
+{
+    float ox[W] ;
+    float oy[W] ;
+    float oz[W] ;
+    float dx[W] ;
+    float dy[W] ;
+    float dz[W] ;
+
+    void set( int l, const float3& o, const float3& d );
+    float3 origin(int l) const {    return make_float3( ox[l], oy[l], oz[l] ) ; }
+    float3 direction(int l) const { return make_float3( dx[l], dy[l], dz[l] ) ; }
+};
+
+template<int W>
+inline void csg_rays<W>::set( int l, const float3& o, const float3& d )
+{
+    ox[l] = o.x ; oy[l] = o.y ; oz[l] = o.z ;
+    dx[l] = d.x ; dy[l] = d.y ; dz[l] = d.z ;
+}
+
+
+template<int W>
+struct csg_isect
+{
+    float nx[W] ;
+    float ny[W] ;
+    float nz[W] ;
+    float t[W] ;
+    int   valid[W] ;
+
+    void   set( int l, const float4& isect ) { nx[l] = isect.x ; ny[l] = isect.y ; nz[l] = isect.z ; t[l] = isect.w ; }
+    float4 get( int l ) const { return make_float4( nx[l], ny[l], nz[l], t[l] ) ; }
+};
+
+
+/**
+csg_packet
+------------
+
+Packet of *num* active rays with t_min and isect for each lane.
+The *fill* method copies the last active lane into the inactive lanes
+so the lane loops can always run over the full width.
+
+**/
+
+template<int W>
+struct csg_packet
+{
+    static constexpr const int WIDTH = W ;
+
+    int           num ;
+    csg_rays<W>   ray ;
+    float         tmin[W] ;
+    csg_isect<W>  isect ;
+
+    void fill();
+};
+
+template<int W>
+inline void csg_packet<W>::fill()
+{
+    assert( num > 0 && num <= W );
+    for(int l=num ; l < W ; l++)
+    {
+        ray.set( l, ray.origin(num-1), ray.direction(num-1) );
+        tmin[l] = tmin[num-1] ;
+        isect.set( l, isect.get(num-1) );
+    }
+}
+
+
+/**
+packet_select packet_fminf packet_fmaxf packet_quadratic_roots
+----------------------------------------------------------------
+
+*packet_select(c,a,b)* is *c ? a : b* done with a bitmask. With the ternary
+the compiler is free to turn the selects back into branches (eg via jump threading)
+which defeats vectorization of the lane loops.
+
+The others are select based equivalents of fminf, fmaxf (with the same NaN handling)
+and of the robust_quadratic_roots functions from csg_robust_quadratic_roots.h
+
+**/
+
+LEAF_FUNC float packet_select( const bool c, const float a, const float b )
+{
+    uif_t ua, ub ;
+    ua.f = a ;
+    ub.f = b ;
+    const unsigned m = 0u - unsigned(c) ;
+    ua.u = ( ua.u & m ) | ( ub.u & ~m ) ;
+    return ua.f ;
+}
+
+LEAF_FUNC float packet_fminf( const float a, const float b ){ return packet_select( ( b < a ) | ( a != a ), b, a ) ; }
+LEAF_FUNC float packet_fmaxf( const float a, const float b ){ return packet_select( ( b > a ) | ( a != a ), b, a ) ; }
+
+/**
+packet_sqrtf_positive
+    same as *disc > 0.f ? sqrtf(disc) : 0.f* with the sqrtf evaluated for all lanes
+
+**/
+
+LEAF_FUNC float packet_sqrtf_positive( const float disc )
+{
+    return packet_select( disc > 0.f, sqrtf(disc), 0.f ) ;
+}
+
+LEAF_FUNC
+void packet_quadratic_roots(float& t1, float &t2, float& sdisc, const float d, const float b, const float c)
+{
+    const float disc = b*b-d*c;
+    sdisc = packet_sqrtf_positive( disc ) ;
+    const float sd = packet_select( b > 0.f, -sdisc, sdisc ) ;   // -(b - sd) is -(b + sdisc) or -(b - sdisc) exactly
+    const float q = -(b - sd) ;
+    const float root1 = q/d  ;
+    const float root2 = c/q  ;
+    t1 = packet_fminf( root1, root2 );
+    t2 = packet_fmaxf( root1, root2 );
+}
+
+LEAF_FUNC
+void packet_quadratic_roots_disqualifying(const float t_min, float& t1, float &t2, float& sdisc, const float d, const float b, const float c)
+{
+    const float disc = b*b-d*c;
+    sdisc = packet_sqrtf_positive( disc ) ;
+    const float sd = packet_select( b > 0.f, -sdisc, sdisc ) ;   // -(b - sd) is -(b + sdisc) or -(b - sdisc) exactly
+    const float q = -(b - sd) ;
+    const float qd = q/d ;
+    const float cq = c/q ;
+    const float root1 = packet_select( sdisc > 0.f, qd, t_min ) ;
+    const float root2 = packet_select( sdisc > 0.f, cq, t_min ) ;
+    t1 = packet_fminf( root1, root2 );
+    t2 = packet_fmaxf( root1, root2 );
+}
+
+
+template<int W>
+LEAF_FUNC
+void csg_rays_transform( csg_rays<W>& loc, const qat4* q, const csg_rays<W>& ray )
+{
+    for(int l=0 ; l < W ; l++)
+    {
+        loc.ox[l] = q->q0.f.x * ray.ox[l] + q->q1.f.x * ray.oy[l] + q->q2.f.x * ray.oz[l] + q->q3.f.x * 1.f ;
+        loc.oy[l] = q->q0.f.y * ray.ox[l] + q->q1.f.y * ray.oy[l] + q->q2.f.y * ray.oz[l] + q->q3.f.y * 1.f ;
+        loc.oz[l] = q->q0.f.z * ray.ox[l] + q->q1.f.z * ray.oy[l] + q->q2.f.z * ray.oz[l] + q->q3.f.z * 1.f ;
+
+        loc.dx[l] = q->q0.f.x * ray.dx[l] + q->q1.f.x * ray.dy[l] + q->q2.f.x * ray.dz[l] + q->q3.f.x * 0.f ;
+        loc.dy[l] = q->q0.f.y * ray.dx[l] + q->q1.f.y * ray.dy[l] + q->q2.f.y * ray.dz[l] + q->q3.f.y * 0.f ;
+        loc.dz[l] = q->q0.f.z * ray.dx[l] + q->q1.f.z * ray.dy[l] + q->q2.f.z * ray.dz[l] + q->q3.f.z * 0.f ;
+    }
+}
+
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_sphere( csg_isect<W>& is, const quad& q0, const float* t_min, const csg_rays<W>& r )
+{
+    const float cx = q0.f.x ;
+    const float cy = q0.f.y ;
+    const float cz = q0.f.z ;
+    const float radius = q0.f.w ;
+
+    for(int l=0 ; l < W ; l++)
+    {
+        const float Ox = r.ox[l] - cx ;
+        const float Oy = r.oy[l] - cy ;
+        const float Oz = r.oz[l] - cz ;
+        const float Dx = r.dx[l] ;
+        const float Dy = r.dy[l] ;
+        const float Dz = r.dz[l] ;
+
+        const float b = Ox*Dx + Oy*Dy + Oz*Dz ;
+        const float c = (Ox*Ox + Oy*Oy + Oz*Oz) - radius*radius ;
+        const float d = Dx*Dx + Dy*Dy + Dz*Dz ;
+
+        float root1, root2, sdisc ;
+        packet_quadratic_roots(root1, root2, sdisc, d, b, c );
+
+        const float t_cand = packet_select( sdisc > 0.f, packet_select( root1 > t_min[l], root1, root2 ), t_min[l] ) ;
+        const bool valid = t_cand > t_min[l] ;
+
+        const float nx = (Ox + t_cand*Dx)/radius ;
+        const float ny = (Oy + t_cand*Dy)/radius ;
+        const float nz = (Oz + t_cand*Dz)/radius ;
+
+        is.nx[l] = packet_select( valid, nx, is.nx[l] ) ;
+        is.ny[l] = packet_select( valid, ny, is.ny[l] ) ;
+        is.nz[l] = packet_select( valid, nz, is.nz[l] ) ;
+        is.t[l]  = packet_select( valid, t_cand, is.t[l] ) ;
+        is.valid[l] = valid ;
+    }
+}
+
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_zsphere( csg_isect<W>& is, const quad& q0, const quad& q1, const float* t_min, const csg_rays<W>& r )
+{
+    const float cx = q0.f.x ;
+    const float cy = q0.f.y ;
+    const float cz = q0.f.z ;
+    const float radius = q0.f.w ;
+    const float zmax = cz + q1.f.y ;
+    const float zmin = cz + q1.f.x ;
+
+    for(int l=0 ; l < W ; l++)
+    {
+        const float Ox = r.ox[l] - cx ;
+        const float Oy = r.oy[l] - cy ;
+        const float Oz = r.oz[l] - cz ;
+        const float Dx = r.dx[l] ;
+        const float Dy = r.dy[l] ;
+        const float Dz = r.dz[l] ;
+        const float tm = t_min[l] ;
+
+        const float b = Ox*Dx + Oy*Dy + Oz*Dz ;
+        const float c = (Ox*Ox + Oy*Oy + Oz*Oz) - radius*radius ;
+        const bool  away = ( c > 0.f ) & ( b > 0.f ) ;   // scalar early exit
+        const float d = Dx*Dx + Dy*Dy + Dz*Dz ;
+
+        float t1sph, t2sph, sdisc ;
+        packet_quadratic_roots(t1sph, t2sph, sdisc, d, b, c);
+
+        const float z1sph = r.oz[l] + t1sph*Dz ;
+        const float z2sph = r.oz[l] + t2sph*Dz ;
+
+        const float idz = 1.f/Dz ;
+        const float t_QCAP = (zmax - r.oz[l])*idz ;
+        const float t_PCAP = (zmin - r.oz[l])*idz ;
+
+        float t1cap = packet_fminf( t_QCAP, t_PCAP ) ;
+        float t2cap = packet_fmaxf( t_QCAP, t_PCAP ) ;
+        t1cap = packet_select( ( t1cap < t1sph ) | ( t1cap > t2sph ), tm, t1cap ) ;
+        t2cap = packet_select( ( t2cap < t1sph ) | ( t2cap > t2sph ), tm, t2cap ) ;
+
+        const bool q1sph = ( t1sph > tm ) & ( z1sph > zmin ) & ( z1sph <= zmax ) ;
+        const bool q2sph = ( t2sph > tm ) & ( z2sph > zmin ) & ( z2sph <= zmax ) ;
+
+        float t_cand = packet_select( q2sph,      t2sph, tm ) ;
+        t_cand = packet_select( t2cap > tm, t2cap, t_cand ) ;
+        t_cand = packet_select( t1cap > tm, t1cap, t_cand ) ;
+        t_cand = packet_select( q1sph,      t1sph, t_cand ) ;
+        t_cand = packet_select( sdisc > 0.f, t_cand, tm ) ;
+
+        const bool valid = !away & ( t_cand > tm ) ;
+        const bool sph = ( t_cand == t1sph ) | ( t_cand == t2sph ) ;
+
+        const float nx = (Ox + t_cand*Dx)/radius ;
+        const float ny = (Oy + t_cand*Dy)/radius ;
+        const float nz = (Oz + t_cand*Dz)/radius ;
+
+        is.nx[l] = packet_select( valid, packet_select( sph, nx, 0.f ), is.nx[l] ) ;
+        is.ny[l] = packet_select( valid, packet_select( sph, ny, 0.f ), is.ny[l] ) ;
+        is.nz[l] = packet_select( valid, packet_select( sph, nz, packet_select( t_cand == t_PCAP, -1.f, 1.f )), is.nz[l] ) ;
+        is.t[l]  = packet_select( valid, t_cand, is.t[l] ) ;
+        is.valid[l] = valid ;
+    }
+}
+
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_cylinder( csg_isect<W>& is, const quad& q0, const quad& q1, const float* t_min, const csg_rays<W>& r_ )
+{
+    const float r  = q0.f.w ;
+    const float z1 = q1.f.x ;
+    const float z2 = q1.f.y ;
+    const float r2 = r*r ;
+
+    for(int l=0 ; l < W ; l++)
+    {
+        const float ox = r_.ox[l] ;
+        const float oy = r_.oy[l] ;
+        const float oz = r_.oz[l] ;
+        const float vx = r_.dx[l] ;
+        const float vy = r_.dy[l] ;
+        const float vz = r_.dz[l] ;
+        const float tm = t_min[l] ;
+
+        const float a = vx*vx + vy*vy ;
+        const float b = ox*vx + oy*vy ;
+        const float c = ox*ox + oy*oy - r2 ;
+
+        float t_near, t_far, sdisc ;
+        packet_quadratic_roots_disqualifying(tm, t_near, t_far, sdisc, a, b, c);
+        const float z_near = oz+t_near*vz ;
+        const float z_far  = oz+t_far*vz ;
+
+        const float t_z1cap = (z1 - oz)/vz ;
+        const float r2_z1cap = (ox+t_z1cap*vx)*(ox+t_z1cap*vx) + (oy+t_z1cap*vy)*(oy+t_z1cap*vy) ;
+
+        const float t_z2cap = (z2 - oz)/vz ;
+        const float r2_z2cap = (ox+t_z2cap*vx)*(ox+t_z2cap*vx) + (oy+t_z2cap*vy)*(oy+t_z2cap*vy) ;
+
+        float t_cand = CUDART_INF_F ;
+        t_cand = packet_select( ( t_near  > tm ) & ( z_near   > z1 ) & ( z_near < z2 ) & ( t_near  < t_cand ), t_near,  t_cand ) ;
+        t_cand = packet_select( ( t_far   > tm ) & ( z_far    > z1 ) & ( z_far  < z2 ) & ( t_far   < t_cand ), t_far,   t_cand ) ;
+        t_cand = packet_select( ( t_z1cap > tm ) & ( r2_z1cap <= r2 )                  & ( t_z1cap < t_cand ), t_z1cap, t_cand ) ;
+        t_cand = packet_select( ( t_z2cap > tm ) & ( r2_z2cap <= r2 )                  & ( t_z2cap < t_cand ), t_z2cap, t_cand ) ;
+
+        const bool valid = ( t_cand > tm ) & ( t_cand < CUDART_INF_F ) ;
+        const bool sheet = ( t_cand == t_near ) | ( t_cand == t_far ) ;
+
+        const float nx = (ox + t_cand*vx)/r ;
+        const float ny = (oy + t_cand*vy)/r ;
+
+        is.nx[l] = packet_select( valid, packet_select( sheet, nx, 0.f ), is.nx[l] ) ;
+        is.ny[l] = packet_select( valid, packet_select( sheet, ny, 0.f ), is.ny[l] ) ;
+        is.nz[l] = packet_select( valid, packet_select( sheet, 0.f, packet_select( t_cand == t_z1cap, -1.f, 1.f )), is.nz[l] ) ;
+        is.t[l]  = packet_select( valid, t_cand, is.t[l] ) ;
+        is.valid[l] = valid ;
+    }
+}
+
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_box3( csg_isect<W>& is, const quad& q0, const float* t_min, const csg_rays<W>& r )
+{
+    const float bminx = -q0.f.x/2.f ;
+    const float bminy = -q0.f.y/2.f ;
+    const float bminz = -q0.f.z/2.f ;
+    const float bmaxx =  q0.f.x/2.f ;
+    const float bmaxy =  q0.f.y/2.f ;
+    const float bmaxz =  q0.f.z/2.f ;
+
+    for(int l=0 ; l < W ; l++)
+    {
+        const float ox = r.ox[l] ;
+        const float oy = r.oy[l] ;
+        const float oz = r.oz[l] ;
+        const float dx = r.dx[l] ;
+        const float dy = r.dy[l] ;
+        const float dz = r.dz[l] ;
+        const float tm = t_min[l] ;
+
+        const float idx = 1.f/dx ;
+        const float idy = 1.f/dy ;
+        const float idz = 1.f/dz ;
+
+        const float t0x = (bminx - ox)*idx ;
+        const float t0y = (bminy - oy)*idy ;
+        const float t0z = (bminz - oz)*idz ;
+        const float t1x = (bmaxx - ox)*idx ;
+        const float t1y = (bmaxy - oy)*idy ;
+        const float t1z = (bmaxz - oz)*idz ;
+
+        const float t_near = packet_fmaxf( packet_fmaxf( packet_fminf(t0x,t1x), packet_fminf(t0y,t1y) ), packet_fminf(t0z,t1z) ) ;
+        const float t_far  = packet_fminf( packet_fminf( packet_fmaxf(t0x,t1x), packet_fmaxf(t0y,t1y) ), packet_fmaxf(t0z,t1z) ) ;
+
+        const bool along_x = ( dx != 0.f ) & ( dy == 0.f ) & ( dz == 0.f ) ;
+        const bool along_y = ( dx == 0.f ) & ( dy != 0.f ) & ( dz == 0.f ) ;
+        const bool along_z = ( dx == 0.f ) & ( dy == 0.f ) & ( dz != 0.f ) ;
+
+        const bool in_x = ( ox > bminx ) & ( ox < bmaxx ) ;
+        const bool in_y = ( oy > bminy ) & ( oy < bmaxy ) ;
+        const bool in_z = ( oz > bminz ) & ( oz < bmaxz ) ;
+
+        const bool has_intersect = ( along_x & in_y & in_z ) |
+                                   ( along_y & in_x & in_z ) |
+                                   ( along_z & in_x & in_y ) |
+                                   ( !along_x & !along_y & !along_z & ( t_far > t_near ) & ( t_far > 0.f )) ;
+
+        const float t_cand = packet_select( tm < t_near, t_near, packet_select( tm < t_far, t_far, tm )) ;
+
+        const float px = ox + t_cand*dx ;
+        const float py = oy + t_cand*dy ;
+        const float pz = oz + t_cand*dz ;
+
+        const float pax = fabs(px)/(bmaxx - bminx) ;
+        const float pay = fabs(py)/(bmaxy - bminy) ;
+        const float paz = fabs(pz)/(bmaxz - bminz) ;
+
+        const bool sx = ( pax >= pay ) & ( pax >= paz ) ;
+        const bool sy = !sx & ( pay >= pax ) & ( pay >= paz ) ;
+        const bool sz = !sx & !sy & ( paz >= pax ) & ( paz >= pay ) ;
+
+        const bool valid = has_intersect & ( t_cand > tm ) ;
+
+        const float nx = copysignf( 1.f, px ) ;
+        const float ny = copysignf( 1.f, py ) ;
+        const float nz = copysignf( 1.f, pz ) ;
+
+        is.nx[l] = packet_select( valid, packet_select( sx, nx, 0.f ), is.nx[l] ) ;
+        is.ny[l] = packet_select( valid, packet_select( sy, ny, 0.f ), is.ny[l] ) ;
+        is.nz[l] = packet_select( valid, packet_select( sz, nz, 0.f ), is.nz[l] ) ;
+        is.t[l]  = packet_select( valid, t_cand, is.t[l] ) ;
+        is.valid[l] = valid ;
+    }
+}
+
+
+/**
+intersect_packet_convexpolyhedron
+-----------------------------------
+
+Planes in the outer loop and lanes in the inner loop. Note that as with
+the scalar function a lane can be valid without the isect being updated
+when both plane intersects are behind t_min.
+
+**/
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_convexpolyhedron( csg_isect<W>& is, const CSGNode* node, const float4* plan, const float* t_min, const csg_rays<W>& r )
+{
+    float t0[W], t1[W] ;
+    float n0x[W], n0y[W], n0z[W] ;
+    float n1x[W], n1y[W], n1z[W] ;
+    int   outside[W] ;
+
+    for(int l=0 ; l < W ; l++)
+    {
+        t0[l] = -CUDART_INF_F ;
+        t1[l] =  CUDART_INF_F ;
+        n0x[l] = 0.f ; n0y[l] = 0.f ; n0z[l] = 0.f ;
+        n1x[l] = 0.f ; n1y[l] = 0.f ; n1z[l] = 0.f ;
+        outside[l] = 0 ;
+    }
+
+    unsigned planeIdx = node->planeIdx() ;
+    unsigned planeNum = node->planeNum() ;
+
+    for(unsigned i=0 ; i < planeNum ; i++)
+    {
+        const float4& plane = plan[planeIdx+i];
+
+        for(int l=0 ; l < W ; l++)
+        {
+            const float nd = plane.x*r.dx[l] + plane.y*r.dy[l] + plane.z*r.dz[l] ;
+            const float no = plane.x*r.ox[l] + plane.y*r.oy[l] + plane.z*r.oz[l] ;
+            const float dist = no - plane.w ;
+            const float t_cand = -dist/nd ;
+
+            const bool parallel_inside  = ( nd == 0.f ) & ( dist < 0.f ) ;
+            const bool parallel_outside = ( nd == 0.f ) & ( dist > 0.f ) ;
+            const bool live = !parallel_inside & !parallel_outside & ( outside[l] == 0 ) ;
+
+            const bool enter = live &  ( nd < 0.f ) & ( t_cand > t0[l] ) ;
+            const bool exit  = live & !( nd < 0.f ) & ( t_cand < t1[l] ) ;
+
+            t0[l]  = packet_select( enter, t_cand,  t0[l] ) ;
+            n0x[l] = packet_select( enter, plane.x, n0x[l] ) ;
+            n0y[l] = packet_select( enter, plane.y, n0y[l] ) ;
+            n0z[l] = packet_select( enter, plane.z, n0z[l] ) ;
+
+            t1[l]  = packet_select( exit, t_cand,  t1[l] ) ;
+            n1x[l] = packet_select( exit, plane.x, n1x[l] ) ;
+            n1y[l] = packet_select( exit, plane.y, n1y[l] ) ;
+            n1z[l] = packet_select( exit, plane.z, n1z[l] ) ;
+
+            outside[l] |= int(parallel_outside) ;
+        }
+    }
+
+    for(int l=0 ; l < W ; l++)
+    {
+        const bool valid = ( outside[l] == 0 ) & ( t0[l] < t1[l] ) ;
+        const bool use0 = valid & ( t0[l] > t_min[l] ) ;
+        const bool use1 = valid & !use0 & ( t1[l] > t_min[l] ) ;
+
+        is.nx[l] = packet_select( use0, n0x[l], packet_select( use1, n1x[l], is.nx[l] )) ;
+        is.ny[l] = packet_select( use0, n0y[l], packet_select( use1, n1y[l], is.ny[l] )) ;
+        is.nz[l] = packet_select( use0, n0z[l], packet_select( use1, n1z[l], is.nz[l] )) ;
+        is.t[l]  = packet_select( use0, t0[l],  packet_select( use1, t1[l],  is.t[l] )) ;
+        is.valid[l] = valid ;
+    }
+}
+
+
+/**
+intersect_packet_leaf
+-----------------------
+
+Packet equivalent of *intersect_leaf*. Typecodes without a packet
+implementation use the scalar *intersect_leaf* for each lane.
+
+**/
+
+template<int W>
+LEAF_FUNC
+void intersect_packet_leaf( csg_isect<W>& is, const CSGNode* node, const float4* plan, const qat4* itra, const float* t_min, const csg_rays<W>& ray )
+{
+    const unsigned typecode = node->typecode() ;
+    const unsigned gtransformIdx = node->gtransformIdx() ;
+    const bool complement = node->is_complement();
+
+    const qat4* q = gtransformIdx > 0 ? itra + gtransformIdx - 1 : nullptr ;
+
+    bool packet = typecode == CSG_SPHERE || typecode == CSG_ZSPHERE || typecode == CSG_CYLINDER || typecode == CSG_BOX3 || typecode == CSG_CONVEXPOLYHEDRON ;
+    if(!packet)
+    {
+        for(int l=0 ; l < W ; l++)
+        {
+            float4 isect = is.get(l) ;
+            is.valid[l] = intersect_leaf( isect, node, plan, itra, t_min[l], ray.origin(l), ray.direction(l) ) ;
+            is.set(l, isect) ;
+        }
+        return ;   // intersect_leaf does the normal transform and complement
+    }
+
+    // local copies allow the compiler to if-convert the lane loops, as locals cannot trap or race
+    csg_isect<W> lis = is ;
+    float tm[W] ;
+    for(int l=0 ; l < W ; l++) tm[l] = t_min[l] ;
+
+    csg_rays<W> loc ;
+    if(q) csg_rays_transform<W>( loc, q, ray ) ;
+    else loc = ray ;
+
+    switch(typecode)
+    {
+        case CSG_SPHERE:           intersect_packet_sphere<W>(           lis, node->q0,           tm, loc ) ; break ;
+        case CSG_ZSPHERE:          intersect_packet_zsphere<W>(          lis, node->q0, node->q1, tm, loc ) ; break ;
+        case CSG_CYLINDER:         intersect_packet_cylinder<W>(         lis, node->q0, node->q1, tm, loc ) ; break ;
+        case CSG_BOX3:             intersect_packet_box3<W>(             lis, node->q0,           tm, loc ) ; break ;
+        case CSG_CONVEXPOLYHEDRON: intersect_packet_convexpolyhedron<W>( lis, node, plan,         tm, loc ) ; break ;
+    }
+
+    if(q)
+    {
+        for(int l=0 ; l < W ; l++)
+        {
+            const float x = q->q0.f.x * lis.nx[l] + q->q0.f.y * lis.ny[l] + q->q0.f.z * lis.nz[l] + q->q0.f.w * 0.f ;
+            const float y = q->q1.f.x * lis.nx[l] + q->q1.f.y * lis.ny[l] + q->q1.f.z * lis.nz[l] + q->q1.f.w * 0.f ;
+            const float z = q->q2.f.x * lis.nx[l] + q->q2.f.y * lis.ny[l] + q->q2.f.z * lis.nz[l] + q->q2.f.w * 0.f ;
+            const bool valid = lis.valid[l] ;
+            lis.nx[l] = packet_select( valid, x, lis.nx[l] ) ;
+            lis.ny[l] = packet_select( valid, y, lis.ny[l] ) ;
+            lis.nz[l] = packet_select( valid, z, lis.nz[l] ) ;
+        }
+    }
+
+    if(complement)  // flip normal of valid, signal complement with isect.x of miss
+    {
+        for(int l=0 ; l < W ; l++)
+        {
+            const bool valid = lis.valid[l] ;
+            const float ny = -lis.ny[l] ;
+            const float nz = -lis.nz[l] ;
+            lis.nx[l] = -lis.nx[l] ;
+            lis.ny[l] = packet_select( valid, ny, lis.ny[l] ) ;
+            lis.nz[l] = packet_select( valid, nz, lis.nz[l] ) ;
+        }
+    }
+
+    is = lis ;
+}
+
+
+/**
+intersect_packet_prim
+-----------------------
+
+Packet equivalent of *intersect_prim*.
+
+**/
+
+template<int W>
+TREE_FUNC
+void intersect_packet_prim( csg_isect<W>& is, const CSGNode* node, const float4* plan, const qat4* itra, const float* t_min, const csg_rays<W>& ray )
+{
+    const unsigned typecode = node->typecode() ;
+    if( typecode >= CSG_LEAF )
+    {
+        intersect_packet_leaf<W>( is, node, plan, itra, t_min, ray );
+    }
+    else
+    {
+        for(int l=0 ; l < W ; l++)
+        {
+            float4 isect = is.get(l) ;
+            is.valid[l] = intersect_prim( isect, node, plan, itra, t_min[l], ray.origin(l), ray.direction(l) ) ;
+            is.set(l, isect) ;
+        }
+    }
+}
+
+#endif
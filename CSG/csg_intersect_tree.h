@@ -261,18 +261,31 @@ so it looks like tree balanching and the CSG algorithm as it stands are not comp
 TODO: need to confirm exactly what is happening using CSGRecord, have not extinguished all hope of getting balanced
 to work yet, as it seems like it should be possible in principle.
 
+
+intersect_tree_<H>
+~~~~~~~~~~~~~~~~~~~~
+
+H is the tree height when known at compile time, or -1 for the generic runtime height.
+With a compile time height the elevation arithmetic folds to constants and the 
+CSG and tranche stacks are sized exactly at H+1 rather than the generic 15 and 4 
+entries, which matters on device where the stacks live in local memory. 
+
+Note that with H=4 the generic tranche stack of 4 can overflow when looping 
+happens at every elevation, the exact size of 5 avoids that ERROR_TRANCHE_OVERFLOW.  
+
 **/
 
+template<int H>
 TREE_FUNC
-bool intersect_tree( float4& isect, const CSGNode* node, const float4* plan0, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction )
+bool intersect_tree_( float4& isect, const CSGNode* node, const float4* plan0, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction )
 {
     const int numNode=node->subNum() ;   // SO THIS SHOULD NO LONGER EVER BE 1 
-    unsigned height = TREE_HEIGHT(numNode) ; // 1->0, 3->1, 7->2, 15->3, 31->4 
+    const unsigned height = H < 0 ? TREE_HEIGHT(numNode) : H ; // 1->0, 3->1, 7->2, 15->3, 31->4 
     float propagate_epsilon = 0.0001f ;  // ? 
     int ierr = 0 ;  
 
     LUT lut ; 
-    Tranche tr ; 
+    Tranche_<H < 0 ? TRANCHE_STACK_SIZE : H+1> tr ; 
     tr.curr = -1 ;
 
     unsigned fullTree = PACK4(0,0, 1 << height, 0 ) ;  // leftmost: 1<<height,  root:1>>1 = 0 ("parent" of root)  
@@ -284,7 +297,7 @@ bool intersect_tree( float4& isect, const CSGNode* node, const float4* plan0, co
 
     tranche_push( tr, fullTree, t_min );
 
-    CSG_Stack csg ;  
+    CSG_Stack_<H < 0 ? CSG_STACK_SIZE : H+1> csg ;  
     csg.curr = -1 ;
     int tloop = -1 ; 
 
@@ -622,6 +635,136 @@ bool intersect_tree( float4& isect, const CSGNode* node, const float4* plan0, co
     return isect.w > 0.f ;  // ? 
 }
 
+/**
+intersect_tree_<1>
+~~~~~~~~~~~~~~~~~~~~
+
+Height 1 trees, a single boolean operator with two leaves, are the most common
+trees in practice. For them the postorder traversal is fully unrolled : the two 
+leaf intersects are held in registers and looping just re-intersects one leaf 
+with advanced tmin, so no CSG or tranche stacks are needed.  
+
+The decisions and the values returned follow the generic traversal exactly, 
+including the classification of both sides at the original t_min after looping.
+Malformed trees (CSG_ZERO or operator children) use the generic traversal to get the same errors.
+
+**/
+
+template<>
+TREE_FUNC
+bool intersect_tree_<1>( float4& isect, const CSGNode* node, const float4* plan0, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction )
+{
+    const CSGNode* lnd = node + 1 ; 
+    const CSGNode* rnd = node + 2 ; 
+    OpticksCSG_t typecode = (OpticksCSG_t)node->typecode() ;
+
+    bool leaves = lnd->typecode() >= CSG_NODE && rnd->typecode() >= CSG_NODE ; 
+    if( typecode == CSG_ZERO || !leaves ) return intersect_tree_<-1>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+
+    float propagate_epsilon = 0.0001f ; 
+    LUT lut ; 
+
+    float4 l = make_float4(0.f, 0.f, 0.f, 0.f) ; 
+    float4 r = make_float4(0.f, 0.f, 0.f, 0.f) ; 
+
+    intersect_node( l, lnd, node, plan0, itra0, t_min, ray_origin, ray_direction );
+    intersect_node( r, rnd, node, plan0, itra0, t_min, ray_origin, ray_direction );
+    l.w = copysignf( l.w, -1.f );   // LHS -ve, as nodeIdx 2 
+    r.w = copysignf( r.w,  1.f );   // RHS +ve, as nodeIdx 3 
+
+    while(true)
+    {
+        IntersectionState_t l_state = CSG_CLASSIFY( l, ray_direction, t_min );
+        IntersectionState_t r_state = CSG_CLASSIFY( r, ray_direction, t_min );
+
+        float t_left  = fabsf( l.w );
+        float t_right = fabsf( r.w );
+        bool leftIsCloser = t_left <= t_right ;
+
+        bool l_promote_miss = l_state == State_Miss && ( signbit(l.x) || signbit(l.y) ) ;  // complement or unbounded 
+        bool r_promote_miss = r_state == State_Miss && ( signbit(r.x) || signbit(r.y) ) ;
+
+        if(r_promote_miss)
+        {
+            r_state = State_Exit ; 
+            leftIsCloser = true ; 
+        }
+        if(l_promote_miss)
+        {
+            l_state = State_Exit ; 
+            leftIsCloser = false ; 
+        }
+
+        int ctrl = lut.lookup( typecode , l_state, r_state, leftIsCloser ) ;
+
+        if(ctrl < CTRL_LOOP_A)
+        {
+            float4 result = ctrl == CTRL_RETURN_MISS ?  make_float4(0.f, 0.f, 0.f, 0.f ) : ( ctrl == CTRL_RETURN_A ? l : r ) ;
+            if(ctrl == CTRL_RETURN_FLIP_B)
+            {
+                result.x = -result.x ;     
+                result.y = -result.y ;     
+                result.z = -result.z ;     
+            }
+            result.w = copysignf( result.w , 1.f );  // root nodeIdx 1 
+            isect = result ; 
+            break ; 
+        }
+        else if(ctrl == CTRL_LOOP_A)
+        {
+            float tminAdvanced = t_left + propagate_epsilon ;
+            l = make_float4(0.f, 0.f, 0.f, 0.f) ; 
+            intersect_node( l, lnd, node, plan0, itra0, tminAdvanced, ray_origin, ray_direction );
+            l.w = copysignf( l.w, -1.f ); 
+        }
+        else
+        {
+            float tminAdvanced = t_right + propagate_epsilon ;
+            r = make_float4(0.f, 0.f, 0.f, 0.f) ; 
+            intersect_node( r, rnd, node, plan0, itra0, tminAdvanced, ray_origin, ray_direction );
+            r.w = copysignf( r.w,  1.f ); 
+        }
+    }
+    return isect.w > 0.f ; 
+}
+
+
+/**
+intersect_tree
+----------------
+
+Dispatches on the numNode of the tree to the height specialized intersect_tree_<H>. 
+Height 1 (numNode 3) uses the unrolled intersect_tree_<1> everywhere. Heights 2 to 4 
+(numNode 7,15,31) use the exactly sized stacks only on device where they live in local 
+memory, on host they measure no faster than the generic runtime height traversal 
+which is used for all other trees. Single leaf prims never reach here, see intersect_prim, 
+so there is no height 0 instantiation. 
+
+The generic traversal is always used with DEBUG or DEBUG_RECORD as the specializations
+do not record or print, or when compiled with CSG_TREE_GENERIC for comparison. 
+
+**/
+
+TREE_FUNC
+bool intersect_tree( float4& isect, const CSGNode* node, const float4* plan0, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction )
+{
+#if defined(DEBUG) || defined(DEBUG_RECORD) || defined(CSG_TREE_GENERIC)
+    return intersect_tree_<-1>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+#else
+    const int numNode = node->subNum() ; 
+    switch( numNode )
+    {
+        case  3: return intersect_tree_<1>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+#if defined(__CUDACC__) || defined(__CUDABE__)
+        case  7: return intersect_tree_<2>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+        case 15: return intersect_tree_<3>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+        case 31: return intersect_tree_<4>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+#endif
+    }
+    return intersect_tree_<-1>( isect, node, plan0, itra0, t_min, ray_origin, ray_direction ); 
+#endif
+}
+
 /**
 intersect_prim
 ----------------
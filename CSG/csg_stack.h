@@ -24,32 +24,41 @@ csg_push
 csg_pop
     pop float4 isect and nodeIdx off the stack   
 
+CSG_Stack_<N> is sized by template parameter, allowing intersect_tree_<H> 
+to use exactly H+1 entries for trees of height H. CSG_Stack is the 
+generic size used when the height is only known at runtime. 
+
 2**/
 
 #define CSG_STACK_SIZE 15
 
-struct CSG_Stack 
+template<int N>
+struct CSG_Stack_ 
 {
-   float4 data[CSG_STACK_SIZE] ; 
-   unsigned idx[CSG_STACK_SIZE] ; 
+   float4 data[N] ; 
+   unsigned idx[N] ; 
    int curr ;
 };
 
+typedef CSG_Stack_<CSG_STACK_SIZE> CSG_Stack ; 
+
+template<int N>
 CSG_FUNC 
-int csg_push(CSG_Stack& csg, const float4& isect, unsigned nodeIdx)
+int csg_push(CSG_Stack_<N>& csg, const float4& isect, unsigned nodeIdx)
 {
 #ifdef DEBUG
-     assert( csg.curr < CSG_STACK_SIZE ); 
+     assert( csg.curr < N ); 
 #endif
-    if(csg.curr >= CSG_STACK_SIZE - 1) return ERROR_OVERFLOW ; 
+    if(csg.curr >= N - 1) return ERROR_OVERFLOW ; 
     csg.curr++ ; 
     csg.data[csg.curr] = isect ; 
     csg.idx[csg.curr] = nodeIdx ; 
 
     return 0 ; 
 }
+template<int N>
 CSG_FUNC 
-int csg_pop(CSG_Stack& csg, float4& isect, unsigned& nodeIdx)
+int csg_pop(CSG_Stack_<N>& csg, float4& isect, unsigned& nodeIdx)
 {
     if(csg.curr < 0) return ERROR_POP_EMPTY ;     
     isect = csg.data[csg.curr] ;
@@ -59,8 +68,9 @@ int csg_pop(CSG_Stack& csg, float4& isect, unsigned& nodeIdx)
     return 0 ; 
 }
 
+template<int N>
 CSG_FUNC 
-int csg_pop0(CSG_Stack& csg)   // pop without returning anything 
+int csg_pop0(CSG_Stack_<N>& csg)   // pop without returning anything 
 {
     if(csg.curr < 0) return ERROR_POP_EMPTY ;     
     csg.idx[csg.curr] = 0u ;   // scrub the idx for debug
@@ -68,8 +78,9 @@ int csg_pop0(CSG_Stack& csg)   // pop without returning anything
     return 0 ; 
 }
 
+template<int N>
 CSG_FUNC 
-unsigned long long csg_repr(CSG_Stack& csg)
+unsigned long long csg_repr(CSG_Stack_<N>& csg)
 {
     unsigned long long val = 0 ; 
     if(csg.curr == -1) return val ; 
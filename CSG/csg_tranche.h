@@ -25,31 +25,39 @@ tranche_pop
 tranche_repr
     representation of the stack of slices packed into a 64 bit unsigned long long  
 
+Tranche_<N> is sized by template parameter, intersect_tree_<H> uses H+1 
+which is the most that looping at every elevation can need. 
+
 1**/
 
 #define TRANCHE_STACK_SIZE 4
 
 
-struct Tranche
+template<int N>
+struct Tranche_
 {
-    float      tmin[TRANCHE_STACK_SIZE] ;  
-    unsigned  slice[TRANCHE_STACK_SIZE] ; 
+    float      tmin[N] ;  
+    unsigned  slice[N] ; 
     int curr ;
 };
 
+typedef Tranche_<TRANCHE_STACK_SIZE> Tranche ; 
+
 
+template<int N>
 TRANCHE_FUNC
-int tranche_push(Tranche& tr, const unsigned slice, const float tmin)
+int tranche_push(Tranche_<N>& tr, const unsigned slice, const float tmin)
 {
-    if(tr.curr >= TRANCHE_STACK_SIZE - 1) return ERROR_TRANCHE_OVERFLOW ; 
+    if(tr.curr >= N - 1) return ERROR_TRANCHE_OVERFLOW ; 
     tr.curr++ ; 
     tr.slice[tr.curr] = slice  ; 
     tr.tmin[tr.curr] = tmin ; 
     return 0 ; 
 }
 
+template<int N>
 TRANCHE_FUNC
-int tranche_pop(Tranche& tr, unsigned& slice, float& tmin)
+int tranche_pop(Tranche_<N>& tr, unsigned& slice, float& tmin)
 {
     if(tr.curr < 0) return ERROR_POP_EMPTY  ; 
     slice = tr.slice[tr.curr] ;
@@ -58,8 +66,9 @@ int tranche_pop(Tranche& tr, unsigned& slice, float& tmin)
     return 0 ; 
 }
 
+template<int N>
 TRANCHE_FUNC
-unsigned long long tranche_repr(Tranche& tr)
+unsigned long long tranche_repr(Tranche_<N>& tr)
 {
     unsigned long long val = 0ull ; 
     if(tr.curr == -1) return val ; 
@@ -0,0 +1,407 @@
+/**
+CSGBVHTest.cc
+===============
+
+Compares closest hits found with CSGBVH.h traversal against brute force
+over all items, for a single level of random spheres and for a two level
+structure of instanced sphere sets using qat4::inverse_affine to bring rays
+into the instance frame as CSGQuery::trace does. Also checks that exponentially
+spaced items, which binned SAH peels off a few at a time, keep the tree depth
+within the traversal stack.
+
+::
+
+    ~/opticks/CSG/tests/CSGBVHTest.sh
+    NUM=100000 NUM_ITEM=10000 ~/opticks/CSG/tests/CSGBVHTest.sh
+
+**/
+
+#include <cstdio>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "CSGBVH.h"
+
+struct CSGBVHTest
+{
+    int num ;
+    int num_item ;
+    int num_inst ;
+
+    std::mt19937 gen ;
+    std::uniform_real_distribution<float> u ;
+
+    std::vector<float4> sphere ;   // center, radius
+    std::vector<float>  aabb ;
+    CSGBVH gas ;
+
+    std::vector<qat4>  inst ;
+    std::vector<qat4>  itra ;
+    std::vector<float> inst_aabb ;
+    CSGBVH ias ;
+
+    std::vector<float3> ori ;
+    std::vector<float3> dir ;
+
+    CSGBVHTest();
+    void init_spheres();
+    void init_instances();
+    void init_rays();
+
+    static bool IntersectSphere( float& t, const float4& sp, const float3& o, const float3& d, float t_min, float t_max );
+
+    bool trace_gas( float& t, int& idx, const float3& o, const float3& d, bool linear ) const ;
+    bool trace_ias( float& t, int& ins, int& idx, const float3& o, const float3& d, bool linear ) const ;
+
+    int check_gas();
+    int check_ias();
+    int check_deep();
+};
+
+CSGBVHTest::CSGBVHTest()
+    :
+    num(ssys::getenvint("NUM", 10000)),
+    num_item(ssys::getenvint("NUM_ITEM", 2000)),
+    num_inst(ssys::getenvint("NUM_INST", 200)),
+    gen(42),
+    u(-1.f, 1.f)
+{
+    init_spheres();
+    init_instances();
+    init_rays();
+}
+
+void CSGBVHTest::init_spheres()
+{
+    for(int i=0 ; i < num_item ; i++)
+    {
+        float r = 1.f + 4.f*fabsf(u(gen)) ;
+        float4 sp = make_float4( 500.f*u(gen), 500.f*u(gen), 100.f*u(gen), r ) ;
+        sphere.push_back(sp);
+        float bb[6] = { sp.x - r, sp.y - r, sp.z - r, sp.x + r, sp.y + r, sp.z + r } ;
+        aabb.insert( aabb.end(), bb, bb + 6 );
+    }
+    gas.build( aabb.data(), num_item );
+    printf("gas %s\n", gas.desc().c_str() );
+}
+
+/**
+CSGBVHTest::init_instances
+----------------------------
+
+Random rotation about z with scaling and translation, with identity
+info in the .w column that must not disturb the transforms.
+
+**/
+
+void CSGBVHTest::init_instances()
+{
+    float gb[6] ;
+    bool ok = gas.get_bounds(gb) ;
+    assert(ok);
+
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        float a = 3.14159f*u(gen) ;
+        float s = 0.5f + 0.25f*(1.f + u(gen)) ;
+        qat4 t ;
+        t.q0.f = make_float4(  s*cosf(a), s*sinf(a), 0.f, 0.f );
+        t.q1.f = make_float4( -s*sinf(a), s*cosf(a), 0.f, 0.f );
+        t.q2.f = make_float4( 0.f, 0.f, s, 0.f );
+        t.q3.f = make_float4( 5000.f*u(gen), 5000.f*u(gen), 5000.f*u(gen), 1.f );
+        t.setIdentity( i, 0, i % 7, i );
+        inst.push_back(t);
+
+        qat4 v ;
+        ok = t.inverse_affine(v) ;
+        assert(ok);
+        itra.push_back(v);
+
+        float bb[6] ;
+        for(int j=0 ; j < 6 ; j++) bb[j] = gb[j] ;
+        qat4 c(t.cdata()) ;
+        c.clearIdentity();
+        c.transform_aabb_inplace(bb);
+        inst_aabb.insert( inst_aabb.end(), bb, bb + 6 );
+    }
+    ias.build( inst_aabb.data(), num_inst );
+    printf("ias %s\n", ias.desc().c_str() );
+}
+
+/**
+CSGBVHTest::init_rays
+-----------------------
+
+Half the rays aimed at random sphere centers, some axis aligned.
+
+**/
+
+void CSGBVHTest::init_rays()
+{
+    for(int i=0 ; i < num ; i++)
+    {
+        float3 o = make_float3( 600.f*u(gen), 600.f*u(gen), 200.f*u(gen) ) ;
+        float3 d ;
+        switch(i % 8)
+        {
+            case 0: d = make_float3( 1.f, 0.f, 0.f ) ; break ;
+            case 1: d = make_float3( 0.f, 0.f,-1.f ) ; break ;
+            case 2: case 3: case 4: { const float4& sp = sphere[i % num_item] ; d = normalize(make_float3(sp.x, sp.y, sp.z) - o) ; } ; break ;
+            default: d = normalize(make_float3( u(gen), u(gen), u(gen) )) ; break ;
+        }
+        ori.push_back(o);
+        dir.push_back(d);
+    }
+}
+
+/**
+CSGBVHTest::IntersectSphere
+-----------------------------
+
+Uses the distance of closest approach, avoiding the cancellation in
+dot(oc,oc) - r*r for distant origins that otherwise gives hits outside
+the sphere bounds that the BVH (like OptiX) rightly culls.
+
+**/
+
+inline bool CSGBVHTest::IntersectSphere( float& t, const float4& sp, const float3& o, const float3& d, float t_min, float t_max )
+{
+    float3 oc = o - make_float3( sp.x, sp.y, sp.z ) ;
+    float a = dot(d, d) ;
+    float tc = -dot(oc, d)/a ;
+    float3 f = oc + tc*d ;
+    float h2 = ( sp.w*sp.w - dot(f, f) )/a ;
+    if( h2 < 0.f ) return false ;
+    float h = sqrtf(h2) ;
+    float t0 = tc - h ;
+    float t1 = tc + h ;
+    float tt = t0 > t_min ? t0 : t1 ;
+    if(!( tt > t_min && tt < t_max )) return false ;
+    t = tt ;
+    return true ;
+}
+
+bool CSGBVHTest::trace_gas( float& t, int& idx, const float3& o, const float3& d, bool linear ) const
+{
+    const float t_min = 0.f ;
+    float t_max = 1e16f ;
+    auto intersect_item = [&](int i, float& t_max_) -> bool
+    {
+        float ti ;
+        if(!IntersectSphere(ti, sphere[i], o, d, t_min, t_max_)) return false ;
+        t_max_ = ti ;
+        idx = i ;
+        return true ;
+    };
+
+    bool hit = false ;
+    if(linear)
+    {
+        for(int i=0 ; i < num_item ; i++) if(intersect_item(i, t_max)) hit = true ;
+    }
+    else
+    {
+        hit = gas.traverse( o, d, t_min, t_max, intersect_item );
+    }
+    t = t_max ;
+    return hit ;
+}
+
+bool CSGBVHTest::trace_ias( float& t, int& ins, int& idx, const float3& o, const float3& d, bool linear ) const
+{
+    const float t_min = 0.f ;
+    float t_max = 1e16f ;
+
+    auto intersect_instance = [&](int i, float& t_max_) -> bool
+    {
+        const qat4& v = itra[i] ;
+        float3 lo = v.right_multiply(o, 1.f) ;
+        float3 ld = v.right_multiply(d, 0.f) ;
+        auto intersect_item = [&](int j, float& t_max__) -> bool
+        {
+            float tj ;
+            if(!IntersectSphere(tj, sphere[j], lo, ld, t_min, t_max__)) return false ;
+            t_max__ = tj ;
+            idx = j ;
+            ins = i ;
+            return true ;
+        };
+        bool hit = false ;
+        if(linear)
+        {
+            for(int j=0 ; j < num_item ; j++) if(intersect_item(j, t_max_)) hit = true ;
+        }
+        else
+        {
+            hit = gas.traverse( lo, ld, t_min, t_max_, intersect_item );
+        }
+        return hit ;
+    };
+
+    bool hit = false ;
+    if(linear)
+    {
+        for(int i=0 ; i < num_inst ; i++) if(intersect_instance(i, t_max)) hit = true ;
+    }
+    else
+    {
+        hit = ias.traverse( o, d, t_min, t_max, intersect_instance );
+    }
+    t = t_max ;
+    return hit ;
+}
+
+int CSGBVHTest::check_gas()
+{
+    int num_hit = 0 ;
+    int num_mismatch = 0 ;
+    double linear_ms = 0. ;
+    double bvh_ms = 0. ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float ta, tb ;
+        int ia = -1, ib = -1 ;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bool ha = trace_gas( ta, ia, ori[i], dir[i], true );
+        auto t1 = std::chrono::high_resolution_clock::now();
+        bool hb = trace_gas( tb, ib, ori[i], dir[i], false );
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        linear_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() ;
+        bvh_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() ;
+
+        if(ha) num_hit += 1 ;
+        bool match = ha == hb && ( !ha || ( ta == tb && ia == ib )) ;
+        if(!match && num_mismatch < 10) printf("//check_gas mismatch i %d ha %d hb %d ta %g tb %g ia %d ib %d \n", i, ha, hb, ta, tb, ia, ib );
+        if(!match) num_mismatch += 1 ;
+    }
+    printf("%20s num %8d num_hit %8d num_mismatch %4d linear_ms %10.3f bvh_ms %10.3f \n", "check_gas", num, num_hit, num_mismatch, linear_ms, bvh_ms );
+    return num_mismatch ;
+}
+
+int CSGBVHTest::check_ias()
+{
+    int num_hit = 0 ;
+    int num_mismatch = 0 ;
+    double linear_ms = 0. ;
+    double bvh_ms = 0. ;
+
+    int nr = std::min( num, 1000 ) ;  // linear reference is slow
+    for(int i=0 ; i < nr ; i++)
+    {
+        // aim at the center of an instance
+        const qat4& t = inst[i % num_inst] ;
+        float3 c = t.right_multiply( make_float3( sphere[i % num_item].x, sphere[i % num_item].y, sphere[i % num_item].z ), 1.f );
+        float3 o = ori[i]*10.f ;
+        float3 d = i % 4 == 0 ? dir[i] : normalize( c - o ) ;
+
+        float ta, tb ;
+        int ia = -1, ib = -1, ja = -1, jb = -1 ;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bool ha = trace_ias( ta, ja, ia, o, d, true );
+        auto t1 = std::chrono::high_resolution_clock::now();
+        bool hb = trace_ias( tb, jb, ib, o, d, false );
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        linear_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() ;
+        bvh_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() ;
+
+        if(ha) num_hit += 1 ;
+        bool match = ha == hb && ( !ha || ( ta == tb && ia == ib && ja == jb )) ;
+        if(!match && num_mismatch < 10) printf("//check_ias mismatch i %d ha %d hb %d ta %g tb %g ia %d ib %d ja %d jb %d \n", i, ha, hb, ta, tb, ia, ib, ja, jb );
+        if(!match) num_mismatch += 1 ;
+    }
+    printf("%20s num %8d num_hit %8d num_mismatch %4d linear_ms %10.3f bvh_ms %10.3f \n", "check_ias", nr, num_hit, num_mismatch, linear_ms, bvh_ms );
+    return num_mismatch ;
+}
+
+/**
+CSGBVHTest::check_deep
+------------------------
+
+Small spheres along the six half axes with exponentially spaced centers and
+radii, 1.5^e for e in [-NUM_DEEP,NUM_DEEP], so the centroid extent at every
+level is dominated by a few of the largest items which SAH peels off, giving
+a tree much deeper than the traversal stack without the median split limit.
+Axis rays from the origin and from outside push a stack entry at most levels.
+Closest hits are compared with brute force.
+
+**/
+
+int CSGBVHTest::check_deep()
+{
+    int num_deep = ssys::getenvint("NUM_DEEP", 200) ;
+    std::vector<float4> deep ;
+    std::vector<float>  deep_aabb ;
+    for(int a=0 ; a < 3 ; a++) for(int s=-1 ; s <= 1 ; s += 2) for(int e=-num_deep ; e <= num_deep ; e++)
+    {
+        float x = s*powf( 1.5f, float(e) ) ;
+        float r = 0.02f*fabsf(x) ;
+        float c[3] = { 0.f, 0.f, 0.f } ;
+        c[a] = x ;
+        deep.push_back( make_float4( c[0], c[1], c[2], r ) );
+        float bb[6] = { c[0] - r, c[1] - r, c[2] - r, c[0] + r, c[1] + r, c[2] + r } ;
+        deep_aabb.insert( deep_aabb.end(), bb, bb + 6 );
+    }
+    int num_item_deep = deep.size() ;
+    CSGBVH bvh ;
+    bvh.build( deep_aabb.data(), num_item_deep );
+    printf("deep %s\n", bvh.desc().c_str() );
+
+    int num_mismatch = bvh.max_depth < CSGBVH::STACK_SIZE ? 0 : 1 ;
+
+    float far = 2.f*powf( 1.5f, float(num_deep) ) ;
+    for(int r=0 ; r < 12 ; r++)
+    {
+        float3 d = make_float3( 0.f, 0.f, 0.f ) ;
+        float* dd = &d.x ;
+        dd[(r/2) % 3] = r % 2 == 0 ? 1.f : -1.f ;
+        float3 o = r < 6 ? make_float3( 0.f, 0.f, 0.f ) : -far*d ;
+
+        float t[2] = { 1e30f, 1e30f } ;
+        int idx[2] = { -1, -1 } ;
+        bool hit[2] = { false, false } ;
+        for(int linear=0 ; linear < 2 ; linear++)
+        {
+            auto intersect_item = [&](int i, float& t_max_) -> bool
+            {
+                float ti ;
+                if(!IntersectSphere(ti, deep[i], o, d, 0.f, t_max_)) return false ;
+                t_max_ = ti ;
+                idx[linear] = i ;
+                return true ;
+            };
+            if(linear)
+            {
+                for(int i=0 ; i < num_item_deep ; i++) if(intersect_item(i, t[linear])) hit[linear] = true ;
+            }
+            else
+            {
+                hit[linear] = bvh.traverse( o, d, 0.f, t[linear], intersect_item );
+            }
+        }
+        bool match = hit[0] == hit[1] && ( !hit[0] || ( t[0] == t[1] && idx[0] == idx[1] )) ;
+        if(!match) printf("//check_deep mismatch r %d hit %d %d idx %d %d \n", r, hit[0], hit[1], idx[0], idx[1] );
+        if(!match) num_mismatch += 1 ;
+    }
+    printf("%20s num %8d max_depth %4d STACK_SIZE %d num_mismatch %4d \n", "check_deep", num_item_deep, bvh.max_depth, CSGBVH::STACK_SIZE, num_mismatch );
+    return num_mismatch ;
+}
+
+int main()
+{
+    CSGBVHTest t ;
+    int rc = 0 ;
+    rc += t.check_gas();
+    rc += t.check_ias();
+    rc += t.check_deep();
+    return rc == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,141 @@
+/**
+CSGInstanceIndexTest.cc
+=========================
+
+Compares CSGInstanceIndex.h lookups with the sqat4.h linear scans over
+an inst vector laid out like a full geometry : a global placeholder 
+followed by runs of instances of several GAS, with sensor identifiers 
+held +1 as CSGFoundry::addInstance does.  
+
+::
+
+    ~/opticks/CSG/tests/CSGInstanceIndexTest.sh
+    NUM=50000 ~/opticks/CSG/tests/CSGInstanceIndexTest.sh
+
+**/
+
+#include <cstdio>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "CSGInstanceIndex.h"
+
+struct CSGInstanceIndexTest
+{
+    int num ;
+    int num_gas ;
+    std::vector<qat4> inst ;
+    CSGInstanceIndex ii ;
+
+    CSGInstanceIndexTest();
+    int check_gas() const ;
+    int check_sensor() const ;
+    int main();
+};
+
+CSGInstanceIndexTest::CSGInstanceIndexTest()
+    :
+    num(ssys::getenvint("NUM", 50000)),
+    num_gas(ssys::getenvint("NUM_GAS", 10))
+{
+    std::mt19937 gen(42) ;
+    std::uniform_int_distribution<int> ugas(1, num_gas-1) ;
+
+    qat4 q ;
+    q.setIdentity( 0, 0, 0, -1 );   // global : gas 0, not-a-sensor
+    inst.push_back(q) ;
+
+    int sensor_identifier = 0 ;
+    while( int(inst.size()) < num )
+    {
+        int gas_idx = ugas(gen) ;
+        int run = 1 + gen() % 1000 ;
+        bool is_sensor = gas_idx % 3 == 0 ;
+        for(int r=0 ; r < run && int(inst.size()) < num ; r++)
+        {
+            qat4 t ;
+            t.q3.f.x = float(inst.size()) ;
+            int sid_u = is_sensor ? 1 + sensor_identifier++ : 0 ;
+            t.setIdentity( inst.size(), gas_idx, sid_u, is_sensor ? sid_u - 1 : -1 );
+            inst.push_back(t) ;
+        }
+    }
+    inst[num/2].q1.i.w = -1 ;   // a placeholder with gas_idx -1 
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ii.build(inst) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    printf("%s build_ms %10.3f is_built_for %d \n", ii.desc().c_str(), std::chrono::duration<double, std::milli>(t1 - t0).count(), ii.is_built_for(inst) );
+}
+
+int CSGInstanceIndexTest::check_gas() const
+{
+    int mismatch = 0 ;
+    double linear_ms = 0. ;
+    double index_ms = 0. ;
+
+    for(int gas_idx=-2 ; gas_idx <= num_gas ; gas_idx++)
+    {
+        unsigned count = qat4::count_gas(inst, gas_idx) ;
+        if( count != unsigned(ii.count_gas(gas_idx)) ) mismatch += 1 ;
+
+        std::vector<const qat4*> sel ;
+        qat4::select_instance_pointers_gas(inst, sel, gas_idx) ;
+        const int* idx = ii.begin_gas(gas_idx) ;
+        for(unsigned i=0 ; i < sel.size() ; i++) if( sel[i] != inst.data() + idx[i] ) mismatch += 1 ;
+
+        for(unsigned ordinal=0 ; ordinal <= count ; ordinal += std::max(1u, count/50) )
+        {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            int a = qat4::find_instance_gas(inst, gas_idx, ordinal) ;
+            auto t1 = std::chrono::high_resolution_clock::now();
+            int b = ii.find_instance_gas(gas_idx, ordinal) ;
+            auto t2 = std::chrono::high_resolution_clock::now();
+            linear_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() ;
+            index_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() ;
+            if( a != b ) mismatch += 1 ;
+        }
+        int c = ii.find_instance_gas(gas_idx, count) ;
+        if( c != -1 ) mismatch += 1 ;
+    }
+    printf("check_gas mismatch %d linear_ms %10.3f index_ms %10.3f \n", mismatch, linear_ms, index_ms );
+    return mismatch ;
+}
+
+int CSGInstanceIndexTest::check_sensor() const
+{
+    int mismatch = 0 ;
+    int num_sensor = 0 ;
+    for(int i=0 ; i < int(inst.size()) ; i++)
+    {
+        int ins_idx, gas_idx, sensor_identifier_u, sensor_index ;
+        inst[i].getIdentity(ins_idx, gas_idx, sensor_identifier_u, sensor_index );
+        if( sensor_identifier_u == 0 ) continue ;
+        num_sensor += 1 ;
+        if( ii.find_instance_sensor( sensor_identifier_u - 1 ) != i ) mismatch += 1 ;
+    }
+    if( ii.find_instance_sensor(-1) != -1 ) mismatch += 1 ;
+    if( ii.find_instance_sensor(num_sensor) != -1 ) mismatch += 1 ;
+    if( int(ii.sensor.size()) != num_sensor ) mismatch += 1 ;
+    printf("check_sensor num_sensor %d mismatch %d \n", num_sensor, mismatch );
+    return mismatch ;
+}
+
+int CSGInstanceIndexTest::main()
+{
+    int rc = 0 ;
+    rc += check_gas();
+    rc += check_sensor();
+    return rc == 0 ? 0 : 1 ;
+}
+
+int main()
+{
+    CSGInstanceIndexTest t ;
+    return t.main() ;
+}
@@ -5,6 +5,9 @@ CSGQueryTest
 DUMP=2 NUM=210 CSGQueryTest A
    dump miss
 
+NUM=10000 CSGQueryTest T
+   compare CSGQuery::trace using CSGBVH with CSGQuery::trace_linear
+
 **/
 
 #include <csignal>
@@ -25,7 +28,7 @@ struct CSGQueryTest
     static const int VERBOSE ; 
 
     const CSGFoundry* fd ; 
-    const CSGQuery* q ; 
+    CSGQuery* q ; 
     CSGDraw* d ; 
     int gsid ; 
 
@@ -70,6 +73,7 @@ struct CSGQueryTest
     void PacmanPhiLine0();
     void PacmanPhiLine1();
     void PacmanPhiLine2();
+    void TraceCompare(); 
 }; 
 
 const char* CSGQueryTest::DUMP=" ( 0:no 1:hit 2:miss 3:hit+miss ) " ; 
@@ -111,6 +115,7 @@ void CSGQueryTest::operator()( char mode)
         case '0': PacmanPhiLine0()  ; break ; 
         case '1': PacmanPhiLine1()  ; break ; 
         case '2': PacmanPhiLine2()  ; break ; 
+        case 'T': TraceCompare()    ; break ; 
         default: assert(0 && "mode unhandled" ) ; break ; 
     }
 }
@@ -365,6 +370,52 @@ void CSGQueryTest::Load()
 }
 
 
+/**
+CSGQueryTest::TraceCompare
+----------------------------
+
+Rays from ORI in NUM directions spread over the sphere using a
+golden angle spiral, traced through the whole geometry with 
+the CSGBVH and with the linear reference, expecting identical prd. 
+Mismatches can only come from intersects outside the prim AABB that
+the linear reference accepts but the CSGBVH culls, as does OptiX. 
+
+**/
+
+void CSGQueryTest::TraceCompare()
+{
+    config("TraceCompare", "0,0,0", "1,0,0", "0", "1000" ); 
+    q->initBVH(); 
+    LOG(info) << q->descBVH() ; 
+
+    int num_hit = 0 ; 
+    int num_mismatch = 0 ; 
+    const float ga = M_PIf*(3.f - sqrtf(5.f)) ; 
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float z = 1.f - 2.f*(float(i) + 0.5f)/float(num) ; 
+        float r = sqrtf( 1.f - z*z ) ; 
+        float3 dir = make_float3( r*cosf(ga*i), r*sinf(ga*i), z ) ; 
+
+        quad2 a ; 
+        quad2 b ; 
+        bool ha = q->trace( &a, ray_origin, dir, tmin ) ;  
+        bool hb = q->trace_linear( &b, ray_origin, dir, tmin ) ;  
+
+        if(ha) num_hit += 1 ; 
+        bool match = ha == hb && memcmp( &a, &b, sizeof(quad2) ) == 0 ; 
+        if(!match) num_mismatch += 1 ; 
+        LOG_IF(error, !match && num_mismatch < 10) 
+            << " mismatch i " << i 
+            << " ha " << ha << " hb " << hb 
+            << " a.t " << a.q0.f.w << " b.t " << b.q0.f.w 
+            << " a.iindex " << a.iindex() << " b.iindex " << b.iindex() 
+            ; 
+    }
+    LOG(info) << " num " << num << " num_hit " << num_hit << " num_mismatch " << num_mismatch ; 
+}
+
 int main(int argc, char** argv)
 {
     OPTICKS_LOG(argc, argv); 
@@ -0,0 +1,249 @@
+/**
+CSGSparseGridTest.cc
+======================
+
+Builds CSGSparseGrid.h narrow band caches of distance_prim for a sphere
+and a height 2 CSG tree and checks:
+
+* every random position within the band is found in the cache
+* cached values are within CSGSparseGrid::err_bound of exact 
+* the cached-or-exact decision used by CSGQuery::distance_cached 
+  never changes the sign or SD_CUT classification 
+* building with one or many threads gives identical samples
+* save and Load roundtrip
+
+::
+
+    ~/opticks/CSG/tests/CSGSparseGridTest.sh
+    NUM=1000000 H=0.5 BAND=4 ~/opticks/CSG/tests/CSGSparseGridTest.sh
+
+**/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "OpticksCSG.h"
+#include "CSGNode.h"
+
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+#include "CSGSparseGrid.h"
+
+struct CSGSparseGridTest
+{
+    static constexpr const float SD_CUT = -1e-3f ;   // as CSGQuery::SD_CUT
+
+    int   num ;
+    float h ;
+    float band ;
+    int   num_threads ;
+    const char* fold ;
+
+    std::vector<qat4> itra ;
+
+    CSGSparseGridTest();
+
+    static CSGNode Node(unsigned typecode, float x, float y, float z, float w, float z1, float z2, unsigned tranIdx=0);
+    int check( const char* label, std::vector<CSGNode>& tree );
+    int main();
+};
+
+CSGSparseGridTest::CSGSparseGridTest()
+    :
+    num(ssys::getenvint("NUM", 200000)),
+    h(ssys::getenvfloat("H", 1.f)),
+    band(ssys::getenvfloat("BAND", 5.f)),
+    num_threads(ssys::getenvint("THREADS", 4)),
+    fold(ssys::getenvvar("FOLD", "/tmp/CSGSparseGridTest"))
+{
+    qat4 t ;   // inverse transform : rotation about z with translation
+    const float c = cosf(0.3f) ;
+    const float s = sinf(0.3f) ;
+    t.q0.f = make_float4(   c,   s, 0.f, 0.f );
+    t.q1.f = make_float4(  -s,   c, 0.f, 0.f );
+    t.q2.f = make_float4( 0.f, 0.f, 1.f, 0.f );
+    t.q3.f = make_float4( 5.f, -7.f, 11.f, 1.f );
+    itra.push_back(t) ;
+}
+
+CSGNode CSGSparseGridTest::Node(unsigned typecode, float x, float y, float z, float w, float z1, float z2, unsigned tranIdx)
+{
+    CSGNode nd = {} ;
+    nd.setParam( x, y, z, w, z1, z2 );
+    nd.setTypecode(typecode) ;
+    nd.setTransform(tranIdx) ;
+    return nd ;
+}
+
+int CSGSparseGridTest::check( const char* label, std::vector<CSGNode>& tree )
+{
+    if(tree.size() > 1) tree[0].setSubNum(tree.size()) ;
+    const CSGNode* node = tree.data() ;
+    const qat4* itra0 = itra.data() ;
+    std::function<float(const float3&)> sdf = [node, itra0](const float3& p){ return distance_prim( p, node, nullptr, itra0 ) ; } ;
+
+    float4 ce = make_float4( 0.f, 0.f, 0.f, 150.f );
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    CSGSparseGrid sg1( ce, h, band );
+    sg1.build( sdf, 1 );
+    auto t1 = std::chrono::high_resolution_clock::now();
+    CSGSparseGrid sg( ce, h, band );
+    sg.build( sdf, num_threads );
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    int rc = 0 ;
+    bool same = sg1.coord == sg.coord && sg1.value.size() == sg.value.size() && memcmp( sg1.value.data(), sg.value.data(), sizeof(float)*sg.value.size() ) == 0 ;
+    if(!same) rc += 1 ;
+
+    printf("%20s %s\n", label, sg.desc().c_str() );
+    printf("%20s build_ms(1 thread) %10.3f build_ms(%d threads) %10.3f same %d \n", label,
+          std::chrono::duration<double, std::milli>(t1 - t0).count(),
+          num_threads,
+          std::chrono::duration<double, std::milli>(t2 - t1).count(),
+          same );
+
+    std::mt19937 gen(42) ;
+    std::uniform_real_distribution<float> u(-1.f, 1.f) ;
+    std::vector<float3> pos(num) ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if( i % 2 == 0 )
+        {
+            pos[i] = make_float3( ce.w*u(gen), ce.w*u(gen), ce.w*u(gen) );
+        }
+        else   // near the surface : step along the gradient direction from a random position  
+        {
+            float3 p = make_float3( ce.w*u(gen), ce.w*u(gen), ce.w*u(gen) );
+            for(int it=0 ; it < 4 ; it++)
+            {
+                float d = sdf(p) ;
+                float3 g = make_float3( sdf(p + make_float3(0.01f,0.f,0.f)) - d, sdf(p + make_float3(0.f,0.01f,0.f)) - d, sdf(p + make_float3(0.f,0.f,0.01f)) - d ) ;
+                float gl = length(g) ;
+                if( gl > 0.f ) p = p - (d/gl)*g ;
+            }
+            float d = sdf(p) ;
+            float3 g = make_float3( sdf(p + make_float3(0.01f,0.f,0.f)) - d, sdf(p + make_float3(0.f,0.01f,0.f)) - d, sdf(p + make_float3(0.f,0.f,0.01f)) - d ) ;
+            float gl = length(g) ;
+            if( gl > 0.f ) p = p + (band*u(gen)/gl)*g ;   // random offset within band along gradient
+            pos[i] = p ;
+        }
+    }
+
+    std::vector<float> exact(num) ;
+    std::vector<float> cached(num) ;
+    std::vector<int>   found(num) ;
+    float err_bound = sg.err_bound() ;
+
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) exact[i] = sdf(pos[i]) ;
+    auto t4 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) found[i] = sg.query( cached[i], pos[i] ) ;
+    auto t5 = std::chrono::high_resolution_clock::now();
+
+    int num_band = 0 ;
+    int num_missed = 0 ;
+    int num_found = 0 ;
+    int num_used = 0 ;
+    int num_decision_mismatch = 0 ;
+    int num_over_err = 0 ;
+    float max_diff = 0.f ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        bool in_band = fabsf(exact[i]) <= band ;
+        if(in_band) num_band += 1 ;
+        if(in_band && !found[i]) num_missed += 1 ;
+        if(!found[i]) continue ;
+        num_found += 1 ;
+
+        float diff = fabsf( cached[i] - exact[i] ) ;
+        max_diff = std::max( max_diff, diff );
+        if( diff > err_bound ) num_over_err += 1 ;
+
+        bool used = fabsf(cached[i]) > err_bound + fabsf(SD_CUT) ;   // as CSGQuery::distance_cached
+        if(!used) continue ;
+        num_used += 1 ;
+        if( (cached[i] < SD_CUT) != (exact[i] < SD_CUT) || (cached[i] < 0.f) != (exact[i] < 0.f) ) num_decision_mismatch += 1 ;
+    }
+
+    printf("%20s num %d num_band %d num_missed %d num_found %d num_used %d num_over_err %d num_decision_mismatch %d max_diff %10.4e \n",
+            label, num, num_band, num_missed, num_found, num_used, num_over_err, num_decision_mismatch, max_diff );
+    printf("%20s exact_ms %10.3f query_ms %10.3f \n", label,
+          std::chrono::duration<double, std::milli>(t4 - t3).count(),
+          std::chrono::duration<double, std::milli>(t5 - t4).count() );
+
+    if( num_missed > 0 ) rc += 1 ;
+    if( num_decision_mismatch > 0 ) rc += 1 ;
+    if( num_over_err > 0 ) rc += 1 ;
+
+    std::string dir = std::string(fold) + "/" + label ;
+    sg.save( dir.c_str() );
+    CSGSparseGrid* lg = CSGSparseGrid::Load( dir.c_str() );
+    if( lg == nullptr ) return rc + 1 ;
+    int num_load_mismatch = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        float sd = 0.f ;
+        bool lf = lg->query( sd, pos[i] ) ;
+        if( lf != bool(found[i]) || ( lf && sd != cached[i] )) num_load_mismatch += 1 ;
+    }
+    printf("%20s num_load_mismatch %d \n", label, num_load_mismatch );
+    if( num_load_mismatch > 0 ) rc += 1 ;
+    delete lg ;
+
+    return rc ;
+}
+
+int CSGSparseGridTest::main()
+{
+    int rc = 0 ;
+
+    std::vector<CSGNode> sphere = { Node(CSG_SPHERE, 10.f, 0.f, 0.f, 100.f, 0.f, 0.f) } ;
+    rc += check( "sphere", sphere );
+
+    std::vector<CSGNode> h2 = {
+        Node(CSG_DIFFERENCE, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_UNION, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_CYLINDER, 0.f, 0.f, 0.f, 30.f, -140.f, 140.f ),
+        Node(CSG_SPHERE, -40.f, 0.f, 0.f, 90.f, 0.f, 0.f ),
+        Node(CSG_BOX3, 100.f, 150.f, 120.f, 0.f, 0.f, 0.f, 1 ),
+        Node(CSG_ZERO, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_ZERO, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f )
+    };
+    rc += check( "h2", h2 );
+
+    CSGNode zero = Node(CSG_ZERO, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ) ;
+    std::vector<CSGNode> h3 = {
+        Node(CSG_DIFFERENCE, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_UNION, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_UNION, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_INTERSECTION, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_DIFFERENCE, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f ),
+        Node(CSG_CYLINDER, 0.f, 0.f, 0.f, 20.f, -140.f, 140.f ),
+        Node(CSG_SPHERE, 0.f, 0.f, 60.f, 40.f, 0.f, 0.f ),
+        Node(CSG_SPHERE, -20.f, 0.f, 0.f, 110.f, 0.f, 0.f ),
+        Node(CSG_BOX3, 150.f, 150.f, 150.f, 0.f, 0.f, 0.f, 1 ),
+        Node(CSG_CYLINDER, 0.f, 0.f, 0.f, 120.f, -30.f, 30.f ),
+        Node(CSG_CYLINDER, 0.f, 0.f, 0.f, 100.f, -40.f, 40.f ),
+        zero, zero, zero, zero
+    };
+    rc += check( "h3", h3 );
+
+    return rc == 0 ? 0 : 1 ;
+}
+
+int main()
+{
+    CSGSparseGridTest t ;
+    return t.main() ;
+}
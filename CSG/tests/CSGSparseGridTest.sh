@@ -0,0 +1,54 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+CSGSparseGridTest.sh
+===============
+
+Check CSGSparseGrid.h narrow band distance cache against exact distance_prim::
+
+    ~/opticks/CSG/tests/CSGSparseGridTest.sh
+    NUM=1000000 H=0.5 BAND=4 ~/opticks/CSG/tests/CSGSparseGridTest.sh
+
+EOU
+}
+
+cd $(dirname $BASH_SOURCE)
+name=CSGSparseGridTest
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE name FOLD bin CUDA_PREFIX arg"
+
+if [ "${arg/info}" != "$arg" ]; then 
+   for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done 
+fi
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc \
+       -std=c++11 -lstdc++ -lm -pthread -O3 -fno-math-errno \
+       -I..  \
+       -I../../sysrap \
+       -I${CUDA_PREFIX}/include \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb -ex r --args $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3
+fi
+
+exit 0 
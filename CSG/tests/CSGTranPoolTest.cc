@@ -0,0 +1,153 @@
+/**
+CSGTranPoolTest.cc
+====================
+
+Node transforms drawn with many repeats, as translations of repeated 
+placements are, are added with CSGTranPool::add and also appended 
+without the pool then compacted with CSGTranPool::dedup.
+Both must give each node a reference to a bitwise identical tran+itra pair
+with the same number of unique pairs. 
+
+::
+
+    ~/opticks/CSG/tests/CSGTranPoolTest.sh
+    NUM=100000 NUM_DISTINCT=500 ~/opticks/CSG/tests/CSGTranPoolTest.sh
+
+**/
+
+#include <cstdio>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "CSGTranPool.h"
+
+struct CSGTranPoolTest
+{
+    int num ;
+    int num_distinct ;
+    std::vector<qat4> src_tran ;   // one per node, with repeats
+    std::vector<qat4> src_itra ;
+
+    CSGTranPoolTest();
+    int check_add() const ;
+    int check_dedup() const ;
+    int check_zero_sign() const ;
+    int main();
+};
+
+CSGTranPoolTest::CSGTranPoolTest()
+    :
+    num(ssys::getenvint("NUM", 100000)),
+    num_distinct(ssys::getenvint("NUM_DISTINCT", 500))
+{
+    std::mt19937 gen(42) ;
+    std::uniform_int_distribution<int> upick(0, num_distinct-1) ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        int k = upick(gen) ;
+        qat4 t ;
+        qat4 v ;
+        t.q3.f.x = float(k) ;  t.q3.f.y = 0.5f*float(k) ;
+        v.q3.f.x = -float(k) ; v.q3.f.y = -0.5f*float(k) ;
+        if( k % 2 ) { t.q0.f.x = 2.f ; v.q0.f.x = 0.5f ; }
+        src_tran.push_back(t) ;
+        src_itra.push_back(v) ;
+    }
+}
+
+int CSGTranPoolTest::check_add() const
+{
+    CSGTranPool tp ;
+    std::vector<qat4> tran ;
+    std::vector<qat4> itra ;
+    std::vector<unsigned> ref(num) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) ref[i] = tp.add( tran, itra, src_tran[i], src_itra[i] ) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    int mismatch = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if(!CSGTranPool::Same(tran[ref[i]], src_tran[i])) mismatch += 1 ;
+        if(!CSGTranPool::Same(itra[ref[i]], src_itra[i])) mismatch += 1 ;
+    }
+    if( int(tran.size()) > num_distinct ) mismatch += 1 ;
+    if( tp.num_reuse + tran.size() != unsigned(num) ) mismatch += 1 ;
+
+    printf("check_add %s add_ms %10.3f mismatch %d \n", tp.desc(tran.size()).c_str(), std::chrono::duration<double, std::milli>(t1 - t0).count(), mismatch );
+    return mismatch ;
+}
+
+int CSGTranPoolTest::check_dedup() const
+{
+    std::vector<qat4> tran(src_tran) ;
+    std::vector<qat4> itra(src_itra) ;
+    std::vector<unsigned> remap ;
+
+    CSGTranPool tp ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    unsigned removed = tp.dedup( tran, itra, remap ) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    int mismatch = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if(!CSGTranPool::Same(tran[remap[i]], src_tran[i])) mismatch += 1 ;
+        if(!CSGTranPool::Same(itra[remap[i]], src_itra[i])) mismatch += 1 ;
+    }
+    if( removed + tran.size() != unsigned(num) ) mismatch += 1 ;
+    if( tran.size() != itra.size() ) mismatch += 1 ;
+
+    // after dedup the pool covers the compacted pairs, so adding them again reuses all 
+    for(int i=0 ; i < num ; i++) if( tp.add( tran, itra, src_tran[i], src_itra[i] ) != remap[i] ) mismatch += 1 ;
+    if( tp.num_reuse != unsigned(num) ) mismatch += 1 ;
+
+    printf("check_dedup %s dedup_ms %10.3f mismatch %d \n", tp.desc(tran.size()).c_str(), std::chrono::duration<double, std::milli>(t1 - t0).count(), mismatch );
+    return mismatch ;
+}
+
+/**
+CSGTranPoolTest::check_zero_sign
+----------------------------------
+
+Sharing is bitwise, so transforms differing only by the sign of zero are kept apart.
+
+**/
+
+int CSGTranPoolTest::check_zero_sign() const
+{
+    CSGTranPool tp ;
+    std::vector<qat4> tran ;
+    std::vector<qat4> itra ;
+    qat4 a ;
+    qat4 b ;
+    b.q3.f.x = -0.f ;
+    unsigned ia = tp.add( tran, itra, a, a ) ;
+    unsigned ib = tp.add( tran, itra, b, b ) ;
+    unsigned ja = tp.add( tran, itra, a, a ) ;
+    int mismatch = ( ia != ib && ia == ja && tran.size() == 2 ) ? 0 : 1 ;
+    printf("check_zero_sign mismatch %d \n", mismatch );
+    return mismatch ;
+}
+
+int CSGTranPoolTest::main()
+{
+    int rc = 0 ;
+    rc += check_add();
+    rc += check_dedup();
+    rc += check_zero_sign();
+    return rc == 0 ? 0 : 1 ;
+}
+
+int main()
+{
+    CSGTranPoolTest t ;
+    return t.main() ;
+}
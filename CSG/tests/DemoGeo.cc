@@ -61,6 +61,7 @@ void DemoGeo::init(const char* geom)
     {
         init_maker(geom); 
     }
+    foundry->initInstIndex(); 
 
     LOG(info) << "]" ; 
 }
@@ -36,6 +36,7 @@ DemoGrid::DemoGrid( CSGFoundry* foundry_, unsigned ias_idx_, unsigned num_solid_
     LOG(info) << "GRIDSINGLE " << SStr::Present(solid_single) ; 
 
     init();   // add qat4 instances to foundry 
+    foundry->initInstIndex(); 
 }
 
 
@@ -0,0 +1,209 @@
+/**
+csg_intersect_packet_test.cc
+==============================
+
+Compares packet intersection from csg_intersect_packet.h with scalar intersect_prim
+for random rays against leaf nodes with and without transform and complement,
+a cone using the scalar fallback within intersect_packet_leaf and a union tree
+using the scalar fallback within intersect_packet_prim.
+Results are required to be bitwise identical.
+
+::
+
+    ~/opticks/CSG/tests/csg_intersect_packet_test.sh
+    NUM=1000000 ~/opticks/CSG/tests/csg_intersect_packet_test.sh
+
+**/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "OpticksCSG.h"
+#include "CSGNode.h"
+#include "csg_intersect_packet.h"
+
+struct csg_intersect_packet_test
+{
+    static constexpr const int W = CSG_PACKET_WIDTH ;
+
+    int num ;
+    std::vector<float3> ori ;
+    std::vector<float3> dir ;
+    std::vector<float>  tmin ;
+
+    std::vector<CSGNode> nodes ;
+    std::vector<float4>  plan ;
+    std::vector<qat4>    itra ;
+
+    csg_intersect_packet_test();
+    void init_rays();
+    void init_geom();
+
+    int check(const char* label, const CSGNode* node );
+    int main();
+};
+
+csg_intersect_packet_test::csg_intersect_packet_test()
+    :
+    num(ssys::getenvint("NUM", 100000))
+{
+    init_rays();
+    init_geom();
+}
+
+/**
+csg_intersect_packet_test::init_rays
+--------------------------------------
+
+Random origins within a 400mm cube, mostly random directions with some
+axis aligned rays to exercise the parallel special cases.
+
+**/
+
+void csg_intersect_packet_test::init_rays()
+{
+    std::mt19937 gen(42) ;
+    std::uniform_real_distribution<float> u(-1.f, 1.f) ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float3 o = make_float3( 200.f*u(gen), 200.f*u(gen), 200.f*u(gen) );
+        float3 d = make_float3( u(gen), u(gen), u(gen) );
+        switch(i % 16)
+        {
+            case 1: d = make_float3( 1.f, 0.f, 0.f ) ; break ;
+            case 2: d = make_float3( 0.f,-1.f, 0.f ) ; break ;
+            case 3: d = make_float3( 0.f, 0.f, 1.f ) ; break ;
+            default: d = normalize(d) ; break ;
+        }
+        ori.push_back(o);
+        dir.push_back(d);
+        tmin.push_back( i % 3 == 0 ? 0.f : 0.1f );
+    }
+}
+
+void csg_intersect_packet_test::init_geom()
+{
+    CSGNode nd = {} ;
+
+    nd.setParam( 10.f, 0.f, 0.f, 100.f, 0.f, 0.f );  nd.setTypecode(CSG_SPHERE) ;    nodes.push_back(nd) ; nd = {} ;   // 0
+    nd.setParam( 0.f, 0.f, 0.f, 100.f, -50.f, 70.f ); nd.setTypecode(CSG_ZSPHERE) ;  nodes.push_back(nd) ; nd = {} ;   // 1
+    nd.setParam( 0.f, 0.f, 0.f, 80.f, -60.f, 90.f );  nd.setTypecode(CSG_CYLINDER) ; nodes.push_back(nd) ; nd = {} ;   // 2
+    nd.setParam( 100.f, 150.f, 50.f, 0.f, 0.f, 0.f ); nd.setTypecode(CSG_BOX3) ;     nodes.push_back(nd) ; nd = {} ;   // 3
+
+    const float h = 80.f ;
+    plan.push_back( make_float4(  1.f,  0.f,  0.f, h ));
+    plan.push_back( make_float4( -1.f,  0.f,  0.f, h ));
+    plan.push_back( make_float4(  0.f,  1.f,  0.f, h ));
+    plan.push_back( make_float4(  0.f, -1.f,  0.f, h ));
+    plan.push_back( make_float4(  0.f,  0.f,  1.f, h ));
+    plan.push_back( make_float4(  0.f,  0.f, -1.f, h ));
+    plan.push_back( make_float4( normalize(make_float3(1.f,1.f,1.f)), h ));
+    nd.setPlaneIdx(0) ; nd.setPlaneNum(plan.size()) ; nd.setTypecode(CSG_CONVEXPOLYHEDRON) ; nodes.push_back(nd) ; nd = {} ;  // 4
+
+    nd.setParam( 50.f, -50.f, 100.f, 50.f, 0.f, 0.f ); nd.setTypecode(CSG_CONE) ;    nodes.push_back(nd) ; nd = {} ;   // 5
+
+    nd.setSubNum(3) ; nd.setTypecode(CSG_UNION) ; nodes.push_back(nd) ; nd = {} ;                                         // 6 : tree
+    nd.setParam( -30.f, 0.f, 0.f, 60.f, 0.f, 0.f ); nd.setTypecode(CSG_SPHERE) ;   nodes.push_back(nd) ; nd = {} ;
+    nd.setParam(  30.f, 0.f, 0.f, 60.f, 0.f, 0.f ); nd.setTypecode(CSG_SPHERE) ;   nodes.push_back(nd) ; nd = {} ;
+
+    qat4 t ;   // inverse transform : rotation about z and translation
+    const float c = cosf(0.3f) ;
+    const float s = sinf(0.3f) ;
+    t.q0.f = make_float4(   c,   s, 0.f, 0.f );
+    t.q1.f = make_float4(  -s,   c, 0.f, 0.f );
+    t.q2.f = make_float4( 0.f, 0.f, 1.f, 0.f );
+    t.q3.f = make_float4( 5.f, -7.f, 11.f, 1.f );
+    itra.push_back(t) ;
+}
+
+int csg_intersect_packet_test::check(const char* label, const CSGNode* node )
+{
+    std::vector<float4> a(num) ;
+    std::vector<float4> b(num) ;
+    std::vector<int> av(num) ;
+    std::vector<int> bv(num) ;
+
+    for(int i=0 ; i < num ; i++) a[i] = make_float4(0.f, 0.f, 0.f, 0.f) ;
+    for(int i=0 ; i < num ; i++) b[i] = make_float4(0.f, 0.f, 0.f, 0.f) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for(int i=0 ; i < num ; i++) av[i] = intersect_prim( a[i], node, plan.data(), itra.data(), tmin[i], ori[i], dir[i] ) ;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    csg_packet<W> pk ;
+    for(int i0=0 ; i0 < num ; i0 += W)
+    {
+        pk.num = std::min( W, num - i0 ) ;
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            pk.ray.set( l, ori[i0+l], dir[i0+l] );
+            pk.tmin[l] = tmin[i0+l] ;
+            pk.isect.set( l, b[i0+l] );
+        }
+        pk.fill();
+        intersect_packet_prim<W>( pk.isect, node, plan.data(), itra.data(), pk.tmin, pk.ray );
+        for(int l=0 ; l < pk.num ; l++)
+        {
+            b[i0+l] = pk.isect.get(l) ;
+            bv[i0+l] = pk.isect.valid[l] ;
+        }
+    }
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    int num_hit = 0 ;
+    int num_mismatch = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if(av[i]) num_hit += 1 ;
+        bool match = av[i] == bv[i] && memcmp( &a[i], &b[i], sizeof(float4) ) == 0 ;
+        if(!match && num_mismatch < 10) printf("//%s mismatch i %d av %d bv %d a (%g %g %g %g) b (%g %g %g %g) \n",
+             label, i, av[i], bv[i], a[i].x, a[i].y, a[i].z, a[i].w, b[i].x, b[i].y, b[i].z, b[i].w );
+        if(!match) num_mismatch += 1 ;
+    }
+
+    double scalar_ms = std::chrono::duration<double, std::milli>(t1 - t0).count() ;
+    double packet_ms = std::chrono::duration<double, std::milli>(t2 - t1).count() ;
+
+    printf("%30s num %8d num_hit %8d num_mismatch %4d scalar_ms %10.3f packet_ms %10.3f \n",
+           label, num, num_hit, num_mismatch, scalar_ms, packet_ms );
+
+    return num_mismatch ;
+}
+
+int csg_intersect_packet_test::main()
+{
+    const char* names[] = { "sphere", "zsphere", "cylinder", "box3", "convexpolyhedron", "cone(fallback)" } ;
+    int rc = 0 ;
+    for(int i=0 ; i < 6 ; i++)
+    {
+        CSGNode nd = nodes[i] ;
+        std::string name = names[i] ;
+
+        rc += check( name.c_str(), &nd );
+
+        nd.setTransform(1) ;
+        rc += check( (name + "+tran").c_str(), &nd );
+
+        nd.setComplement(true) ;
+        rc += check( (name + "+tran+compl").c_str(), &nd );
+    }
+    rc += check( "union(tree fallback)", &nodes[6] );
+    return rc == 0 ? 0 : 1 ;
+}
+
+int main()
+{
+    csg_intersect_packet_test t ;
+    return t.main() ;
+}
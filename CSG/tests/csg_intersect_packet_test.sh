@@ -0,0 +1,57 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+csg_intersect_packet_test.sh
+==============================
+
+Compare csg_intersect_packet.h packet intersection with scalar intersect_prim::
+
+    ~/opticks/CSG/tests/csg_intersect_packet_test.sh
+    NUM=1000000 ~/opticks/CSG/tests/csg_intersect_packet_test.sh
+    WIDTH=16 ~/opticks/CSG/tests/csg_intersect_packet_test.sh
+
+EOU
+}
+
+cd $(dirname $BASH_SOURCE)
+name=csg_intersect_packet_test
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+WIDTH=${WIDTH:-8}
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE name FOLD bin CUDA_PREFIX WIDTH arg"
+
+if [ "${arg/info}" != "$arg" ]; then 
+   for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done 
+fi
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc \
+       -std=c++11 -lstdc++ -lm -O3 -fno-math-errno \
+       -DCSG_PACKET_WIDTH=$WIDTH \
+       -I..  \
+       -I../../sysrap \
+       -I${CUDA_PREFIX}/include \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb -ex r --args $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3
+fi
+
+exit 0 
@@ -0,0 +1,257 @@
+/**
+csg_intersect_tree_test.cc
+============================
+
+Compares the height specialized intersect_tree_<H> with the generic runtime 
+height traversal intersect_tree_<-1> for random rays 
+against trees of height 1 to 4, including complemented and transformed leaves 
+and CSG_ZERO placeholders. Results are required to be bitwise identical.
+
+::
+
+    ~/opticks/CSG/tests/csg_intersect_tree_test.sh
+    NUM=1000000 ~/opticks/CSG/tests/csg_intersect_tree_test.sh
+
+**/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sqat4.h"
+#include "OpticksCSG.h"
+#include "CSGNode.h"
+
+#include "csg_intersect_leaf.h"
+#include "csg_intersect_node.h"
+#include "csg_intersect_tree.h"
+
+struct csg_intersect_tree_test
+{
+    int num ;
+    std::vector<float3> ori ;
+    std::vector<float3> dir ;
+    std::vector<float>  tmin ;
+    std::vector<qat4>   itra ;
+
+    csg_intersect_tree_test();
+    void init_rays();
+    void init_itra();
+
+    static CSGNode Sphere(float x, float y, float z, float r);
+    static CSGNode Box3(float fx, float fy, float fz, unsigned tranIdx);
+    static CSGNode Cylinder(float r, float z1, float z2, unsigned tranIdx);
+    static CSGNode Operator(unsigned typecode);
+    static bool Special( float4& isect, const CSGNode* node, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction );
+
+    int check(const char* label, std::vector<CSGNode>& tree );
+    int main();
+};
+
+csg_intersect_tree_test::csg_intersect_tree_test()
+    :
+    num(ssys::getenvint("NUM", 100000))
+{
+    init_rays();
+    init_itra();
+}
+
+void csg_intersect_tree_test::init_rays()
+{
+    std::mt19937 gen(42) ;
+    std::uniform_real_distribution<float> u(-1.f, 1.f) ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float3 o = make_float3( 200.f*u(gen), 200.f*u(gen), 200.f*u(gen) );
+        float3 d = make_float3( u(gen), u(gen), u(gen) );
+        switch(i % 16)
+        {
+            case 1: d = make_float3( 1.f, 0.f, 0.f ) ; break ;
+            case 2: d = make_float3( 0.f, 0.f,-1.f ) ; break ;
+            default: d = normalize(d) ; break ;
+        }
+        ori.push_back(o);
+        dir.push_back(d);
+        tmin.push_back( i % 3 == 0 ? 0.f : 0.1f );
+    }
+}
+
+/**
+csg_intersect_tree_test::init_itra
+------------------------------------
+
+Inverse transforms : 1 is rotation about z with translation, 2 is a translation.
+
+**/
+
+void csg_intersect_tree_test::init_itra()
+{
+    qat4 t ;
+    const float c = cosf(0.3f) ;
+    const float s = sinf(0.3f) ;
+    t.q0.f = make_float4(   c,   s, 0.f, 0.f );
+    t.q1.f = make_float4(  -s,   c, 0.f, 0.f );
+    t.q2.f = make_float4( 0.f, 0.f, 1.f, 0.f );
+    t.q3.f = make_float4( 5.f, -7.f, 11.f, 1.f );
+    itra.push_back(t) ;
+
+    qat4 u ;
+    u.q0.f = make_float4( 1.f, 0.f, 0.f, 0.f );
+    u.q1.f = make_float4( 0.f, 1.f, 0.f, 0.f );
+    u.q2.f = make_float4( 0.f, 0.f, 1.f, 0.f );
+    u.q3.f = make_float4( 0.f, 0.f, -40.f, 1.f );
+    itra.push_back(u) ;
+}
+
+CSGNode csg_intersect_tree_test::Sphere(float x, float y, float z, float r)
+{
+    CSGNode nd = {} ;
+    nd.setParam( x, y, z, r, 0.f, 0.f );
+    nd.setTypecode(CSG_SPHERE) ;
+    return nd ;
+}
+CSGNode csg_intersect_tree_test::Box3(float fx, float fy, float fz, unsigned tranIdx)
+{
+    CSGNode nd = {} ;
+    nd.setParam( fx, fy, fz, 0.f, 0.f, 0.f );
+    nd.setTypecode(CSG_BOX3) ;
+    nd.setTransform(tranIdx);
+    return nd ;
+}
+CSGNode csg_intersect_tree_test::Cylinder(float r, float z1, float z2, unsigned tranIdx)
+{
+    CSGNode nd = {} ;
+    nd.setParam( 0.f, 0.f, 0.f, r, z1, z2 );
+    nd.setTypecode(CSG_CYLINDER) ;
+    nd.setTransform(tranIdx);
+    return nd ;
+}
+CSGNode csg_intersect_tree_test::Operator(unsigned typecode)
+{
+    CSGNode nd = {} ;
+    nd.setTypecode(typecode) ;
+    return nd ;
+}
+
+/**
+csg_intersect_tree_test::Special
+----------------------------------
+
+Explicit dispatch to the specializations, as intersect_tree only 
+uses heights 2 to 4 on device. 
+
+**/
+
+bool csg_intersect_tree_test::Special( float4& isect, const CSGNode* node, const qat4* itra0, const float t_min , const float3& ray_origin, const float3& ray_direction )
+{
+    switch( node->subNum() )
+    {
+        case  3: return intersect_tree_<1>( isect, node, nullptr, itra0, t_min, ray_origin, ray_direction ); 
+        case  7: return intersect_tree_<2>( isect, node, nullptr, itra0, t_min, ray_origin, ray_direction ); 
+        case 15: return intersect_tree_<3>( isect, node, nullptr, itra0, t_min, ray_origin, ray_direction ); 
+        case 31: return intersect_tree_<4>( isect, node, nullptr, itra0, t_min, ray_origin, ray_direction ); 
+    }
+    return intersect_tree( isect, node, nullptr, itra0, t_min, ray_origin, ray_direction ); 
+}
+
+int csg_intersect_tree_test::check(const char* label, std::vector<CSGNode>& tree )
+{
+    tree[0].setSubNum(tree.size()) ;
+    const CSGNode* node = tree.data() ;
+
+    std::vector<float4> a(num) ;
+    std::vector<float4> b(num) ;
+    std::vector<int> av(num) ;
+    std::vector<int> bv(num) ;
+
+    for(int i=0 ; i < num ; i++) a[i] = make_float4(0.f, 0.f, 0.f, 0.f) ;
+    for(int i=0 ; i < num ; i++) b[i] = make_float4(0.f, 0.f, 0.f, 0.f) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) av[i] = intersect_tree_<-1>( a[i], node, nullptr, itra.data(), tmin[i], ori[i], dir[i] ) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) bv[i] = Special( b[i], node, itra.data(), tmin[i], ori[i], dir[i] ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    int num_hit = 0 ;
+    int num_mismatch = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if(av[i]) num_hit += 1 ;
+        bool match = av[i] == bv[i] && memcmp( &a[i], &b[i], sizeof(float4) ) == 0 ;
+        if(!match && num_mismatch < 10) printf("//%s mismatch i %d av %d bv %d a (%g %g %g %g) b (%g %g %g %g) \n",
+             label, i, av[i], bv[i], a[i].x, a[i].y, a[i].z, a[i].w, b[i].x, b[i].y, b[i].z, b[i].w );
+        if(!match) num_mismatch += 1 ;
+    }
+
+    double generic_ms = std::chrono::duration<double, std::milli>(t1 - t0).count() ;
+    double special_ms = std::chrono::duration<double, std::milli>(t2 - t1).count() ;
+
+    printf("%30s numNode %2d num %8d num_hit %8d num_mismatch %4d generic_ms %10.3f special_ms %10.3f \n",
+           label, int(tree.size()), num, num_hit, num_mismatch, generic_ms, special_ms );
+
+    return num_mismatch ;
+}
+
+int csg_intersect_tree_test::main()
+{
+    int rc = 0 ;
+    CSGNode zero = Operator(CSG_ZERO) ;
+
+    const unsigned ops[3] = { CSG_UNION, CSG_INTERSECTION, CSG_DIFFERENCE } ;
+    for(int i=0 ; i < 3 ; i++)
+    {
+        std::string op = CSG::Name(ops[i]) ;
+
+        std::vector<CSGNode> t1 = { Operator(ops[i]), Sphere(-30.f, 0.f, 0.f, 80.f), Box3(100.f, 150.f, 50.f, 1) } ;
+        rc += check( (op + "(sphere,box3)").c_str(), t1 );
+
+        std::vector<CSGNode> t2 = { Operator(ops[i]), Cylinder(90.f, -60.f, 60.f, 0), Cylinder(50.f, -100.f, 100.f, 2) } ;
+        rc += check( (op + "(cyl,cyl)").c_str(), t2 );
+
+        t2[2].setComplement(true) ;
+        rc += check( (op + "(cyl,!cyl)").c_str(), t2 );
+    }
+
+    std::vector<CSGNode> h2 = {
+        Operator(CSG_DIFFERENCE),
+        Operator(CSG_UNION), Operator(CSG_INTERSECTION),
+        Sphere(-40.f, 0.f, 0.f, 90.f), Sphere(40.f, 0.f, 0.f, 90.f), Box3(60.f, 60.f, 300.f, 1), Cylinder(40.f, -150.f, 150.f, 0)
+    };
+    rc += check( "h2", h2 );
+
+    std::vector<CSGNode> h3 = {
+        Operator(CSG_DIFFERENCE),
+        Operator(CSG_DIFFERENCE), Sphere(0.f, 0.f, 80.f, 30.f),
+        Operator(CSG_UNION), Box3(20.f, 20.f, 400.f, 0), zero, zero,
+        Cylinder(100.f, -50.f, 50.f, 0), Cylinder(60.f, -120.f, 120.f, 2), zero, zero, zero, zero, zero, zero
+    };
+    rc += check( "h3", h3 );
+
+    std::vector<CSGNode> h4(31, zero) ;
+    h4[0] = Operator(CSG_DIFFERENCE) ;           // 1
+    h4[1] = Operator(CSG_DIFFERENCE) ;           // 2
+    h4[2] = Box3(300.f, 10.f, 10.f, 0) ;          // 3
+    h4[3] = Operator(CSG_DIFFERENCE) ;           // 4
+    h4[4] = Box3(10.f, 300.f, 10.f, 0) ;          // 5
+    h4[7] = Operator(CSG_UNION) ;                // 8
+    h4[8] = Sphere(0.f, 0.f, 0.f, 40.f) ;        // 9
+    h4[15] = Sphere(0.f, 0.f, 30.f, 100.f) ;     // 16
+    h4[16] = Box3(150.f, 150.f, 150.f, 1) ;      // 17
+    rc += check( "h4", h4 );
+
+    return rc == 0 ? 0 : 1 ;
+}
+
+int main()
+{
+    csg_intersect_tree_test t ;
+    return t.main() ;
+}
@@ -252,7 +252,7 @@ static __forceinline__ __device__ void simulate( const uint3& launch_idx, const
     if (launch_idx.x >= evt->num_photon) return;
 
     unsigned idx = launch_idx.x ;  // aka photon_idx
-    unsigned genstep_idx = evt->seed[idx] ; 
+    unsigned genstep_idx = evt->genstep_id(idx) ; 
     const quad6& gs = evt->genstep[genstep_idx] ; 
      
     qsim* sim = params.sim ; 
@@ -337,7 +337,7 @@ static __forceinline__ __device__ void simtrace( const uint3& launch_idx, const
     sevent* evt  = params.evt ; 
     if (idx >= evt->num_simtrace) return;
 
-    unsigned genstep_id = evt->seed[idx] ; 
+    unsigned genstep_id = evt->genstep_id(idx) ; 
 
 #if defined(DEBUG_PIDX)
     if(idx == 0) printf("//CSGOptiX7.cu : simtrace idx %d genstep_id %d evt->num_simtrace %d \n", idx, genstep_id, evt->num_simtrace ); 
@@ -61,6 +61,7 @@ CSGFoundry* CSG_GGeo_Convert::Translate(const GGeo* ggeo )
     bool ksb = SSys::getenvbool("KLUDGE_SCALE_PRIM_BBOX"); 
     if(ksb) conv.kludgeScalePrimBBox();  
 
+    fd->initInstIndex(); 
 
     LOG(LEVEL) << "] convert ggeo " ; 
     return fd ; 
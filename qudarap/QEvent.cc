@@ -9,6 +9,7 @@
 #include "scuda.h"
 #include "squad.h"
 #include "sphoton.h"
+#include "sphoton_column.h"
 
 #ifndef PRODUCTION
 #include "srec.h"
@@ -17,6 +18,7 @@
 #endif
 
 #include "sevent.h"
+#include "sgenstep_lookup.h"
 #include "salloc.h"
 #include "sstamp.h"
 #include "ssys.h"
@@ -220,6 +222,7 @@ If the number of gensteps is zero there are no photons and no launch.
 3. QU::device_memset zeroing the seed buffer : this is needed 
    for each launch, doing at initialization only is not sufficient.
    **This is a documented limitation of sysrap/iexpand.h**
+   (no seed buffer when running seedless)
 
 4. QEvent::count_genstep_photons_and_fill_seed_buffer
 
@@ -229,6 +232,11 @@ If the number of gensteps is zero there are no photons and no launch.
    * populates seed buffer using num photons per genstep from genstep buffer, 
      which is the way each photon thread refers back to its genstep
 
+   With seedless SEventConfig::GenstepLookup "search" or "table" 
+   QEvent::fill_genstep_lookup instead fills the num_genstep+1 genstep offsets
+   (and coarse table) that the photon threads search with sevent::genstep_id, 
+   see sgenstep_lookup.h 
+
 5. setNumSimtrace/setInputPhoton/setNumPhoton which may allocate records
 
 
@@ -270,7 +278,7 @@ int QEvent::setGenstepUpload(const quad6* qq, int num_genstep )
 #endif
 
     evt->num_genstep = num_genstep ; 
-    bool not_allocated = evt->genstep == nullptr && evt->seed == nullptr ; 
+    bool not_allocated = evt->genstep == nullptr ; 
 
     LOG_IF(info, LIFECYCLE) << " not_allocated " << ( not_allocated ? "YES" : "NO" ) ;  
 
@@ -299,7 +307,7 @@ int QEvent::setGenstepUpload(const quad6* qq, int num_genstep )
     sev->t_setGenstep_5 = sstamp::Now(); 
 #endif
 
-    QU::device_memset<int>(   evt->seed,    0, evt->max_photon );
+    if(evt->seed) QU::device_memset<int>(   evt->seed,    0, evt->max_photon );
 
 #ifndef PRODUCTION 
     sev->t_setGenstep_6 = sstamp::Now(); 
@@ -307,7 +315,14 @@ int QEvent::setGenstepUpload(const quad6* qq, int num_genstep )
 
     //count_genstep_photons();   // sets evt->num_seed
     //fill_seed_buffer() ;       // populates seed buffer
-    count_genstep_photons_and_fill_seed_buffer();   // combi-function doing what both the above do 
+    if(evt->seed)
+    {
+        count_genstep_photons_and_fill_seed_buffer();   // combi-function doing what both the above do 
+    }
+    else
+    {
+        fill_genstep_lookup();   // sets evt->num_seed without any per photon buffer
+    }
 
 #ifndef PRODUCTION 
     sev->t_setGenstep_7 = sstamp::Now(); 
@@ -343,14 +358,32 @@ QEvent::device_alloc_genstep_and_seed
 Allocates memory for genstep and seed, keeping device pointers within
 the hostside sevent.h "evt->genstep" "evt->seed"
 
+With seedless SEventConfig::GenstepLookup the max_photon seed buffer 
+is replaced by max_genstep+1 genstep offsets "evt->gs_offset" 
+and for "table" mode also the coarse table "evt->gs_table". 
+
 **/
 
 void QEvent::device_alloc_genstep_and_seed()
 {
+    int lookup = SEventConfig::GenstepLookup() ; 
     LOG_IF(info, LIFECYCLE) ; 
-    LOG(LEVEL) << " device_alloc genstep and seed " ; 
+    LOG(LEVEL) << " device_alloc genstep and seed lookup " << sgenstep_lookup::Name(lookup) ; 
     evt->genstep = QU::device_alloc<quad6>( evt->max_genstep, "QEvent::setGenstep/device_alloc_genstep_and_seed:quad6" ) ; 
-    evt->seed    = QU::device_alloc<int>(   evt->max_photon , "QEvent::setGenstep/device_alloc_genstep_and_seed:int seed" )  ;
+
+    if( lookup == sgenstep_lookup::SEED )
+    {
+        evt->seed    = QU::device_alloc<int>(   evt->max_photon , "QEvent::setGenstep/device_alloc_genstep_and_seed:int seed" )  ;
+    }
+    else
+    {
+        evt->gs_offset = QU::device_alloc<int>( evt->max_genstep + 1, "QEvent::setGenstep/device_alloc_genstep_and_seed:int gs_offset" ) ; 
+        if( lookup == sgenstep_lookup::TABLE )
+        {
+            int num_table = sgenstep_lookup::NumTable(evt->max_photon) ; 
+            evt->gs_table = QU::device_alloc<int>( num_table + 1, "QEvent::setGenstep/device_alloc_genstep_and_seed:int gs_table" ) ; 
+        }
+    }
 }
 
 
@@ -459,7 +492,7 @@ int QEvent::setGenstep(quad6* qgs, unsigned num_gs )  // TODO: what uses this ?
 // TODO: how to avoid duplication between QEvent and SEvt ?
 
 bool QEvent::hasGenstep() const { return evt->genstep != nullptr ; }
-bool QEvent::hasSeed() const {    return evt->seed != nullptr ; }
+bool QEvent::hasSeed() const {    return evt->seed != nullptr || evt->gs_offset != nullptr ; }
 bool QEvent::hasPhoton() const {  return evt->photon != nullptr ; }
 bool QEvent::hasRecord() const { return evt->record != nullptr ; }
 bool QEvent::hasRec() const    { return evt->rec != nullptr ; }
@@ -513,6 +546,23 @@ void QEvent::count_genstep_photons_and_fill_seed_buffer()
     QEvent_count_genstep_photons_and_fill_seed_buffer( evt ); 
 }
 
+/**
+QEvent::fill_genstep_lookup
+-----------------------------
+
+Seedless alternative to count_genstep_photons_and_fill_seed_buffer, 
+fills the device genstep offsets (and table) and sets evt->num_seed,
+see sgenstep_lookup.h 
+
+**/
+
+extern "C" void QEvent_fill_genstep_lookup(sevent* evt ); 
+void QEvent::fill_genstep_lookup()
+{
+    LOG_IF(info, LIFECYCLE) ; 
+    QEvent_fill_genstep_lookup( evt ); 
+}
+
 
 
 
@@ -573,7 +623,16 @@ NP* QEvent::gatherSeed() const
     LOG_IF(fatal, !has_seed) << " gatherSeed called when there is no such array, use SEventConfig::SetCompMask to avoid " ; 
     if(!has_seed) return nullptr ;  
     NP* s = NP::Make<int>( evt->num_seed );   // TODO: use SEvt::makeSeed
-    QU::copy_device_to_host<int>( (int*)s->bytes(), evt->seed, evt->num_seed ); 
+    if( evt->seed )
+    {
+        QU::copy_device_to_host<int>( (int*)s->bytes(), evt->seed, evt->num_seed ); 
+    }
+    else
+    {
+        std::vector<int> offset( evt->num_genstep + 1 ) ;   // seedless : expand from the genstep offsets 
+        QU::copy_device_to_host<int>( offset.data(), evt->gs_offset, evt->num_genstep + 1 ); 
+        sgenstep_lookup::Expand( s->values<int>(), offset.data(), evt->num_genstep ); 
+    }
     return s ; 
 }
 
@@ -812,6 +871,65 @@ NP* QEvent::gatherHit_() const
 }
 
 
+/**
+QEvent::gatherHitColumns
+--------------------------
+
+Columnar alternative to QEvent::gatherHit used when SEventConfig::HitColumns
+is configured, see sphoton_column.h 
+
+1. count *evt.num_hit* passing the photon *selector* 
+2. allocate one device buffer sized for the selected columns of *evt.num_hit* hits 
+3. select and write the columns on device with SU::copy_if_device_to_device_presized_sphoton_column
+4. add host arrays for the selected columns to *fold* and download each column into them
+5. free the device buffer 
+
+Only the selected column bytes are allocated on device and downloaded, 
+eg 22 bytes per hit with "pos,time,wavelength,identity,half" compared with 
+64 bytes for the sphoton hits of QEvent::gatherHit_
+
+Returns the number of hits or -1 when there is no photon array. 
+
+**/
+
+int QEvent::gatherHitColumns(NPFold* fold) const 
+{
+    bool has_photon = hasPhoton(); 
+    LOG_IF(LEVEL, !has_photon) << " gatherHitColumns called when there is no photon array " ; 
+    if(!has_photon) return -1 ; 
+
+    LOG_IF(fatal, evt->num_photon == 0 ) << " evt->num_photon ZERO " ;  
+    assert( evt->num_photon ); 
+
+    evt->num_hit = SU::count_if_sphoton( evt->photon, evt->num_photon, *selector );    
+    if( evt->num_hit == 0 ) return 0 ; 
+
+    unsigned mask = SEventConfig::HitColumns() ; 
+    size_t bytes = sphoton_column::Bytes(mask, evt->num_hit) ; 
+
+    char* d_buf = QU::device_alloc<char>( bytes, "QEvent::gatherHitColumns:char" ); 
+
+    sphoton_column d_column(mask, evt->num_hit) ; 
+    d_column.init_contiguous(d_buf) ; 
+
+    SU::copy_if_device_to_device_presized_sphoton_column( d_column, evt->photon, evt->num_photon, *selector );
+
+    sphoton_column h_column(mask, evt->num_hit) ; 
+    h_column.add_arrays(fold) ; 
+
+    for(int f=0 ; f < sphoton_column::NUM_FIELD ; f++)
+    {
+        if(h_column.col[f] == nullptr) continue ; 
+        QU::copy_device_to_host<char>( h_column.col[f], d_column.col[f], evt->num_hit*sphoton_column::ItemSize(mask, f) ); 
+    }
+
+    QU::device_free<char>( d_buf ); 
+
+    LOG(LEVEL) << h_column.desc() ; 
+    return evt->num_hit ; 
+}
+
+
 /**
 QEvent::getMeta
 -----------------
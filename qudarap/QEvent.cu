@@ -6,15 +6,20 @@
 #include "sphoton.h"
 #include "sevent.h"
 
+#include "sgenstep_lookup.h"
+
 #include "iexpand.h"
 #include "strided_range.h"
 #include <thrust/device_vector.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
 
 /**
 _QEvent_checkEvt
 -----------------
 
-Demonstrates using seed buffer to lookup genstep_id from photon_id 
+Demonstrates using seed buffer (or seedless genstep offsets) to lookup genstep_id from photon_id 
 
 **/
 
@@ -24,7 +29,7 @@ __global__ void _QEvent_checkEvt(sevent* evt, unsigned width, unsigned height)
     if( ix >= width ) return ;  
 
     unsigned photon_id = ix ; 
-    unsigned genstep_id = evt->seed[photon_id] ; 
+    unsigned genstep_id = evt->genstep_id(photon_id) ; 
     const quad6& gs = evt->genstep[genstep_id] ; 
     int gencode = gs.q0.i.x ; 
     unsigned num_photon = evt->num_photon ; 
@@ -238,4 +243,71 @@ extern "C" void QEvent_count_genstep_photons_and_fill_seed_buffer(sevent* evt )
 
 
 
+/**
+QEvent_fill_genstep_lookup
+----------------------------
+
+Seedless alternative to QEvent_count_genstep_photons_and_fill_seed_buffer, 
+invoked from QEvent::setGenstepUpload when SEventConfig::GenstepLookup is not "seed". 
+
+1. inclusive_scan of the strided numphoton into gs_offset+1 with gs_offset[0]=0,
+   giving the exclusive prefix sum with the total at gs_offset[num_genstep]
+
+2. when gs_table is allocated fill it with the genstep of the first photon
+   of each bucket of 2^sgenstep_lookup::TABLE_SHIFT photons, and the last 
+   entry num_genstep-1 
+
+No zeroing is needed as every used element is written. 
+
+**/
+
+struct genstep_table_functor
+{
+    const int* offset ; 
+    int num_genstep ; 
+
+    genstep_table_functor(const int* offset_, int num_genstep_) : offset(offset_), num_genstep(num_genstep_) {} 
+
+    __device__ int operator()(int b) const 
+    { 
+        return sgenstep_lookup::GenstepId( offset, num_genstep, nullptr, b << sgenstep_lookup::TABLE_SHIFT ) ; 
+    }
+};
+
+extern "C" void QEvent_fill_genstep_lookup(sevent* evt )
+{
+    typedef typename thrust::device_vector<int>::iterator Iterator;
+
+    thrust::device_ptr<int> t_gs = thrust::device_pointer_cast( (int*)evt->genstep ) ; 
+
+    strided_range<Iterator> gs_pho( 
+        t_gs + sevent::genstep_numphoton_offset, 
+        t_gs + evt->num_genstep*sevent::genstep_itemsize , 
+        sevent::genstep_itemsize );    // begin, end, stride 
+
+    assert( evt->gs_offset ); 
+    thrust::device_ptr<int> t_offset = thrust::device_pointer_cast(evt->gs_offset) ; 
+    t_offset[0] = 0 ; 
+    thrust::inclusive_scan( gs_pho.begin(), gs_pho.end(), t_offset + 1 ); 
+
+    evt->num_seed = t_offset[evt->num_genstep] ; 
+
+#ifdef DEBUG_QEVENT
+    printf("//QEvent_fill_genstep_lookup evt.num_genstep %d evt.num_seed %d evt.max_photon %d gs_table %s \n", 
+        evt->num_genstep, evt->num_seed, evt->max_photon, ( evt->gs_table ? "YES" : "NO" ) ); 
+#endif
+
+    bool num_seed_ok = evt->num_seed <= evt->max_photon ;
+    if(!num_seed_ok) printf("//QEvent_fill_genstep_lookup FAIL evt.num_seed %d evt.max_photon %d \n", evt->num_seed, evt->max_photon ); 
+    assert( num_seed_ok ); 
+
+    if( evt->gs_table )
+    {
+        int num_table = sgenstep_lookup::NumTable( evt->num_seed ) ; 
+        thrust::device_ptr<int> t_table = thrust::device_pointer_cast(evt->gs_table) ; 
+        thrust::counting_iterator<int> b0(0) ; 
+        thrust::transform( b0, b0 + num_table, t_table, genstep_table_functor(evt->gs_offset, evt->num_genstep) ); 
+        t_table[num_table] = evt->num_genstep > 0 ? evt->num_genstep - 1 : 0 ; 
+    }
+}
 
@@ -7,6 +7,7 @@ struct salloc ;
 struct qat4 ; 
 struct quad6 ;
 struct NP ; 
+struct NPFold ; 
 
 struct SEvt ; 
 struct sphoton_selector ; 
@@ -105,6 +106,7 @@ private:
     unsigned count_genstep_photons(); 
     void     fill_seed_buffer(); 
     void     count_genstep_photons_and_fill_seed_buffer(); 
+    void     fill_genstep_lookup(); 
 
 public:
     // who uses these ? TODO: switch to comp based 
@@ -125,6 +127,7 @@ public:
     std::string getMeta() const ;  // returns underlying (SEvt)sev->meta
     const char* getTypeName() const ; 
     NP*      gatherComponent(unsigned comp) const ; 
+    int      gatherHitColumns(NPFold* fold) const ; 
 public:
     // [ expedient getters : despite these coming from SEvt 
     NP*      getGenstep() const ; 
@@ -1,4 +1,5 @@
 #include "NP.hh"
+#include "ssys.h"
 
 #if defined(MOCK_CURAND)
 #include "plog/Severity.h"
@@ -84,7 +85,7 @@ Instanciation:
 **/
 
 template<typename T>
-QProp<T>::QProp(const NP* a_)
+QProp<T>::QProp(const NP* a_, int grid_n_)
     :
     a(a_),
     pp(a ? a->cvalues<T>() : nullptr),
@@ -92,6 +93,7 @@ QProp<T>::QProp(const NP* a_)
     ni(a ? a->shape[0] : 0 ),
     nj(a ? a->shape[1] : 0 ),
     nk(a ? a->shape[2] : 0 ),
+    grid_n( grid_n_ < 0 ? ssys::getenvint(GRID_, 0) : grid_n_ ),
     prop(new qprop<T>),
     d_prop(nullptr)
 {
@@ -119,9 +121,48 @@ void QProp<T>::init()
     assert( type_consistent );  
 
     //dump(); 
+    if( grid_n > 0 ) initGrid(); 
     upload(); 
 }
 
+/**
+QProp::initGrid
+-----------------
+
+For each property divides the domain [x_first, x_last] into grid_n equal 
+buckets and records at each of the grid_n+1 bucket edges the index of 
+the last item with domain value not above the edge, limited to ni-2 
+so that item+1 is always valid. 
+
+**/
+
+template<typename T>
+void QProp<T>::initGrid()
+{
+    grid.resize( ni*(grid_n+1) ); 
+    grid_dom.resize( ni*2 ); 
+
+    for(unsigned i=0 ; i < ni ; i++)
+    {
+        const T* vv = pp + nj*nk*i ; 
+        int prop_ni = sview::int_from<T>( vv[nj*nk-1] ) ; 
+        T x0 = vv[0] ; 
+        T x1 = vv[2*(prop_ni-1)] ; 
+        T scale = x1 > x0 ? T(grid_n)/(x1 - x0) : T(0) ; 
+        grid_dom[2*i+0] = x0 ; 
+        grid_dom[2*i+1] = scale ; 
+
+        int* gg = grid.data() + (grid_n+1)*i ; 
+        int j = 0 ; 
+        for(unsigned b=0 ; b <= grid_n ; b++)
+        {
+            T edge = b == grid_n ? x1 : x0 + (x1 - x0)*T(b)/T(grid_n) ; 
+            while( j + 1 < prop_ni - 1 && vv[2*(j+1)] <= edge ) j++ ; 
+            gg[b] = prop_ni > 1 ? j : 0 ; 
+        }
+    }
+}
+
 /**
 QProp::upload
 --------------
@@ -144,12 +185,21 @@ void QProp<T>::upload()
     prop->height = ni ;   
     prop->width  = nj*nk ;
 
+    prop->grid_n = grid.size() > 0 ? grid_n : 0 ; 
+
 #if defined(MOCK_CURAND)
     prop->pp = const_cast<T*>(pp) ; 
+    prop->grid = grid.size() > 0 ? grid.data() : nullptr ; 
+    prop->grid_dom = grid.size() > 0 ? grid_dom.data() : nullptr ; 
     d_prop = prop ; 
 #else
     prop->pp = QU::device_alloc<T>(nv,"QProp::upload/pp") ; 
     QU::copy_host_to_device<T>( prop->pp, pp, nv ); 
+    if( grid.size() > 0 )
+    {
+        prop->grid = QU::UploadArray<int>(grid.data(), grid.size(), "QProp::upload/grid"); 
+        prop->grid_dom = QU::UploadArray<T>(grid_dom.data(), grid_dom.size(), "QProp::upload/grid_dom"); 
+    }
     d_prop = QU::UploadArray<qprop<T>>(prop, 1, "QProp::upload/d_prop");  
 #endif
 
@@ -161,6 +211,8 @@ void QProp<T>::cleanup()
 #if defined(MOCK_CURAND)
 #else
     QUDA_CHECK(cudaFree(prop->pp)); 
+    if(prop->grid) QUDA_CHECK(cudaFree(prop->grid)); 
+    if(prop->grid_dom) QUDA_CHECK(cudaFree(prop->grid_dom)); 
     QUDA_CHECK(cudaFree(d_prop)); 
 #endif
 }
@@ -180,6 +232,7 @@ std::string QProp<T>::desc() const
        << " ni " << ni
        << " nj " << nj
        << " nk " << nk
+       << " grid_n " << grid_n 
        ;
     return ss.str(); 
 }
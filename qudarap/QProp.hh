@@ -21,6 +21,15 @@ The QProp approach is very close to what Geant4 does, the texture approach
 is likely faster but takes more effort to setup and probably requires fine
 textures to reproduce the Geant4 results. 
 
+Uniform grid acceleration
+----------------------------
+
+With QProp__GRID set to the number of buckets per property, QProp::initGrid builds 
+the uniform bucket index used by qprop::interpolate to narrow the binary search, 
+see qprop.h. The interpolated values are unchanged:: 
+
+    export QProp__GRID=256   # 0: no grid, plain binary search (default) 
+
 **/
 
 #include <vector>
@@ -38,6 +47,7 @@ template <typename T>
 struct QUDARAP_API QProp
 {
     static const plog::Severity LEVEL ;
+    static constexpr const char* GRID_ = "QProp__GRID" ; 
     static const QProp<T>*  INSTANCE ; 
     static const QProp<T>*  Get(); 
 
@@ -49,13 +59,18 @@ struct QUDARAP_API QProp
     unsigned nj ; 
     unsigned nk ; 
 
+    unsigned         grid_n ; 
+    std::vector<int> grid ; 
+    std::vector<T>   grid_dom ; 
+
     qprop<T>* prop ; 
     qprop<T>* d_prop ; 
 
-    QProp(const NP* a); 
+    QProp(const NP* a, int grid_n=-1);   // -1: from QProp__GRID 
 
     virtual ~QProp(); 
     void init(); 
+    void initGrid(); 
     void upload(); 
     void cleanup(); 
 
@@ -2,6 +2,10 @@
 #include <cstring>
 #include "SLOG.hh"
 #include "SPath.hh"
+#include "ssys.h"
+#include "spath.h"
+#include "s_curand_xorwow.h"
+#include "SEventConfig.hh"
 #include "SCurandState.hh"
 #include "QRng.hh"
 #include "qrng.h"
@@ -18,7 +22,7 @@ QRng::QRng(unsigned skipahead_event_offset)
     :
     path(SCurandState::Path()),        // null path will assert in Load
     rngmax(0),
-    rng_states(Load(rngmax, path)),   // rngmax set based on file_size/item_size 
+    rng_states(LoadOrGenerate(rngmax, path)),   // rngmax set based on file_size/item_size or config 
     qr(new qrng(skipahead_event_offset)),
     d_qr(nullptr)
 {
@@ -60,6 +64,75 @@ as shown below::
 
 )" ;
 
+/**
+QRng::LoadOrGenerate
+----------------------
+
+Loads states from file when it exists. Otherwise returns nullptr 
+with rngmax set to SEventConfig::MaxCurandState which QRng::upload 
+takes as the signal to generate the states chunk by chunk with QRng::UploadGenerate. 
+The seed and offset of zero match those used by SCurandState::Path.
+
+**/
+
+curandState* QRng::LoadOrGenerate(long& rngmax, const char* path)  // static 
+{
+    bool forced = ssys::getenvbool(GENERATE_) ; 
+    bool missing = path == nullptr || !spath::Exists(path) ; 
+    LOG(LEVEL) << " path " << ( path ? path : "-" ) << " forced " << ( forced ? "YES" : "NO" ) << " missing " << ( missing ? "YES" : "NO" ) ; 
+    if(!forced && !missing) return Load(rngmax, path) ; 
+
+    rngmax = SEventConfig::MaxCurandState() ; 
+
+    LOG_IF(warning, missing) 
+        << " curandState file [" << ( path ? path : "-" ) << "] does not exist"
+        << " : GENERATING " << rngmax << " states on host"
+        << " (" << sizeof(curandState)*rngmax/1000000 << " MB of device memory)"
+        << " in chunks of " << ssys::getenvint(CHUNK_, 1000000) 
+        << " : set " << GENERATE_ << " to skip this warning or create the file with qudarap-prepare-installation"
+        ; 
+
+    return nullptr ; 
+}
+
+/**
+QRng::UploadGenerate
+----------------------
+
+Host equivalent of QCurandState creation, the states are identical 
+to those from curand_init(seed, i, offset) for i in [0, rngmax). 
+They are created by s_curand_xorwow_chunked one chunk at a time, 
+each chunk being copied into the device array and then freed, 
+so host memory is bounded by QRng__CHUNK states. 
+Returns the device pointer. 
+
+**/
+
+curandState* QRng::UploadGenerate(long rngmax, unsigned long long seed, unsigned long long offset)  // static 
+{
+    static_assert( sizeof(curandState) == sizeof(s_curand_xorwow), "s_curand_xorwow layout must match curandState" ); 
+    int num_threads = ssys::getenvint(THREADS_, 0) ; 
+    int chunk_size = ssys::getenvint(CHUNK_, 1000000) ; 
+
+    curandState* d_rng_states = QU::device_alloc<curandState>( rngmax, "QRng::UploadGenerate/rng_states" ) ; 
+
+    s_curand_xorwow_chunked gen( rngmax, seed, offset, chunk_size, num_threads ); 
+    for(int c=0 ; c < gen.num_chunk() ; c++)
+    {
+        const s_curand_xorwow* states = gen.get_chunk(c) ; 
+        QU::copy_host_to_device<curandState>( d_rng_states + gen.chunk_size*c, (const curandState*)states, gen.chunk_num(c) ); 
+        gen.release_chunk(c) ; 
+    }
+
+    LOG(LEVEL) 
+        << " rngmax " << rngmax 
+        << " seed " << seed 
+        << " offset " << offset 
+        << " " << gen.desc()
+        ; 
+    return d_rng_states ; 
+}
+
 /**
 QRng::Load
 ------------
@@ -142,11 +215,18 @@ void QRng::Save( curandState* states, unsigned num_states, const char* path ) //
 
 void QRng::upload()
 {
-    const char* label_0 = "QRng::upload/rng_states" ; 
-    qr->rng_states = QU::UploadArray<curandState>(rng_states, rngmax, label_0 ) ;   
-
-    free(rng_states); 
-    rng_states = nullptr ; 
+    if( rng_states == nullptr )  // file missing or QRng__GENERATE 
+    {
+        qr->rng_states = UploadGenerate(rngmax, 0ull, 0ull ) ; 
+    }
+    else
+    {
+        const char* label_0 = "QRng::upload/rng_states" ; 
+        qr->rng_states = QU::UploadArray<curandState>(rng_states, rngmax, label_0 ) ;   
+
+        free(rng_states); 
+        rng_states = nullptr ; 
+    }
 
     const char* label_1 = "QRng::upload/d_qr" ; 
     d_qr = QU::UploadArray<qrng>(qr, 1, label_1 ); 
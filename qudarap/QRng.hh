@@ -11,6 +11,18 @@ Small *skipahead_event_offsets* are for functionality testing,
 typically the offset should be greater than the maximum number of 
 randoms to simulate an item(photon). 
 
+When the curandState file from SCurandState::Path does not exist or 
+QRng__GENERATE is set the states are instead created on the host 
+with the bit-exact s_curand_xorwow.h (equivalent to curand_init(0, photon_idx, 0))
+using QRng__THREADS threads (0: all cores), avoiding the need for 
+large precomputed state files. The states are generated and uploaded 
+QRng__CHUNK at a time so host memory is bounded by one chunk::
+
+    export QRng__GENERATE=1 
+    export QRng__THREADS=0 
+    export QRng__CHUNK=1000000
+
+
 **/
 
 #include <string>
@@ -28,8 +40,14 @@ struct QUDARAP_API QRng
     static const char* DEFAULT_PATH ; 
     static const QRng* Get(); 
 
+    static constexpr const char* GENERATE_ = "QRng__GENERATE" ; 
+    static constexpr const char* THREADS_ = "QRng__THREADS" ; 
+    static constexpr const char* CHUNK_ = "QRng__CHUNK" ; 
+
     static const char* Load_FAIL_NOTES ; 
+    static curandState* LoadOrGenerate(long& rngmax, const char* path); 
     static curandState* Load(long& rngmax, const char* path); 
+    static curandState* UploadGenerate(long rngmax, unsigned long long seed, unsigned long long offset); 
     static void Save( curandState* states, unsigned num_states, const char* path ); 
 
     const char*    path ; 
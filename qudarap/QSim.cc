@@ -8,6 +8,7 @@
 #include "spath.h"
 #include "scontext.h"
 #include "SProf.hh"
+#include "stimeline.h"
 
 #include "SEvt.hh"
 #include "SSim.hh"
@@ -347,6 +348,7 @@ the launch.
 
 double QSim::simulate(int eventID, bool reset_)
 {
+    STIMELINE_SCOPE("QSim::simulate"); 
     SProf::Add("QSim__simulate_HEAD"); 
 
     LOG_IF(info, SEvt::LIFECYCLE) << "[ eventID " << eventID ;
@@ -354,13 +356,21 @@ double QSim::simulate(int eventID, bool reset_)
 
     sev->beginOfEvent(eventID);  // set SEvt index and tees up frame gensteps for simtrace and input photon simulate running
 
-    int rc = event->setGenstep() ;    // QEvent 
+    int rc = 0 ; 
+    {
+        STIMELINE_SCOPE("QSim::simulate.setGenstep"); 
+        rc = event->setGenstep() ;    // QEvent 
+    }
     LOG_IF(error, rc != 0) << " QEvent::setGenstep ERROR : have event but no gensteps collected : will skip cx.simulate " ; 
 
     SProf::Add("QSim__simulate_PREL"); 
 
     sev->t_PreLaunch = sstamp::Now() ; 
-    double dt = rc == 0 && cx != nullptr ? cx->simulate_launch() : -1. ;  //SCSGOptiX protocol
+    double dt = -1. ; 
+    {
+        STIMELINE_SCOPE("QSim::simulate.launch"); 
+        dt = rc == 0 && cx != nullptr ? cx->simulate_launch() : -1. ;  //SCSGOptiX protocol
+    }
     sev->t_PostLaunch = sstamp::Now() ; 
     sev->t_Launch = dt ; 
 
@@ -372,6 +382,8 @@ double QSim::simulate(int eventID, bool reset_)
 
     int num_ht = sev->getNumHit() ; 
     int num_ph = event->getNumPhoton() ; 
+    STIMELINE_COUNTER("QSim::simulate.num_ph", num_ph ); 
+    STIMELINE_COUNTER("QSim::simulate.num_ht", num_ht ); 
 
     LOG(info) 
         << " eventID " << eventID 
@@ -172,7 +172,7 @@ __global__ void _QSim_generate_photon(qsim* sim)
     if (idx >= evt->num_photon) return;
     
     curandState rng = sim->rngstate[idx] ; 
-    unsigned genstep_id = evt->seed[idx] ; 
+    unsigned genstep_id = evt->genstep_id(idx) ; 
     const quad6& gs     = evt->genstep[genstep_id] ; 
 
     //printf("//_QSim_generate_photon idx %4d evt->num_photon %4d genstep_id %4d  \n", idx, evt->num_photon, genstep_id );  
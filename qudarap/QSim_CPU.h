@@ -0,0 +1,315 @@
+#pragma once
+/**
+QSim_CPU.h : multi-threaded CPU simulation using the MOCK_CURAND qsim.h
+=========================================================================
+
+GPU free equivalent of CSGOptiX/CSGOptiX7.cu:simulate that loops over
+the photons of the gensteps collected into an SEvt, calling
+qsim::generate_photon and the qsim::propagate bounce loop for each photon.
+Used for validation and for running on nodes without GPUs.
+
+* photon results are written into the hostside SEvt vectors via the
+  sevent.h pointers set by SEvt::hostside_running_resize, so the usual
+  SEvt::gather and save machinery applies
+
+* threads claim chunks of photon indices from a shared atomic counter,
+  so threads that finish early take more chunks (dynamic scheduling)
+
+* each thread owns a curandStateXORWOW that is re-initialized
+  for every photon from (seed, photon_idx) with QSim_CPU::InitRNG,
+  so results do not depend on the number of threads or the chunking
+
+* geometry intersection is provided by the *trace* callback which must
+  fill the quad2 prd in the same way as the OptiX trace, eg using CSGQuery::trace.
+  This keeps QUDARap independent of CSG.
+
+Configure with::
+
+    export QSim_CPU__THREADS=0      # 0: std::thread::hardware_concurrency
+    export QSim_CPU__CHUNK=1024     # photons per chunk claimed by a thread
+
+Usage::
+
+    qsim* sim = ... ;   // with bnd, base, pmt etc from mocked QBnd, QPMT, ...
+    QSim_CPU::Trace trace = [&](quad2* prd, const float3& pos, const float3& mom, float tmin){ ... } ;
+    QSim_CPU cpu(sim, SEvt::Get_ECPU(), trace) ;
+    cpu.simulate() ;
+
+**/
+
+#if defined(MOCK_CURAND) || defined(MOCK_CUDA)
+
+#include <atomic>
+#include <thread>
+#include <functional>
+
+#include "ssys.h"
+#include "sstamp.h"
+#include "SEvt.hh"
+#include "SEventConfig.hh"
+#include "sgenstep_lookup.h"
+#include "qsim.h"
+
+struct QSim_CPU
+{
+    typedef std::function<void(quad2* prd, const float3& pos, const float3& mom, float tmin)> Trace ;
+
+    static constexpr const char* THREADS_ = "QSim_CPU__THREADS" ;
+    static constexpr const char* CHUNK_ = "QSim_CPU__CHUNK" ;
+
+    static void InitRNG( curandStateXORWOW& rng, unsigned long long seed, unsigned idx );
+    static int  SeedPhotons( std::vector<int>& seed, std::vector<int>& offset, std::vector<int>& table, const std::vector<quad6>& genstep, int mode );
+
+    qsim*     sim ;
+    SEvt*     sev ;
+    Trace     trace ;
+    float     tmin ;
+    unsigned long long rng_seed ;
+    int       num_threads ;
+    int       chunk ;
+
+    int                  lookup ;   // sgenstep_lookup mode from SEventConfig::GenstepLookup
+    int                  num_photon ;
+    std::vector<int>     seed ;     // photon_idx -> genstep_idx, as from QEvent::setGenstep on device, empty when seedless
+    std::vector<int>     gs_offset ; // genstep numphoton exclusive prefix sum, see sgenstep_lookup.h
+    std::vector<int>     gs_table ;
+    std::atomic<int64_t> next ;     // next photon_idx to be claimed
+    std::vector<int64_t> thread_count ;
+
+    QSim_CPU( qsim* sim, SEvt* sev, Trace trace, float tmin=0.1f, unsigned long long rng_seed=0ull );
+
+    int  simulate();
+    void worker(int t);
+    void simulate_photon(unsigned idx, curandStateXORWOW& rng, quad2* prd ) const ;
+
+    std::string desc() const ;
+};
+
+
+inline QSim_CPU::QSim_CPU( qsim* sim_, SEvt* sev_, Trace trace_, float tmin_, unsigned long long rng_seed_ )
+    :
+    sim(sim_),
+    sev(sev_),
+    trace(trace_),
+    tmin(tmin_),
+    rng_seed(rng_seed_),
+    num_threads(ssys::getenvint(THREADS_, 0)),
+    chunk(ssys::getenvint(CHUNK_, 1024)),
+    lookup(SEventConfig::GenstepLookup()),
+    num_photon(0),
+    next(0)
+{
+    if( num_threads <= 0 ) num_threads = std::max( 1u, std::thread::hardware_concurrency() ) ;
+    if( chunk <= 0 ) chunk = 1 ;
+}
+
+/**
+QSim_CPU::InitRNG
+-------------------
+
+Per-photon stream initialization. With the srng based mock curand this
+seeds the engine from a splitmix64 mix of *seed* and *idx*.
+
+With MOCK_CURAND_XORWOW the state is the bit-exact host XORWOW, initialized
+as curand_init(seed, idx, 0) giving the same randoms as the GPU photon *idx*
+using QRng states of that seed (for event index 0).
+*worker* then avoids the full init by stepping a base state from one
+photon subsequence to the next with a single jump.
+
+**/
+
+inline void QSim_CPU::InitRNG( curandStateXORWOW& rng, unsigned long long seed, unsigned idx ) // static
+{
+#if defined(MOCK_CURAND_XORWOW)
+    curand_init( seed, idx, 0ull, &rng );
+#else
+    unsigned long long z = seed + 0x9e3779b97f4a7c15ull*( 1ull + idx ) ;
+    z = ( z ^ ( z >> 30 )) * 0xbf58476d1ce4e5b9ull ;
+    z = ( z ^ ( z >> 27 )) * 0x94d049bb133111ebull ;
+    z = z ^ ( z >> 31 ) ;
+    rng.engine.seed(z) ;
+#endif
+}
+
+/**
+QSim_CPU::SeedPhotons
+-----------------------
+
+Host equivalent of the device side seeding, giving the
+genstep index for every photon index. The genstep offsets are 
+always filled, the seed array only with sgenstep_lookup::SEED mode 
+and the coarse table only with sgenstep_lookup::TABLE mode.
+Returns the total number of photons.
+
+**/
+
+inline int QSim_CPU::SeedPhotons( std::vector<int>& seed, std::vector<int>& offset, std::vector<int>& table, const std::vector<quad6>& genstep, int mode ) // static
+{
+    int num_genstep = genstep.size() ;
+    offset.resize( num_genstep + 1 );
+    const int* gs = (const int*)genstep.data() ;
+    int num = sgenstep_lookup::FillOffset<int>( offset.data(), gs, num_genstep, sevent::genstep_itemsize, sevent::genstep_numphoton_offset );
+
+    seed.clear();
+    table.clear();
+    if( mode == sgenstep_lookup::SEED )
+    {
+        seed.resize( num );
+        sgenstep_lookup::Expand( seed.data(), offset.data(), num_genstep );
+    }
+    else if( mode == sgenstep_lookup::TABLE )
+    {
+        table.resize( sgenstep_lookup::NumTable(num) + 1 );
+        sgenstep_lookup::FillTable( table.data(), offset.data(), num_genstep, num );
+    }
+    return num ;
+}
+
+/**
+QSim_CPU::simulate
+--------------------
+
+1. seed photons from the SEvt gensteps
+2. hostside resize of SEvt vectors, setting sevent.h pointers
+3. launch threads to work through the photons
+
+Returns the number of photons simulated.
+
+**/
+
+inline int QSim_CPU::simulate()
+{
+    int64_t t0 = sstamp::Now();
+
+    num_photon = SeedPhotons( seed, gs_offset, gs_table, sev->genstep, lookup );
+
+    sevent* evt = sev->evt ;
+    assert( evt->num_photon == num_photon );
+    if(!sev->hostside_running_resize_done) sev->hostside_running_resize() ;
+
+    evt->genstep = sev->genstep.data() ;
+    evt->seed = seed.empty() ? nullptr : seed.data() ;
+    evt->gs_offset = gs_offset.data() ;
+    evt->gs_table = gs_table.empty() ? nullptr : gs_table.data() ;
+    evt->num_genstep = int(sev->genstep.size()) ;
+    evt->num_seed = num_photon ;
+    sim->evt = evt ;
+
+    next = 0 ;
+    thread_count.assign( num_threads, 0 ) ;
+
+    if( num_threads == 1 )
+    {
+        worker(0);
+    }
+    else
+    {
+        std::vector<std::thread> threads ;
+        for(int t=0 ; t < num_threads ; t++) threads.emplace_back( &QSim_CPU::worker, this, t );
+        for(int t=0 ; t < num_threads ; t++) threads[t].join();
+    }
+
+    int64_t t1 = sstamp::Now();
+    sev->setMeta<int>("QSim_CPU_num_threads", num_threads );
+    sev->setMeta<int>("QSim_CPU_chunk", chunk );
+    sev->setMeta<uint64_t>("QSim_CPU_simulate_us", t1 - t0 );
+
+    return num_photon ;
+}
+
+inline void QSim_CPU::worker(int t)
+{
+    int64_t num = num_photon ;
+    curandStateXORWOW rng(1u) ;
+    quad2 prd ;
+
+    while(true)
+    {
+        int64_t i0 = next.fetch_add(chunk) ;
+        if( i0 >= num ) break ;
+        int64_t i1 = std::min( i0 + chunk, num ) ;
+#if defined(MOCK_CURAND_XORWOW)
+        curandStateXORWOW base ;
+        InitRNG( base, rng_seed, unsigned(i0) );
+#endif
+        for(int64_t idx=i0 ; idx < i1 ; idx++)
+        {
+#if defined(MOCK_CURAND_XORWOW)
+            rng = base ;
+            skipahead_sequence( 1ull, &base );
+#else
+            InitRNG( rng, rng_seed, unsigned(idx) );
+#endif
+            simulate_photon( unsigned(idx), rng, &prd );
+        }
+        thread_count[t] += i1 - i0 ;
+    }
+}
+
+/**
+QSim_CPU::simulate_photon
+---------------------------
+
+Follows CSGOptiX7.cu:simulate with *trace* standing in for the OptiX trace.
+
+**/
+
+inline void QSim_CPU::simulate_photon(unsigned idx, curandStateXORWOW& rng, quad2* prd ) const
+{
+    sevent* evt = sim->evt ;
+    unsigned genstep_idx = evt->genstep_id(idx) ;
+    const quad6& gs = evt->genstep[genstep_idx] ;
+
+    sctx ctx = {} ;
+    ctx.evt = evt ;
+    ctx.prd = prd ;
+    ctx.idx = idx ;
+
+    sim->generate_photon(ctx.p, rng, gs, idx, genstep_idx );
+
+    int command = START ;
+    int bounce = 0 ;
+#ifndef PRODUCTION
+    ctx.point(bounce);
+#endif
+    while( bounce < evt->max_bounce )
+    {
+        trace( prd, ctx.p.pos, ctx.p.mom, tmin );
+        if( prd->boundary() == 0xffffu ) break ;
+
+        float3* normal = prd->normal();
+        *normal = normalize(*normal);
+
+#ifndef PRODUCTION
+        ctx.trace(bounce);
+#endif
+        command = sim->propagate(bounce, rng, ctx);
+        bounce++;
+#ifndef PRODUCTION
+        ctx.point(bounce) ;
+#endif
+        if(command == BREAK) break ;
+    }
+#ifndef PRODUCTION
+    ctx.end();
+#endif
+    evt->photon[idx] = ctx.p ;
+}
+
+inline std::string QSim_CPU::desc() const
+{
+    std::stringstream ss ;
+    ss << "QSim_CPU::desc"
+       << " num_photon " << num_photon
+       << " lookup " << sgenstep_lookup::Name(lookup)
+       << " num_threads " << num_threads
+       << " chunk " << chunk
+       << " rng_seed " << rng_seed
+       << std::endl
+       ;
+    for(int t=0 ; t < int(thread_count.size()) ; t++) ss << " t " << std::setw(3) << t << " count " << thread_count[t] << std::endl ;
+    std::string str = ss.str();
+    return str ;
+}
+
+#endif
@@ -92,7 +92,7 @@ void QTex<T>::init()
 {
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
     assert(a); 
-    MockTextureManager::Add(a) ; 
+    texObj = MockTextureManager::Add(a, filterMode, normalizedCoords, 'W' ) ;  // wrap addressing as createTextureObject 
 #else
     createArray();   // cudaMallocArray using channelDesc for T 
     uploadToArray();
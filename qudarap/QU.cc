@@ -276,6 +276,8 @@ T* QU::device_alloc( unsigned num_items, const char* label )
     return d ; 
 }
 
+template QUDARAP_API char*      QU::device_alloc<char>(unsigned num_items, const char* label) ;
+template QUDARAP_API curandState* QU::device_alloc<curandState>(unsigned num_items, const char* label) ;
 template QUDARAP_API float*     QU::device_alloc<float>(unsigned num_items, const char* label) ;
 template QUDARAP_API double*    QU::device_alloc<double>(unsigned num_items, const char* label) ;
 template QUDARAP_API unsigned*  QU::device_alloc<unsigned>(unsigned num_items, const char* label) ;
@@ -371,6 +373,7 @@ void QU::device_free( T* d)
     QUDA_CHECK( cudaFree(d) ); 
 }
 
+template void   QU::device_free<char>(char*) ;
 template void   QU::device_free<float>(float*) ;
 template void   QU::device_free<double>(double*) ;
 template void   QU::device_free<unsigned>(unsigned*) ;
@@ -397,6 +400,7 @@ int QU::copy_device_to_host( T* h, T* d,  unsigned num_items)
 }
 
 
+template int QU::copy_device_to_host<char>(  char* h, char* d,  unsigned num_items);
 template int QU::copy_device_to_host<int>(  int* h, int* d,  unsigned num_items);
 template int QU::copy_device_to_host<float>(  float* h, float* d,  unsigned num_items);
 template int QU::copy_device_to_host<double>( double* h, double* d,  unsigned num_items);
@@ -502,6 +506,7 @@ template void QU::copy_host_to_device<quad4>(    quad4* d,    const quad4* h, un
 template void QU::copy_host_to_device<sphoton>(  sphoton* d,  const sphoton* h, unsigned num_items);
 template void QU::copy_host_to_device<quad6>(    quad6* d,    const quad6* h, unsigned num_items);
 template void QU::copy_host_to_device<quad2>(    quad2* d,    const quad2* h, unsigned num_items);
+template void QU::copy_host_to_device<curandState>( curandState* d, const curandState* h, unsigned num_items);
 
 /**
 QU::NumItems
@@ -7,6 +7,16 @@ HMM: this relies on the prop arrays having last column integer
 annotation as done by NP::combine but there is no naming 
 or anything that stresses that 
 
+Optional uniform grid acceleration
+-------------------------------------
+
+When *grid* is non-null (see QProp::initGrid) each property domain 
+[x_first, x_last] is divided into *grid_n* equal buckets. 
+For bucket edge b the table holds the index of the last domain value 
+not above the edge, so a lookup in bucket b only needs to binary search 
+between items grid[b] and grid[b+1]+1 rather than over the full domain. 
+*grid_dom* holds (x_first, grid_n/(x_last-x_first)) for each property.   
+
 **/
 
 
@@ -27,6 +37,10 @@ struct qprop
     unsigned width ; 
     unsigned height ; 
 
+    int*     grid ;       // (height, grid_n+1) item index at each bucket edge, nullptr for plain binary search 
+    T*       grid_dom ;   // (height, 2) 
+    unsigned grid_n ;     // buckets per property 
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_CURAND )
     QPROP_METHOD T  interpolate( unsigned iprop, T x );  
 #else
@@ -34,7 +48,10 @@ struct qprop
         :
         pp(nullptr),
         width(0),
-        height(0)
+        height(0),
+        grid(nullptr),
+        grid_dom(nullptr),
+        grid_n(0)
     {
     }
 #endif
@@ -50,8 +67,11 @@ qprop<T>::interpolate
 
 1. access property data for index iprop
 2. interpret the last column to obtain the number of payload values
-3. binary search to find the bin relevant to domain argument x  
-4. linear interpolation to yield the y value at x
+3. when the grid is present narrow the search range using the bucket of x, 
+   the range is only used where it is confirmed to bracket x, 
+   guarding against host/device rounding differences in the bucket 
+4. binary search to find the bin relevant to domain argument x  
+5. linear interpolation to yield the y value at x
 
 **/
 
@@ -70,6 +90,18 @@ inline QPROP_METHOD T qprop<T>::interpolate( unsigned iprop, T x )
     if( x <= vv[2*lo+0] ) return vv[2*lo+1] ; 
     if( x >= vv[2*hi+0] ) return vv[2*hi+1] ; 
 
+    if( grid )
+    {
+        const T* gd = grid_dom + 2*iprop ; 
+        int b = int( (x - gd[0])*gd[1] ) ; 
+        b = b < 0 ? 0 : ( b >= int(grid_n) ? int(grid_n) - 1 : b ) ; 
+        const int* gg = grid + (grid_n+1)*iprop ; 
+        int glo = gg[b] ; 
+        int ghi = gg[b+1] + 1 ; 
+        if( x >= vv[2*glo+0] ) lo = glo ; 
+        if( ghi < hi && x < vv[2*ghi+0] ) hi = ghi ; 
+    }
+
     while (lo < hi-1)
     {    
         int mi = (lo+hi)/2;
@@ -5,14 +5,89 @@ QProp_test.cc : CPU version of the CUDA QPropTest.cc
 Usage::
 
     ./QProp_test.sh 
+    TEST=bench ./QProp_test.sh 
 
 **/
 
+#include <random>
+#include <chrono>
+#include "ssys.h"
 #include "SPropMockup.h"
 #include "QPropTest.h"
+#include "qprop.h"
+
+/**
+test_bench
+------------
+
+Lookup rate of qprop::interpolate without and with the uniform grid 
+for synthetic properties with 2000-3000 irregularly spaced domain values, 
+requiring identical results. 
+
+**/
+
+int test_bench()
+{
+    std::mt19937 gen(42) ; 
+    std::uniform_real_distribution<float> u(0.f, 1.f) ; 
+
+    int num_prop = 16 ; 
+    std::vector<const NP*> aa ; 
+    for(int p=0 ; p < num_prop ; p++)
+    {
+        int n = 2000 + int(1000.f*u(gen)) ; 
+        NP* a = NP::Make<float>(n, 2) ; 
+        float* vv = a->values<float>() ; 
+        float x = 1.5f + u(gen) ; 
+        for(int i=0 ; i < n ; i++)
+        {
+            x += 0.001f + 0.01f*u(gen)*u(gen) ;    // irregular spacing 
+            vv[2*i+0] = x ; 
+            vv[2*i+1] = 1.4f + 0.1f*sinf(x) ; 
+        }
+        aa.push_back(a); 
+    }
+    const NP* propcom = NP::Combine(aa) ; 
+
+    int num = 4000000 ; 
+    std::vector<float> xx(num) ; 
+    for(int i=0 ; i < num ; i++) xx[i] = 1.f + 30.f*u(gen) ; 
+
+    QProp<float> plain(propcom, 0) ; 
+    QProp<float> grid(propcom, ssys::getenvint("GRID", 1024)) ; 
+
+    std::vector<float> y0(num) ; 
+    std::vector<float> y1(num) ; 
+
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+    for(int i=0 ; i < num ; i++) y0[i] = plain.prop->interpolate( i % num_prop, xx[i] ) ; 
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+    for(int i=0 ; i < num ; i++) y1[i] = grid.prop->interpolate( i % num_prop, xx[i] ) ; 
+    auto t2 = std::chrono::high_resolution_clock::now(); 
+
+    int mismatch = 0 ; 
+    for(int i=0 ; i < num ; i++) if( y0[i] != y1[i] ) mismatch += 1 ; 
+
+    double ms0 = std::chrono::duration<double, std::milli>(t1 - t0).count() ; 
+    double ms1 = std::chrono::duration<double, std::milli>(t2 - t1).count() ; 
+
+    std::cout 
+        << "QProp_test::test_bench"
+        << " propcom " << propcom->sstr()
+        << " num " << num 
+        << " plain_Mlookup_per_s " << num/ms0/1e3 
+        << " grid_Mlookup_per_s " << num/ms1/1e3 
+        << " mismatch " << mismatch 
+        << std::endl 
+        ; 
+    return mismatch == 0 ? 0 : 1 ; 
+}
 
 int main()
 {
+    const char* TEST = getenv("TEST") ; 
+    if( TEST && strcmp(TEST, "bench") == 0 ) return test_bench() ; 
+
     const NP* propcom = SPropMockup::CombinationDemo();
     std::cout << " propcom " << ( propcom ? propcom->sstr() : "-" ) << std::endl ; 
 
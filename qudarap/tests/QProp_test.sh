@@ -3,6 +3,11 @@ usage(){ cat << EOU
 QProp_test.sh 
 ===============
 
+::
+
+    ~/opticks/qudarap/tests/QProp_test.sh
+    TEST=bench GRID=1024 ~/opticks/qudarap/tests/QProp_test.sh build_run   # qprop lookup rate without and with grid 
+
 EOU
 }
 
@@ -27,7 +32,7 @@ fi
 
 if [ "${arg/build}" != "$arg" ]; then 
     gcc $name.cc ../QProp.cc  \
-       -g -std=c++11 -lstdc++ \
+       -g -O2 -std=c++11 -lstdc++ -lm \
        -DMOCK_CURAND \
        -I.. \
        -I../../sysrap \
@@ -0,0 +1,157 @@
+/**
+QSim_CPUTest.cc : multi-threaded CPU simulation with QSim_CPU.h
+==================================================================
+
+Torch photons from the origin are simulated within a single sphere 
+whose boundary is looked up from the BND spec. 
+The photon arrays simulated with one thread and with QSim_CPU__THREADS 
+threads are compared, they must be identical.  
+
+Standalone compile and run with::
+
+   ./QSim_CPUTest.sh 
+
+**/
+
+#include "NPFold.h"
+
+#include "ssys.h"
+#include "scuda.h"
+#include "smath.h"    // includes s_mock_erfinvf.h when MOCK_CUDA is defined
+#include "squad.h"
+#include "sphoton.h"
+
+#include "scurand.h"    // includes s_mock_curand.h when MOCK_CURAND OR MOCK_CUDA defined 
+#include "stexture.h"   // includes s_mock_texture.h when MOCK_TEXTURE OR MOCK_CUDA defined 
+
+#include "SPMT.h"
+#include "SBnd.h"
+#include "SEvt.hh"
+#include "SEvent.hh"
+#include "OpticksPhoton.hh"
+
+#include "QBase.hh"
+#include "QPMT.hh"
+#include "QBnd.hh"
+
+#include "qpmt.h"
+#include "qbnd.h"
+#include "qsim.h"
+#include "QSim_CPU.h"
+
+struct QSim_CPUTest
+{
+    static constexpr const char* BASE = "$HOME/.opticks/GEOM/$GEOM/CSGFoundry/SSim/stree/standard" ; 
+    static constexpr const char* BND_ = "Water///Pyrex" ;
+
+    const char* BND ; 
+    const float radius ; 
+    const NP* bnd ; 
+    const QBase*    q_base ; 
+    const QBnd*     q_bnd ; 
+    const SBnd*     s_bnd ; 
+    int   boundary ; 
+    const NPFold* jpmt ; 
+    const QPMT<float>* q_pmt ; 
+    qsim* sim ; 
+    SEvt* sev ; 
+
+    QSim_CPUTest(); 
+
+    void trace( quad2* prd, const float3& pos, const float3& mom, float tmin ) const ; 
+    int run(); 
+};
+
+inline QSim_CPUTest::QSim_CPUTest()
+    :
+    BND(ssys::getenvvar("BND", BND_)),
+    radius(ssys::getenvfloat("RADIUS", 100.f)),
+    bnd(NP::Load(BASE, "bnd.npy")),
+    q_base( new QBase ),
+    q_bnd(    bnd ? new QBnd(bnd)  : nullptr), 
+    s_bnd(    bnd ? new SBnd(bnd)  : nullptr),
+    boundary(s_bnd ? s_bnd->getBoundaryIndex(BND) : -1),
+    jpmt(SPMT::Serialize()),
+    q_pmt( jpmt ? new QPMT<float>( jpmt ) : nullptr),  
+    sim(new qsim),
+    sev(SEvt::Create_ECPU())
+{
+    assert( boundary > -1 ); 
+    sim->base = q_base->d_base ; 
+    sim->bnd = q_bnd->d_qb ;  
+    sim->pmt = q_pmt ? q_pmt->d_pmt : nullptr ; 
+}
+
+/**
+QSim_CPUTest::trace
+---------------------
+
+Sphere of *radius* centered on origin, photons inside the sphere
+intersect at the far side. 
+
+**/
+
+inline void QSim_CPUTest::trace( quad2* prd, const float3& pos, const float3& mom, float tmin ) const 
+{
+    float b = dot(pos, mom) ; 
+    float c = dot(pos, pos) - radius*radius ; 
+    float disc = b*b - c ; 
+    float t = disc > 0.f ? -b + sqrtf(disc) : -1.f ; 
+    if( t <= tmin )
+    {
+        prd->set_boundary(0xffffu) ; 
+        return ; 
+    }
+    float3 ipos = pos + t*mom ; 
+    float3 nrm = ipos/radius ; 
+    prd->q0.f.x = nrm.x ; 
+    prd->q0.f.y = nrm.y ; 
+    prd->q0.f.z = nrm.z ; 
+    prd->q0.f.w = t ; 
+    prd->set_lposcost( nrm.z ); 
+    prd->set_iindex(0u); 
+    prd->set_identity(0u); 
+    prd->set_boundary(boundary); 
+}
+
+inline int QSim_CPUTest::run()
+{
+    sev->addGenstep(SEvent::MakeTorchGenstep(0));   // OPTICKS_NUM_PHOTON photons 
+
+    QSim_CPU::Trace tr = [this](quad2* prd, const float3& pos, const float3& mom, float tmin){ trace(prd, pos, mom, tmin) ; } ; 
+    QSim_CPU cpu(sim, sev, tr) ; 
+
+    int num_threads = cpu.num_threads ; 
+
+    cpu.num_threads = 1 ; 
+    cpu.simulate(); 
+    std::vector<sphoton> p1(sev->photon) ; 
+
+    cpu.num_threads = num_threads ; 
+    cpu.chunk = 7 ;   // small odd chunk size to interleave threads 
+    cpu.simulate(); 
+    std::vector<sphoton> pn(sev->photon) ; 
+
+    std::cout << cpu.desc() ; 
+
+    bool same = p1.size() == pn.size() && memcmp( p1.data(), pn.data(), p1.size()*sizeof(sphoton) ) == 0 ; 
+    std::cout 
+        << "QSim_CPUTest::run"
+        << " num_photon " << p1.size()
+        << " num_threads " << num_threads
+        << " same " << ( same ? "YES" : "NO" )
+        << std::endl 
+        ;
+
+    NP* a = NP::Make<float>( pn.size(), 4, 4 ); 
+    a->read2<float>( (float*)pn.data() ); 
+    a->save("$FOLD/photon.npy"); 
+
+    return same ? 0 : 1 ; 
+}
+
+int main(int argc, char** argv)
+{
+    QSim_CPUTest t ; 
+    return t.run() ; 
+}
@@ -0,0 +1,75 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+QSim_CPUTest.sh
+=================
+
+Multi-threaded CPU simulation using the MOCK_CURAND qsim.h::
+
+    ~/opticks/qudarap/tests/QSim_CPUTest.sh
+    QSim_CPU__THREADS=16 ~/opticks/qudarap/tests/QSim_CPUTest.sh
+    XORWOW=1 ~/opticks/qudarap/tests/QSim_CPUTest.sh   # bit-exact host curand XORWOW, same randoms as GPU 
+
+EOU
+}
+
+cd $(dirname $BASH_SOURCE)
+name=QSim_CPUTest
+
+source $HOME/.opticks/GEOM/GEOM.sh 
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+export OPTICKS_NUM_PHOTON=${OPTICKS_NUM_PHOTON:-100000}
+
+opt=""
+[ -n "$XORWOW" ] && opt="$opt -DMOCK_CURAND_XORWOW"
+
+vars="BASH_SOURCE FOLD GEOM bin name CUDA_PREFIX OPTICKS_NUM_PHOTON QSim_CPU__THREADS opt"
+
+if [ "${arg/info}" != "$arg" ]; then 
+    for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done 
+fi
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc \
+       ../QPMT.cc \
+       ../QBnd.cc \
+       ../QTex.cc \
+       ../QProp.cc \
+       ../QBase.cc \
+       -g -O2 \
+       -std=c++11 -lstdc++ -lm -pthread \
+       -DMOCK_CURAND \
+       -DMOCK_CUDA \
+       -DMOCK_TEXTURE \
+       $opt \
+       -I.. \
+       -I$OPTICKS_PREFIX/include/SysRap  \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -I$OPTICKS_PREFIX/externals/plog/include \
+       -L$OPTICKS_PREFIX/lib -lSysRap \
+       -o $bin 
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb -ex r --args $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE dbg error && exit 3 
+fi
+
+exit 0 
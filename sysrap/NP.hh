@@ -36,6 +36,9 @@ but the headers are also copied into opticks/sysrap.
 #include <map>
 #include <functional>
 #include <locale>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include "NPU.hh"
 
@@ -99,11 +102,11 @@ struct NP
     const char* bytes() const ;  
 
     unsigned hdr_bytes() const ;  
-    unsigned num_items() const ;       // shape[0] 
-    unsigned num_values() const ;      // all values, product of shape[0]*shape[1]*...
-    unsigned num_itemvalues() const ;  // values after first dimension 
-    unsigned arr_bytes() const ;       // formerly num_bytes
-    unsigned item_bytes() const ;      // *item* comprises all dimensions beyond the first 
+    size_t   num_items() const ;       // shape[0] 
+    size_t   num_values() const ;      // all values, product of shape[0]*shape[1]*...
+    size_t   num_itemvalues() const ;  // values after first dimension 
+    size_t   arr_bytes() const ;       // formerly num_bytes
+    size_t   item_bytes() const ;      // *item* comprises all dimensions beyond the first 
     unsigned meta_bytes() const ;
 
     template<typename T> bool is_itemtype() const ;  // size of item matches size of type
@@ -140,19 +143,19 @@ struct NP
     void set_dtype(const char* dtype_); // *set_dtype* may change shape and size of array while retaining the same underlying bytes 
 
 
-    unsigned  index(  int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
-    unsigned  index0( int i,  int j=-1,  int k=-1,  int l=-1, int m=-1, int o=-1) const ; 
+    size_t    index(  int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
+    size_t    index0( int i,  int j=-1,  int k=-1,  int l=-1, int m=-1, int o=-1) const ; 
 
-    unsigned dimprod(unsigned q) const ;    // product of dimensions starting from dimension q
+    size_t   dimprod(unsigned q) const ;    // product of dimensions starting from dimension q
 
     template<typename... Args> 
-    unsigned index_(Args ... idxx ) const ; 
+    size_t   index_(Args ... idxx ) const ; 
 
     template<typename... Args> 
-    unsigned stride_(Args ... idxx ) const ; 
+    size_t   stride_(Args ... idxx ) const ; 
 
     template<typename... Args> 
-    unsigned offset_(Args ... idxx ) const ; 
+    size_t   offset_(Args ... idxx ) const ; 
 
 
     template<typename T>
@@ -182,14 +185,14 @@ struct NP
 
     int pickdim__(    const std::vector<int>& idxx) const ; 
 
-    unsigned index__( const std::vector<int>& idxx) const ; 
-    unsigned stride__(const std::vector<int>& idxx) const ; 
-    unsigned offset__(const std::vector<int>& idxx) const ; 
+    size_t   index__( const std::vector<int>& idxx) const ; 
+    size_t   stride__(const std::vector<int>& idxx) const ; 
+    size_t   offset__(const std::vector<int>& idxx) const ; 
 
 
 
-    unsigned  itemsize_(int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1) const ; 
-    void      itembytes_(const char** start,  unsigned& num_bytes, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 ) const  ; 
+    size_t    itemsize_(int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1) const ; 
+    void      itembytes_(const char** start,  size_t& num_bytes, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 ) const  ; 
 
     template<typename T> T           get( int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
     template<typename T> void        set( T val, int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0 ) ; 
@@ -273,6 +276,9 @@ struct NP
     static NP* Load(const char* dir, const char* name); 
     static NP* Load(const char* dir, const char* reldir, const char* name); 
 
+    static NP* LoadMapped(const char* path); 
+    static NP* LoadMapped(const char* dir, const char* name); 
+
     // load float OR double array and if float(4 bytes per element) widens it to double(8 bytes per element)  
     static NP* LoadWide(const char* dir, const char* reldir, const char* name); 
     static NP* LoadWide(const char* dir, const char* name); 
@@ -431,9 +437,15 @@ struct NP
     static bool IsNoData(const char* path); 
     static const char* PathWithNoDataPrefix(const char* path); 
 
+    static const char MAPPED_PREFIX = '%' ; 
+    static bool IsMapped(const char* path); 
+    static const char* PathWithMappedPrefix(const char* path); 
+
 
     int load(const char* dir, const char* name);   
     int load(const char* path);   
+    int load_mapped(const char* path); 
+    void unmap(); 
 
     int load_string_(  const char* path, const char* ext, std::string& str ); 
     int load_strings_( const char* path, const char* ext, std::vector<std::string>* vstr ); 
@@ -556,11 +568,16 @@ struct NP
     const char* dtype ; 
     char        uifc ;    // element type code 
     int         ebyte ;   // element bytes  
-    int         size ;    // number of elements from shape
+    int64_t     size ;    // number of elements from shape
 
     // nodata:true used for lightweight access to metadata from many arrays
     bool        nodata ; 
 
+    // mapped:true when bytes() is a read-only mmap view of the payload, see NP::load_mapped
+    bool                  mapped ; 
+    const char*           mdata ; 
+    std::shared_ptr<void> mhold ;   // shared by copies, munmap when last reference goes  
+
 
 };
 
@@ -568,19 +585,19 @@ struct NP
 //  SPECIALIZED MEMBER FUNCTIONS 
 
 
-template<typename T> inline const T*  NP::cvalues() const { return (T*)data.data() ;  } 
-template<typename T> inline T*        NP::values() { return (T*)data.data() ;  } 
+template<typename T> inline const T*  NP::cvalues() const { return (T*)bytes() ;  } 
+template<typename T> inline T*        NP::values() { return (T*)bytes() ;  } 
 
 template<typename T> inline void NP::fill(T value)
 {
     T* vv = values<T>(); 
-    for(int i=0 ; i < size ; i++) *(vv+i) = value ; 
+    for(int64_t i=0 ; i < size ; i++) *(vv+i) = value ; 
 }
 
 template<typename T> inline void NP::_fillIndexFlat(T offset)
 {
     T* vv = values<T>(); 
-    for(int i=0 ; i < size ; i++) *(vv+i) = T(i) + offset ; 
+    for(int64_t i=0 ; i < size ; i++) *(vv+i) = T(i) + offset ; 
 }
 
 
@@ -606,8 +623,8 @@ EOT
 
 specialize-(){
     cat << EOC | perl -pe "s,T,$1,g" - 
-template<> inline const T* NP::values<T>() const { return (T*)data.data() ; }
-template<> inline       T* NP::values<T>()      {  return (T*)data.data() ; }
+template<> inline const T* NP::values<T>() const { return (T*)bytes() ; }
+template<> inline       T* NP::values<T>()      {  return (T*)bytes() ; }
 template   void NP::_fillIndexFlat<T>(T) ;
 
 EOC
@@ -619,52 +636,52 @@ specialize
 
 // template specializations generated by above bash function
 
-template<>  inline const float* NP::cvalues<float>() const { return (float*)data.data() ; }
-template<>  inline       float* NP::values<float>()      {  return (float*)data.data() ; }
+template<>  inline const float* NP::cvalues<float>() const { return (float*)bytes() ; }
+template<>  inline       float* NP::values<float>()      {  return (float*)bytes() ; }
 template    void NP::_fillIndexFlat<float>(float) ;
 
-template<> inline const double* NP::cvalues<double>() const { return (double*)data.data() ; }
-template<> inline       double* NP::values<double>()      {  return (double*)data.data() ; }
+template<> inline const double* NP::cvalues<double>() const { return (double*)bytes() ; }
+template<> inline       double* NP::values<double>()      {  return (double*)bytes() ; }
 template   void NP::_fillIndexFlat<double>(double) ;
 
-template<> inline const char* NP::cvalues<char>() const { return (char*)data.data() ; }
-template<> inline       char* NP::values<char>()      {  return (char*)data.data() ; }
+template<> inline const char* NP::cvalues<char>() const { return (char*)bytes() ; }
+template<> inline       char* NP::values<char>()      {  return (char*)bytes() ; }
 template   void NP::_fillIndexFlat<char>(char) ;
 
-template<> inline const short* NP::cvalues<short>() const { return (short*)data.data() ; }
-template<> inline       short* NP::values<short>()      {  return (short*)data.data() ; }
+template<> inline const short* NP::cvalues<short>() const { return (short*)bytes() ; }
+template<> inline       short* NP::values<short>()      {  return (short*)bytes() ; }
 template   void NP::_fillIndexFlat<short>(short) ;
 
-template<> inline const int* NP::cvalues<int>() const { return (int*)data.data() ; }
-template<> inline       int* NP::values<int>()      {  return (int*)data.data() ; }
+template<> inline const int* NP::cvalues<int>() const { return (int*)bytes() ; }
+template<> inline       int* NP::values<int>()      {  return (int*)bytes() ; }
 template   void NP::_fillIndexFlat<int>(int) ;
 
-template<> inline const long* NP::cvalues<long>() const { return (long*)data.data() ; }
-template<> inline       long* NP::values<long>()      {  return (long*)data.data() ; }
+template<> inline const long* NP::cvalues<long>() const { return (long*)bytes() ; }
+template<> inline       long* NP::values<long>()      {  return (long*)bytes() ; }
 template   void NP::_fillIndexFlat<long>(long) ;
 
-template<> inline const long long* NP::cvalues<long long>() const { return (long long*)data.data() ; }
-template<> inline       long long* NP::values<long long>()      {  return (long long*)data.data() ; }
+template<> inline const long long* NP::cvalues<long long>() const { return (long long*)bytes() ; }
+template<> inline       long long* NP::values<long long>()      {  return (long long*)bytes() ; }
 template   void NP::_fillIndexFlat<long long>(long long) ;
 
-template<> inline const unsigned char* NP::cvalues<unsigned char>() const { return (unsigned char*)data.data() ; }
-template<> inline       unsigned char* NP::values<unsigned char>()      {  return (unsigned char*)data.data() ; }
+template<> inline const unsigned char* NP::cvalues<unsigned char>() const { return (unsigned char*)bytes() ; }
+template<> inline       unsigned char* NP::values<unsigned char>()      {  return (unsigned char*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned char>(unsigned char) ;
 
-template<> inline const unsigned short* NP::cvalues<unsigned short>() const { return (unsigned short*)data.data() ; }
-template<> inline       unsigned short* NP::values<unsigned short>()      {  return (unsigned short*)data.data() ; }
+template<> inline const unsigned short* NP::cvalues<unsigned short>() const { return (unsigned short*)bytes() ; }
+template<> inline       unsigned short* NP::values<unsigned short>()      {  return (unsigned short*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned short>(unsigned short) ;
 
-template<> inline const unsigned int* NP::cvalues<unsigned int>() const { return (unsigned int*)data.data() ; }
-template<> inline       unsigned int* NP::values<unsigned int>()      {  return (unsigned int*)data.data() ; }
+template<> inline const unsigned int* NP::cvalues<unsigned int>() const { return (unsigned int*)bytes() ; }
+template<> inline       unsigned int* NP::values<unsigned int>()      {  return (unsigned int*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned int>(unsigned int) ;
 
-template<> inline const unsigned long* NP::cvalues<unsigned long>() const { return (unsigned long*)data.data() ; }
-template<> inline       unsigned long* NP::values<unsigned long>()      {  return (unsigned long*)data.data() ; }
+template<> inline const unsigned long* NP::cvalues<unsigned long>() const { return (unsigned long*)bytes() ; }
+template<> inline       unsigned long* NP::values<unsigned long>()      {  return (unsigned long*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned long>(unsigned long) ;
 
-template<> inline const unsigned long long* NP::cvalues<unsigned long long>() const { return (unsigned long long*)data.data() ; }
-template<> inline       unsigned long long* NP::values<unsigned long long>()      {  return (unsigned long long*)data.data() ; }
+template<> inline const unsigned long long* NP::cvalues<unsigned long long>() const { return (unsigned long long*)bytes() ; }
+template<> inline       unsigned long long* NP::values<unsigned long long>()      {  return (unsigned long long*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned long long>(unsigned long long) ;
 
 
@@ -993,15 +1010,24 @@ template<typename T> NP* NP::MakeFlat(int ni, int nj, int nk, int nl, int nm, in
 //  MEMBER FUNCTIONS 
 
 
-inline char*        NP::bytes() { return (char*)data.data() ;  } 
-inline const char*  NP::bytes() const { return (char*)data.data() ;  } 
+/**
+NP::bytes
+----------
+
+Mutable access to a mapped array first copies the payload into 
+the owned data vector, see NP::unmap. Const access does not. 
+
+**/
+
+inline char*        NP::bytes() { if(mapped) unmap() ; return (char*)data.data() ;  } 
+inline const char*  NP::bytes() const { return mapped ? mdata : (char*)data.data() ;  } 
 
 inline unsigned NP::hdr_bytes() const { return _hdr.length() ; }
-inline unsigned NP::num_items() const { return shape[0] ;  }
-inline unsigned NP::num_values() const { return NPS::size(shape) ;  }
-inline unsigned NP::num_itemvalues() const { return NPS::itemsize(shape) ;  }
-inline unsigned NP::arr_bytes()  const { return NPS::size(shape)*ebyte ; }
-inline unsigned NP::item_bytes() const { return NPS::itemsize(shape)*ebyte ; }
+inline size_t   NP::num_items() const { return shape[0] ;  }
+inline size_t   NP::num_values() const { return NPS::size(shape) ;  }
+inline size_t   NP::num_itemvalues() const { return NPS::itemsize(shape) ;  }
+inline size_t   NP::arr_bytes()  const { return NPS::size(shape)*ebyte ; }
+inline size_t   NP::item_bytes() const { return NPS::itemsize(shape)*ebyte ; }
 inline unsigned NP::meta_bytes() const { return meta.length() ; }
 
 
@@ -1026,6 +1052,9 @@ inline void NP::clear()
 {
     data.clear(); 
     data.shrink_to_fit(); 
+    mapped = false ; 
+    mdata = nullptr ; 
+    mhold.reset(); 
     shape[0] = 0 ; 
 }
 
@@ -1061,7 +1090,7 @@ inline std::string NP::make_prefix() const
 {
     std::vector<unsigned> parts ;
     parts.push_back(hdr_bytes());
-    parts.push_back(arr_bytes());
+    parts.push_back(unsigned(arr_bytes()));  // NB: 32 bit network prefix limits transport to arrays < 4GB  
     parts.push_back(meta_bytes());
     parts.push_back(0);    // xxd neater to have 16 byte prefix 
 
@@ -1103,7 +1132,7 @@ inline bool NP::decode_header()
     NPU::parse_header( shape, descr, uifc, ebyte, _hdr ) ; 
     dtype = strdup(descr.c_str());  
     size = NPS::size(shape);    // product of shape dimensions 
-    if(!nodata) data.resize(size*ebyte) ;   // data is now just char 
+    if(!nodata && !mapped) data.resize(size*ebyte) ;   // data is now just char 
     return true  ; 
 }
 
@@ -1162,7 +1191,9 @@ inline NP::NP(const char* dtype_, const std::vector<int>& shape_ )
     uifc(NPU::_dtype_uifc(dtype)),
     ebyte(NPU::_dtype_ebyte(dtype)),
     size(NPS::size(shape)),
-    nodata(false)
+    nodata(false),
+    mapped(false),
+    mdata(nullptr)
 {
     init(); 
 }
@@ -1175,7 +1206,9 @@ inline NP::NP(const char* dtype_, int ni, int nj, int nk, int nl, int nm, int no
     uifc(NPU::_dtype_uifc(dtype)),
     ebyte(NPU::_dtype_ebyte(dtype)),
     size(NPS::set_shape(shape, ni,nj,nk,nl,nm,no )),
-    nodata(false)
+    nodata(false),
+    mapped(false),
+    mdata(nullptr)
 {
     init(); 
 }
@@ -1380,22 +1413,22 @@ in a dimension.
 
 **/
 
-inline unsigned NP::index( int i,  int j,  int k,  int l, int m, int o ) const 
+inline size_t NP::index( int i,  int j,  int k,  int l, int m, int o ) const 
 {
     unsigned nd = shape.size() ; 
-    unsigned ni = nd > 0 ? shape[0] : 1 ; 
-    unsigned nj = nd > 1 ? shape[1] : 1 ; 
-    unsigned nk = nd > 2 ? shape[2] : 1 ; 
-    unsigned nl = nd > 3 ? shape[3] : 1 ; 
-    unsigned nm = nd > 4 ? shape[4] : 1 ; 
-    unsigned no = nd > 5 ? shape[5] : 1 ; 
-
-    unsigned ii = i < 0 ? ni + i : i ; 
-    unsigned jj = j < 0 ? nj + j : j ; 
-    unsigned kk = k < 0 ? nk + k : k ; 
-    unsigned ll = l < 0 ? nl + l : l ; 
-    unsigned mm = m < 0 ? nm + m : m ; 
-    unsigned oo = o < 0 ? no + o : o ; 
+    size_t ni = nd > 0 ? shape[0] : 1 ; 
+    size_t nj = nd > 1 ? shape[1] : 1 ; 
+    size_t nk = nd > 2 ? shape[2] : 1 ; 
+    size_t nl = nd > 3 ? shape[3] : 1 ; 
+    size_t nm = nd > 4 ? shape[4] : 1 ; 
+    size_t no = nd > 5 ? shape[5] : 1 ; 
+
+    size_t ii = i < 0 ? ni + i : i ; 
+    size_t jj = j < 0 ? nj + j : j ; 
+    size_t kk = k < 0 ? nk + k : k ; 
+    size_t ll = l < 0 ? nl + l : l ; 
+    size_t mm = m < 0 ? nm + m : m ; 
+    size_t oo = o < 0 ? no + o : o ; 
 
     return  ii*nj*nk*nl*nm*no + jj*nk*nl*nm*no + kk*nl*nm*no + ll*nm*no + mm*no + oo ;
 }
@@ -1408,23 +1441,23 @@ Same as NP::index but -ve "missing" indices are treated as if they were zero.
 
 **/
 
-inline unsigned NP::index0( int i,  int j,  int k,  int l, int m, int o) const 
+inline size_t NP::index0( int i,  int j,  int k,  int l, int m, int o) const 
 {
     unsigned nd = shape.size() ; 
 
-    unsigned ni = nd > 0 ? shape[0] : 1 ; 
-    unsigned nj = nd > 1 ? shape[1] : 1 ; 
-    unsigned nk = nd > 2 ? shape[2] : 1 ; 
-    unsigned nl = nd > 3 ? shape[3] : 1 ; 
-    unsigned nm = nd > 4 ? shape[4] : 1 ; 
-    unsigned no = nd > 5 ? shape[5] : 1 ; 
+    size_t ni = nd > 0 ? shape[0] : 1 ; 
+    size_t nj = nd > 1 ? shape[1] : 1 ; 
+    size_t nk = nd > 2 ? shape[2] : 1 ; 
+    size_t nl = nd > 3 ? shape[3] : 1 ; 
+    size_t nm = nd > 4 ? shape[4] : 1 ; 
+    size_t no = nd > 5 ? shape[5] : 1 ; 
 
-    unsigned ii = i < 0 ? 0 : i ; 
-    unsigned jj = j < 0 ? 0 : j ; 
-    unsigned kk = k < 0 ? 0 : k ; 
-    unsigned ll = l < 0 ? 0 : l ; 
-    unsigned mm = m < 0 ? 0 : m ; 
-    unsigned oo = o < 0 ? 0 : o ; 
+    size_t ii = i < 0 ? 0 : i ; 
+    size_t jj = j < 0 ? 0 : j ; 
+    size_t kk = k < 0 ? 0 : k ; 
+    size_t ll = l < 0 ? 0 : l ; 
+    size_t mm = m < 0 ? 0 : m ; 
+    size_t oo = o < 0 ? 0 : o ; 
 
     if(!(ii <  ni)) std::cerr << "NP::index0 ii/ni " << ii << "/" << ni  << std::endl ; 
 
@@ -1448,30 +1481,30 @@ inline unsigned NP::index0( int i,  int j,  int k,  int l, int m, int o) const
     //      i                   j                k             l          m       o 
 }
 
-inline unsigned NP::dimprod(unsigned q) const   // product of dimensions starting from dimension q
+inline size_t NP::dimprod(unsigned q) const   // product of dimensions starting from dimension q
 {
-    unsigned dim = 1 ; 
+    size_t dim = 1 ; 
     for(unsigned d=q ; d < shape.size() ; d++) dim *= shape[d] ; 
     return dim ;   
 } 
 
 
 template<typename... Args>
-inline unsigned NP::index_(Args ... idxx_) const 
+inline size_t NP::index_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return index__(idxx); 
 }
 
 template<typename... Args>
-inline unsigned NP::stride_(Args ... idxx_) const 
+inline size_t NP::stride_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return stride__(idxx); 
 }
 
 template<typename... Args>
-inline unsigned NP::offset_(Args ... idxx_) const 
+inline size_t NP::offset_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return offset__(idxx); 
@@ -1543,9 +1576,9 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
     int slicedim = pickdim__(idxx); 
     assert( slicedim > -1 ); 
 
-    unsigned start = index__(idxx) ; 
-    unsigned stride = stride__(idxx) ; 
-    unsigned offset = offset__(idxx) ; 
+    size_t start = index__(idxx) ; 
+    size_t stride = stride__(idxx) ; 
+    size_t offset = offset__(idxx) ; 
     unsigned numval = shape[slicedim] ; 
 
     if(NP::VERBOSE) 
@@ -1644,9 +1677,9 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
 
     **/
 
-    inline unsigned NP::index__(const std::vector<int>& idxx) const 
+    inline size_t NP::index__(const std::vector<int>& idxx) const 
     {
-        unsigned idx = 0 ; 
+        size_t idx = 0 ; 
         for(unsigned d=0 ; d < shape.size() ; d++)  
         {
             int dd = (d < idxx.size() ? idxx[d] : 1) ; 
@@ -1657,20 +1690,20 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
     }
 
 
-    inline unsigned NP::stride__(const std::vector<int>& idxx) const 
+    inline size_t NP::stride__(const std::vector<int>& idxx) const 
     {
         int pd = pickdim__(idxx);  
         assert( pd > -1 ); 
-        unsigned stride = dimprod(pd+1) ; 
+        size_t stride = dimprod(pd+1) ; 
         return stride ; 
     }
 
-    inline unsigned NP::offset__(const std::vector<int>& idxx) const 
+    inline size_t NP::offset__(const std::vector<int>& idxx) const 
     {
         int pd = pickdim__(idxx);  
         assert( pd > -1 ); 
 
-        unsigned offset = 0 ; 
+        size_t offset = 0 ; 
         for(unsigned d=pd+1 ; d < shape.size() ; d++)  
         {
             int dd = (d < idxx.size() ? idxx[d] : 1) ; 
@@ -1684,17 +1717,17 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
 
 
 
-inline unsigned NP::itemsize_(int i, int j, int k, int l, int m, int o) const
+inline size_t NP::itemsize_(int i, int j, int k, int l, int m, int o) const
 {
     return NPS::itemsize_(shape, i, j, k, l, m, o) ; 
 }
 
-inline void NP::itembytes_(const char** start,  unsigned& num_bytes,  int i,  int j,  int k,  int l, int m, int o ) const 
+inline void NP::itembytes_(const char** start,  size_t& num_bytes,  int i,  int j,  int k,  int l, int m, int o ) const 
 {
-    unsigned idx0 = index0(i,j,k,l,m,o) ; 
+    size_t idx0 = index0(i,j,k,l,m,o) ; 
     *start = bytes() + idx0*ebyte ;  
 
-    unsigned sz = itemsize_(i, j, k, l, m, o) ; 
+    size_t sz = itemsize_(i, j, k, l, m, o) ; 
     num_bytes = sz*ebyte ; 
 }
 
@@ -1703,14 +1736,14 @@ inline void NP::itembytes_(const char** start,  unsigned& num_bytes,  int i,  in
 
 template<typename T> inline T NP::get( int i,  int j,  int k,  int l, int m, int o) const 
 {
-    unsigned idx = index(i, j, k, l, m, o); 
+    size_t idx = index(i, j, k, l, m, o); 
     const T* vv = cvalues<T>() ;  
     return vv[idx] ; 
 }
 
 template<typename T> inline void NP::set( T val, int i,  int j,  int k,  int l, int m, int o) 
 {
-    unsigned idx = index(i, j, k, l, m, o); 
+    size_t idx = index(i, j, k, l, m, o); 
     T* vv = values<T>() ;  
     vv[idx] = val ; 
 }
@@ -1721,8 +1754,8 @@ template<typename T> inline bool NP::is_allzero() const
 {
     T zero = T(0) ; 
     const T* vv = cvalues<T>(); 
-    int num = 0 ; 
-    for(int i=0 ; i < size ; i++) if(vv[i] == zero) num += 1 ; 
+    int64_t num = 0 ; 
+    for(int64_t i=0 ; i < size ; i++) if(vv[i] == zero) num += 1 ; 
     bool allzero = num == size ; 
     return allzero ; 
 }
@@ -1800,8 +1833,8 @@ inline T NP::findMinimumTimestamp() const
     T MAX = std::numeric_limits<T>::max(); 
     T t0 = MAX ; 
 
-    int nv = num_values() ; 
-    for(int i=0 ; i < nv ; i++)
+    int64_t nv = num_values() ; 
+    for(int64_t i=0 ; i < nv ; i++)
     {
         T t = vv[i] ;
         if(!U::LooksLikeTimestamp<T>(t)) continue ; 
@@ -2013,14 +2046,14 @@ inline NP* NP::MakeNarrow(const NP* a) // static
 
 
     assert( a->num_values() == b->num_values() ); 
-    unsigned nv = a->num_values(); 
-    unsigned iv = a->num_itemvalues(); 
+    size_t nv = a->num_values(); 
+    size_t iv = a->num_itemvalues(); 
 
     if( a->uifc == 'f' && b->uifc == 'f')
     {
         const double* aa = a->cvalues<double>() ;  
         float*        bb = b->values<float>() ;  
-        for(unsigned i=0 ; i < nv ; i++) 
+        for(size_t i=0 ; i < nv ; i++) 
         {
             bb[i] = float(aa[i]); 
             bool preserve_last_column_integer = plcia && ((i % iv) == iv - 1 ) ; // only works for 3D not higher D
@@ -2046,13 +2079,13 @@ inline NP* NP::MakeWide(const NP* a) // static
     CopyMeta(b, a ); 
 
     assert( a->num_values() == b->num_values() ); 
-    unsigned nv = a->num_values(); 
+    size_t nv = a->num_values(); 
 
     if( a->uifc == 'f' && b->uifc == 'f')
     {
         const float* aa = a->cvalues<float>() ;  
         double* bb = b->values<double>() ;  
-        for(unsigned i=0 ; i < nv ; i++)
+        for(size_t i=0 ; i < nv ; i++)
         {
             bb[i] = double(aa[i]); 
         }
@@ -2079,7 +2112,7 @@ inline NP* NP::MakeCopy(const NP* a) // static
     {
         memcpy( b->bytes(), a->bytes(), a->arr_bytes() );    
     }
-    unsigned nv = a->num_values(); 
+    size_t nv = a->num_values(); 
 
     if(VERBOSE) std::cout 
         << "NP::MakeCopy"
@@ -2212,10 +2245,10 @@ inline NP* NP::MakeSelectCopy_(  const NP* src, const int* items, int num_items
     dst_shape[0] = num_items ; 
     NP* dst = new NP(src->dtype, dst_shape); 
     assert( src->item_bytes() == dst->item_bytes() );  
-    unsigned size = src->item_bytes(); 
+    size_t size = src->item_bytes(); 
     for(int i=0 ; i < num_items ; i++) 
     {
-        memcpy( dst->bytes() + i*size, src->bytes() + items[i]*size , size ); 
+        memcpy( dst->bytes() + i*size, src->bytes() + size_t(items[i])*size , size ); 
     }
 
     // format string idlist list of items and set into metadata 
@@ -2241,7 +2274,7 @@ inline NP* NP::MakeItemCopy(  const NP* src, int i, int j, int k, int l, int m,
 {
     std::vector<int> sub_shape ; 
     src->item_shape(sub_shape, i, j, k, l, m, o );   // shape of the item specified by (i,j,k,l,m,n)
-    unsigned idx = src->index0(i, j, k, l, m, o ); 
+    size_t idx = src->index0(i, j, k, l, m, o ); 
 
     if(NP::VERBOSE) std::cout 
         << "NP::MakeItemCopy"
@@ -2869,6 +2902,31 @@ inline NP* NP::Load(const char* dir, const char* reldir, const char* name)
     return Load(path.c_str());
 }
 
+/**
+NP::LoadMapped
+----------------
+
+Loads header and sidecars but not the payload, which is 
+instead memory mapped read-only and paged in lazily as 
+it is accessed. See NP::load_mapped. 
+
+**/
+
+inline NP* NP::LoadMapped(const char* path_)
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    const char* mpath = PathWithMappedPrefix(path) ; 
+    return NP::Load_(mpath) ; 
+}
+
+inline NP* NP::LoadMapped(const char* dir, const char* name)
+{
+    if(!dir) return nullptr ; 
+    std::string path = U::form_path(dir, name); 
+    return LoadMapped(path.c_str());
+}
+
 /**
 NP::LoadWide
 --------------
@@ -3514,16 +3572,16 @@ template<typename T> inline NP* NP::trapz() const
 
 template<typename T> void NP::psplit(std::vector<T>& dom, std::vector<T>& val) const 
 {
-    unsigned nv = num_values() ; 
+    size_t nv = num_values() ; 
     const T* vv = cvalues<T>() ; 
 
     assert( nv %  2 == 0 );  
-    unsigned entries = nv/2 ;
+    size_t entries = nv/2 ;
 
     dom.resize(entries); 
     val.resize(entries); 
 
-    for(unsigned i=0 ; i < entries ; i++)
+    for(size_t i=0 ; i < entries ; i++)
     {   
         dom[i] = vv[2*i+0] ; 
         val[i] = vv[2*i+1] ; 
@@ -4083,7 +4141,7 @@ template<typename T> inline NP* NP::cumsum(int axis) const
     const T* vv = cvalues<T>(); 
     NP* cs = NP::MakeLike(this) ; 
     T* ss = cs->values<T>(); 
-    for(int p=0 ; p < size ; p++) ss[p] = vv[p] ;   // flat copy 
+    for(int64_t p=0 ; p < size ; p++) ss[p] = vv[p] ;   // flat copy 
 
     unsigned ndim = shape.size() ; 
 
@@ -4264,6 +4322,7 @@ inline std::string NP::desc() const
        << " names.size " << names.size() 
        ;
     if(nodata) ss << " NODATA " ; 
+    if(mapped) ss << " MAPPED " ; 
     return ss.str(); 
 }
 
@@ -4283,12 +4342,12 @@ template<typename T>
 inline std::string NP::repr() const 
 {
     const T* vv = cvalues<T>(); 
-    int nv = num_values() ; 
-    const int edge = 5 ; 
+    int64_t nv = num_values() ; 
+    const int64_t edge = 5 ; 
 
     std::stringstream ss ; 
     ss << "{" ; 
-    for(int i=0 ; i < nv ; i++) 
+    for(int64_t i=0 ; i < nv ; i++) 
     {     
         if( i < edge || i > nv - edge )
         {
@@ -5389,8 +5448,8 @@ NP::Memcmp
 
 inline int NP::Memcmp(const NP* a, const NP* b ) // static
 {
-    unsigned a_bytes = a->arr_bytes() ; 
-    unsigned b_bytes = b->arr_bytes() ; 
+    size_t a_bytes = a->arr_bytes() ; 
+    size_t b_bytes = b->arr_bytes() ; 
     return a_bytes == b_bytes ? memcmp(a->bytes(), b->bytes(), a_bytes) : -1 ; 
 }
 
@@ -5413,14 +5472,14 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
 
     NP* a0 = aa[0] ; 
     
-    unsigned nv0 = a0->num_itemvalues() ; 
+    size_t nv0 = a0->num_itemvalues() ; 
     const char* dtype0 = a0->dtype ; 
 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         NP* a = aa[i] ;
 
-        unsigned nv = a->num_itemvalues() ; 
+        size_t nv = a->num_itemvalues() ; 
         bool compatible = nv == nv0 && strcmp(dtype0, a->dtype) == 0 ; 
         if(!compatible) 
             std::cout 
@@ -5436,9 +5495,10 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
         if(VERBOSE) std::cout << "NP::Concatenate " << std::setw(3) << i << " " << a->desc() << " nv " << nv << std::endl ; 
     }
 
-    unsigned ni_total = 0 ; 
+    int64_t ni_total = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++) ni_total += aa[i]->shape[0] ; 
     if(VERBOSE) std::cout << "NP::Concatenate ni_total " << ni_total << std::endl ; 
+    assert( ni_total <= std::numeric_limits<int>::max() );  // each dimension must fit in int 
 
     std::vector<int> comb_shape ; 
     NPS::copy_shape( comb_shape, a0->shape );  
@@ -5448,12 +5508,12 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
     c->set_shape(comb_shape); 
     if(VERBOSE) std::cout << "NP::Concatenate c " << c->desc() << std::endl ; 
 
-    unsigned offset_bytes = 0 ; 
+    size_t offset_bytes = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         NP* a = aa[i]; 
-        unsigned a_bytes = a->arr_bytes() ; 
-        memcpy( c->data.data() + offset_bytes ,  a->data.data(),  a_bytes ); 
+        size_t a_bytes = a->arr_bytes() ; 
+        memcpy( c->data.data() + offset_bytes , ((const NP*)a)->bytes(),  a_bytes ); 
         offset_bytes += a_bytes ;  
         a->clear(); // HUH: THATS A BIT IMPOLITE ASSUMING CALLER DOESNT WANT TO USE INPUTS
     }
@@ -5542,7 +5602,7 @@ inline NP* NP::Combine(const std::vector<const NP*>& aa, bool annotate, const NP
     assert( ldim0 == 2 && "last dimension must currently be 2"); 
 
     NP* c = new NP(a0->dtype, aa.size(), width, ldim0 ); 
-    unsigned item_bytes = c->item_bytes(); 
+    size_t item_bytes = c->item_bytes(); 
 
     if(VERBOSE) std::cout 
         << "NP::Combine"
@@ -5556,15 +5616,15 @@ inline NP* NP::Combine(const std::vector<const NP*>& aa, bool annotate, const NP
         ; 
 
     assert( item_bytes % ebyte0 == 0 ); 
-    unsigned item_values = item_bytes/ebyte0 ; 
+    size_t item_values = item_bytes/ebyte0 ; 
 
-    unsigned offset_bytes = 0 ; 
+    size_t offset_bytes = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         const NP* a = aa[i]; 
-        unsigned a_bytes = a->arr_bytes() ; 
+        size_t a_bytes = a->arr_bytes() ; 
 
-        memcpy( c->data.data() + offset_bytes ,  a->data.data(),  a_bytes ); 
+        memcpy( c->data.data() + offset_bytes ,  a->bytes(),  a_bytes ); 
 
         // NB: a_bytes may be less than item_bytes 
         // effectively are padding to allow ragged arrays to be handled together
@@ -5662,6 +5722,22 @@ inline const char* NP::PathWithNoDataPrefix(const char* path) // static
     return strdup(str.c_str()); 
 }
 
+inline bool NP::IsMapped(const char* path) // static
+{
+    return path && strlen(path) > 0 && path[0] == MAPPED_PREFIX ; 
+}
+
+inline const char* NP::PathWithMappedPrefix(const char* path) // static
+{
+    if(path == nullptr) return nullptr ; 
+    if(IsMapped(path)) return path ;   
+
+    std::stringstream ss ; 
+    ss << MAPPED_PREFIX << path ; 
+    std::string str = ss.str() ; 
+    return strdup(str.c_str()); 
+}
+
 
 inline int NP::load(const char* dir, const char* name)
 {
@@ -5685,6 +5761,8 @@ newline from the stream without returning it.
 
 inline int NP::load(const char* _path)
 {
+    if(IsMapped(_path)) return load_mapped(_path + 1) ;  // _path starting with MAPPED_PREFIX currently '%'
+
     nodata = IsNoData(_path) ;  // _path starting with NODATA_PREFIX currently '@'
     const char* path = nodata ? _path + 1 : _path ;  
 
@@ -5723,6 +5801,120 @@ inline int NP::load(const char* _path)
     return 0 ; 
 }
 
+/**
+NP::load_mapped
+-----------------
+
+Instead of reading the payload into the owned data vector
+the whole file is mmap-ed read-only with the payload 
+starting after the header. Pages are only read from 
+disk when touched, so RSS and load time are proportional 
+to the parts of the array actually accessed. 
+
+This suits analysis of large event arrays (photon, record, seq, hit) 
+where only a few columns of each are typically used. 
+
+Const access via bytes/cvalues reads the mapping directly. 
+Mutable access via bytes/values copies the payload into 
+the owned data vector first, see NP::unmap.  
+
+The mapping is held by a std::shared_ptr so copies of the 
+NP struct share it and the munmap happens when the last 
+of them is destroyed or cleared. 
+
+**/
+
+inline int NP::load_mapped(const char* path)
+{
+    if(VERBOSE) std::cerr << "[ NP::load_mapped " << path << std::endl ; 
+
+    nodata = false ; 
+    lpath = path ;  
+    lfold = U::DirName(path); 
+
+    std::ifstream fp(path, std::ios::in|std::ios::binary);
+    if(fp.fail())
+    {
+        std::cerr << "NP::load_mapped Failed to load from path " << path << std::endl ; 
+        std::raise(SIGINT); 
+        return 1 ; 
+    }
+
+    std::getline(fp, _hdr );   
+    _hdr += '\n' ; 
+    fp.close(); 
+
+    data.clear(); 
+    data.shrink_to_fit(); 
+    mapped = true ;   // before decode_header to skip data.resize 
+    decode_header(); 
+
+    size_t hdr_size = _hdr.length() ; 
+    size_t arr_size = arr_bytes() ;  
+    size_t map_size = hdr_size + arr_size ; 
+
+    int fd = open(path, O_RDONLY); 
+    struct stat st ; 
+    bool ok = fd > -1 && fstat(fd, &st) == 0 && size_t(st.st_size) >= map_size ; 
+    void* addr = ok && map_size > 0 ? mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0 ) : nullptr ; 
+    if(fd > -1) close(fd);   // mapping remains valid after close 
+
+    if(!ok || addr == MAP_FAILED)
+    {
+        std::cerr 
+            << "NP::load_mapped FAILED to mmap " << path 
+            << " map_size " << map_size
+            << " fd " << fd  
+            << std::endl
+            ; 
+        mapped = false ; 
+        return 1 ; 
+    }
+
+    if(addr)
+    {
+        mhold.reset( addr, [map_size](void* p){ munmap(p, map_size) ; } ); 
+        mdata = (const char*)addr + hdr_size ; 
+    }
+    else
+    {
+        mhold.reset(); 
+        mdata = nullptr ;   // empty array  
+    }
+
+    load_meta( path ); 
+    load_names( path ); 
+    load_labels( path ); 
+
+    if(VERBOSE) std::cerr << "] NP::load_mapped " << path << std::endl ; 
+    return 0 ; 
+}
+
+/**
+NP::unmap
+-----------
+
+Copies mapped payload into the owned data vector and 
+releases this objects reference to the mapping. 
+Invoked by non-const NP::bytes, so a mapped array can be 
+used anywhere an ordinary loaded one can. 
+
+**/
+
+inline void NP::unmap()
+{
+    if(!mapped) return ; 
+    const char* src = mdata ; 
+    size_t arr_size = arr_bytes() ; 
+
+    data.resize(arr_size); 
+    if(src && arr_size > 0) memcpy( data.data(), src, arr_size ); 
+
+    mapped = false ; 
+    mdata = nullptr ; 
+    mhold.reset();  
+}
+
 
 inline int NP::load_string_( const char* path, const char* ext, std::string& str )
 {
@@ -5984,7 +6176,7 @@ template <typename T> void NP::read(const T* src)
     for(int m=0 ; m < sh.nm_() ; m++ )
     for(int o=0 ; o < sh.no_() ; o++ )
     {  
-        int index = sh.idx(i,j,k,l,m,o); 
+        int64_t index = sh.idx(i,j,k,l,m,o); 
         *(v + index) = *(src + index ) ; 
     }   
 }
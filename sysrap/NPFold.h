@@ -59,6 +59,19 @@ to loading a directory tree of .npy all into a single NPFold
 Now with load_dir each directory is loading into an NPFold
 so loading a directory tree creates a corresponding tree of NPFold. 
 
+Concurrent Load/Save
+----------------------
+
+With NPFold__THREADS set to more than 1 the per-key reads and writes
+of arrays and the recursion into subfolds are dispatched to a pool
+of at most that many threads (including the calling thread), see NPFold::ForEach.
+Loaded items are collected into per-key slots and added to the fold
+in key order once all are done, so the resulting fold has the same
+key order as a sequential load. This helps most with network
+filesystems where per-file latency dominates::
+
+    export NPFold__THREADS=8    # default 0 : sequential
+
 Hid fts.h usage behind WITH_FTS as getting compilation error on Linux::
 
     /usr/include/fts.h:41:3: error: #error "<fts.h> cannot be used with -D_FILE_OFFSET_BITS==64"
@@ -86,6 +99,9 @@ Hid fts.h usage behind WITH_FTS as getting compilation error on Linux::
 #include <errno.h>
 #include <sstream>
 #include <iomanip>
+#include <atomic>
+#include <thread>
+#include <functional>
 
 #include "NP.hh"
 #include "NPX.h"
@@ -109,9 +125,12 @@ struct NPFold
 
     // nodata:true used for lightweight access to metadata from many arrays
     bool                      nodata ; 
+    // mapped:true arrays are mmap-ed read-only views, paged in lazily, see NP::load_mapped
+    bool                      mapped ; 
     bool                      verbose_ ; 
 
     static constexpr const int UNDEF = -1 ; 
+    enum { SKIP, ARRAY, SUBFOLD } ;   // kinds of items for load_items 
     static constexpr const bool VERBOSE = false ; 
     static constexpr const char* DOT_NPY = ".npy" ;  // formerly EXT
     static constexpr const char* DOT_TXT = ".txt" ; 
@@ -122,6 +141,12 @@ struct NPFold
     static constexpr const char* META  = "NPFold_meta.txt" ; 
     static constexpr const char* NAMES = "NPFold_names.txt" ; 
     static constexpr const char* kNP_PROP_BASE = "NP_PROP_BASE" ; 
+    static constexpr const char* THREADS_ = "NPFold__THREADS" ; 
+
+    static int& Threads();                // max threads used for load/save, <= 1 : sequential 
+    static std::atomic<int>& Spare();     // pool threads not currently in use 
+    static void SetThreads(int num); 
+    static void ForEach(int num, const std::function<void(int)>& fn ); 
 
 
     static bool IsNPY(const char* k); 
@@ -139,6 +164,7 @@ struct NPFold
     static bool    Exists(const char* base); 
     static NPFold* Load_(const char* base ); 
     static NPFold* LoadNoData_(const char* base ); 
+    static NPFold* LoadMapped_(const char* base ); 
 
     static const char* Resolve(const char* base_, const char* rel1_=nullptr, const char* rel2_=nullptr); 
     static NPFold* Load(const char* base); 
@@ -149,6 +175,10 @@ struct NPFold
     static NPFold* LoadNoData(const char* base, const char* rel ); 
     static NPFold* LoadNoData(const char* base, const char* rel1, const char* rel2 ); 
 
+    static NPFold* LoadMapped(const char* base); 
+    static NPFold* LoadMapped(const char* base, const char* rel ); 
+    static NPFold* LoadMapped(const char* base, const char* rel1, const char* rel2 ); 
+
 
     static NPFold* LoadProp(const char* rel0, const char* rel1=nullptr ); 
 
@@ -274,8 +304,10 @@ public:
     int  _save_arrays(const char* base); 
     void _save_subfold_r(const char* base); 
 
+    static NP* LoadArray(const char* base, const char* relp); 
     void load_array(const char* base, const char* relp); 
     void load_subfold(const char* base, const char* relp);
+    int  load_items(const char* base, const std::vector<std::string>& keys, const std::function<int(const char*)>& kind ); 
 
 #ifdef WITH_FTS
     static int FTS_Compare(const FTSENT** one, const FTSENT** two); 
@@ -461,6 +493,25 @@ inline NPFold* NPFold::LoadNoData_(const char* base_ )
     return nf ;  
 }
 
+/**
+NPFold::LoadMapped_
+--------------------
+
+Arrays of the fold and its subfold are mmap-ed rather than read, 
+avoiding reading the full payload of large arrays when only 
+small parts of them are accessed.  
+
+**/
+
+inline NPFold* NPFold::LoadMapped_(const char* base_ )
+{
+    if(base_ == nullptr) return nullptr ; 
+    const char* base = NP::PathWithMappedPrefix(base_);
+    NPFold* nf = new NPFold ; 
+    nf->load(base); 
+    return nf ;  
+}
+
 inline const char* NPFold::Resolve(const char* base_, const char* rel1_, const char* rel2_ )
 {
     const char* base = U::Resolve(base_, rel1_, rel2_ ); 
@@ -512,6 +563,23 @@ inline NPFold* NPFold::LoadNoData(const char* base_, const char* rel1_, const ch
 }
 
 
+inline NPFold* NPFold::LoadMapped(const char* base_)
+{
+    const char* base = Resolve(base_); 
+    return LoadMapped_(base); 
+}
+inline NPFold* NPFold::LoadMapped(const char* base_, const char* rel_)
+{
+    const char* base = Resolve(base_, rel_); 
+    return LoadMapped_(base); 
+}
+inline NPFold* NPFold::LoadMapped(const char* base_, const char* rel1_, const char* rel2_ )
+{
+    const char* base = Resolve(base_, rel1_, rel2_ ); 
+    return LoadMapped_(base); 
+}
+
+
 
 
 
@@ -525,6 +593,92 @@ inline NPFold* NPFold::LoadProp(const char* rel0, const char* rel1 )
     return nf ;  
 }
 
+/**
+NPFold::Threads
+-----------------
+
+Maximum number of threads used by concurrent load and save,
+initialized from envvar NPFold__THREADS, default 0 meaning sequential.
+
+**/
+
+inline int& NPFold::Threads() // static
+{
+    static int threads = U::GetEnvInt(THREADS_, 0) ; 
+    return threads ; 
+}
+
+inline std::atomic<int>& NPFold::Spare() // static
+{
+    static std::atomic<int> spare( std::max(0, Threads() - 1) ) ; 
+    return spare ; 
+}
+
+/**
+NPFold::SetThreads
+--------------------
+
+Only to be called when no load or save is in progress. 
+
+**/
+
+inline void NPFold::SetThreads(int num) // static
+{
+    Threads() = num ; 
+    Spare() = std::max(0, num - 1) ; 
+}
+
+/**
+NPFold::ForEach
+-----------------
+
+Calls fn(i) for i in [0,num). When spare pool threads are available
+up to num-1 of them are taken and run alongside the calling thread,
+each claiming indices from a shared atomic counter. The taken threads
+are returned to the pool on completion. 
+
+As nested calls from within fn (eg loading subfolds) can only take
+threads that are spare the total never exceeds NPFold::Threads
+and as the calling thread always participates progress is guaranteed.
+
+**/
+
+inline void NPFold::ForEach(int num, const std::function<void(int)>& fn ) // static
+{
+    std::atomic<int>& spare = Spare() ; 
+    int extra = 0 ; 
+    int avail = spare.load() ; 
+    while( num > 1 && avail > 0 )
+    {
+        int take = std::min( num - 1, avail ) ; 
+        if(spare.compare_exchange_weak(avail, avail - take)) 
+        {
+            extra = take ; 
+            break ; 
+        }
+    }
+
+    if( extra == 0 )
+    {
+        for(int i=0 ; i < num ; i++) fn(i) ; 
+        return ; 
+    }
+
+    std::atomic<int> next(0) ; 
+    auto work = [&]()
+    { 
+        for(int i=next++ ; i < num ; i=next++) fn(i) ; 
+    };
+
+    std::vector<std::thread> threads ; 
+    for(int t=0 ; t < extra ; t++) threads.emplace_back(work) ; 
+    work(); 
+    for(int t=0 ; t < extra ; t++) threads[t].join() ; 
+
+    spare += extra ; 
+}
+
+
 inline int NPFold::Compare(const NPFold* a, const NPFold* b )
 {
     int na = a->num_items(); 
@@ -613,6 +767,7 @@ inline NPFold::NPFold()
     savedir(nullptr),
     loaddir(nullptr),
     nodata(false),
+    mapped(false),
     verbose_(VERBOSE)
 {
     if(verbose_) std::cerr << "NPFold::NPFold" << std::endl ; 
@@ -866,6 +1021,7 @@ inline std::string NPFold::desc_subfold(const char* top)  const
     }
 
     if(nodata) ss << " NODATA " ; 
+    if(mapped) ss << " MAPPED " ; 
 
     std::string s = ss.str(); 
     return s ; 
@@ -1624,10 +1780,20 @@ inline void NPFold::_save(const char* base)  // not const as sets savedir
 
 
 
+/**
+NPFold::_save_arrays
+----------------------
+
+Arrays are written concurrently when NPFold__THREADS > 1, 
+the directory creation within NP::save tolerates other threads 
+creating the same directory. 
+
+**/
+
 inline int NPFold::_save_arrays(const char* base) // using the keys with .npy ext as filenames
 {
-    int count = 0 ; 
-    for(unsigned i=0 ; i < kk.size() ; i++) 
+    std::atomic<int> count(0) ; 
+    auto save_array = [&](int i)
     {
         const char* k = kk[i].c_str() ; 
         const NP* a = aa[i] ; 
@@ -1646,7 +1812,8 @@ inline int NPFold::_save_arrays(const char* base) // using the keys with .npy ex
             a->save(base, k );  
             count += 1 ; 
         }
-    }
+    };
+    ForEach( kk.size(), save_array ); 
     // this motivated adding directory creation to NP::save 
     return count ; 
 }
@@ -1654,26 +1821,26 @@ inline int NPFold::_save_arrays(const char* base) // using the keys with .npy ex
 inline void NPFold::_save_subfold_r(const char* base)  // NB recursively called via NPFold::save
 {
     assert( subfold.size() == ff.size() ); 
-    for(unsigned i=0 ; i < ff.size() ; i++) 
+    auto save_subfold = [&](int i)
     {
         const char* f = ff[i].c_str() ; 
         NPFold* sf = subfold[i] ; 
         sf->save(base, f );  
-    }
+    };
+    ForEach( ff.size(), save_subfold ); 
 }
 
 
 
 
 /**
-NPFold::load_array
---------------------
+NPFold::LoadArray
+-------------------
 
-0. NP::Load for relp ending .npy otherwise NP::LoadFromTxtFile<double>
-1. add the array using relp as the key
+NP::Load for relp ending .npy otherwise NP::LoadFromTxtFile<double>
 
 **/
-inline void NPFold::load_array(const char* _base, const char* relp)
+inline NP* NPFold::LoadArray(const char* _base, const char* relp) // static
 {
     bool is_nodata = NP::IsNoData(_base); 
     bool is_npy = IsNPY(relp) ; 
@@ -1692,12 +1859,27 @@ inline void NPFold::load_array(const char* _base, const char* relp)
     }
     else if(is_txt)
     {
-        a = NP::LoadFromTxtFile<double>(_base, relp) ; 
+        const char* base = NP::IsMapped(_base) ? _base + 1 : _base ;  // txt are small, so just read  
+        a = NP::LoadFromTxtFile<double>(base, relp) ; 
     }
     else
     {
         a = nullptr ; 
     } 
+    return a ; 
+}
+
+/**
+NPFold::load_array
+--------------------
+
+0. NPFold::LoadArray
+1. add the array using relp as the key
+
+**/
+inline void NPFold::load_array(const char* _base, const char* relp)
+{
+    NP* a = LoadArray(_base, relp) ; 
     if(a) add(relp,a ) ; 
 }
 
@@ -1792,15 +1974,15 @@ the associated array eg run.npy
 
 inline int NPFold::load_dir(const char* _base) 
 {
-    const char* base = nodata ? _base + 1 : _base ;  
+    const char* base = nodata || mapped ? _base + 1 : _base ;  
     std::vector<std::string> names ; 
     U::DirList(names, base) ; 
     if(names.size() == 0) return 1 ; 
 
-    for(unsigned i=0 ; i < names.size() ; i++)
+    auto kind = [&](const char* name) -> int
     {
-        const char* name = names[i].c_str(); 
         int type = U::PathType(base, name) ; 
+        int k = SKIP ; 
 
         if( type == U::FILE_PATH && U::EndsWith(name, "_meta.txt"))
         {
@@ -1808,7 +1990,7 @@ inline int NPFold::load_dir(const char* _base)
         }
         else if( type == U::FILE_PATH ) 
         {
-            load_array(_base, name) ; 
+            k = ARRAY ; 
         }
         else if( type == U::DIR_PATH && U::StartsWith(name, "_"))
         {
@@ -1816,29 +1998,58 @@ inline int NPFold::load_dir(const char* _base)
         }
         else if( type == U::DIR_PATH ) 
         {
-            load_subfold(_base, name);  // instanciates NPFold and add_subfold
+            k = SUBFOLD ; 
         }
-    }
-    return 0 ; 
+        return k ; 
+    };
+
+    return load_items(_base, names, kind ); 
 }
 
 
 inline int NPFold::load_index(const char* _base) 
 {
-    const char* base = nodata ? _base + 1 : _base ;  
+    const char* base = nodata || mapped ? _base + 1 : _base ;  
     std::vector<std::string> keys ; 
     NP::ReadNames(base, INDEX, keys );  
-    for(unsigned i=0 ; i < keys.size() ; i++) 
+
+    auto kind = [](const char* key) -> int { return IsNPY(key) ? ARRAY : SUBFOLD ; } ; 
+    return load_items(_base, keys, kind ); 
+}
+
+/**
+NPFold::load_items
+--------------------
+
+Loads arrays and subfolds for *keys* with *kind* of each key 
+obtained within the task as for load_dir that involves a stat.
+Loads are done via NPFold::ForEach, so concurrently when NPFold__THREADS > 1,
+into per-key slots that are then added in key order giving the 
+same fold as sequential loading.
+
+**/
+
+inline int NPFold::load_items(const char* _base, const std::vector<std::string>& keys, const std::function<int(const char*)>& kind )
+{
+    int num = keys.size() ; 
+    std::vector<int>     kk_(num, SKIP) ; 
+    std::vector<NP*>     aa_(num, nullptr) ; 
+    std::vector<NPFold*> ff_(num, nullptr) ; 
+
+    auto load_item = [&](int i)
     {
         const char* key = keys[i].c_str() ; 
-        if(IsNPY(key))
-        {
-            load_array(_base, key );   // invokes *add* appending to kk and aa 
-        }
-        else
-        {
-            load_subfold(_base, key);  // instanciates NPFold and add_subfold
-        }
+        kk_[i] = kind(key) ; 
+        if(      kk_[i] == ARRAY )   aa_[i] = LoadArray(_base, key) ; 
+        else if( kk_[i] == SUBFOLD ) ff_[i] = NPFold::Load(_base, key) ; 
+    };
+    ForEach( num, load_item ); 
+
+    for(int i=0 ; i < num ; i++)
+    {
+        const char* key = keys[i].c_str() ; 
+        if(      kk_[i] == ARRAY && aa_[i] ) add(key, aa_[i]) ; 
+        else if( kk_[i] == SUBFOLD )         add_subfold(key, ff_[i]) ; 
     }
     return 0 ; 
 }
@@ -1866,7 +2077,8 @@ How to avoid this structural difference and allow booting from property text fil
 inline int NPFold::load(const char* _base) 
 {
     nodata = NP::IsNoData(_base) ;  // _path starting with NP::NODATA_PREFIX eg '@' 
-    const char* base = nodata ? _base + 1 : _base ;  
+    mapped = NP::IsMapped(_base) ;  // _path starting with NP::MAPPED_PREFIX eg '%' 
+    const char* base = nodata || mapped ? _base + 1 : _base ;  
 
     loaddir = strdup(base); 
     bool has_meta = NP::Exists(base, META) ; 
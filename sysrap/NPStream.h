@@ -0,0 +1,282 @@
+#pragma once
+/**
+NPStream.h : append items to .npy file without holding the whole array in memory
+==================================================================================
+
+Usage::
+
+    NPStream st ;
+    st.open("$FOLD/hit.npy", "<f4", {4,4} );  // dtype and itemshape
+    st.append(a0) ;    // NP with matching dtype and itemshape
+    st.append(a1) ;
+    st.close() ;       // patches header shape[0] with total items appended
+
+The header is written first with zero items and padded to the length
+of a header with the largest possible item count, so it can be rewritten
+in place without moving the payload. NPStream::flush does that
+rewrite with the current count, so a file from an interrupted
+process is still valid with every item flushed before the interruption.
+
+Metadata set into NPStream::meta is written to the _meta.txt
+sidecar on close, as NP::save does.
+
+**/
+
+#include "NP.hh"
+
+struct NPStream
+{
+    static constexpr const bool VERBOSE = false ;
+
+    std::string       path ;
+    std::string       dtype ;
+    std::vector<int>  itemshape ;
+    std::string       meta ;
+
+    std::fstream*     fp ;
+    size_t            hdr_bytes ;
+    size_t            item_bytes ;
+    int64_t           num_items ;
+
+    static std::string Header(const std::vector<int>& shape, const char* dtype, size_t hdr_bytes );
+
+    NPStream();
+    ~NPStream();
+
+    bool is_open() const ;
+    std::vector<int> get_shape() const ;
+
+    int open(const char* path, const char* dtype, const std::vector<int>& itemshape );
+    template<typename T> int open(const char* path, const std::vector<int>& itemshape );
+
+    int append(const char* bytes, int64_t ni );
+    template<typename T> int append(const T* items, int64_t ni );
+    int append(const NP* a );
+
+    void flush();
+    int  close();
+
+    std::string desc() const ;
+};
+
+
+/**
+NPStream::Header
+-----------------
+
+Same layout as NPU::_make_header but padded with spaces to
+a requested total length. That is permitted by the NPY format
+and allows the shape to change without changing the header length.
+
+**/
+
+inline std::string NPStream::Header(const std::vector<int>& shape, const char* dtype, size_t hdr_bytes ) // static
+{
+    std::string dict = NPU::_make_dict( shape, dtype );
+    std::string preamble = NPU::_make_preamble() ;
+    size_t fixed = preamble.length() + 2 ;   // 2 bytes of little endian header length
+
+    bool fits = fixed + dict.length() + 1 <= hdr_bytes ;
+    if(!fits) std::cerr << "NPStream::Header dict does not fit within hdr_bytes " << hdr_bytes << std::endl ;
+    assert(fits);
+
+    uint16_t hlen = hdr_bytes - fixed ;
+
+    std::stringstream ss ;
+    ss << preamble ;
+    ss << NPU::_little_endian_short_string( hlen ) ;
+    ss << dict ;
+    for(size_t i=fixed + dict.length() ; i < hdr_bytes - 1 ; i++ ) ss << " " ;
+    ss << "\n" ;
+    std::string hdr = ss.str();
+    assert( hdr.length() == hdr_bytes );
+    return hdr ;
+}
+
+
+inline NPStream::NPStream()
+    :
+    fp(nullptr),
+    hdr_bytes(0),
+    item_bytes(0),
+    num_items(0)
+{
+}
+
+inline NPStream::~NPStream()
+{
+    if(is_open()) close();
+}
+
+inline bool NPStream::is_open() const
+{
+    return fp != nullptr ;
+}
+
+inline std::vector<int> NPStream::get_shape() const
+{
+    std::vector<int> shape ;
+    shape.push_back(int(num_items));
+    for(unsigned i=0 ; i < itemshape.size() ; i++) shape.push_back(itemshape[i]) ;
+    return shape ;
+}
+
+/**
+NPStream::open
+----------------
+
+The header length is fixed using the largest shape[0] the int shape can hold.
+
+**/
+
+inline int NPStream::open(const char* path_, const char* dtype_, const std::vector<int>& itemshape_ )
+{
+    assert( !is_open() );
+    const char* _path = U::Resolve(path_);
+    if(_path == nullptr) std::cerr << "NPStream::open failed to U::Resolve path_ " << ( path_ ? path_ : "-" ) << std::endl ;
+    if(_path == nullptr) return 1 ;
+
+    int rc = U::MakeDirsForFile(_path);
+    assert( rc == 0 );
+
+    path = _path ;
+    dtype = dtype_ ;
+    itemshape = itemshape_ ;
+    num_items = 0 ;
+    item_bytes = NPS::product(itemshape)*NPU::_dtype_ebyte(dtype.c_str()) ;
+
+    std::vector<int> max_shape(itemshape) ;
+    max_shape.insert( max_shape.begin(), std::numeric_limits<int>::max() );
+    hdr_bytes = NPU::_make_header( max_shape, dtype.c_str() ).length() ;
+
+    fp = new std::fstream(path.c_str(), std::ios::in|std::ios::out|std::ios::binary|std::ios::trunc);
+    if(fp->fail())
+    {
+        std::cerr << "NPStream::open FAILED for path " << path << std::endl ;
+        delete fp ;
+        fp = nullptr ;
+        return 1 ;
+    }
+
+    std::string hdr = Header( get_shape(), dtype.c_str(), hdr_bytes );
+    fp->write( hdr.data(), hdr.length() );
+
+    if(VERBOSE) std::cout << "NPStream::open " << desc() << std::endl ;
+    return 0 ;
+}
+
+template<typename T>
+inline int NPStream::open(const char* path_, const std::vector<int>& itemshape_ )
+{
+    std::string dtype_ = descr_<T>::dtype() ;
+    return open(path_, dtype_.c_str(), itemshape_ );
+}
+
+/**
+NPStream::append
+------------------
+
+Writes *ni* items to the end of the file, *bytes* must
+hold ni*item_bytes.
+
+**/
+
+inline int NPStream::append(const char* bytes, int64_t ni )
+{
+    assert( is_open() );
+    bool fits = num_items + ni <= std::numeric_limits<int>::max() ;
+    if(!fits) std::cerr << "NPStream::append FAILED : total items exceeds int shape limit " << desc() << std::endl ;
+    if(!fits) return 1 ;
+
+    fp->seekp( hdr_bytes + num_items*item_bytes );
+    fp->write( bytes, ni*item_bytes );
+    if(fp->fail()) std::cerr << "NPStream::append write FAILED " << desc() << std::endl ;
+    if(fp->fail()) return 2 ;
+
+    num_items += ni ;
+    return 0 ;
+}
+
+template<typename T>
+inline int NPStream::append(const T* items, int64_t ni )
+{
+    assert( sizeof(T) == item_bytes );
+    return append( (const char*)items, ni );
+}
+
+/**
+NPStream::append
+------------------
+
+Array dtype and item shape must match the stream.
+
+**/
+
+inline int NPStream::append(const NP* a )
+{
+    if(a == nullptr) return 0 ;
+    std::vector<int> a_itemshape(a->shape.begin() + 1, a->shape.end()) ;
+    bool match = strcmp(a->dtype, dtype.c_str()) == 0 && a_itemshape == itemshape ;
+    if(!match) std::cerr
+        << "NPStream::append FAILED : array dtype or itemshape does not match stream "
+        << " a " << a->sstr() << " " << a->dtype
+        << " stream " << desc()
+        << std::endl
+        ;
+    if(!match) return 1 ;
+    return append( a->bytes(), a->num_items() );
+}
+
+/**
+NPStream::flush
+-----------------
+
+Rewrites the header with the current item count and flushes
+the stream, leaving a valid .npy file.
+
+**/
+
+inline void NPStream::flush()
+{
+    assert( is_open() );
+    std::string hdr = Header( get_shape(), dtype.c_str(), hdr_bytes );
+    fp->seekp(0);
+    fp->write( hdr.data(), hdr.length() );
+    fp->flush();
+}
+
+inline int NPStream::close()
+{
+    if(!is_open()) return 1 ;
+    flush();
+    bool ok = !fp->fail() ;
+    fp->close();
+    delete fp ;
+    fp = nullptr ;
+
+    if(!meta.empty())
+    {
+        std::string meta_path = U::ChangeExt(path.c_str(), ".npy", "_meta.txt" );
+        std::ofstream fps(meta_path.c_str(), std::ios::out);
+        fps << meta ;
+    }
+
+    if(VERBOSE) std::cout << "NPStream::close " << desc() << std::endl ;
+    return ok ? 0 : 1 ;
+}
+
+inline std::string NPStream::desc() const
+{
+    std::stringstream ss ;
+    ss << "NPStream::desc"
+       << " path " << path
+       << " dtype " << dtype
+       << " shape " << NPS::desc(get_shape())
+       << " hdr_bytes " << hdr_bytes
+       << " item_bytes " << item_bytes
+       << " is_open " << ( is_open() ? "YES" : "NO " )
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
@@ -186,20 +186,20 @@ struct NPS
 {
     NPS(std::vector<int>& shape_ ) : shape(shape_) {}  ; 
 
-    static int set_shape(std::vector<int>& shape_, int ni, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) 
+    static int64_t set_shape(std::vector<int>& shape_, int ni, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) 
     {
         NPS sh(shape_); 
         sh.set_shape(ni,nj,nk,nl,nm,no); 
         return sh.size(); 
     }
 
-    static int copy_shape(std::vector<int>& dst, const std::vector<int>& src) 
+    static int64_t copy_shape(std::vector<int>& dst, const std::vector<int>& src) 
     {
         for(unsigned i=0 ; i < src.size() ; i++) dst.push_back(src[i]); 
         return size(dst); 
     }
 
-    static int copy_shape(std::vector<int>& dst, int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1) 
+    static int64_t copy_shape(std::vector<int>& dst, int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1) 
     {
         if(ni >= 0) dst.push_back(ni);   // experimental allow zero items
         if(nj > 0) dst.push_back(nj); 
@@ -224,10 +224,10 @@ struct NPS
         copy_shape(shape, other); 
     }
 
-    static int change_shape(std::vector<int>& shp, int ni_, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1)
+    static int64_t change_shape(std::vector<int>& shp, int ni_, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1)
     {
-        unsigned nv0 = size(shp); 
-        unsigned nv1 = std::max(1,ni_)*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
+        int64_t nv0 = size(shp); 
+        int64_t nv1 = int64_t(std::max(1,ni_))*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
 
         if( nv0 != nv1 )  // try to devine a missing -1 entry 
         {
@@ -238,7 +238,7 @@ struct NPS
             else if( nm_ < 0 ) nm_ = nv0/nv1 ; 
             else if( no_ < 0 ) no_ = nv0/nv1 ; 
 
-            unsigned nv2 = std::max(1,ni_)*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
+            int64_t nv2 = int64_t(std::max(1,ni_))*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
             bool expect = nv0 % nv1 == 0 && nv2 == nv0 ; 
 
             if(!expect) std::cout 
@@ -263,10 +263,10 @@ struct NPS
         return copy_shape(shp, ni_, nj_, nk_, nl_, nm_, no_ ); 
     }
 
-    static int product(const std::vector<int>& src )
+    static int64_t product(const std::vector<int>& src )
     {
         int nd = src.size(); 
-        int prod = 1 ; 
+        int64_t prod = 1 ; 
         for(int i=0 ; i < nd ; i++) prod *= src[i] ; 
         return prod ; 
     }
@@ -308,22 +308,22 @@ struct NPS
         return ss.str(); 
     } 
 
-    static int size(const std::vector<int>& shape)
+    static int64_t size(const std::vector<int>& shape)
     {
         int ndim = int(shape.size()); 
-        int sz = 1;
+        int64_t sz = 1;
         for(int i=0; i<ndim; ++i) sz *= shape[i] ;
         return ndim == 0 ? 0 : sz ;  
     }
 
-    static int itemsize(const std::vector<int>& shape)
+    static int64_t itemsize(const std::vector<int>& shape)
     {
-        int sz = 1;
+        int64_t sz = 1;
         for(unsigned i=1; i<shape.size(); ++i) sz *= shape[i] ;
         return sz ;  
     }
 
-    static int itemsize_(const std::vector<int>& shape, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 )
+    static int64_t itemsize_(const std::vector<int>& shape, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 )
     {
         // assert only one transition from valid indices to skipped indices 
         if( i == -1 )                                                      assert( j == -1 && k == -1 &&  l == -1 && m == -1 && o == -1 ) ;  
@@ -342,7 +342,7 @@ struct NPS
         if( i > -1 && j > -1 && k >  -1 && l >  -1 && m >  -1 && o == -1 ) dim0 = 5 ; 
         if( i > -1 && j > -1 && k >  -1 && l >  -1 && m >  -1 && o >  -1 ) dim0 = 6 ; 
 
-        int sz = 1;
+        int64_t sz = 1;
         if( dim0 < shape.size() )
         {
             for(unsigned d=dim0; d<shape.size(); ++d) sz *= shape[d] ;
@@ -366,7 +366,7 @@ struct NPS
 
     std::string desc() const { return desc(shape) ; }
     std::string json() const { return json(shape) ; }
-    int size() const { return size(shape) ; }
+    int64_t size() const { return size(shape) ; }
      
 
     static int ni_(const std::vector<int>& shape) { return shape.size() > 0 ? shape[0] : 1 ;  }
@@ -383,14 +383,14 @@ struct NPS
     int nm_() const { return nm_(shape) ; }
     int no_() const { return no_(shape) ; }
 
-    int idx(int i, int j, int k, int l, int m, int o)
+    int64_t idx(int i, int j, int k, int l, int m, int o)
     {
-        //int ni = ni_() ;
-        int nj = nj_() ; 
-        int nk = nk_() ; 
-        int nl = nl_() ;
-        int nm = nm_() ;
-        int no = no_() ;
+        //int64_t ni = ni_() ;
+        int64_t nj = nj_() ; 
+        int64_t nk = nk_() ; 
+        int64_t nl = nl_() ;
+        int64_t nm = nm_() ;
+        int64_t no = no_() ;
 
         return  i*nj*nk*nl*nm*no + j*nk*nl*nm*no + k*nl*nm*no + l*nm*no + m*no + o ;
     }
@@ -340,7 +340,7 @@ inline void NPX::VecFromArray(std::vector<S>& v, const NP* a )
 {
    if(a == nullptr || a->shape.size() == 0 ) return ; 
    int ni = a->shape[0] ; 
-   unsigned ib = a->item_bytes() ;   
+   size_t ib = a->item_bytes() ;   
    bool expected_sizeof_item = sizeof(S) == ib  ; 
 
    if(!expected_sizeof_item) 
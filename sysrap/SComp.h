@@ -15,6 +15,7 @@ NB: the old OpticksEvent analog of this is SComponent.hh
 #include "SYSRAP_API_EXPORT.hh"
 
 struct NP ; 
+struct NPFold ; 
 
 enum {
     SCOMP_UNDEFINED = 0x1 <<  0, 
@@ -46,6 +47,7 @@ struct SYSRAP_API SCompProvider
     virtual const char* getTypeName() const = 0 ; 
     virtual std::string getMeta() const = 0 ; 
     virtual NP* gatherComponent(unsigned comp) const = 0 ; 
+    virtual int gatherHitColumns(NPFold* fold) const = 0 ;   // columnar alternative to the hit component, see sphoton_column.h
 }; 
 
 struct SYSRAP_API SComp
@@ -5,6 +5,9 @@ SCurandState.hh
 
 See also qudarap/QCurandState.hh 
 
+The states in these files can also be created on the host with s_curand_xorwow.h 
+which QRng uses when the file does not exist or QRng__GENERATE is set. 
+
 Chunked States ?
 -------------------
 
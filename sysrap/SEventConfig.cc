@@ -18,6 +18,8 @@
 #include "SRG.h"  // raygenmode
 #include "SRM.h"  // runningmode
 #include "SComp.h"
+#include "sphoton_column.h"
+#include "sgenstep_lookup.h"
 #include "OpticksPhoton.hh"
 
 #include "SLOG.hh"
@@ -51,6 +53,8 @@ const char* SEventConfig::_OutFoldDefault = "$DefaultOutputDir" ;
 const char* SEventConfig::_OutNameDefault = nullptr ; 
 const char* SEventConfig::_RGModeDefault = "simulate" ; 
 const char* SEventConfig::_HitMaskDefault = "SD" ; 
+const char* SEventConfig::_HitColumnsDefault = "" ; 
+const char* SEventConfig::_GenstepLookupDefault = "seed" ; 
 
 #ifdef __APPLE__
 const char* SEventConfig::_MaxGenstepDefault = "M1" ; 
@@ -166,6 +170,8 @@ const char* SEventConfig::_OutFold = ssys::getenvvar(kOutFold, _OutFoldDefault )
 const char* SEventConfig::_OutName = ssys::getenvvar(kOutName, _OutNameDefault ); 
 int SEventConfig::_RGMode = SRG::Type(ssys::getenvvar(kRGMode, _RGModeDefault)) ;    
 unsigned SEventConfig::_HitMask  = OpticksPhoton::GetHitMask(ssys::getenvvar(kHitMask, _HitMaskDefault )) ;   
+unsigned SEventConfig::_HitColumns = sphoton_column::Mask(ssys::getenvvar(kHitColumns, _HitColumnsDefault )) ;   
+int SEventConfig::_GenstepLookup = sgenstep_lookup::Mode(ssys::getenvvar(kGenstepLookup, _GenstepLookupDefault )) ;   
 
 unsigned SEventConfig::_GatherComp  = SComp::Mask(ssys::getenvvar(kGatherComp, _GatherCompDefault )) ;   
 unsigned SEventConfig::_SaveComp    = SComp::Mask(ssys::getenvvar(kSaveComp,   _SaveCompDefault )) ;   
@@ -235,6 +241,8 @@ float SEventConfig::MaxTime(){   return _MaxTime ; }
 const char* SEventConfig::OutFold(){   return _OutFold ; }
 const char* SEventConfig::OutName(){   return _OutName ; }
 unsigned SEventConfig::HitMask(){     return _HitMask ; }
+unsigned SEventConfig::HitColumns(){  return _HitColumns ; }
+int SEventConfig::GenstepLookup(){    return _GenstepLookup ; }
 
 unsigned SEventConfig::GatherComp(){  return _GatherComp ; } 
 unsigned SEventConfig::SaveComp(){    return _SaveComp ; } 
@@ -332,6 +340,8 @@ void SEventConfig::SetMaxTime(   float max_time){   _MaxTime = max_time  ; Check
 void SEventConfig::SetOutFold(   const char* outfold){   _OutFold = outfold ? strdup(outfold) : nullptr ; Check() ; }
 void SEventConfig::SetOutName(   const char* outname){   _OutName = outname ? strdup(outname) : nullptr ; Check() ; }
 void SEventConfig::SetHitMask(   const char* abrseq, char delim){  _HitMask = OpticksPhoton::GetHitMask(abrseq,delim) ; }
+void SEventConfig::SetHitColumns(const char* names, char delim){   _HitColumns = sphoton_column::Mask(names,delim) ; }
+void SEventConfig::SetGenstepLookup(const char* mode){   _GenstepLookup = sgenstep_lookup::Mode(mode) ; }
 
 void SEventConfig::SetRGMode(   const char* mode){   _RGMode = SRG::Type(mode) ; Check() ; }
 void SEventConfig::SetRGModeSimulate(){  SetRGMode( SRG::SIMULATE_ ); }
@@ -470,6 +480,8 @@ void SEventConfig::CompAuto(unsigned& gather_mask, unsigned& save_mask )
 
 
 std::string SEventConfig::HitMaskLabel(){  return OpticksPhoton::FlagMask( _HitMask ) ; }
+std::string SEventConfig::HitColumnsLabel(){  return sphoton_column::Desc( _HitColumns ) ; }
+const char* SEventConfig::GenstepLookupLabel(){  return sgenstep_lookup::Name( _GenstepLookup ) ; }
 
 
 //std::string SEventConfig::CompMaskLabel(){ return SComp::Desc( _CompMask ) ; }
@@ -620,6 +632,12 @@ std::string SEventConfig::Desc()
        << std::setw(25) << ""
        << std::setw(20) << " HitMaskLabel " << " : " << HitMaskLabel() 
        << std::endl 
+       << std::setw(25) << kHitColumns
+       << std::setw(20) << " HitColumnsLabel " << " : " << HitColumnsLabel() 
+       << std::endl 
+       << std::setw(25) << kGenstepLookup
+       << std::setw(20) << " GenstepLookupLabel " << " : " << GenstepLookupLabel() 
+       << std::endl 
        << std::setw(25) << kMaxExtent
        << std::setw(20) << " MaxExtent " << " : " << MaxExtent() 
        << std::endl 
@@ -889,6 +907,8 @@ NP* SEventConfig::Serialize() // static
     if(on) meta->set_meta<std::string>("OutName", on );  
 
     meta->set_meta<unsigned>("HitMask", HitMask() );  
+    meta->set_meta<unsigned>("HitColumns", HitColumns() );  
+    meta->set_meta<std::string>("GenstepLookup", GenstepLookupLabel() );  
 
     meta->set_meta<unsigned>("GatherComp", GatherComp() );  
     meta->set_meta<unsigned>("SaveComp", SaveComp() );  
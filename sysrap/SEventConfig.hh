@@ -50,6 +50,18 @@ MaxExtent (mm)
 MaxTime (ns)
     only relevant to the domain compression of the compressed step records
 
+HitColumns
+    normally empty, giving the standard 4x4 float hit array. When fields are listed,
+    eg "pos,time,wavelength,identity,half", hits are gathered as one array per field
+    (hit_pos, hit_time, ...) with the selection done on device before download,
+    see sphoton_column.h 
+
+GenstepLookup
+    photon index to genstep index mapping used by the simulate and simtrace
+    launches, one of "seed" (default, per photon seed array filled by iexpand),
+    "search" or "table" (seedless search of the genstep numphoton prefix sum),
+    see sgenstep_lookup.h 
+
 
 +-------------------------------+-----------------------------------------+---------------------------------------+
 | Method                        |  Default                                | envvar                                |
@@ -69,6 +81,8 @@ struct SYSRAP_API SEventConfig
     static void Check(); 
     static std::string Desc(); 
     static std::string HitMaskLabel(); 
+    static std::string HitColumnsLabel(); 
+    static const char* GenstepLookupLabel(); 
 
 
     // [TODO : RECONSIDER OUTDIR OUTNAME MECHANICS FOLLOWING SEVT LAYOUT 
@@ -113,6 +127,8 @@ struct SYSRAP_API SEventConfig
     static constexpr const char* kOutFold      = "OPTICKS_OUT_FOLD" ; 
     static constexpr const char* kOutName      = "OPTICKS_OUT_NAME" ; 
     static constexpr const char* kHitMask      = "OPTICKS_HIT_MASK" ; 
+    static constexpr const char* kHitColumns   = "OPTICKS_HIT_COLUMNS" ; 
+    static constexpr const char* kGenstepLookup = "OPTICKS_GENSTEP_LOOKUP" ; 
     static constexpr const char* kRGMode       = "OPTICKS_RG_MODE" ; 
 
     static constexpr const char* kGatherComp   = "OPTICKS_GATHER_COMP" ; 
@@ -165,6 +181,8 @@ struct SYSRAP_API SEventConfig
     static const char* OutFold(); 
     static const char* OutName(); 
     static unsigned HitMask(); 
+    static unsigned HitColumns();   // sphoton_column mask, zero for standard 4x4 hits 
+    static int GenstepLookup();     // sgenstep_lookup::SEED/SEARCH/TABLE 
 
     static unsigned GatherComp(); 
     static unsigned SaveComp(); 
@@ -254,6 +272,8 @@ struct SYSRAP_API SEventConfig
     static void SetOutFold( const char* out_fold); 
     static void SetOutName( const char* out_name); 
     static void SetHitMask(const char* abrseq, char delim=',' ); 
+    static void SetHitColumns(const char* names, char delim=',' ); 
+    static void SetGenstepLookup(const char* mode); 
 
     static void SetRGMode( const char* rg_mode) ; 
     static void SetRGModeSimulate() ; 
@@ -305,6 +325,8 @@ struct SYSRAP_API SEventConfig
     static const char* _OutFoldDefault ; 
     static const char* _OutNameDefault ; 
     static const char* _HitMaskDefault ; 
+    static const char* _HitColumnsDefault ; 
+    static const char* _GenstepLookupDefault ; 
     static const char* _RGModeDefault ; 
 
     static const char* _GatherCompDefault ; 
@@ -353,6 +375,8 @@ struct SYSRAP_API SEventConfig
     static const char* _OutFold ; 
     static const char* _OutName ; 
     static unsigned _HitMask ; 
+    static unsigned _HitColumns ; 
+    static int _GenstepLookup ; 
     static int _RGMode ; 
 
     static unsigned _GatherComp ; 
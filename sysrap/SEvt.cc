@@ -8,8 +8,11 @@
 #include "squadx.h"
 #include "sstamp.h"
 #include "sprof.h"
+#include "stimeline.h"
 
 #include "sphoton.h"
+#include "sphoton_column.h"
+#include "sphoton_compact.h"
 #include "srec.h"
 #include "sseq.h"
 #include "ssys.h"
@@ -29,6 +32,7 @@
 #include "NP.hh"
 #include "NPX.h"
 #include "NPFold.h"
+#include "NPStream.h"
 #include "SGeo.hh"
 #include "SEvt.hh"
 #include "SEvent.hh"
@@ -44,6 +48,7 @@
 bool SEvt::GATHER = ssys::getenvbool(SEvt__GATHER) ; 
 bool SEvt::LIFECYCLE = ssys::getenvbool(SEvt__LIFECYCLE) ; 
 bool SEvt::CLEAR_SIGINT = ssys::getenvbool(SEvt__CLEAR_SIGINT) ; 
+bool SEvt::STREAM_HIT = ssys::getenvbool(SEvt__STREAM_HIT) ; 
 
 
 const char* SEvt::descStage() const 
@@ -186,6 +191,7 @@ SEvt::SEvt()
     random_array(nullptr),
     provider(this),   // overridden with SEvt::setCompProvider for device running from QEvent::init 
     fold(new NPFold),
+    hit_stream(),
     cf(nullptr),
     hostside_running_resize_done(false),
     gather_done(false),
@@ -1392,6 +1398,8 @@ void SEvt::EndOfRun()
 { 
     SetRunProf("SEvt__EndOfRun"); 
     SaveRunMeta(); 
+    CloseHitStreams(); 
+    if(stimeline::Enabled()) stimeline::Save(RunDir()); 
 } 
 
 
@@ -1550,6 +1558,7 @@ as still need to collect the gensteps.
 
 void SEvt::beginOfEvent(int eventID)
 {
+    STIMELINE_SCOPE("SEvt::beginOfEvent"); 
     if(isFirstEvtInstance() && eventID == 0) BeginOfRun() ; 
     if(eventID == 0) SetRunProf( isEGPU() ? "SEvt__beginOfEvent_FIRST_EGPU" : "SEvt__beginOfEvent_FIRST_ECPU" ) ; 
 
@@ -1591,6 +1600,7 @@ so can switch off all saving wuth that config.
 
 void SEvt::endOfEvent(int eventID)
 {
+    STIMELINE_SCOPE("SEvt::endOfEvent"); 
 
     setStage(SEvt__endOfEvent); 
     LOG_IF(info, LIFECYCLE) << id() ; 
@@ -3139,7 +3149,9 @@ SEvt::gatherHit
 -------------------------------------------
 
 Does CPU side equivalent of QEvent::gatherHit_ 
-using the photon array and the sphoton_selector 
+using the photon array and the sphoton_selector hitmask 
+with the multi-threaded prefix sum compaction of sphoton_compact.h
+which gives the same hit ordering as the GPU thrust::copy_if 
 
 HMM: notice that this relies on having gathered 
 the photon array, and there being an entry in the fold.
@@ -3152,10 +3164,44 @@ This means that hit must come after photon in the component order
 NP* SEvt::gatherHit() const 
 { 
     const NP* p = getPhoton(); 
-    NP* h = p ? p->copy_if<float, sphoton>(*selector) : nullptr ;  
+    NP* h = p ? sphoton_compact::Select(p, selector->hitmask) : nullptr ;  
     return h ; 
 }
 
+/**
+SEvt::gatherHitColumns
+------------------------
+
+CPU side equivalent of QEvent::gatherHitColumns, adding the 
+SEventConfig::HitColumns selected arrays such as hit_pos, hit_time 
+to *hfold* filled from the photon array with the sphoton_selector. 
+As with SEvt::gatherHit this relies on photon being gathered first.  
+
+Returns the number of hits or -1 when there is no photon array. 
+
+**/
+
+int SEvt::gatherHitColumns(NPFold* hfold) const 
+{
+    const NP* p = getPhoton(); 
+    if(p == nullptr) return -1 ; 
+
+    const sphoton* pp = (const sphoton*)p->cvalues<float>() ; 
+    int num_photon = p->shape[0] ; 
+
+    unsigned num_hit = sphoton_compact::Count(p, selector->hitmask) ; 
+    if( num_hit == 0 ) return 0 ; 
+
+    sphoton_column column(SEventConfig::HitColumns(), num_hit) ; 
+    column.add_arrays(hfold) ; 
+
+    unsigned j = 0 ; 
+    for(int i=0 ; i < num_photon ; i++) if((*selector)(pp[i])) column.write(j++, pp[i]) ; 
+    assert( j == num_hit ); 
+
+    return num_hit ; 
+}
+
 NP* SEvt::gatherSimtrace() const 
 { 
     if( evt->simtrace == nullptr ) return nullptr ; 
@@ -3487,6 +3533,14 @@ void SEvt::gather_components()   // *GATHER*
     {
         unsigned cmp = gather_comp[i] ;   
         const char* k = SComp::Name(cmp);    
+
+        if( SComp::IsHit(cmp) && SEventConfig::HitColumns() != 0u )
+        {
+            num_hit = provider->gatherHitColumns(fold) ;  // hit_pos, hit_time, ... in place of hit 
+            LOG_IF(info, GATHER) << " k " << std::setw(15) << k << " columns " << SEventConfig::HitColumnsLabel() << " num_hit " << num_hit ; 
+            continue ; 
+        }
+
         NP* a = provider->gatherComponent(cmp); 
         bool null_component = a == nullptr ;
 
@@ -3514,6 +3568,8 @@ void SEvt::gather_components()   // *GATHER*
         else if(SComp::IsHit(cmp))     num_hit = num ; 
     }
 
+    if(STREAM_HIT) streamHit(); 
+
     gather_total += 1 ;
 
     if(num_genstep > -1) genstep_total += num_genstep ;
@@ -3567,6 +3623,7 @@ into NPFold from the SCompProvider which can either be:
 
 void SEvt::gather() 
 {
+    STIMELINE_SCOPE("SEvt::gather"); 
     setStage(SEvt__gather); 
     LOG_IF(info, LIFECYCLE) << id() ; 
     LOG_IF(fatal, gather_done) << " gather_done ALREADY : SKIPPING " ; 
@@ -3863,6 +3920,7 @@ int SEvt::load(const char* dir_)
 
 int SEvt::loadfold( const char* dir )
 {
+    STIMELINE_SCOPE("SEvt::loadfold.NPFold::load"); 
     LOG(LEVEL) << "[ fold.load " << dir ; 
     int rc = fold->load(dir); 
     LOG(LEVEL) << "] fold.load " << dir ; 
@@ -3928,6 +3986,15 @@ void SEvt::save(const char* dir_)
 
     bool shallow = true ; 
     std::string save_comp = SEventConfig::SaveCompLabel() ; 
+    if(SComp::IsHit(SEventConfig::SaveComp()) && SEventConfig::HitColumns() != 0u) save_comp += "," + sphoton_column::Keys(SEventConfig::HitColumns()) ; 
+    if(STREAM_HIT)  // hits already appended to the run level stream by gather_components, so dont save again
+    {
+        std::vector<std::string> kk ; 
+        U::Split( save_comp.c_str(), ',', kk ); 
+        std::stringstream ss ; 
+        for(unsigned i=0 ; i < kk.size() ; i++) if(!IsStreamedHitKey(kk[i].c_str())) ss << ( ss.tellp() > 0 ? "," : "" ) << kk[i] ; 
+        save_comp = ss.str() ; 
+    }
     NPFold* save_fold = fold->copy(save_comp.c_str(), shallow) ; 
 
     LOG_IF(LEVEL, save_fold == nullptr) << " NOTHING TO SAVE SEventConfig::SaveCompLabel/OPTICKS_SAVE_COMP  " << save_comp ; 
@@ -3954,7 +4021,10 @@ void SEvt::save(const char* dir_)
         LOG(LEVEL) << descSaveDir(dir_) ; 
 
         LOG(LEVEL) << "[ save_fold.save " << dir ; 
-        save_fold->save(dir); 
+        {
+            STIMELINE_SCOPE("SEvt::save.NPFold::save"); 
+            save_fold->save(dir); 
+        }
         LOG(LEVEL) << "] save_fold.save " << dir ; 
 
         int num_save_comp = SEventConfig::NumSaveComp();  
@@ -3986,6 +4056,95 @@ void SEvt::saveFrame(const char* dir) const
     LOG(LEVEL) << "] dir " << dir ; 
 }
 
+/**
+SEvt::streamHit
+-----------------
+
+With SEvt__STREAM_HIT the hit array of every event, or with SEventConfig::HitColumns
+each of the hit column arrays, is appended to a run level file in the RunDir, 
+eg hit_stream_A.npy for EGPU or hit_pos_stream_A.npy for the hit_pos column, 
+using NPStream. Hits from all events of a run are then persisted 
+without holding them all in memory. The header is rewritten after 
+each append so the files are always loadable. 
+
+Invoked from SEvt::gather_components as soon as the hits are gathered. 
+SEvt::save then leaves the streamed keys out of the saved fold so
+the hits are not written twice. The streams are closed by SEvt::EndOfRun. 
+
+**/
+
+bool SEvt::IsStreamedHitKey(const char* k) // static
+{
+    return strcmp(k, SComp::Name(SCOMP_HIT)) == 0 || strncmp(k, "hit_", 4) == 0 ; 
+}
+
+void SEvt::streamHit()
+{
+    for(int i=0 ; i < fold->num_items() ; i++)
+    {
+        const char* k = fold->get_key(i) ; 
+        if(IsStreamedHitKey(k)) streamHit(k, fold->get_array(i)) ; 
+    }
+}
+
+void SEvt::streamHit(const char* k, const NP* a)
+{
+    if(a == nullptr) return ; 
+    NPStream*& st = hit_stream[k] ; 
+
+    if(st == nullptr)
+    {
+        std::stringstream ss ; 
+        ss << k << "_stream_" << getInstancePrefix() << ".npy" ; 
+        std::string name = ss.str(); 
+        const char* path = spath::Resolve(RunDir(), name.c_str()) ; 
+
+        std::vector<int> itemshape(a->shape.begin() + 1, a->shape.end()) ; 
+        st = new NPStream ; 
+        int rc = st->open(path, a->dtype, itemshape ); 
+        LOG_IF(error, rc != 0) << " FAILED to open hit_stream " << path ; 
+        if(rc != 0) 
+        {
+            delete st ; 
+            hit_stream.erase(k) ; 
+            return ; 
+        }
+    }
+
+    int rc = st->append(a); 
+    LOG_IF(error, rc != 0) << " FAILED to append " << k << " " << a->sstr() << " " << st->desc() ; 
+    st->flush(); 
+    LOG(LEVEL) << st->desc() ; 
+}
+
+/**
+SEvt::closeHitStream
+----------------------
+
+Invoked for every SEvt instance from SEvt::EndOfRun after SEvt::SaveRunMeta
+so the run metadata written to the stream sidecars is complete. 
+
+**/
+
+void SEvt::closeHitStream()
+{
+    typedef std::map<std::string, NPStream*>::iterator IT ; 
+    for(IT it=hit_stream.begin() ; it != hit_stream.end() ; it++)
+    {
+        NPStream* st = it->second ; 
+        st->meta = RUN_META->meta ; 
+        st->close(); 
+        LOG(LEVEL) << st->desc() ; 
+        delete st ; 
+    }
+    hit_stream.clear(); 
+}
+
+void SEvt::CloseHitStreams() // static
+{
+    for(int i=0 ; i < MAX_INSTANCE ; i++) if(Exists(i)) Get(i)->closeHitStream() ; 
+}
+
 
 std::string SEvt::descComponent() const 
 {
@@ -4138,6 +4297,7 @@ unsigned SEvt::getNumPhoton() const { return fold->get_num(SComp::PHOTON_) ; }
 unsigned SEvt::getNumHit() const    
 { 
     int num = fold->get_num(SComp::HIT_) ;  // number of items in array 
+    if(num == NPFold::UNDEF && SEventConfig::HitColumns() != 0u ) num = sphoton_column::Num(fold, SEventConfig::HitColumns()) ; 
     return num == NPFold::UNDEF ? 0 : num ;   // avoid returning -1 when no hits
 }
 
@@ -55,6 +55,7 @@ index and photon offset in addition to  gentype/trackid/matline/numphotons
 
 #include <cassert>
 #include <vector>
+#include <map>
 #include <string>
 #include <sstream>
 #include "plog/Severity.h"
@@ -82,6 +83,7 @@ struct sphoton_selector ;
 struct sdebug ; 
 struct NP ; 
 struct NPFold ; 
+struct NPStream ; 
 struct SGeo ; 
 struct S4RandomArray ;  
 struct stimer ; 
@@ -102,6 +104,9 @@ struct SYSRAP_API SEvt : public SCompProvider
     static constexpr const char* SEvt__CLEAR_SIGINT = "SEvt__CLEAR_SIGINT" ; 
     static bool CLEAR_SIGINT ; 
 
+    static constexpr const char* SEvt__STREAM_HIT = "SEvt__STREAM_HIT" ; 
+    static bool STREAM_HIT ; 
+
     enum { SEvt__SEvt, 
            SEvt__init, 
            SEvt__beginOfEvent, 
@@ -176,6 +181,7 @@ struct SYSRAP_API SEvt : public SCompProvider
 
     const SCompProvider*  provider ; 
     NPFold*               fold ; 
+    std::map<std::string, NPStream*> hit_stream ;   // keyed by hit or hit column name, only with SEvt__STREAM_HIT, see SEvt::streamHit 
     const SGeo*           cf ; 
 
     bool              hostside_running_resize_done ; // only ever becomes true for non-GPU running 
@@ -588,6 +594,7 @@ public:
     std::string getMeta() const ; 
     const char* getTypeName() const ; 
     NP* gatherComponent(unsigned comp) const ; 
+    int gatherHitColumns(NPFold* fold) const ; 
     //] SCompProvider methods
 
 
@@ -650,6 +657,12 @@ public:
     void saveExtra(const char* dir_, const char* name, const NP* a ) const ; 
     void saveFrame(const char* dir_) const ; 
 
+    static bool IsStreamedHitKey(const char* k); 
+    void streamHit(); 
+    void streamHit(const char* k, const NP* a); 
+    void closeHitStream(); 
+    static void CloseHitStreams(); 
+
     std::string descComponent() const ; 
     std::string descComp() const ; 
     std::string descVec() const ; 
@@ -9,12 +9,15 @@
 #include "ssys.h"
 
 #include "SLOG.hh"
-#include "SRng.hh"
+#include "sphilox.h"
 #include "SGenstep.hh"
 #include "OpticksGenstep.h"
 #include "SFrameGenstep.hh"
 #include "NP.hh"
 
+#include <thread>
+#include <algorithm>
+
 
 const plog::Severity SFrameGenstep::LEVEL = SLOG::EnvLevel("SFrameGenstep", "DEBUG" ); 
 
@@ -581,74 +584,77 @@ void SFrameGenstep::GetBoundingBox( float3& mn, float3& mx, const float4& ce, co
 
 
 /**
-SFrameGenstep::GenerateCenterExtentGenstepPhotons
------------------------------------------------------
+SFrameGenstep::NumThreads
+---------------------------
+
+Number of threads for generating num_photon, default std::thread::hardware_concurrency
+override with envvar SFrameGenstep__THREADS. Below MIN_PARALLEL photons uses one thread. 
 
 **/
 
-NP* SFrameGenstep::GenerateCenterExtentGenstepPhotons_( const NP* gsa, float gridscale )
+int SFrameGenstep::NumThreads(int num_threads, int64_t num_photon) // static
 {
-    std::vector<quad4> pp ;
-    GenerateCenterExtentGenstepPhotons( pp, gsa, gridscale ); 
-
-    NP* ppa = NP::Make<float>( pp.size(), 4, 4 );
-    memcpy( ppa->bytes(),  (float*)pp.data(), ppa->arr_bytes() );
-    return ppa ; 
+    int nt = num_threads > 0 ? num_threads : ssys::getenvint(EKEY_THREADS, 0) ; 
+    if( nt <= 0 ) nt = int(std::thread::hardware_concurrency()) ; 
+    if( nt < 1 ) nt = 1 ; 
+    if( num_photon < MIN_PARALLEL ) nt = 1 ; 
+    return nt ; 
 }
 
+/**
+SFrameGenstep::GetOffsets
+---------------------------
+
+Exclusive prefix sum over the gensteps of photons with num_genstep+1 entries, 
+giving the index of the first photon of each genstep. 
+Returns the total number of photons.
 
+**/
 
+int64_t SFrameGenstep::GetOffsets( std::vector<int64_t>& photon_offset, const quad6* gs, int num_genstep ) // static
+{
+    photon_offset.resize( num_genstep + 1 ); 
+    int64_t num_photon = 0 ; 
+    for(int g=0 ; g < num_genstep ; g++)
+    {
+        photon_offset[g] = num_photon ; 
+        int num_photons_ = gs[g].q0.i.w ; 
+        num_photon += std::abs(num_photons_) ; 
+    }
+    photon_offset[num_genstep] = num_photon ; 
+    return num_photon ; 
+}
 
 /**
-SFrameGenstep::GenerateCenterExtentGenstepPhotons
----------------------------------------------------
+SFrameGenstep::Generate_range
+-------------------------------
+
+Generates the photons of gensteps [g0,g1) into pp[photon_offset[g]-p_base+j]. 
+The randoms u0 and u1 of each photon are the first two of a counter based sphilox 
+stream keyed on (SEED, photon index) so any range can be generated independently 
+with results that do not depend on how the gensteps are split. 
 
 Contrast this CPU implementation of CEGS generation with qudarap/qsim.h qsim<T>::generate_photon_torch
 
 The inner loop should be similar to qudarap/qsim.h/generate_photon_simtrace
 
-TODO: arrange a header such that can actually use the same code via some curand_uniform 
-macro refinition trickery
-
 -ve num_photons uses regular, not random azimuthal spray of directions
 
-TODO: consolidate the below two methods, paradir is the hangup 
+layout CEGS
+    p.q0 position, p.q1 direction, p.q3.u.w identity : as formerly GenerateCenterExtentGenstepPhotons, 
+    with non-zero *paradir* the photons are parallel along the grid instead of from genstep position 
 
+layout SIMTRACE
+    follows sevent::add_simtrace p.q2 initial position p.q3 initial direction p.q3.u.w identity
+    as formerly GenerateSimtracePhotons
 
 **/
 
-void SFrameGenstep::GenerateCenterExtentGenstepPhotons( std::vector<quad4>& pp, const NP* gsa, float gridscale )
+void SFrameGenstep::Generate_range( quad4* pp, int64_t p_base, const quad6* gsv, const int64_t* photon_offset, int g0, int g1, int layout, float gridscale, const float3& paradir ) // static
 {
-    LOG(LEVEL) << " gsa " << gsa->sstr() ; 
-
-    assert( gsa->shape.size() == 3 && gsa->shape[1] == 6 && gsa->shape[2] == 4 );
-    assert( gsa->has_shape(-1,6,4) ); 
-
-    std::vector<quad6> gsv(gsa->shape[0]) ; 
-    memcpy( gsv.data(), gsa->bytes(), gsa->arr_bytes() );
- 
-    quad4 p ;
-    p.zero();
-    
-    unsigned seed = 0 ; 
-    SRng<float> rng(seed) ;
-
-
-    float3 paradir ; 
-    qvals(paradir, "PARADIR", "0,0,0" );  
     bool with_paradir = dot(paradir,paradir) > 0.f ; 
-    if(with_paradir)  
-    {
-        paradir = normalize(paradir);     
-        LOG(LEVEL) << " PARADIR enabled " << paradir ; 
-    }
-    else
-    {
-        LOG(LEVEL) << " PARADIR NOT-enabled " ; 
-    }
 
-    
-    for(unsigned i=0 ; i < gsv.size() ; i++)
+    for(int i=g0 ; i < g1 ; i++)
     {   
         const quad6& gs = gsv[i]; 
         qat4 qt(gs) ;  // copy 4x4 transform from last 4 quads of genstep 
@@ -665,67 +671,184 @@ void SFrameGenstep::GenerateCenterExtentGenstepPhotons( std::vector<quad4>& pp,
         bool expect = gencode == OpticksGenstep_TORCH || gencode == OpticksGenstep_FRAME ; 
 
         LOG_IF(error, !expect) 
-            << "unexpected gencod " << gencode 
+            << "unexpected gencode " << gencode 
             << " OpticksGenstep_::Name " << OpticksGenstep_::Name(gencode) ; 
 
         assert(expect);
 
-        //std::cout << " i " << i << " num_photons " << num_photons << std::endl ;
-        
         double u0, u1 ; 
         double phi, sinPhi,   cosPhi ; 
         double sinTheta, cosTheta ; 
 
-        
-        
+        quad4* pg = pp + photon_offset[i] - p_base ; 
+
         for(unsigned j=0 ; j < num_photons ; j++)
         {   
-            u0 = num_photons_ < 0 ? double(j)/double(num_photons-1) : rng() ;
+            sphilox rng(SEED, photon_offset[i] + j) ; 
+            float r0 = rng.generate_float() ; 
+            float r1 = rng.generate_float() ; 
+
+            u0 = num_photons_ < 0 ? double(j)/double(num_photons-1) : r0 ;
 
             phi = 2.*M_PIf*u0 ;     // azimuthal 0->2pi 
             ssincos(phi,sinPhi,cosPhi);  
 
-            
             // cosTheta sinTheta are only used for 3D (not 2D planar gensteps)
-            u1 = rng(); 
+            u1 = r1 ; 
             cosTheta = u1 ; 
             sinTheta = sqrtf(1.0-u1*u1);
 
-            if( with_paradir )
+            float4 ori ; 
+            float4 dir ; 
+
+            if( layout == CEGS && with_paradir )
             {
                 // what scaling is needed to span the grid ?
-                p.q0.f.x = 0.f ;  
-                p.q0.f.y = u0*float(num_photons-1)*gridscale ; 
-                p.q0.f.z = 0.f ; 
-                p.q0.f.w = 1.f ;  
-
-                p.q1.f.x = paradir.x ; 
-                p.q1.f.y = paradir.y ; 
-                p.q1.f.z = paradir.z ; 
-                p.q1.f.w = 0.f ; 
+                ori = make_float4( 0.f, u0*float(num_photons-1)*gridscale, 0.f, 1.f ); 
+                dir = make_float4( paradir.x, paradir.y, paradir.z, 0.f ); 
             }
             else
             {
-                // copy position from genstep into the photon, historically has been origin   
-                p.q0.f.x = gs.q1.f.x ;
-                p.q0.f.y = gs.q1.f.y ;
-                p.q0.f.z = gs.q1.f.z ;
-                p.q0.f.w = 1.f ;       // <-- dont copy the "float" gsid 
-
-                SetGridPlaneDirection( p.q1.f, gridaxes, cosPhi, sinPhi, cosTheta, sinTheta );  
+                // copy position from genstep, historically has been origin   
+                ori = make_float4( gs.q1.f.x, gs.q1.f.y, gs.q1.f.z, 1.f );  // <-- dont copy the "float" gsid 
+                SetGridPlaneDirection( dir, gridaxes, cosPhi, sinPhi, cosTheta, sinTheta );  
             }
 
-            // tranform photon position and direction into the desired frame
-            qt.right_multiply_inplace( p.q0.f, 1.f );  // position 
-            qt.right_multiply_inplace( p.q1.f, 0.f );  // direction
+            // transform photon position and direction into the genstep frame
+            qt.right_multiply_inplace( ori, 1.f );  // position 
+            qt.right_multiply_inplace( dir, 0.f );  // direction
 
             unsigned char ucj = (j < 255 ? j : 255 ) ;  // photon index local to the genstep
             gsid.c4.w = ucj ;     // setting C4U union element to change gsid.u 
-            p.q3.u.w = gsid.u ;   // include photon index IW with the genstep coordinate into photon (3,3)
-        
-            pp.push_back(p) ;
+
+            quad4& p = pg[j] ; 
+            p.zero(); 
+            if( layout == SIMTRACE )
+            {
+                p.q2.f = ori ;                 // initial position
+                p.q3.f = dir ;                 // initial direction 
+            }
+            else
+            {
+                p.q0.f = ori ; 
+                p.q1.f = dir ; 
+            }
+            p.q3.u.w = gsid.u ;   // include photon index IW with the genstep coordinate 
         }
     }
+}
+
+/**
+SFrameGenstep::Generate
+-------------------------
+
+Multi-threaded generation of the photons of gensteps [g0,g1) into pp[photon_offset[g]-p_base+j].
+
+The gensteps are split into contiguous ranges of similar photon counts, one per thread.
+As the randoms of each photon are keyed on its index, see Generate_range, each thread 
+starts its range without any serial positioning and the output is identical to serial 
+generation for any number of threads or chunking. 
+
+**/
+
+void SFrameGenstep::Generate( quad4* pp, int64_t p_base, const quad6* gs, const std::vector<int64_t>& photon_offset, int g0, int g1, int layout, float gridscale, const float3& paradir, int num_threads ) // static
+{
+    int64_t num = photon_offset[g1] - photon_offset[g0] ; 
+    int nt = NumThreads(num_threads, num) ; 
+
+    std::vector<int> split(nt+1) ; 
+    split[0] = g0 ; 
+    split[nt] = g1 ; 
+    for(int t=1 ; t < nt ; t++)
+    {
+        int64_t target = photon_offset[g0] + num*t/nt ; 
+        split[t] = int(std::lower_bound( photon_offset.begin() + g0, photon_offset.begin() + g1, target ) - photon_offset.begin()) ; 
+    }
+
+    auto range = [&](int t)
+    {
+        Generate_range( pp, p_base, gs, photon_offset.data(), split[t], split[t+1], layout, gridscale, paradir ); 
+    };
+
+    std::vector<std::thread> threads ; 
+    for(int t=1 ; t < nt ; t++) threads.emplace_back( range, t ); 
+    range(0); 
+    for(size_t t=0 ; t < threads.size() ; t++) threads[t].join(); 
+}
+
+
+/**
+SFrameGenstep::GenerateCenterExtentGenstepPhotons_
+----------------------------------------------------
+
+Generates directly into the NP without intermediate vector. 
+
+**/
+
+NP* SFrameGenstep::GenerateCenterExtentGenstepPhotons_( const NP* gsa, float gridscale )
+{
+    assert( gsa->has_shape(-1,6,4) ); 
+    const quad6* gs = (const quad6*)gsa->bytes() ; 
+    int num_genstep = gsa->shape[0] ; 
+
+    std::vector<int64_t> photon_offset ; 
+    int64_t num_photon = GetOffsets( photon_offset, gs, num_genstep ); 
+
+    NP* ppa = NP::Make<float>( num_photon, 4, 4 );
+    quad4* pp = (quad4*)ppa->bytes() ; 
+
+    float3 paradir = ParaDir() ; 
+    Generate( pp, 0, gs, photon_offset, 0, num_genstep, CEGS, gridscale, paradir ); 
+    return ppa ; 
+}
+
+float3 SFrameGenstep::ParaDir() // static
+{
+    float3 paradir ; 
+    qvals(paradir, "PARADIR", "0,0,0" );  
+    bool with_paradir = dot(paradir,paradir) > 0.f ; 
+    if(with_paradir)  
+    {
+        paradir = normalize(paradir);     
+        LOG(LEVEL) << " PARADIR enabled " << paradir ; 
+    }
+    else
+    {
+        LOG(LEVEL) << " PARADIR NOT-enabled " ; 
+    }
+    return paradir ; 
+}
+
+
+/**
+SFrameGenstep::GenerateCenterExtentGenstepPhotons
+---------------------------------------------------
+
+Appends the generated photons to *pp*.
+
+TODO: arrange a header such that can actually use the same code via some curand_uniform 
+macro refinition trickery
+
+**/
+
+void SFrameGenstep::GenerateCenterExtentGenstepPhotons( std::vector<quad4>& pp, const NP* gsa, float gridscale )
+{
+    LOG(LEVEL) << " gsa " << gsa->sstr() ; 
+
+    assert( gsa->shape.size() == 3 && gsa->shape[1] == 6 && gsa->shape[2] == 4 );
+    assert( gsa->has_shape(-1,6,4) ); 
+
+    const quad6* gs = (const quad6*)gsa->bytes() ; 
+    int num_genstep = gsa->shape[0] ; 
+
+    std::vector<int64_t> photon_offset ; 
+    int64_t num_photon = GetOffsets( photon_offset, gs, num_genstep ); 
+
+    size_t num_before = pp.size() ; 
+    pp.resize( num_before + num_photon ); 
+
+    float3 paradir = ParaDir() ; 
+    Generate( pp.data() + num_before, 0, gs, photon_offset, 0, num_genstep, CEGS, gridscale, paradir ); 
 
     LOG(LEVEL) << " pp.size " << pp.size() ; 
 }
@@ -737,6 +860,7 @@ SFrameGenstep::GenerateSimtracePhotons
 
 Canonical invokation is from SEvt::setFrame_HostsideSimtrace
 using the genstep created by SFrameGenstep::MakeCenterExtentGensteps
+with the simtrace vector already sized by SEvt::hostside_running_resize
 
 **/
 
@@ -747,90 +871,99 @@ void SFrameGenstep::GenerateSimtracePhotons( std::vector<quad4>& simtrace, const
         << " simtrace.size " << simtrace.size() 
         ; 
 
-    unsigned seed = 0 ; 
-    SRng<float> rng(seed) ;
+    int num_genstep = genstep.size() ; 
+    std::vector<int64_t> photon_offset ; 
+    int64_t num_photon = GetOffsets( photon_offset, genstep.data(), num_genstep ); 
+    assert( int64_t(simtrace.size()) >= num_photon ); 
 
-    bool simtrace_layout = true ; 
-    unsigned count = 0 ; 
+    float3 zero = make_float3( 0.f, 0.f, 0.f ); 
+    Generate( simtrace.data(), 0, genstep.data(), photon_offset, 0, num_genstep, SIMTRACE, 0.f, zero ); 
 
-    for(unsigned i=0 ; i < genstep.size() ; i++)
-    {   
-        const quad6& gs = genstep[i]; 
-        C4U gsid ;   // genstep integer grid coordinate IXYZ and IW photon index up to 255
-        int gencode           = gs.q0.i.x ; 
-        int gridaxes          = gs.q0.i.y ; 
-        gsid.u                = gs.q0.u.z ;     // formerly gs.q1.u.w 
-        int      num_photons_ = gs.q0.i.w ;     // -ve num_photons_ doesnt use random u0 so creates phi wheels
+    LOG(LEVEL) << " simtrace.size " << simtrace.size() ; 
+}
 
-        qat4 qt(gs) ;  // copy 4x4 transform from last 4 quads of genstep 
+/**
+SFrameGenstep::GenerateSimtracePhotons_
+-----------------------------------------
 
-        unsigned num_photons  = std::abs(num_photons_);  
-        bool expect = gencode == OpticksGenstep_TORCH || gencode == OpticksGenstep_FRAME ; 
+Simtrace photons for the gensteps generated directly into a preallocated (num_photon,4,4) NP.
 
-        LOG_IF(error, !expect) 
-            << "unexpected gencode " << gencode 
-            << " OpticksGenstep_::Name " << OpticksGenstep_::Name(gencode) ; 
+**/
 
-        assert(expect);
-        //std::cout << " i " << i << " num_photons " << num_photons << std::endl ;
-        
-        double u0, u1 ; 
-        double phi, sinPhi,   cosPhi ; 
-        double sinTheta, cosTheta ; 
+NP* SFrameGenstep::GenerateSimtracePhotons_( const NP* gsa, int num_threads )
+{
+    assert( gsa->has_shape(-1,6,4) ); 
+    const quad6* gs = (const quad6*)gsa->bytes() ; 
+    int num_genstep = gsa->shape[0] ; 
 
-        for(unsigned j=0 ; j < num_photons ; j++)
-        {   
-            u0 = num_photons_ < 0 ? double(j)/double(num_photons-1) : rng() ;
+    std::vector<int64_t> photon_offset ; 
+    int64_t num_photon = GetOffsets( photon_offset, gs, num_genstep ); 
 
-            phi = 2.*M_PIf*u0 ;     // azimuthal 0->2pi 
-            ssincos(phi,sinPhi,cosPhi);  
-            
-            // cosTheta sinTheta are only used for 3D (not 2D planar gensteps)
-            u1 = rng(); 
-            cosTheta = u1 ; 
-            sinTheta = sqrtf(1.0-u1*u1);
+    NP* simtrace = NP::Make<float>( num_photon, 4, 4 ); 
 
-            float4 ori ; // copy position from genstep, historically has been origin   
-            ori.x = gs.q1.f.x ;
-            ori.y = gs.q1.f.y ;
-            ori.z = gs.q1.f.z ;
-            ori.w = 1.f ; // <-- dont copy the "float" gsid 
+    float3 zero = make_float3( 0.f, 0.f, 0.f ); 
+    Generate( (quad4*)simtrace->bytes(), 0, gs, photon_offset, 0, num_genstep, SIMTRACE, 0.f, zero, num_threads ); 
+    return simtrace ; 
+}
 
-            float4 dir ; 
-            SetGridPlaneDirection(dir, gridaxes, cosPhi, sinPhi, cosTheta, sinTheta );  
+/**
+SFrameGenstep::GenerateSimtracePhotons_stream
+-----------------------------------------------
 
-            // transform photon position and direction into the genstep frame
-            qt.right_multiply_inplace( ori, 1.f );  // position 
-            qt.right_multiply_inplace( dir, 0.f );  // direction
+Generates the simtrace photons in chunks of whole gensteps with about *chunk* photons
+(default envvar SFrameGenstep__STREAM_CHUNK or 1M), passing each chunk to the *consumer* 
+on the calling thread in order together with the index of its first photon.
+While the consumer works on one chunk the next is generated into the other of two buffers, 
+so memory is bounded by two chunks whatever the size of the grid. 
+The concatenated chunks are identical to GenerateSimtracePhotons_ 
 
-            unsigned char ucj = (j < 255 ? j : 255 ) ;  // photon index local to the genstep
-            gsid.c4.w = ucj ;     // setting C4U union element to change gsid.u 
+Returns the total number of photons. 
 
-            unsigned identity = gsid.u ;   // include photon index IW with the genstep coordinate
+**/
 
-            quad4& p = simtrace[count] ; 
-            p.zero(); 
+int64_t SFrameGenstep::GenerateSimtracePhotons_stream( const NP* gsa, const Consumer& consumer, int64_t chunk, int num_threads )
+{
+    assert( gsa->has_shape(-1,6,4) ); 
+    const quad6* gs = (const quad6*)gsa->bytes() ; 
+    int num_genstep = gsa->shape[0] ; 
+    if( chunk <= 0 ) chunk = ssys::getenvint(EKEY_STREAM_CHUNK, 1000000) ; 
+    if( chunk <= 0 ) chunk = 1 ; 
 
-            if(simtrace_layout)  // follow layout of sevent::add_simtrace
-            {
-                p.q0.f = {0.f,0.f,0.f,0.f} ;   // intersect normal and distance
-                p.q1.f = {0.f,0.f,0.f,0.f} ;   // intersect position
-                p.q2.f = ori ;                 // initial position
-                p.q3.f = dir ;                 // initial direction 
-                p.q3.u.w = identity ;   
-            } 
-            else
-            {
-                p.q0.f = ori ; 
-                p.q1.f = dir ; 
-                p.q2.f = {0.f,0.f,0.f,0.f} ;
-                p.q3.f = {0.f,0.f,0.f,0.f} ;
-                p.q3.u.w = identity ;   
-            }
-            count += 1 ; 
-        }
+    std::vector<int64_t> photon_offset ; 
+    int64_t num_photon = GetOffsets( photon_offset, gs, num_genstep ); 
+
+    std::vector<int> split(1, 0) ;   // genstep boundaries of the chunks
+    for(int g=0 ; g < num_genstep ; g++) 
+    {
+        if( photon_offset[g+1] - photon_offset[split.back()] >= chunk ) split.push_back(g+1) ; 
     }
-    LOG(LEVEL) << " simtrace.size " << simtrace.size() ; 
+    if( split.back() != num_genstep ) split.push_back(num_genstep) ; 
+    int num_chunk = split.size() - 1 ; 
+
+    std::vector<quad4> buf[2] ; 
+    float3 zero = make_float3( 0.f, 0.f, 0.f ); 
+
+    auto generate_chunk = [&](int c)
+    {
+        int g0 = split[c] ; 
+        int g1 = split[c+1] ; 
+        std::vector<quad4>& b = buf[c % 2] ; 
+        b.resize( photon_offset[g1] - photon_offset[g0] ); 
+        Generate( b.data(), photon_offset[g0], gs, photon_offset, g0, g1, SIMTRACE, 0.f, zero, num_threads ); 
+    }; 
+
+    if( num_chunk > 0 ) generate_chunk(0) ; 
+    for(int c=0 ; c < num_chunk ; c++)
+    {
+        std::thread next ; 
+        if( c + 1 < num_chunk ) next = std::thread( generate_chunk, c + 1 ) ; 
+
+        const std::vector<quad4>& b = buf[c % 2] ; 
+        consumer( b.data(), photon_offset[split[c]], b.size() ); 
+
+        if(next.joinable()) next.join(); 
+    }
+    return num_photon ; 
 }
 
 
@@ -12,10 +12,14 @@ TODO: contrast this with SCenterExtentGenstep and replace all use of that with t
 **/
 
 #include <vector>
+#include <cstdint>
+#include <functional>
 #include "plog/Severity.h"
 
 struct float3 ; 
 struct float4 ; 
+struct quad4 ; 
+struct quad6 ; 
 struct NP ; 
 template <typename T> struct Tran ;
 
@@ -55,6 +59,45 @@ struct SYSRAP_API SFrameGenstep
         float gridscale, 
         const float3& ce_offset ) ; 
 
+    static constexpr const char* EKEY_THREADS = "SFrameGenstep__THREADS" ; 
+    static constexpr const char* EKEY_STREAM_CHUNK = "SFrameGenstep__STREAM_CHUNK" ; 
+    static constexpr const int64_t MIN_PARALLEL = 10000 ; 
+    static constexpr const unsigned long long SEED = 0ull ; 
+    enum { CEGS, SIMTRACE } ; 
+
+    typedef std::function<void(const quad4* pp, int64_t offset, int64_t num)> Consumer ; 
+
+    static int NumThreads(int num_threads, int64_t num_photon); 
+    static int64_t GetOffsets( 
+        std::vector<int64_t>& photon_offset, 
+        const quad6* gs, 
+        int num_genstep ); 
+
+    static void Generate_range( 
+        quad4* pp, 
+        int64_t p_base, 
+        const quad6* gs, 
+        const int64_t* photon_offset, 
+        int g0, 
+        int g1, 
+        int layout, 
+        float gridscale, 
+        const float3& paradir ); 
+
+    static void Generate( 
+        quad4* pp, 
+        int64_t p_base, 
+        const quad6* gs, 
+        const std::vector<int64_t>& photon_offset, 
+        int g0, 
+        int g1, 
+        int layout, 
+        float gridscale, 
+        const float3& paradir, 
+        int num_threads=0 ); 
+
+    static float3 ParaDir(); 
+
     static void GenerateCenterExtentGenstepPhotons( 
         std::vector<quad4>& pp, 
         const NP* gsa, 
@@ -68,6 +111,16 @@ struct SYSRAP_API SFrameGenstep
         std::vector<quad4>& simtrace, 
         const std::vector<quad6>& genstep ); 
 
+    static NP* GenerateSimtracePhotons_( 
+        const NP* gsa, 
+        int num_threads=0 ); 
+
+    static int64_t GenerateSimtracePhotons_stream( 
+        const NP* gsa, 
+        const Consumer& consumer, 
+        int64_t chunk=0, 
+        int num_threads=0 ); 
+
     static void SetGridPlaneDirection( 
         float4& dir, 
         int gridaxes, 
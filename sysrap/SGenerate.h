@@ -8,14 +8,42 @@ the MOCK_CURAND macro the method was moved to this header only SGenerate.h
 to allow switching on MOCK_CURAND in the "user" code 
 rather than the widely used sysrap library. 
 
+
+Parallel Generation
+---------------------
+
+With the below EKEY_STREAM set each photon draws from its own random stream 
+keyed on (rng_seed, photon_id) : sphilox counter based streams via srng::setStream 
+or with MOCK_CURAND_XORWOW the curand_init(rng_seed, photon_id, 0) XORWOW streams.
+As no random state is shared between photons the loop is split into contiguous 
+ranges over EKEY_THREADS threads (0: all cores) with the output identical for any 
+number of threads::
+
+    export SGenerate__GeneratePhotons_RNG_STREAM=1
+    export SGenerate__GeneratePhotons_THREADS=0
+
+Without EKEY_STREAM a single srng is shared by all photons in sequence, 
+so the output depends on the order and generation stays single threaded. 
+
+The genstep of each photon comes from the SEvent::MakeSeed seed array 
+or with seedless SEventConfig::GenstepLookup "search" or "table" by search 
+of the genstep offsets as done on device, see sgenstep_lookup.h 
+
 **/
 
 
 struct NP ; 
+struct sphoton ; 
+struct quad6 ; 
+
 struct SGenerate
 {
     static constexpr const char* EKEY = "SGenerate__GeneratePhotons_RNG_PRECOOKED" ; 
+    static constexpr const char* EKEY_STREAM = "SGenerate__GeneratePhotons_RNG_STREAM" ; 
+    static constexpr const char* EKEY_THREADS = "SGenerate__GeneratePhotons_THREADS" ; 
+
     static NP* GeneratePhotons(const NP* gs);  
+    static void GeneratePhotons_range(sphoton* pp, const quad6* gg, const int* seed, const int* offset, int num_genstep, const int* table, int i0, int i1, unsigned rng_seed, bool rng_precooked, bool rng_stream ); 
 }; 
 
 
@@ -28,8 +56,16 @@ struct SGenerate
 #include "SGenstep.hh"
 #include "SEvt.hh"
 #include "SEvent.hh"
+#include "SEventConfig.hh"
+#include "sevent.h"
+#include "sgenstep_lookup.h"
 #include "OpticksGenstep.h"
 #include "NP.hh"
+#include "ssys.h"
+
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 
 /**
@@ -51,48 +87,99 @@ A: YES, see SGenerate__test.sh : MOCK_CURAND is to allow
 inline NP* SGenerate::GeneratePhotons(const NP* gs_ )
 {
     bool rng_precooked = ssys::getenvbool(EKEY); 
+    bool rng_stream = ssys::getenvbool(EKEY_STREAM); 
+    int num_threads = ssys::getenvint(EKEY_THREADS, 0) ; 
+    if( num_threads <= 0 ) num_threads = std::max( 1u, std::thread::hardware_concurrency() ) ; 
+    if( !rng_stream || rng_precooked ) num_threads = 1 ;   // shared sequence or shared precooked seq : must be serial
+
     std::cerr 
         << "SGenerate::GeneratePhotons"
         << " " << EKEY 
         << " : "
         << ( rng_precooked ? "YES" : "NO " ) 
+        << " " << EKEY_STREAM 
+        << " : "
+        << ( rng_stream ? "YES" : "NO " ) 
+        << " num_threads " << num_threads 
         << std::endl 
         ; 
 
     const quad6* gg = (quad6*)gs_->bytes() ; 
-    NP* se = SEvent::MakeSeed(gs_) ;
-    const int*   seed = (int*)se->bytes() ;   
+    int num_genstep = gs_->shape[0] ; 
+    int lookup = SEventConfig::GenstepLookup() ; 
+
+    std::vector<int> offset( num_genstep + 1 ) ;
+    int tot_photon = sgenstep_lookup::FillOffset<int>( offset.data(), (const int*)gg, num_genstep, sevent::genstep_itemsize, sevent::genstep_numphoton_offset ); 
+
+    std::vector<int> table ; 
+    if( lookup == sgenstep_lookup::TABLE )
+    {
+        table.resize( sgenstep_lookup::NumTable(tot_photon) + 1 ); 
+        sgenstep_lookup::FillTable( table.data(), offset.data(), num_genstep, tot_photon ); 
+    }
 
-    int tot_photon = se->shape[0] ; 
+    NP* se = lookup == sgenstep_lookup::SEED ? SEvent::MakeSeed(gs_) : nullptr ;
+    const int* seed = se ? (int*)se->bytes() : nullptr ;   
+    const int* tab = table.empty() ? nullptr : table.data() ; 
+    assert( se == nullptr || se->shape[0] == tot_photon ); 
     NP* ph = NP::Make<float>( tot_photon, 4, 4); 
     sphoton* pp = (sphoton*)ph->bytes() ; 
 
     unsigned rng_seed = 1u ; 
+
+    int per_thread = ( tot_photon + num_threads - 1 )/num_threads ; 
+    std::vector<std::thread> threads ; 
+    for(int i0=per_thread ; i0 < tot_photon ; i0 += per_thread )
+    {
+        threads.push_back( std::thread( GeneratePhotons_range, pp, gg, seed, offset.data(), num_genstep, tab, i0, std::min( i0 + per_thread, tot_photon ), rng_seed, rng_precooked, rng_stream ) ); 
+    }
+    GeneratePhotons_range( pp, gg, seed, offset.data(), num_genstep, tab, 0, std::min( per_thread, tot_photon ), rng_seed, rng_precooked, rng_stream ); 
+    for(size_t i=0 ; i < threads.size() ; i++) threads[i].join(); 
+
+    delete se ; 
+    return ph ;
+}
+
+/**
+SGenerate::GeneratePhotons_range
+----------------------------------
+
+Generates photons [i0, i1) with an rng owned by the calling thread.
+
+**/
+
+inline void SGenerate::GeneratePhotons_range(sphoton* pp, const quad6* gg, const int* seed, const int* offset, int num_genstep, const int* table, int i0, int i1, unsigned rng_seed, bool rng_precooked, bool rng_stream )
+{
 #if defined(MOCK_CURAND)
     curandStateXORWOW rng(rng_seed); 
 #else
     srng rng(rng_seed);  
 #endif
 
-    for(int i=0 ; i < tot_photon ; i++ )
+    for(int i=i0 ; i < i1 ; i++ )
     {   
         unsigned photon_id = i ; 
-        unsigned genstep_id = seed[photon_id] ; 
+        unsigned genstep_id = seed ? seed[photon_id] : sgenstep_lookup::GenstepId( offset, num_genstep, table, photon_id ) ; 
         sphoton& p = pp[photon_id] ; 
         const quad6& gs = gg[genstep_id] ;   
         int gencode = SGenstep::GetGencode(gs);  
 
+#if defined(MOCK_CURAND_XORWOW)
+        assert( !rng_precooked ); 
+        if(rng_stream) curand_init( rng_seed, photon_id, 0ull, &rng ); 
+#else
         if(rng_precooked) rng.setSequenceIndex(i);  
+        if(rng_stream) rng.setStream(rng_seed, photon_id); 
+#endif
         switch(gencode)
         {    
             case OpticksGenstep_CARRIER:         scarrier::generate(     p, rng, gs, photon_id, genstep_id)  ; break ; 
             case OpticksGenstep_TORCH:           storch::generate(       p, rng, gs, photon_id, genstep_id ) ; break ; 
             case OpticksGenstep_INPUT_PHOTON:    assert(0)  ; break ; 
         }    
+#if !defined(MOCK_CURAND_XORWOW)
         if(rng_precooked) rng.setSequenceIndex(-1);  
+#endif
     }
-    delete se ; 
-    return ph ;
 }
 
-
@@ -553,7 +553,7 @@ NP* SSim::AddOptical(
             unsigned idx = i*4 + j ; 
 
             const char* ibytes = nullptr ; 
-            unsigned num_bytes = 0 ; 
+            size_t num_bytes = 0 ; 
 
             if(found)
             { 
@@ -682,7 +682,7 @@ NP* SSim::AddBoundary( const NP* dsrc, const std::vector<std::string>& specs ) /
             bool found = SBnd::FindName(i, j, qname, names ); 
             
             const char* ibytes = nullptr ; 
-            unsigned num_bytes = 0 ; 
+            size_t num_bytes = 0 ; 
 
             if(found)
             { 
@@ -3,9 +3,13 @@
 #include "scuda.h"
 #include "squad.h"
 #include "sphoton.h"
+#include "sphoton_column.h"
 
 #include <thrust/device_ptr.h>
 #include <thrust/copy.h>
+#include <thrust/for_each.h>
+#include <thrust/device_vector.h>
+#include <thrust/iterator/counting_iterator.h>
 
 
 template<typename T>
@@ -152,6 +156,43 @@ void SU::copy_if_device_to_device_presized_sphoton( sphoton* d_select, const sph
 }
 
 
+/**
+SU::copy_if_device_to_device_presized_sphoton_column
+------------------------------------------------------
+
+Columnar equivalent of SU::copy_if_device_to_device_presized_sphoton
+with *d_column* holding device column bases presized for d_column.num selected photons.
+
+1. thrust::copy_if with the photons as stencil collects the indices of the selected photons
+2. thrust::for_each writes the selected fields of each selected photon into the columns
+
+The temporary index buffer is 4 bytes per hit, compared with the 64 of the sphoton hit buffer.
+
+**/
+
+struct sphoton_column_writer
+{
+    sphoton_column column ; 
+    const sphoton* d ; 
+    const unsigned* idx ; 
+
+    sphoton_column_writer( const sphoton_column& column_, const sphoton* d_, const unsigned* idx_ ) : column(column_), d(d_), idx(idx_) {} 
+    __device__ void operator()(unsigned i) const { column.write( i, d[idx[i]] ) ; }
+}; 
+
+void SU::copy_if_device_to_device_presized_sphoton_column( const sphoton_column& d_column, const sphoton* d, unsigned num_d, const sphoton_selector& selector )
+{
+    thrust::device_ptr<const sphoton> td(d);
+    thrust::device_vector<unsigned> idx(d_column.num) ; 
+    thrust::counting_iterator<unsigned> first(0u) ; 
+
+    thrust::copy_if(first, first+num_d, td, idx.begin(), selector ); 
+
+    sphoton_column_writer writer( d_column, d, thrust::raw_pointer_cast(idx.data()) ); 
+    thrust::for_each(first, first+d_column.num, writer ); 
+}
+
+
 
 template<typename T>
 void SU::copy_device_to_host_presized( T* h, const T* d, unsigned num  )
@@ -4,6 +4,7 @@ template <typename T> struct qselector ;
 
 struct sphoton ; 
 struct sphoton_selector ; 
+struct sphoton_column ; 
 
 
 #include "SYSRAP_API_EXPORT.hh"
@@ -40,6 +41,8 @@ struct SYSRAP_API SU
 
     static void copy_if_device_to_device_presized_sphoton( sphoton* d_select, const sphoton* d, unsigned num_d, const sphoton_selector& selector ); 
 
+    static void copy_if_device_to_device_presized_sphoton_column( const sphoton_column& d_column, const sphoton* d, unsigned num_d, const sphoton_selector& selector ); 
+
 
 
     // try "untyped" byte moving "_sizeof" funcs  : handy for quick testing 
@@ -32,6 +32,8 @@ struct SYSRAP_API s_bb
     static constexpr const bool LEAK = false ; 
     typedef s_pool<s_bb,_s_bb> POOL ;
     static POOL* pool ;
+    static void* operator new(size_t sz){ return POOL::Allocate(pool, sz) ; }  // into pool arena, see s_pool.h 
+    static void  operator delete(void* p){ POOL::Deallocate(p) ; } 
     static void SetPOOL( POOL* pool_ ); 
     static int level() ; 
     //static bool IsZero( const double* v ); 
@@ -0,0 +1,461 @@
+#pragma once
+/**
+s_curand_xorwow.h : host bit-exact curand XORWOW with skipahead
+==================================================================
+
+CPU reimplementation of the curand XORWOW generator that reproduces
+*curand_init(seed, subsequence, offset, &state)* exactly, so the
+curandState for any photon index can be created on the host on demand
+rather than loaded from the large QCurandState_num_seed_offset.bin files
+that SCurandState/QRng otherwise need.
+
+* struct layout matches curandStateXORWOW (48 bytes), so arrays of
+  s_curand_xorwow can be uploaded and used directly by device code
+
+* generation (*generate*, *generate_float*, *generate_double*) follows
+  curand_kernel.h : curand, curand_uniform and curand_uniform_double
+
+* the XORWOW transition of the 160 bit *v* state is linear over GF(2)
+  so skipping ahead by n steps is multiplication by the 160x160 bit
+  matrix M^n. The powers M^(2^k) for offsets and M^(2^(67+k)) for
+  subsequences are computed once (by repeated squaring) and stored as
+  4-bit lookup tables, making a jump cost 40 table lookups.
+  The d counter is a simple Weyl sequence and is advanced arithmetically.
+  As matrix powers are exact the results do not depend on how curand
+  itself factors the jumps into its precalc tables.
+
+* consecutive subsequences are one M^(2^67) jump apart, which *Fill*
+  uses to generate contiguous ranges of states with a single lookup jump
+  per state, optionally split across threads
+
+* s_curand_xorwow_chunked provides on-demand, thread-safe, chunk-at-a-time
+  creation of states for random access by photon index
+
+Note that nvcc by default contracts the multiply-add of curand_uniform
+into an FMA. That is reproduced here with std::fma, unless compiling
+with S_CURAND_XORWOW_NO_FMA for comparison with device code built
+with "--fmad=false".
+
+Test with::
+
+    ~/opticks/sysrap/tests/s_curand_xorwow_test.sh
+
+**/
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+
+struct s_xorwow_jump
+{
+    static constexpr const int N = 5 ;        // 32 bit words of v state
+    static constexpr const int NIB = 8*N ;    // 4 bit nibbles of v state
+
+    uint32_t t[NIB][16][N] ;
+
+    void set_columns(const uint32_t* col);
+    void apply(uint32_t* v) const ;
+};
+
+/**
+s_xorwow_jump::set_columns
+----------------------------
+
+*col* holds 160 columns of N words, column i being the image of state
+bit i (word i/32, bit i%32). Each table entry is the XOR of the
+columns of the set bits of a nibble.
+
+**/
+
+inline void s_xorwow_jump::set_columns(const uint32_t* col)
+{
+    for(int j=0 ; j < NIB ; j++) for(int k=0 ; k < 16 ; k++)
+    {
+        uint32_t* r = t[j][k] ;
+        for(int w=0 ; w < N ; w++) r[w] = 0u ;
+        for(int b=0 ; b < 4 ; b++)
+        {
+            if((k & (1 << b)) == 0) continue ;
+            const uint32_t* c = col + (4*j+b)*N ;
+            for(int w=0 ; w < N ; w++) r[w] ^= c[w] ;
+        }
+    }
+}
+
+inline void s_xorwow_jump::apply(uint32_t* v) const
+{
+    uint32_t r[N] = {0u, 0u, 0u, 0u, 0u} ;
+    for(int j=0 ; j < NIB ; j++)
+    {
+        const uint32_t* e = t[j][ (v[j/8] >> (4*(j%8))) & 0xfu ] ;
+        for(int w=0 ; w < N ; w++) r[w] ^= e[w] ;
+    }
+    for(int w=0 ; w < N ; w++) v[w] = r[w] ;
+}
+
+
+/**
+s_xorwow_skip
+---------------
+
+Lazily created singleton holding the jump tables, about 1.6MB.
+
+**/
+
+struct s_xorwow_skip
+{
+    static constexpr const int N = s_xorwow_jump::N ;
+    static constexpr const int NUM = 64 ;
+    static constexpr const int SEQ_LOG2 = 67 ;     // subsequences are 2^67 steps apart
+
+    std::vector<s_xorwow_jump> off ;   // M^(2^k)
+    std::vector<s_xorwow_jump> seq ;   // M^(2^(67+k))
+
+    static const s_xorwow_skip& Get();
+    static void Step(uint32_t* v);
+
+    s_xorwow_skip();
+};
+
+inline const s_xorwow_skip& s_xorwow_skip::Get()  // static
+{
+    static s_xorwow_skip skip ;   // C++11 guarantees thread safe initialization
+    return skip ;
+}
+
+/**
+s_xorwow_skip::Step
+---------------------
+
+The *v* part of the curand XORWOW transition, without the d counter.
+
+**/
+
+inline void s_xorwow_skip::Step(uint32_t* v) // static
+{
+    uint32_t t = v[0] ^ ( v[0] >> 2 ) ;
+    v[0] = v[1] ;
+    v[1] = v[2] ;
+    v[2] = v[3] ;
+    v[3] = v[4] ;
+    v[4] = ( v[4] ^ ( v[4] << 4 )) ^ ( t ^ ( t << 1 )) ;
+}
+
+inline s_xorwow_skip::s_xorwow_skip()
+    :
+    off(NUM),
+    seq(NUM)
+{
+    std::vector<uint32_t> col(32*N*N, 0u) ;
+    for(int i=0 ; i < 32*N ; i++)
+    {
+        uint32_t* c = col.data() + i*N ;
+        c[i/32] = 1u << (i%32) ;
+        Step(c) ;
+    }
+
+    s_xorwow_jump jump ;
+    for(int p=0 ; p < SEQ_LOG2 + NUM ; p++)   // col holds M^(2^p)
+    {
+        jump.set_columns( col.data() );
+        if( p < NUM ) off[p] = jump ;
+        if( p >= SEQ_LOG2 ) seq[p - SEQ_LOG2] = jump ;
+        for(int i=0 ; i < 32*N ; i++) jump.apply( col.data() + i*N ) ;   // square
+    }
+}
+
+
+struct s_curand_xorwow
+{
+    unsigned int d ;
+    unsigned int v[5] ;
+    int boxmuller_flag ;
+    int boxmuller_flag_double ;
+    float boxmuller_extra ;
+    double boxmuller_extra_double ;
+
+    static constexpr const unsigned int D_STEP = 362437u ;
+    static constexpr const float  TWOPOW32_INV = 2.3283064e-10f ;
+    static constexpr const double TWOPOW53_INV_DOUBLE = 1.1102230246251565e-16 ;
+
+    s_curand_xorwow(unsigned long long seed=0ull, unsigned long long subsequence=0ull, unsigned long long offset=0ull);
+
+    void init(unsigned long long seed, unsigned long long subsequence, unsigned long long offset);
+    void skipahead(unsigned long long n);
+    void skipahead_sequence(unsigned long long n);
+
+    unsigned int generate();
+    float  generate_float();
+    double generate_double();
+
+    static void Fill( s_curand_xorwow* states, unsigned long long num, unsigned long long seed, unsigned long long subsequence0, unsigned long long offset, int num_threads=1 );
+
+    std::string desc() const ;
+};
+
+
+inline s_curand_xorwow::s_curand_xorwow(unsigned long long seed, unsigned long long subsequence, unsigned long long offset)
+{
+    init(seed, subsequence, offset);
+}
+
+/**
+s_curand_xorwow::init
+-----------------------
+
+Equivalent of curand_init : seed scrambling as done by curand followed by
+the subsequence and offset jumps.
+
+**/
+
+inline void s_curand_xorwow::init(unsigned long long seed, unsigned long long subsequence, unsigned long long offset)
+{
+    unsigned int s0 = ((unsigned int)seed) ^ 0xaad26b49u ;
+    unsigned int s1 = (unsigned int)(seed >> 32) ^ 0xf7dcefddu ;
+    unsigned int t0 = 1099087573u * s0 ;
+    unsigned int t1 = 2591861531u * s1 ;
+    d    = 6615241u + t1 + t0 ;
+    v[0] = 123456789u + t0 ;
+    v[1] = 362436069u ^ t0 ;
+    v[2] = 521288629u + t1 ;
+    v[3] = 88675123u ^ t1 ;
+    v[4] = 5783321u + t0 ;
+
+    skipahead_sequence(subsequence);
+    skipahead(offset);
+
+    boxmuller_flag = 0 ;
+    boxmuller_flag_double = 0 ;
+    boxmuller_extra = 0.f ;
+    boxmuller_extra_double = 0. ;
+}
+
+inline void s_curand_xorwow::skipahead(unsigned long long n)
+{
+    const s_xorwow_skip& skip = s_xorwow_skip::Get() ;
+    for(int k=0 ; k < s_xorwow_skip::NUM ; k++) if( n & (1ull << k)) skip.off[k].apply(v) ;
+    d += (unsigned int)n * D_STEP ;
+}
+
+/**
+s_curand_xorwow::skipahead_sequence
+-------------------------------------
+
+Jumps of 2^67 steps leave d unchanged as D_STEP*2^67 is a multiple of 2^32.
+
+**/
+
+inline void s_curand_xorwow::skipahead_sequence(unsigned long long n)
+{
+    const s_xorwow_skip& skip = s_xorwow_skip::Get() ;
+    for(int k=0 ; k < s_xorwow_skip::NUM ; k++) if( n & (1ull << k)) skip.seq[k].apply(v) ;
+}
+
+inline unsigned int s_curand_xorwow::generate()
+{
+    s_xorwow_skip::Step(v) ;
+    d += D_STEP ;
+    return v[4] + d ;
+}
+
+inline float s_curand_xorwow::generate_float()
+{
+    float x = float(generate()) ;
+#ifdef S_CURAND_XORWOW_NO_FMA
+    return x * TWOPOW32_INV + (TWOPOW32_INV/2.0f) ;
+#else
+    return std::fma( x, TWOPOW32_INV, TWOPOW32_INV/2.0f ) ;
+#endif
+}
+
+inline double s_curand_xorwow::generate_double()
+{
+    unsigned int x = generate() ;
+    unsigned int y = generate() ;
+    unsigned long long z = (unsigned long long)x ^ ((unsigned long long)y << (53 - 32)) ;
+#ifdef S_CURAND_XORWOW_NO_FMA
+    return double(z) * TWOPOW53_INV_DOUBLE + (TWOPOW53_INV_DOUBLE/2.0) ;
+#else
+    return std::fma( double(z), TWOPOW53_INV_DOUBLE, TWOPOW53_INV_DOUBLE/2.0 ) ;
+#endif
+}
+
+/**
+s_curand_xorwow::Fill
+-----------------------
+
+Sets states[i] to the equivalent of curand_init(seed, subsequence0 + i, offset)
+for i in [0, num). Each thread takes a contiguous range, does one full
+init for its first state and then a single M^(2^67) jump per state.
+
+**/
+
+inline void s_curand_xorwow::Fill( s_curand_xorwow* states, unsigned long long num, unsigned long long seed, unsigned long long subsequence0, unsigned long long offset, int num_threads ) // static
+{
+    if( num_threads <= 0 ) num_threads = std::max( 1u, std::thread::hardware_concurrency() ) ;
+    unsigned long long per_thread = ( num + num_threads - 1 )/num_threads ;
+    if( per_thread < 1024 ) per_thread = 1024 ;
+
+    const s_xorwow_jump& next = s_xorwow_skip::Get().seq[0] ;
+
+    auto fill_range = [&](unsigned long long i0, unsigned long long i1)
+    {
+        s_curand_xorwow cur(seed, subsequence0 + i0, offset) ;
+        for(unsigned long long i=i0 ; i < i1 ; i++)
+        {
+            states[i] = cur ;
+            next.apply(cur.v) ;
+        }
+    };
+
+    std::vector<std::thread> threads ;
+    for(unsigned long long i0=per_thread ; i0 < num ; i0 += per_thread )
+    {
+        threads.push_back( std::thread( fill_range, i0, std::min( i0 + per_thread, num ) ) );
+    }
+    fill_range( 0ull, std::min( per_thread, num ) ) ;
+    for(size_t i=0 ; i < threads.size() ; i++) threads[i].join();
+}
+
+inline std::string s_curand_xorwow::desc() const
+{
+    std::stringstream ss ;
+    ss << "s_curand_xorwow d " << std::setw(10) << d << " v" ;
+    for(int w=0 ; w < 5 ; w++) ss << " " << std::setw(10) << v[w] ;
+    std::string str = ss.str();
+    return str ;
+}
+
+
+/**
+s_curand_xorwow_chunked
+-------------------------
+
+On-demand states for subsequences [0, num) created one chunk at a time
+when first accessed, with the creation of each chunk guarded by a mutex.
+This avoids generating (or loading) states for photon indices that are never used.
+
+get_chunk and release_chunk allow whole chunks to be created, consumed
+(eg uploaded by QRng) and freed one at a time, bounding host memory to 
+a single chunk. Chunks are filled with *num_threads* threads. 
+
+**/
+
+struct s_curand_xorwow_chunked
+{
+    unsigned long long seed ;
+    unsigned long long offset ;
+    unsigned long long num ;
+    unsigned long long chunk_size ;
+    int num_threads ;
+
+    std::vector<std::atomic<s_curand_xorwow*>> chunk ;
+    std::mutex mtx ;
+
+    s_curand_xorwow_chunked( unsigned long long num, unsigned long long seed=0ull, unsigned long long offset=0ull, unsigned long long chunk_size=1000000ull, int num_threads=1 );
+    ~s_curand_xorwow_chunked();
+
+    const s_curand_xorwow& get(unsigned long long idx);
+    const s_curand_xorwow* get_chunk(int c);
+    unsigned long long chunk_num(int c) const ;
+    void release_chunk(int c);
+    int num_chunk() const ;
+    int num_chunk_created() const ;
+    std::string desc() const ;
+};
+
+inline s_curand_xorwow_chunked::s_curand_xorwow_chunked( unsigned long long num_, unsigned long long seed_, unsigned long long offset_, unsigned long long chunk_size_, int num_threads_ )
+    :
+    seed(seed_),
+    offset(offset_),
+    num(num_),
+    chunk_size(chunk_size_ > 0 ? chunk_size_ : 1ull),
+    num_threads(num_threads_),
+    chunk( (num_ + chunk_size - 1)/chunk_size )
+{
+    for(size_t i=0 ; i < chunk.size() ; i++) chunk[i].store(nullptr) ;
+}
+
+inline s_curand_xorwow_chunked::~s_curand_xorwow_chunked()
+{
+    for(size_t i=0 ; i < chunk.size() ; i++) delete [] chunk[i].load() ;
+}
+
+inline const s_curand_xorwow& s_curand_xorwow_chunked::get(unsigned long long idx)
+{
+    int c = int(idx/chunk_size) ;
+    const s_curand_xorwow* states = get_chunk(c) ;
+    return states[idx - c*chunk_size] ;
+}
+
+inline const s_curand_xorwow* s_curand_xorwow_chunked::get_chunk(int c)
+{
+    s_curand_xorwow* states = chunk[c].load(std::memory_order_acquire) ;
+    if( states == nullptr )
+    {
+        std::lock_guard<std::mutex> lock(mtx) ;
+        states = chunk[c].load(std::memory_order_relaxed) ;
+        if( states == nullptr )
+        {
+            unsigned long long n = chunk_num(c) ;
+            states = new s_curand_xorwow[n] ;
+            s_curand_xorwow::Fill( states, n, seed, c*chunk_size, offset, num_threads );
+            chunk[c].store(states, std::memory_order_release) ;
+        }
+    }
+    return states ;
+}
+
+inline unsigned long long s_curand_xorwow_chunked::chunk_num(int c) const
+{
+    unsigned long long i0 = c*chunk_size ;
+    return std::min( chunk_size, num - i0 ) ;
+}
+
+/**
+s_curand_xorwow_chunked::release_chunk
+-----------------------------------------
+
+Frees the states of chunk *c*, the caller must ensure that no references
+from *get* or *get_chunk* into the chunk are still in use. A subsequent
+access recreates the chunk.
+
+**/
+
+inline void s_curand_xorwow_chunked::release_chunk(int c)
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    delete [] chunk[c].exchange(nullptr) ;
+}
+
+inline int s_curand_xorwow_chunked::num_chunk() const { return chunk.size() ; }
+inline int s_curand_xorwow_chunked::num_chunk_created() const
+{
+    int n = 0 ;
+    for(size_t i=0 ; i < chunk.size() ; i++) if( chunk[i].load() != nullptr ) n += 1 ;
+    return n ;
+}
+
+inline std::string s_curand_xorwow_chunked::desc() const
+{
+    std::stringstream ss ;
+    ss << "s_curand_xorwow_chunked"
+       << " num " << num
+       << " seed " << seed
+       << " offset " << offset
+       << " chunk_size " << chunk_size
+       << " num_threads " << num_threads
+       << " num_chunk " << num_chunk()
+       << " num_chunk_created " << num_chunk_created()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -16,16 +16,39 @@ other than switching headers.
 Note that instanciation API does not match the real one, 
 but that does that matter as instanciation doesnt need testing. 
 
+Defining MOCK_CURAND_XORWOW switches the state type from srng to 
+the bit-exact host XORWOW of s_curand_xorwow.h, with the real 
+curand_init/curand/skipahead/skipahead_sequence API, so CPU running 
+can use the same random streams as the GPU photons.  
+
 **/
 
+#if defined(MOCK_CURAND_XORWOW)
+
+#include "s_curand_xorwow.h"
+typedef s_curand_xorwow curandStateXORWOW ; 
+typedef s_curand_xorwow curandState_t ; 
+
+inline void curand_init(unsigned long long seed, unsigned long long subsequence, unsigned long long offset, curandState_t* state )
+{
+    state->init(seed, subsequence, offset) ; 
+}
+inline unsigned int curand(curandState_t* state ){ return state->generate() ; }
+inline void skipahead(unsigned long long n, curandState_t* state ){ state->skipahead(n) ; }
+inline void skipahead_sequence(unsigned long long n, curandState_t* state ){ state->skipahead_sequence(n) ; }
+
+#else
+
 #include "srng.h"
 
 //typedef curandStateXORWOW curandState_t ; 
 typedef srng curandStateXORWOW ; 
 typedef srng curandState_t ; 
 
-float curand_uniform(curandState_t* state ){         return state->generate_float() ; }
-double curand_uniform_double(curandState_t* state ){ return state->generate_double() ; }
+#endif
+
+inline float curand_uniform(curandState_t* state ){         return state->generate_float() ; }
+inline double curand_uniform_double(curandState_t* state ){ return state->generate_double() ; }
 
 
 
@@ -4,7 +4,12 @@ s_mock_texture : exploring CUDA texture lookup API on CPU
 =============================================================
 
 The cudaTextureObject_t just probably typedef to unsigned long 
-so its an "int" pointer. 
+so its an "int" pointer. The mock handles are the addresses 
+of the MockTexture. 
+
+MockTexture follows the CUDA filter (point/linear), coordinate 
+(normalized or not) and address (wrap/clamp) modes, which QTex 
+passes to MockTextureManager::Add to match the GPU textures. 
 
 The .cc that includes this needs to plant the INSTANCE, eg::
 
@@ -16,6 +21,9 @@ The .cc that includes this needs to plant the INSTANCE, eg::
 #include <vector>
 #include <iomanip>
 #include <cassert>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 
 #include <vector_types.h>
 #include "NP.hh"
@@ -28,25 +36,128 @@ struct MockTexture
     int height ; 
     float4 dom ; 
 
-    MockTexture(const NP* a); 
+    char  filterMode ;        // 'P':cudaFilterModePoint 'L':cudaFilterModeLinear 
+    bool  normalizedCoords ; 
+    char  addressMode ;       // 'W':cudaAddressModeWrap 'C':cudaAddressModeClamp 
+    bool  quantize ;          // 8 bit fraction interpolation weights, as texture hardware 
+
+    int   nch ;               // floats per texel : 4 or 1 
+    float xscale ;            // width or 1.f for unnormalized coordinates
+    float yscale ;            // height or 1.f 
+    const float* vv ;         // texel values of *a* for point lookups 
+    int   pitch ;             // texels per padded row : width + 1 
+    std::vector<float> pad ;  // (height+1, width+1, nch) texels with border row and column 
+
+    MockTexture(const NP* a, char filterMode='P', bool normalizedCoords=true, char addressMode='W' ); 
+    ~MockTexture(); 
+    MockTexture(const MockTexture&) = delete ; 
+    MockTexture& operator=(const MockTexture&) = delete ; 
+    void init(); 
+    void update(); 
+
+    int address(int i, int n) const ; 
 
     std::string desc() const ; 
     template<typename T> T lookup(float x, float y ) const ; 
+    template<typename T> T lookup_linear(float x, float y ) const ; 
+    template<typename T> T lookup_nearest(float x, float y ) const ; 
+    template<typename T> T lookup_nearest_outside(float xt, float yt ) const ; 
     template<typename T> std::string dump() const ; 
 }; 
 
-inline MockTexture::MockTexture(const NP* a_ )
+inline MockTexture::MockTexture(const NP* a_, char filterMode_, bool normalizedCoords_, char addressMode_ )
     :
     a(NP::MakeNarrowIfWide(a_)),  // NB even if narrow already, still copies
     width(0),
-    height(0)
+    height(0),
+    filterMode(filterMode_),
+    normalizedCoords(normalizedCoords_),
+    addressMode(addressMode_),
+    quantize(true),
+    nch(0),
+    xscale(1.f),
+    yscale(1.f),
+    vv(nullptr),
+    pitch(0)
+{
+    init(); 
+}
+
+inline MockTexture::~MockTexture()
+{
+    delete a ;   // narrowed copy owned by the texture 
+}
+
+inline void MockTexture::init()
 {
-    a->size_2D<4>(width, height); 
+    const std::vector<int>& sh = a->shape ; 
+    int nd = sh.size() ; 
+    int last = nd > 0 ? sh[nd-1] : 0 ; 
+
+    if( last == 4 )
+    {
+        a->size_2D<4>(width, height); 
+        nch = 4 ; 
+    }
+    else if( last == 1 && nd > 2 )
+    {
+        a->size_2D<1>(width, height); 
+        nch = 1 ; 
+    }
+    else
+    {
+        width = last ; 
+        height = 1 ; 
+        for(int i=0 ; i < nd-1 ; i++) height *= sh[i] ; 
+        nch = 1 ; 
+    }
+    pitch = width + 1 ; 
+    xscale = normalizedCoords ? float(width)  : 1.f ; 
+    yscale = normalizedCoords ? float(height) : 1.f ; 
  
     dom.x = a->get_meta<float>("domain_low",  0.f );
     dom.y = a->get_meta<float>("domain_high",  0.f );
     dom.z = a->get_meta<float>("domain_step",  0.f );
     dom.w = a->get_meta<float>("domain_range", 0.f );
+
+    update(); 
+}
+
+/**
+MockTexture::update
+---------------------
+
+Copies the texels into *pad* with an extra column and row holding 
+the wrap or clamp neighbours of the last column and row, so the 2x2 
+footprint of a linear lookup never needs index addressing beyond 
+that of its first texel. Must be called again after changing the 
+values of *a*.  
+
+**/
+
+inline void MockTexture::update()
+{
+    vv = a->cvalues<float>() ; 
+    pad.resize( size_t(pitch)*(height+1)*nch ); 
+    for(int iy=0 ; iy <= height ; iy++)
+    for(int ix=0 ; ix <= width ; ix++)
+    {
+        int sx = ix < width  ? ix : address(ix, width) ; 
+        int sy = iy < height ? iy : address(iy, height) ; 
+        const float* src = vv + (size_t(sy)*width + sx)*nch ;
+        float* dst = pad.data() + (size_t(iy)*pitch + ix)*nch ; 
+        for(int c=0 ; c < nch ; c++) dst[c] = src[c] ; 
+    }
+}
+
+inline int MockTexture::address(int i, int n) const 
+{
+    if( addressMode == 'W' ) 
+    {
+        i %= n ; 
+        return i < 0 ? i + n : i ;  
+    }
+    return i < 0 ? 0 : ( i >= n ? n - 1 : i ) ; 
 }
 
 inline std::string MockTexture::desc() const 
@@ -56,6 +167,10 @@ inline std::string MockTexture::desc() const
        << " a " << ( a ? a->sstr() : "-" )
        << " width " << width
        << " height " << height
+       << " nch " << nch 
+       << " filterMode " << filterMode 
+       << " normalizedCoords " << normalizedCoords 
+       << " addressMode " << addressMode 
        << " dom " << dom 
        ; 
 
@@ -63,20 +178,127 @@ inline std::string MockTexture::desc() const
     return str ; 
 }
 
+/**
+MockTexture::lookup
+---------------------
+
+Follows the CUDA tex2D semantics for the configured filter, coordinate and 
+address modes, see the "Texture Fetching" appendix of the CUDA Programming Guide. 
+Kept small so that it inlines into tex2D, the point lookups within 
+the texture then cost little more than an array access. 
+
+**/
+
 template<typename T> 
 inline T MockTexture::lookup(float x, float y ) const
 {
-    const T* vv = a->cvalues<T>() ; 
-    int nx = width ; 
-    int ny = height ; 
+    return filterMode == 'P' ? lookup_nearest<T>(x, y) : lookup_linear<T>(x, y) ; 
+}
+
+/**
+MockTexture::lookup_linear
+----------------------------
+
+Linear filtering of texel coordinates (xt, yt) with xt = x*width - 0.5 
+(or x - 0.5 for unnormalized coordinates) returns::
+
+    (1-a)(1-b) T[i,j] + a(1-b) T[i+1,j] + (1-a)b T[i,j+1] + ab T[i+1,j+1]
+  
+    i = floor(xt), a = frac(xt), j = floor(yt), b = frac(yt)
+   
+With *quantize* the weights a and b are rounded to 8 bits of fraction 
+like the 9-bit fixed point weights of the texture hardware. 
+When b is zero, as for the texel centred lines of the boundary texture, 
+only one row is read.  
+
+**/
 
-    int ix = int(x*float(nx)) ;  // NB no subtraction of 0.5f to get match 
-    int iy = int(y*float(ny)) ; 
-    int idx = iy*nx + ix ; 
+template<typename T> 
+inline T MockTexture::lookup_linear(float x, float y ) const
+{
+    constexpr int N = sizeof(T)/sizeof(float) ; 
+    assert( N == nch ); 
+
+    float xt = ( normalizedCoords ? x*float(width)  : x ) - 0.5f ; 
+    float yt = ( normalizedCoords ? y*float(height) : y ) - 0.5f ; 
+    int ix = int(xt) ;   
+    int iy = int(yt) ; 
+    if( xt < float(ix) ) ix -= 1 ;  // floor without libm call  
+    if( yt < float(iy) ) iy -= 1 ; 
+    float wa = xt - float(ix) ; 
+    float wb = yt - float(iy) ; 
+    if( quantize )
+    {
+        wa = float(int( wa*256.f + 0.5f ))*(1.f/256.f) ; 
+        wb = float(int( wb*256.f + 0.5f ))*(1.f/256.f) ; 
+    }
+
+    if( addressMode == 'W' )
+    {
+        if( ix < 0 || ix >= width )  ix = address(ix, width) ; 
+        if( iy < 0 || iy >= height ) iy = address(iy, height) ; 
+    }
+    else
+    {
+        if( ix < 0 ){ ix = 0 ; wa = 0.f ; } else if( ix >= width - 1 ){ ix = width - 1 ; wa = 0.f ; }
+        if( iy < 0 ){ iy = 0 ; wb = 0.f ; } else if( iy >= height - 1 ){ iy = height - 1 ; wb = 0.f ; }
+    }
+
+    const float* p0 = pad.data() + (size_t(iy)*pitch + ix)*N ; 
+    const float* p1 = p0 + N ; 
+
+    T r ; 
+    float* rr = (float*)&r ; 
+    for(int c=0 ; c < N ; c++) rr[c] = (1.f - wa)*p0[c] + wa*p1[c] ; 
+
+    if( wb != 0.f )
+    {
+        const float* q0 = p0 + size_t(pitch)*N ; 
+        const float* q1 = q0 + N ; 
+        for(int c=0 ; c < N ; c++) rr[c] = (1.f - wb)*rr[c] + wb*((1.f - wa)*q0[c] + wa*q1[c]) ; 
+    }
+    return r ; 
+}
+
+/**
+MockTexture::lookup_nearest
+-----------------------------
+
+Point filtering. Lookups within the texture, which is almost all of them, 
+take the fast path reading directly from the array with truncation as the 
+floor. Only lookups outside need the floor and address mode handling 
+of lookup_nearest_outside. 
+
+**/
+
+template<typename T> 
+inline T MockTexture::lookup_nearest(float x, float y ) const
+{
+    float xt = x*xscale ;  // NB no subtraction of 0.5f to get match 
+    float yt = y*yscale ; 
+    if( xt >= 0.f && yt >= 0.f )
+    {
+        int ix = int(xt) ; 
+        int iy = int(yt) ; 
+        if( ix < width && iy < height ) return ((const T*)vv)[iy*width + ix] ; 
+    }
+    return lookup_nearest_outside<T>(xt, yt) ; 
+}
 
-    T v0 = vv[idx] ;     // hmm should be interpolating between v0 and v1 presumably 
-    //T v1 = vv[idx+1] ;  // can this go beyond the array ?
-    return v0  ; 
+template<typename T> 
+inline T MockTexture::lookup_nearest_outside(float xt, float yt ) const
+{
+    int ix = int(xt) ; 
+    int iy = int(yt) ; 
+    if( xt < float(ix) ) ix -= 1 ; 
+    if( yt < float(iy) ) iy -= 1 ; 
+    if( ix < 0 || ix >= width )  ix = address(ix, width) ; 
+    if( iy < 0 || iy >= height ) iy = address(iy, height) ; 
+
+    const float* p = pad.data() + (size_t(iy)*pitch + ix)*nch ; 
+    T r ; 
+    memcpy( &r, p, sizeof(T) ); 
+    return r ; 
 }
 
 template<typename T> 
@@ -95,22 +317,35 @@ inline std::string MockTexture::dump() const
 
 
 
+/**
+MockTextureManager
+--------------------
+
+The cudaTextureObject_t handles returned by *add* are the addresses 
+of the heap allocated MockTexture, so *tex2D* resolves a handle with 
+a cast rather than a lookup into the manager. The manager owns the 
+textures which are deleted with it. 
+
+**/
+
 struct MockTextureManager 
 {
     static MockTextureManager* INSTANCE ; 
     static MockTextureManager* Get(); 
-    static MockTexture Get(cudaTextureObject_t tex); 
-    static cudaTextureObject_t Add(const NP* a ); 
+    static const MockTexture& Get(cudaTextureObject_t tex); 
+    static cudaTextureObject_t Add(const NP* a, char filterMode='P', bool normalizedCoords=true, char addressMode='W' ); 
+    static const MockTexture* Resolve(cudaTextureObject_t tex); 
 
-    std::vector<MockTexture> tt ; 
+    std::vector<MockTexture*> tt ; 
 
     MockTextureManager() ;
+    ~MockTextureManager() ;
 
-    cudaTextureObject_t add( const NP* a ); 
+    cudaTextureObject_t add( const NP* a, char filterMode='P', bool normalizedCoords=true, char addressMode='W' ); 
 
     static std::string Desc(); 
     std::string desc() const ; 
-    MockTexture get(cudaTextureObject_t tex ) const ; 
+    const MockTexture& get(cudaTextureObject_t tex ) const ; 
 
     template<typename T> T tex2D( cudaTextureObject_t t, float x, float y ) const  ; 
 
@@ -130,24 +365,43 @@ inline MockTextureManager::MockTextureManager()
     INSTANCE = this ; 
 }
 
-inline MockTexture MockTextureManager::Get(cudaTextureObject_t obj) // static
+/**
+MockTextureManager::~MockTextureManager
+-----------------------------------------
+
+The manager owns the textures, deleting it invalidates all handles. 
+
+**/
+
+inline MockTextureManager::~MockTextureManager()
+{
+    for(size_t i=0 ; i < tt.size() ; i++) delete tt[i] ; 
+    tt.clear(); 
+    if( INSTANCE == this ) INSTANCE = nullptr ; 
+}
+
+inline const MockTexture& MockTextureManager::Get(cudaTextureObject_t obj) // static
 {
     assert(INSTANCE); 
     return INSTANCE->get(obj) ; 
 }
-inline cudaTextureObject_t MockTextureManager::Add(const NP* a )
+inline cudaTextureObject_t MockTextureManager::Add(const NP* a, char filterMode, bool normalizedCoords, char addressMode )
 {
     if(INSTANCE == nullptr) new MockTextureManager ; 
     assert(INSTANCE); 
-    return INSTANCE->add(a); 
+    return INSTANCE->add(a, filterMode, normalizedCoords, addressMode); 
 }
 
-inline cudaTextureObject_t MockTextureManager::add(const NP* a )
+inline const MockTexture* MockTextureManager::Resolve(cudaTextureObject_t t) // static
 {
-    cudaTextureObject_t idx = tt.size() ; 
-    MockTexture tex(a) ; 
+    return reinterpret_cast<const MockTexture*>(t) ; 
+}
+
+inline cudaTextureObject_t MockTextureManager::add(const NP* a, char filterMode, bool normalizedCoords, char addressMode )
+{
+    MockTexture* tex = new MockTexture(a, filterMode, normalizedCoords, addressMode) ; 
     tt.push_back(tex); 
-    return idx ; 
+    return reinterpret_cast<cudaTextureObject_t>(tex) ; 
 }
 
 inline std::string MockTextureManager::Desc() // static
@@ -159,45 +413,43 @@ inline std::string MockTextureManager::desc() const
     int num_tex = tt.size(); 
     std::stringstream ss ;
     ss << "MockTextureManager::desc num_tex " << num_tex << std::endl ; 
-    for(int i=0 ; i < num_tex ; i++) ss << std::setw(4) << i << " : " << tt[i].desc() << std::endl ;  
+    for(int i=0 ; i < num_tex ; i++) ss << std::setw(4) << i << " : " << tt[i]->desc() << std::endl ;  
     std::string str = ss.str(); 
     return str ; 
 }
 
-inline MockTexture MockTextureManager::get(cudaTextureObject_t t ) const
+inline const MockTexture& MockTextureManager::get(cudaTextureObject_t t ) const
 {
-    assert( t < tt.size() ); 
-    return tt[t] ; 
+    const MockTexture* tex = Resolve(t) ; 
+    assert( tex ); 
+    return *tex ; 
 }
 
 template<typename T> 
 inline std::string MockTextureManager::dump( cudaTextureObject_t t ) const
 {
-    MockTexture tex = get(t) ; 
+    const MockTexture& tex = get(t) ; 
     return tex.dump<T>(); 
 }
 
 template<typename T> 
 inline T MockTextureManager::tex2D( cudaTextureObject_t t, float x, float y ) const 
 {
-    MockTexture tex = get(t) ; 
+    const MockTexture& tex = get(t) ; 
     return tex.lookup<T>(x,y) ; 
 }
 
 template<typename T> T tex2D(cudaTextureObject_t t, float x, float y )
 {
-    MockTextureManager* mgr = MockTextureManager::Get() ; 
-    if( mgr == nullptr ) 
+    if( t == 0 ) 
     {
          std::cerr 
-             << "s_mock_texture.h/tex2D : FATAL : null MockTextureManager "
+             << "s_mock_texture.h/tex2D : FATAL : null texture handle "
              << std::endl 
-             << " manager is instanciated when adding MOCK texture arrays with MockTextureManager::Add "
+             << " handles are obtained when adding MOCK texture arrays with MockTextureManager::Add "
              << std::endl 
              ; 
         assert(0);   
     }
-    return mgr->tex2D<T>( t, x, y ); 
+    return MockTextureManager::Resolve(t)->lookup<T>( x, y ); 
 }
-
-
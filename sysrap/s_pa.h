@@ -33,6 +33,8 @@ struct SYSRAP_API s_pa
 
     typedef s_pool<s_pa,_s_pa> POOL ;
     static POOL* pool ;
+    static void* operator new(size_t sz){ return POOL::Allocate(pool, sz) ; }  // into pool arena, see s_pool.h 
+    static void  operator delete(void* p){ POOL::Deallocate(p) ; } 
     static void SetPOOL( POOL* pool_ ); 
     static int level() ; 
     static void Serialize( _s_pa& p, const s_pa* o ); 
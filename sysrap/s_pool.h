@@ -15,6 +15,17 @@ as the *pid* is based on a global count of additions to the pool with no account
 for any deletions, whereas the the *index* adjusts to the size of the current pool providing 
 a contiguous key. 
 
+Bookkeeping is O(1) per operation:
+
+* *slot* vector holds the object pointer for each pid, nullptr after removal
+* *pid_of* hash map gives the pid of an object pointer
+* *rank* vector gives the contiguous index of each pid, it is extended by *add*
+  and only rebuilt (once, O(N)) by the first *index* call after any *remove*
+
+Objects of types that route their class operator new/delete 
+to s_pool::Allocate/s_pool::Deallocate (sn, s_tv, s_pa, s_bb) 
+are placed into the *arena* of the pool, see s_arena below. 
+
 
 ::
 
@@ -34,39 +45,192 @@ a contiguous key.
 #include <iomanip>
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include <functional>
+#include <cstddef>
+#include <cstdlib>
 
 #include "ssys.h"
 #include "NPX.h"
 
 
 /**
-s_find
+s_arena
 ---------
 
-s_find is used by s_pool::index and s_pool::remove in std::find_if 
-traversals of the pools which are maps of T* pointers with int keys  
+Slab allocator for objects of type T giving contiguous storage 
+and stable pointers, with freed slots reused via a free list. 
+Each slot is preceded by a header holding the owning arena, 
+so s_arena::Deallocate can return the memory to the right place 
+and can also handle objects allocated from the heap when no 
+arena was available (owner nullptr). 
 
 **/
 
 template<typename T>
-struct s_find
+struct s_arena
 {
-    const T* q ; 
-    s_find(const T* q_) : q(q_) {} ;  
-    bool operator()(const std::pair<int, T*>& p){ return q == p.second ; }  
+    struct Head 
+    { 
+        s_arena<T>* owner ; 
+        char*       next ;    // next free slot, only meaningful when slot is free 
+    };
+
+    static constexpr const size_t ALIGN = alignof(std::max_align_t) ; 
+    static constexpr const size_t HEAD = (sizeof(Head) + ALIGN - 1)/ALIGN*ALIGN ; 
+    static constexpr const size_t SLOT = HEAD + (sizeof(T) + ALIGN - 1)/ALIGN*ALIGN ; 
+
+    int                slab_items ; 
+    std::vector<char*> slab ; 
+    char*              free_list ; 
+    int                slab_used ;   // slots handed out from the last slab 
+    int                num_live ; 
+
+    s_arena(int slab_items=4096); 
+    ~s_arena(); 
+    s_arena(const s_arena&) = delete ; 
+    s_arena& operator=(const s_arena&) = delete ; 
+
+    void* allocate(); 
+    void  deallocate(void* p); 
+
+    static void* Allocate(s_arena<T>* arena, size_t sz); 
+    static void  Deallocate(void* p); 
+
+    std::string desc() const ; 
 };
 
+template<typename T>
+inline s_arena<T>::s_arena(int slab_items_)
+    :
+    slab_items(slab_items_),
+    free_list(nullptr),
+    slab_used(slab_items_),
+    num_live(0)
+{
+}
+
+template<typename T>
+inline s_arena<T>::~s_arena()
+{
+    for(unsigned i=0 ; i < slab.size() ; i++) ::operator delete(slab[i]) ; 
+}
+
+/**
+s_arena::allocate
+-------------------
+
+Returns pointer to storage for one T, after the header.
+
+**/
+
+template<typename T>
+inline void* s_arena<T>::allocate()
+{
+    char* slot = nullptr ; 
+    if( free_list )
+    {
+        slot = free_list ; 
+        free_list = ((Head*)slot)->next ; 
+    }
+    else
+    {
+        if( slab_used == slab_items )
+        {
+            slab.push_back( (char*)::operator new( SLOT*slab_items ) ); 
+            slab_used = 0 ; 
+        }
+        slot = slab.back() + SLOT*slab_used ; 
+        slab_used += 1 ; 
+    }
+    Head* h = (Head*)slot ; 
+    h->owner = this ; 
+    h->next = nullptr ; 
+    num_live += 1 ; 
+    return slot + HEAD ; 
+}
+
+template<typename T>
+inline void s_arena<T>::deallocate(void* p)
+{
+    char* slot = (char*)p - HEAD ; 
+    Head* h = (Head*)slot ; 
+    assert( h->owner == this ); 
+    h->next = free_list ; 
+    free_list = slot ; 
+    num_live -= 1 ; 
+}
+
+/**
+s_arena::Allocate
+-------------------
+
+Intended for use from class operator new of T. When *arena* is nullptr 
+or *sz* does not match (eg for a subclass) the storage comes from the heap 
+with a header with nullptr owner. 
+
+**/
+
+template<typename T>
+inline void* s_arena<T>::Allocate(s_arena<T>* arena, size_t sz) // static
+{
+    if( arena && sz == sizeof(T) ) return arena->allocate() ; 
+    char* slot = (char*)::operator new( HEAD + sz ) ; 
+    Head* h = (Head*)slot ; 
+    h->owner = nullptr ; 
+    h->next = nullptr ; 
+    return slot + HEAD ; 
+}
+
+template<typename T>
+inline void s_arena<T>::Deallocate(void* p) // static
+{
+    if( p == nullptr ) return ; 
+    char* slot = (char*)p - HEAD ; 
+    Head* h = (Head*)slot ; 
+    if( h->owner ) 
+    {
+        h->owner->deallocate(p) ; 
+    }
+    else
+    {
+        ::operator delete(slot) ; 
+    }
+}
+
+template<typename T>
+inline std::string s_arena<T>::desc() const 
+{
+    std::stringstream ss ; 
+    ss << "s_arena::desc"
+       << " SLOT " << SLOT 
+       << " slab_items " << slab_items 
+       << " num_slab " << slab.size() 
+       << " num_live " << num_live 
+       ;
+    std::string str = ss.str(); 
+    return str ; 
+}
+
+
 template<typename T, typename P>    
 struct s_pool
 {
-    typedef typename std::map<int, T*> POOL ; 
-    POOL pool ; 
+    std::vector<T*>   slot ;     // pid -> object, nullptr after remove 
+    std::unordered_map<const T*, int> pid_of ;  
+    mutable std::vector<int> rank ;   // pid -> contiguous index of active objects 
+    mutable bool      rank_dirty ; 
+    int               num_active ; 
+    s_arena<T>        arena ; 
+
     const char* label ; 
     int count ; 
     int level ;  
 
-    s_pool(const char* label); 
+    s_pool(const char* label=nullptr); 
+
+    static void* Allocate(s_pool<T,P>* pool, size_t sz); 
+    static void  Deallocate(void* p); 
 
     int size() const ; 
     int num_root() const ; 
@@ -80,6 +244,7 @@ struct s_pool
     std::string brief() const ; 
     std::string desc() const ; 
 
+    int pid(const T* q) const ; 
     int index(const T* q) const ; 
     int add( T* o ); 
     int remove( T* o ); 
@@ -96,26 +261,53 @@ struct s_pool
 template<typename T, typename P>
 inline s_pool<T,P>::s_pool(const char* label)
     :
+    rank_dirty(false),
+    num_active(0),
     label(label ? strdup(label) : nullptr),
     count(0),
     level(ssys::getenvint("s_pool_level",0))
 {
 }
 
+/**
+s_pool<T,P>::Allocate
+-----------------------
+
+For use from class operator new of T, eg::
+
+    static void* operator new(size_t sz){ return POOL::Allocate(pool, sz) ; }
+    static void  operator delete(void* p){ POOL::Deallocate(p) ; }
+
+Objects created with a pool in place are placed into its arena, 
+otherwise they come from the heap. 
+
+**/
+
+template<typename T, typename P>
+inline void* s_pool<T,P>::Allocate(s_pool<T,P>* pool, size_t sz) // static
+{
+    return s_arena<T>::Allocate( pool ? &pool->arena : nullptr, sz ); 
+}
+
+template<typename T, typename P>
+inline void s_pool<T,P>::Deallocate(void* p) // static
+{
+    s_arena<T>::Deallocate(p); 
+}
+
 template<typename T, typename P>
 inline int s_pool<T,P>::size() const 
 {
-    return pool.size(); 
+    return num_active ; 
 }
 template<typename T, typename P>
 inline int s_pool<T,P>::num_root() const 
 {
     int count_root = 0 ; 
-    typedef typename POOL::const_iterator IT ; 
-    for(IT it=pool.begin() ; it != pool.end() ; it++) 
+    for(size_t i=0 ; i < slot.size() ; i++) 
     {
-        T* n = it->second ;  
-        if(n->is_root()) count_root += 1 ; 
+        T* n = slot[i] ;  
+        if(n && n->is_root()) count_root += 1 ; 
     }
     return count_root ; 
 }
@@ -144,11 +336,10 @@ inline T* s_pool<T,P>::get_root(int idx) const
 {
     T* root = nullptr ; 
     int count_root = 0 ; 
-    typedef typename POOL::const_iterator IT ; 
-    for(IT it=pool.begin() ; it != pool.end() ; it++) 
+    for(size_t i=0 ; i < slot.size() ; i++) 
     {
-        T* n = it->second ;  
-        if(n->is_root()) 
+        T* n = slot[i] ;  
+        if(n && n->is_root()) 
         {
             if( idx == count_root ) root = n ; 
             count_root += 1 ; 
@@ -160,18 +351,17 @@ inline T* s_pool<T,P>::get_root(int idx) const
 template<typename T, typename P>
 inline T* s_pool<T,P>::get(int idx) const 
 {
-    return pool.count(idx) == 1 ? pool.at(idx) : nullptr ; 
+    return idx > -1 && idx < int(slot.size()) ? slot[idx] : nullptr ; 
 }
 
 
 template<typename T, typename P>
 inline void s_pool<T,P>::find(std::vector<T*>& vec, std::function<bool(const T*)> predicate ) const 
 {
-    typedef typename POOL::const_iterator IT ; 
-    for(IT it=pool.begin() ; it != pool.end() ; it++) 
+    for(size_t i=0 ; i < slot.size() ; i++) 
     {
-        T* n = it->second ;  
-        if(predicate(n)) vec.push_back(n) ; 
+        T* n = slot[i] ;  
+        if(n && predicate(n)) vec.push_back(n) ; 
     }
 }
 
@@ -184,7 +374,7 @@ inline std::string s_pool<T,P>::brief() const
        << "s_pool::brief "
        << " label " << ( label ? label : "-" )
        << " count " << count 
-       << " pool.size " << pool.size() 
+       << " pool.size " << size() 
        << " num_root " << num_root()
        ;
     std::string str = ss.str(); 
@@ -198,17 +388,18 @@ inline std::string s_pool<T,P>::desc() const
     ss << "s_pool::desc "
        << " label " << ( label ? label : "-" )
        << " count " << count 
-       << " pool.size " << pool.size() 
+       << " pool.size " << size() 
        << " num_root " << num_root()
+       << std::endl
+       << arena.desc()
        << std::endl
         ; 
 
-    typedef typename POOL::const_iterator IT ; 
-    for(IT it=pool.begin() ; it != pool.end() ; it++) 
+    for(size_t i=0 ; i < slot.size() ; i++) 
     {
-        int key = it->first ; 
-        T* n = it->second ;  
-        ss << std::setw(3) << key << " : " << n->desc() << std::endl ; 
+        int key = i ; 
+        T* n = slot[i] ;  
+        if(n) ss << std::setw(3) << key << " : " << n->desc() << std::endl ; 
     }
     std::string str = ss.str(); 
     return str ; 
@@ -225,24 +416,37 @@ cause gaps in the pid values whereas the indices will be contiguous.
 
 **/
 
+template<typename T, typename P>
+inline int s_pool<T, P>::pid(const T* q) const 
+{
+    typename std::unordered_map<const T*, int>::const_iterator it = pid_of.find(q) ; 
+    return it == pid_of.end() ? -1 : it->second ; 
+}
+
 template<typename T, typename P>
 inline int s_pool<T, P>::index(const T* q) const 
 {
     if( q == nullptr && level > 0) std::cerr 
          << "s_pool::index got nullptr arg "
-         << " pool.size " << pool.size()
+         << " pool.size " << size()
          << std::endl 
          ;
      
     if( q == nullptr ) return -1 ;     
 
-    s_find<T> find(q); 
-    size_t idx_ = std::distance( pool.begin(), std::find_if( pool.begin(), pool.end(), find )); 
-    int idx = idx_ < pool.size() ? idx_ : -1 ;  
+    int _pid = pid(q) ; 
+    if( _pid > -1 && rank_dirty )
+    {
+        rank.assign( slot.size(), -1 ); 
+        int r = 0 ; 
+        for(size_t i=0 ; i < slot.size() ; i++) if(slot[i]) rank[i] = r++ ; 
+        rank_dirty = false ; 
+    }
+    int idx = _pid > -1 ? rank[_pid] : -1 ;  
 
     if( idx == -1 && level > 0) std::cerr
          << "s_pool::index failed to find non-nullptr  "
-         << " pool.size " << pool.size()
+         << " pool.size " << size()
          << std::endl 
          ;
  
@@ -253,7 +457,11 @@ template<typename T, typename P>
 inline int s_pool<T, P>::add(T* o)
 {
     int pid = count ; 
-    pool[pid] = o ; 
+    slot.push_back(o); 
+    pid_of[o] = pid ; 
+    if(!rank_dirty) rank.push_back(num_active) ; 
+    num_active += 1 ; 
+
     if(level > 0) std::cerr 
         << "s_pool::add " 
         << ( label ? label : "-" ) 
@@ -267,11 +475,10 @@ inline int s_pool<T, P>::add(T* o)
 template<typename T, typename P>
 inline int s_pool<T,P>::remove(T* o)
 {
-    s_find<T> find(o); 
-    typename POOL::iterator it = std::find_if( pool.begin(), pool.end(), find ) ; 
+    typename std::unordered_map<const T*, int>::iterator it = pid_of.find(o) ; 
 
     int pid = -1 ; 
-    if( it == pool.end() )
+    if( it == pid_of.end() )
     {
         if(level > 0) std::cerr 
            << "s_pool::remove " 
@@ -282,14 +489,17 @@ inline int s_pool<T,P>::remove(T* o)
     }
     else
     {
-        pid = it->first ; 
+        pid = it->second ; 
         if(level > 0) std::cerr 
             << "s_pool::remove " 
             << ( label ? label : "-"  ) 
             << " pid " << pid 
             << std::endl
             ; 
-        pool.erase(it); 
+        pid_of.erase(it); 
+        slot[pid] = nullptr ; 
+        num_active -= 1 ; 
+        rank_dirty = true ; 
     }
     return pid ; 
 } 
@@ -307,12 +517,14 @@ calling sn::Serialize between refs to _sn and sn pointer.
 template<typename T, typename P>
 inline void s_pool<T,P>::serialize_( std::vector<P>& buf ) const 
 {
-    buf.resize(pool.size());  
-    for(typename POOL::const_iterator it=pool.begin() ; it != pool.end() ; it++)
+    buf.resize(size());  
+    size_t idx = 0 ; 
+    for(size_t i=0 ; i < slot.size() ; i++)
     {
-        size_t idx = std::distance(pool.begin(), it ); 
+        if(slot[i] == nullptr) continue ; 
         if(level > 1) std::cerr << "s_pool::serialize_ " << idx << std::endl ; 
-        T::Serialize( buf[idx], it->second ); 
+        T::Serialize( buf[idx], slot[i] ); 
+        idx += 1 ; 
     }
 }
 
@@ -87,6 +87,8 @@ struct sflat ;
 
 struct sphoton ; 
 
+#include "sgenstep_lookup.h"
+
 #if defined(__CUDACC__) || defined(__CUDABE__)
 #else
 #include <string>
@@ -149,7 +151,9 @@ struct sevent
     // TODO: check for leaking of hit buffers  
 
     quad6*   genstep ;    //QEvent::device_alloc_genstep
-    int*     seed ;     
+    int*     seed ;       //QEvent::device_alloc_genstep_and_seed, nullptr with seedless SEventConfig::GenstepLookup
+    int*     gs_offset ;  // num_genstep+1 exclusive prefix sum of genstep numphoton, see sgenstep_lookup.h
+    int*     gs_table ;   // optional coarse table of sgenstep_lookup::TABLE mode 
     sphoton* hit ;        //QEvent::gatherHit_ allocates event by event depending on num_hit
     sphoton* photon ;     //QEvent::device_alloc_photon
 
@@ -185,6 +189,8 @@ struct sevent
     SEVENT_METHOD void zero(); 
 #endif 
 
+    SEVENT_METHOD unsigned genstep_id( unsigned idx ) const ; 
+
 #ifndef PRODUCTION
     SEVENT_METHOD void add_rec( srec& r, unsigned idx, unsigned bounce, const sphoton& p); 
     SEVENT_METHOD void add_simtrace( unsigned idx, const quad4& p, const quad2* prd, float tmin ); 
@@ -306,6 +312,9 @@ SEVENT_METHOD std::string sevent::descBuf() const
         << std::setw(20) << " num_seed "        << std::setw(7) << num_seed 
         << std::setw(20) << " max_photon "      << std::setw(7) << max_photon
         << std::endl 
+        << std::setw(20) << " evt.gs_offset "   << std::setw(w) << ( gs_offset ? "Y" : "N" ) << " " << std::setw(20) << gs_offset
+        << std::setw(20) << " evt.gs_table "    << std::setw(w) << ( gs_table  ? "Y" : "N" ) << " " << std::setw(20) << gs_table
+        << std::endl 
         << std::setw(20) << " evt.photon "      << std::setw(w) << ( photon  ? "Y" : "N" ) << " " << std::setw(20) << photon
         << std::setw(20) << " num_photon "      << std::setw(7) << num_photon 
         << std::setw(20) << " max_photon "      << std::setw(7) << max_photon 
@@ -471,6 +480,8 @@ SEVENT_METHOD void sevent::zero()
 
     genstep = nullptr ; 
     seed = nullptr ; 
+    gs_offset = nullptr ; 
+    gs_table = nullptr ; 
     hit = nullptr ; 
     photon = nullptr ; 
 
@@ -487,6 +498,21 @@ SEVENT_METHOD void sevent::zero()
 #endif     // ends host only block 
 
 
+/**
+sevent::genstep_id
+--------------------
+
+Genstep index of photon idx, from the seed array when present
+otherwise by search of the genstep offsets, see sgenstep_lookup.h
+
+**/
+
+SEVENT_METHOD unsigned sevent::genstep_id( unsigned idx ) const
+{
+    return seed ? seed[idx] : sgenstep_lookup::GenstepId( gs_offset, num_genstep, gs_table, idx ) ; 
+}
+
+
 #ifndef PRODUCTION
 /**
 sevent::add_rec
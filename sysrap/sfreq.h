@@ -7,30 +7,83 @@ Canonical usage is for geometry progeny digests
 
 * subs are collected by stree::classifySubtrees
 
+Keys are located with a hash index rather than a linear search.
+32 character hex digest keys are indexed by their 128-bit value
+with sfreq_key, other keys are indexed by string.  
+The index holds positions within the vsu vector and is
+rebuilt when vsu is found to have been changed directly, 
+eg by sorting. 
 
 **/
 
 #include <cassert>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <cstring>
+#include <unordered_map>
 #include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include "NPFold.h"
 
-struct sfreq_matchkey 
+/**
+sfreq_key
+-----------
+
+128-bit value of a 32 character hex digest string
+
+**/
+
+struct sfreq_key
 {
-    const char* query ; 
-    sfreq_matchkey(const char* query_) : query(query_) {}
+    uint64_t hi ; 
+    uint64_t lo ; 
 
-    bool operator()(const std::pair<std::string, int>& p) const 
-    { 
-        return strcmp(query, p.first.c_str()) == 0 ;
-    }
+    static int  Nibble(char c) ; 
+    static bool FromHex( sfreq_key& k, const char* str ); 
+
+    bool operator==(const sfreq_key& other) const { return hi == other.hi && lo == other.lo ; }
 };
 
+struct sfreq_key_hash
+{
+    size_t operator()(const sfreq_key& k) const { return k.lo ^ ( k.hi * 0x9e3779b97f4a7c15ull ) ; } 
+};
+
+inline int sfreq_key::Nibble(char c) // static
+{
+    if( c >= '0' && c <= '9' ) return c - '0' ; 
+    if( c >= 'a' && c <= 'f' ) return c - 'a' + 10 ; 
+    return -1 ; 
+}
+
+/**
+sfreq_key::FromHex
+--------------------
+
+Returns false when *str* is not 32 lower case hex characters, as 
+from sdigest. Upper case is not accepted as that would give the same 
+key for different strings.
+
+**/
+
+inline bool sfreq_key::FromHex( sfreq_key& k, const char* str ) // static
+{
+    k.hi = 0ull ; 
+    k.lo = 0ull ; 
+    for(int i=0 ; i < 32 ; i++)
+    {
+        int n = Nibble(str[i]) ;  // -1 at the terminator of short strings
+        if( n < 0 ) return false ; 
+        uint64_t& v = i < 16 ? k.hi : k.lo ; 
+        v = ( v << 4 ) | uint64_t(n) ; 
+    }
+    return str[32] == '\0' ; 
+}
+
+
 struct sfreq
 {
     typedef std::pair<std::string,int> SU ;   
@@ -39,6 +92,13 @@ struct sfreq
 
     VSU vsu ; 
 
+    mutable std::unordered_map<sfreq_key, int, sfreq_key_hash> dig_index ; 
+    mutable std::unordered_map<std::string, int>               str_index ; 
+
+    void reindex() const ; 
+    void add_index(const char* key, int idx) const ; 
+    int  find_index_(const char* key) const ; 
+
     unsigned get_num() const ; 
     void get_keys(std::vector<std::string>& keys, int freq_cut) const ; 
 
@@ -58,6 +118,7 @@ struct sfreq
     static bool ascending_freq( const SU& a, const SU& b) ; 
     static bool descending_freq(const SU& a, const SU& b) ; 
     void sort(bool descending=true);  
+    void reorder(const std::vector<int>& order); 
 
     std::string desc(const char* sub) const ; 
     std::string desc(unsigned idx) const ; 
@@ -84,6 +145,36 @@ struct sfreq
 };
 
 
+inline void sfreq::reindex() const
+{
+    dig_index.clear(); 
+    str_index.clear(); 
+    for(unsigned i=0 ; i < vsu.size() ; i++) add_index( vsu[i].first.c_str(), i ); 
+}
+
+inline void sfreq::add_index(const char* key, int idx) const
+{
+    sfreq_key k ; 
+    if(sfreq_key::FromHex(k, key)) dig_index[k] = idx ; 
+    else str_index[key] = idx ; 
+}
+
+inline int sfreq::find_index_(const char* key) const
+{
+    sfreq_key k ; 
+    if(sfreq_key::FromHex(k, key)) 
+    {
+        auto it = dig_index.find(k) ; 
+        return it == dig_index.end() ? -1 : it->second ; 
+    }
+    else
+    {
+        auto it = str_index.find(key) ; 
+        return it == str_index.end() ? -1 : it->second ; 
+    }
+}
+
+
 inline unsigned sfreq::get_num() const
 {
     return vsu.size();  
@@ -117,11 +208,26 @@ inline int sfreq::get_freq(const char* key) const
     return idx == -1 ? -1 : int(vsu[idx].second) ; 
 }
 
+/**
+sfreq::find_index
+-------------------
+
+Changes to vsu made without the index, such as sorting or importing, 
+are detected by the index size not matching or the indexed
+key not matching, in which case the index is rebuilt. 
+
+**/
+
 inline int sfreq::find_index(const char* key) const 
 {
-    sfreq_matchkey mk(key);  
-    IT it = std::find_if( vsu.begin(), vsu.end(), mk ); 
-    return it == vsu.end() ? -1 : std::distance( vsu.begin(), it ); 
+    if( dig_index.size() + str_index.size() != vsu.size() ) reindex(); 
+    int idx = find_index_(key); 
+    if( idx > -1 && ( idx >= int(vsu.size()) || strcmp(vsu[idx].first.c_str(), key) != 0 ) )
+    {
+        reindex(); 
+        idx = find_index_(key); 
+    }
+    return idx ; 
 }
 
 /**
@@ -136,8 +242,15 @@ Adding sub keys and counts to a vector of pairs::
 inline void sfreq::add(const char* key)
 {
     int idx = find_index(key); 
-    if( idx == -1 ) vsu.push_back(SU(key, 1u)) ; 
-    else vsu[idx].second += 1 ;  
+    if( idx == -1 ) 
+    {
+        vsu.push_back(SU(key, 1u)) ; 
+        add_index(key, vsu.size() - 1 ); 
+    }
+    else 
+    {
+        vsu[idx].second += 1 ;  
+    }
 }
 
 
@@ -179,6 +292,25 @@ inline bool sfreq::descending_freq(const SU& a, const SU& b) // static
 inline void sfreq::sort(bool descending) 
 {
     std::sort(vsu.begin(), vsu.end(), descending ? descending_freq : ascending_freq );
+    reindex(); 
+}
+
+/**
+sfreq::reorder
+----------------
+
+Rearrange vsu such that the new vsu[i] is the old vsu[order[i]]
+
+**/
+
+inline void sfreq::reorder(const std::vector<int>& order) 
+{
+    assert( order.size() == vsu.size() ); 
+    VSU tmp ; 
+    tmp.reserve(vsu.size()); 
+    for(unsigned i=0 ; i < order.size() ; i++) tmp.push_back( vsu[order[i]] ); 
+    vsu.swap(tmp); 
+    reindex(); 
 }
 
 inline std::string sfreq::desc(const char* sub) const 
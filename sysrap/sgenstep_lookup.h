@@ -0,0 +1,218 @@
+#pragma once
+/**
+sgenstep_lookup.h : seedless photon index to genstep index mapping by search of prefix sum offsets
+=====================================================================================================
+
+The seed buffer filled by iexpand in QEvent::setGenstepUpload holds one int per photon
+giving the index of its genstep : max_photon*4 bytes of device memory that must be
+zeroed and written for every launch.
+
+This replaces the seed array with the exclusive prefix sum of the genstep numphoton,
+num_genstep+1 ints, with the genstep of photon idx found by search::
+
+    offset[g] = sum of numphoton of gensteps [0,g)
+    offset[num_genstep] = total number of photons
+
+    genstep_id(idx) : largest g with offset[g] <= idx
+
+Gensteps with zero photons give repeated offsets, the largest g is always
+a genstep that has photons as offset[g+1] > idx.
+
+Modes, selected with SEventConfig::GenstepLookup envvar OPTICKS_GENSTEP_LOOKUP
+
+seed
+    default, per photon seed array filled by iexpand
+
+search
+    branch-light binary search over all the offsets, log2(num_genstep) steps
+
+table
+    two level : the search starts from a coarse table giving the genstep of the
+    first photon of every bucket of 2^TABLE_SHIFT photons, so typically only a
+    few offsets are searched. The table has NumTable(num_photon)+1 entries
+    with the last entry num_genstep-1.
+
+With the table each photon thread reads one table pair and a handful of offsets
+which are shared by neighbouring threads, so stay cached.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#    define SGENSTEP_LOOKUP_METHOD __host__ __device__ __forceinline__
+#else
+#    define SGENSTEP_LOOKUP_METHOD inline
+#endif
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include <cstring>
+#include <string>
+#include <sstream>
+#endif
+
+
+struct sgenstep_lookup
+{
+    enum { SEED, SEARCH, TABLE } ;
+    static constexpr const int TABLE_SHIFT = 10 ;
+
+    SGENSTEP_LOOKUP_METHOD static int Search( const int* offset, int lo, int n, int idx );
+    SGENSTEP_LOOKUP_METHOD static int GenstepId( const int* offset, int num_genstep, const int* table, int idx );
+    SGENSTEP_LOOKUP_METHOD static int NumTable( int num_photon );
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    static int  Mode( const char* name );
+    static const char* Name( int mode );
+
+    template<typename T>
+    static int  FillOffset( int* offset, const T* gs, int num_genstep, int itemsize, int numphoton_offset );
+    static void FillTable( int* table, const int* offset, int num_genstep, int num_photon );
+    static void Expand( int* seed, const int* offset, int num_genstep );
+    static std::string Desc( const int* offset, int num_genstep, const int* table );
+#endif
+};
+
+
+/**
+sgenstep_lookup::Search
+-------------------------
+
+Largest g in [lo, lo+n) with offset[g] <= idx, requiring offset[lo] <= idx.
+The loop count depends only on n and the select compiles to a conditional
+move so threads of a warp do not diverge.
+
+**/
+
+SGENSTEP_LOOKUP_METHOD int sgenstep_lookup::Search( const int* offset, int lo, int n, int idx ) // static
+{
+    int base = lo ;
+    while( n > 1 )
+    {
+        int half = n >> 1 ;
+        base = offset[base+half] <= idx ? base + half : base ;
+        n -= half ;
+    }
+    return base ;
+}
+
+/**
+sgenstep_lookup::GenstepId
+----------------------------
+
+With table the search is restricted to the gensteps between those
+of the first photons of the bucket of idx and of the next bucket.
+
+**/
+
+SGENSTEP_LOOKUP_METHOD int sgenstep_lookup::GenstepId( const int* offset, int num_genstep, const int* table, int idx ) // static
+{
+    if( table == nullptr ) return Search( offset, 0, num_genstep, idx ) ;
+    int b = idx >> TABLE_SHIFT ;
+    int lo = table[b] ;
+    return Search( offset, lo, table[b+1] - lo + 1, idx ) ;
+}
+
+SGENSTEP_LOOKUP_METHOD int sgenstep_lookup::NumTable( int num_photon ) // static
+{
+    return ( num_photon + (1 << TABLE_SHIFT) - 1 ) >> TABLE_SHIFT ;
+}
+
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+inline int sgenstep_lookup::Mode( const char* name ) // static
+{
+    if( name == nullptr ) return SEED ;
+    if( strcmp(name, "search") == 0 ) return SEARCH ;
+    if( strcmp(name, "table") == 0 )  return TABLE ;
+    return SEED ;
+}
+
+inline const char* sgenstep_lookup::Name( int mode ) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case SEED:   s = "seed"   ; break ;
+        case SEARCH: s = "search" ; break ;
+        case TABLE:  s = "table"  ; break ;
+    }
+    return s ;
+}
+
+/**
+sgenstep_lookup::FillOffset
+-----------------------------
+
+Host exclusive prefix sum of the numphoton of each genstep,
+for quad6 gensteps use T=int itemsize=6*4 numphoton_offset=3
+(sevent::genstep_itemsize sevent::genstep_numphoton_offset).
+Returns the total number of photons.
+
+**/
+
+template<typename T>
+inline int sgenstep_lookup::FillOffset( int* offset, const T* gs, int num_genstep, int itemsize, int numphoton_offset ) // static
+{
+    int tot = 0 ;
+    for(int g=0 ; g < num_genstep ; g++)
+    {
+        offset[g] = tot ;
+        tot += int(gs[g*itemsize + numphoton_offset]) ;
+    }
+    offset[num_genstep] = tot ;
+    return tot ;
+}
+
+/**
+sgenstep_lookup::FillTable
+----------------------------
+
+Linear merge of bucket starts with the offsets, matching GenstepId(offset,num_genstep,nullptr,b<<TABLE_SHIFT).
+
+**/
+
+inline void sgenstep_lookup::FillTable( int* table, const int* offset, int num_genstep, int num_photon ) // static
+{
+    int num_table = NumTable(num_photon) ;
+    int g = 0 ;
+    for(int b=0 ; b < num_table ; b++)
+    {
+        int p = b << TABLE_SHIFT ;
+        while( g + 1 < num_genstep && offset[g+1] <= p ) g++ ;
+        table[b] = g ;
+    }
+    table[num_table] = num_genstep > 0 ? num_genstep - 1 : 0 ;
+}
+
+/**
+sgenstep_lookup::Expand
+-------------------------
+
+Seed array from offsets, as SEvent::MakeSeed and the device iexpand,
+for gathering seeds when running seedless.
+
+**/
+
+inline void sgenstep_lookup::Expand( int* seed, const int* offset, int num_genstep ) // static
+{
+    for(int g=0 ; g < num_genstep ; g++) for(int i=offset[g] ; i < offset[g+1] ; i++) seed[i] = g ;
+}
+
+inline std::string sgenstep_lookup::Desc( const int* offset, int num_genstep, const int* table ) // static
+{
+    int num_photon = offset ? offset[num_genstep] : 0 ;
+    std::stringstream ss ;
+    ss << "sgenstep_lookup::Desc"
+       << " num_genstep " << num_genstep
+       << " num_photon " << num_photon
+       << " table " << ( table ? "Y" : "N" )
+       << " num_table " << ( table ? NumTable(num_photon) : 0 )
+       ;
+    std::string str = ss.str() ;
+    return str ;
+}
+
+#endif
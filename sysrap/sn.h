@@ -28,9 +28,13 @@ In order to convert active *sn* pointers into indices
 on persisting have explictly avoided leaking ANY *sn* by 
 taking care to ALWAYS delete appropriately. 
 This means that can use the *sn* ctor/dtor to add/erase update 
-an std::map of active *sn* pointers keyed on a creation index.  
-This map allows the active *sn* pointers to be converted into 
-a contiguous set of indices to facilitate serialization. 
+the pool of active *sn* pointers keyed on a creation index.  
+The pool allows the active *sn* pointers to be converted into 
+a contiguous set of indices to facilitate serialization, 
+with O(1) lookups via a pointer to pid hash map. 
+
+The class operator new/delete place *sn* into the slab arena 
+of the pool, giving contiguous storage with stable pointers. 
 
 Possible Future
 -----------------
@@ -166,6 +170,8 @@ struct SYSRAP_API sn
 
     typedef s_pool<sn,_sn> POOL ;
     static POOL* pool ;  
+    static void* operator new(size_t sz){ return POOL::Allocate(pool, sz) ; }  // into pool arena, see s_pool.h 
+    static void  operator delete(void* p){ POOL::Deallocate(p) ; } 
     static constexpr const int VERSION = 0 ;
     static constexpr const char* NAME = "sn.npy" ; 
     static constexpr const double zero = 0. ; 
@@ -0,0 +1,115 @@
+#pragma once
+/**
+sphilox.h : Philox4x32-10 counter based random number generation
+===================================================================
+
+Counter based generator (Salmon et al, "Parallel Random Numbers: As Easy as 1, 2, 3")
+where each block of four 32 bit randoms is a pure function of
+(key, counter). Keying on the seed and using the high half of the
+counter for a stream index, such as a photon index, gives independent
+streams that can be generated in any order or on any thread
+with identical results.
+
+* key : 64 bit seed
+* counter : (block_lo, block_hi, stream_lo, stream_hi)
+
+Uniform floats use the same conversion as curand_uniform, giving (0,1].
+
+Used by srng::setStream for the per-photon streams of SGenerate::GeneratePhotons
+and directly by SFrameGenstep::Generate_range for the simtrace and CEGS grids.
+
+**/
+
+#include <cstdint>
+
+struct sphilox
+{
+    static constexpr const uint32_t M0 = 0xD2511F53u ;
+    static constexpr const uint32_t M1 = 0xCD9E8D57u ;
+    static constexpr const uint32_t W0 = 0x9E3779B9u ;
+    static constexpr const uint32_t W1 = 0xBB67AE85u ;
+    static constexpr const float  TWOPOW32_INV = 2.3283064e-10f ;
+    static constexpr const double TWOPOW53_INV_DOUBLE = 1.1102230246251565e-16 ;
+
+    uint32_t key[2] ;
+    uint32_t ctr[4] ;
+    uint32_t out[4] ;
+    int      idx ;     // next unused of out, 4 when exhausted
+
+    sphilox(unsigned long long seed=0ull, unsigned long long stream=0ull);
+
+    void init(unsigned long long seed, unsigned long long stream);
+    static void Block( uint32_t* out, const uint32_t* ctr, const uint32_t* key );
+
+    uint32_t generate();
+    float    generate_float();
+    double   generate_double();
+};
+
+inline sphilox::sphilox(unsigned long long seed, unsigned long long stream)
+{
+    init(seed, stream);
+}
+
+inline void sphilox::init(unsigned long long seed, unsigned long long stream)
+{
+    key[0] = uint32_t(seed) ;
+    key[1] = uint32_t(seed >> 32) ;
+    ctr[0] = 0u ;
+    ctr[1] = 0u ;
+    ctr[2] = uint32_t(stream) ;
+    ctr[3] = uint32_t(stream >> 32) ;
+    idx = 4 ;
+}
+
+/**
+sphilox::Block
+----------------
+
+Ten rounds of Philox4x32 applied to *ctr* with *key*.
+
+**/
+
+inline void sphilox::Block( uint32_t* o, const uint32_t* c_, const uint32_t* k_ ) // static
+{
+    uint32_t c[4] = { c_[0], c_[1], c_[2], c_[3] } ;
+    uint32_t k[2] = { k_[0], k_[1] } ;
+    for(int r=0 ; r < 10 ; r++)
+    {
+        uint64_t p0 = uint64_t(M0)*c[0] ;
+        uint64_t p1 = uint64_t(M1)*c[2] ;
+        uint32_t n0 = uint32_t(p1 >> 32) ^ c[1] ^ k[0] ;
+        uint32_t n2 = uint32_t(p0 >> 32) ^ c[3] ^ k[1] ;
+        c[1] = uint32_t(p1) ;
+        c[3] = uint32_t(p0) ;
+        c[0] = n0 ;
+        c[2] = n2 ;
+        k[0] += W0 ;
+        k[1] += W1 ;
+    }
+    for(int i=0 ; i < 4 ; i++) o[i] = c[i] ;
+}
+
+inline uint32_t sphilox::generate()
+{
+    if( idx == 4 )
+    {
+        Block(out, ctr, key);
+        if( ++ctr[0] == 0u ) ++ctr[1] ;
+        idx = 0 ;
+    }
+    return out[idx++] ;
+}
+
+inline float sphilox::generate_float()
+{
+    return float(generate())*TWOPOW32_INV + TWOPOW32_INV/2.0f ;
+}
+
+inline double sphilox::generate_double()
+{
+    uint32_t x = generate() ;
+    uint32_t y = generate() ;
+    unsigned long long z = (unsigned long long)x ^ ((unsigned long long)y << (53 - 32)) ;
+    return double(z)*TWOPOW53_INV_DOUBLE + TWOPOW53_INV_DOUBLE/2.0 ;
+}
@@ -0,0 +1,391 @@
+#pragma once
+/**
+sphoton_column.h : columnar (struct-of-arrays) hit output with selectable fields
+===================================================================================
+
+Hits gathered as full 4x4 float sphoton are 64 bytes each, even when
+downstream only needs a few fields. With a column mask configured
+(SEventConfig::HitColumns, envvar OPTICKS_HIT_COLUMNS) hits are instead
+gathered into one array per selected field::
+
+    OPTICKS_HIT_COLUMNS=pos,time,wavelength,identity,half
+
++---------------+--------------+-------+-------------------------------------+
+| name          | array shape  | dtype | sphoton field                       |
++===============+==============+=======+=====================================+
+| pos           | (n,3)        | <f4   | pos                                 |
+| mom           | (n,3)        | <f4   | mom                                 |
+| pol           | (n,3)        | <f4   | pol                                 |
+| iindex        | (n,)         | <u4   | iindex                              |
+| identity      | (n,)         | <u4   | identity                            |
+| boundary_flag | (n,)         | <u4   | boundary_flag                       |
+| orient_idx    | (n,)         | <u4   | orient_idx                          |
+| flagmask      | (n,)         | <u4   | flagmask                            |
+| time          | (n,)         | <f4   | time        (<f2 with half)         |
+| wavelength    | (n,)         | <f4   | wavelength  (<f2 with half)         |
++---------------+--------------+-------+-------------------------------------+
+
+The arrays are added to the SEvt fold with keys prefixed "hit_", eg hit_pos.npy,
+in place of the hit.npy array.
+
+half
+    stores time and wavelength as IEEE binary16 with round to nearest even.
+    That gives 11 significant bits : wavelength 380-800 nm is kept to 0.25-0.5 nm
+    and time to about 0.1% (0.06 ns at 100 ns), times beyond 65504 ns become inf.
+
+The same layout is used on both sides:
+
+* device : QEvent::gatherHitColumns lays out the selected columns contiguously
+  in one device buffer filled by SU::copy_if_device_to_device_presized_sphoton_column,
+  so only the selected bytes are downloaded and no intermediate sphoton hit buffer
+  is needed
+* host : SEvt::gatherHitColumns fills the columns from the photon array
+
+Both use the selected photon order of the standard hit array.
+
+Fields are ordered with the optionally two byte time and wavelength last so
+that the contiguous device layout keeps four byte alignment of all other columns.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#    define SPHOTON_COLUMN_METHOD __host__ __device__ __forceinline__
+#else
+#    define SPHOTON_COLUMN_METHOD inline
+#endif
+
+#include "squad.h"
+#include "sphoton.h"
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include <string>
+#include <sstream>
+#include <cstring>
+#include "sstr.h"
+#include "NPFold.h"
+#endif
+
+
+struct sphoton_column
+{
+    enum { POS, MOM, POL, IINDEX, IDENTITY, BOUNDARY_FLAG, ORIENT_IDX, FLAGMASK, TIME, WAVELENGTH, NUM_FIELD } ;
+    static constexpr const unsigned HALF = 0x1 << 16 ;
+    static constexpr const char* PREFIX = "hit_" ;
+
+    unsigned mask ;
+    unsigned num ;
+    char*    col[NUM_FIELD] ;   // base of each selected column, nullptr when not selected
+
+    SPHOTON_COLUMN_METHOD static bool     Has(unsigned mask, int f){ return ( mask & ( 0x1u << f )) != 0u ; }
+    SPHOTON_COLUMN_METHOD static bool     IsHalf(unsigned mask, int f){ return ( mask & HALF ) && ( f == TIME || f == WAVELENGTH ) ; }
+    SPHOTON_COLUMN_METHOD static unsigned NumComp(int f){ return f == POS || f == MOM || f == POL ? 3u : 1u ; }
+    SPHOTON_COLUMN_METHOD static unsigned ItemSize(unsigned mask, int f){ return IsHalf(mask, f) ? 2u : 4u*NumComp(f) ; }
+    SPHOTON_COLUMN_METHOD static size_t   Bytes(unsigned mask, unsigned num);
+    SPHOTON_COLUMN_METHOD static unsigned short FloatToHalf(float f);
+
+    SPHOTON_COLUMN_METHOD sphoton_column( unsigned mask, unsigned num );
+    SPHOTON_COLUMN_METHOD void init_contiguous( char* base );
+    SPHOTON_COLUMN_METHOD void write( unsigned i, const sphoton& p ) const ;
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    static const char* Name(int f);
+    static const char* DType(unsigned mask, int f);
+    static unsigned    Mask(const char* names, char delim=',');
+    static std::string Desc(unsigned mask);
+    static float       HalfToFloat(unsigned short h);
+
+    static std::string Keys(unsigned mask);
+    static int         Num(const NPFold* fold, unsigned mask);
+    void add_arrays( NPFold* fold );
+    std::string desc() const ;
+#endif
+};
+
+
+SPHOTON_COLUMN_METHOD sphoton_column::sphoton_column( unsigned mask_, unsigned num_ )
+    :
+    mask(mask_),
+    num(num_)
+{
+    for(int f=0 ; f < NUM_FIELD ; f++) col[f] = nullptr ;
+}
+
+SPHOTON_COLUMN_METHOD size_t sphoton_column::Bytes(unsigned mask, unsigned num) // static
+{
+    size_t bytes = 0 ;
+    for(int f=0 ; f < NUM_FIELD ; f++) if(Has(mask, f)) bytes += size_t(num)*ItemSize(mask, f) ;
+    return bytes ;
+}
+
+/**
+sphoton_column::init_contiguous
+---------------------------------
+
+Sets the column bases to consecutive ranges of the buffer *base* of sphoton_column::Bytes,
+which can be a device pointer.
+
+**/
+
+SPHOTON_COLUMN_METHOD void sphoton_column::init_contiguous( char* base )
+{
+    size_t offset = 0 ;
+    for(int f=0 ; f < NUM_FIELD ; f++)
+    {
+        col[f] = Has(mask, f) ? base + offset : nullptr ;
+        if(Has(mask, f)) offset += size_t(num)*ItemSize(mask, f) ;
+    }
+}
+
+/**
+sphoton_column::FloatToHalf
+-----------------------------
+
+IEEE binary16 bits of *f* with round to nearest even, handling subnormals,
+overflow to inf and nan. Done with integer operations so that host and
+device give bitwise identical columns.
+
+**/
+
+SPHOTON_COLUMN_METHOD unsigned short sphoton_column::FloatToHalf(float f) // static
+{
+    UIF x ;
+    x.f = f ;
+    unsigned sign = ( x.u >> 16 ) & 0x8000u ;
+    unsigned expo = ( x.u >> 23 ) & 0xffu ;
+    unsigned mant = x.u & 0x7fffffu ;
+
+    if( expo == 0xffu ) return sign | 0x7c00u | ( mant ? 0x200u : 0u ) ;
+
+    int e = int(expo) - 127 + 15 ;
+    if( e >= 31 ) return sign | 0x7c00u ;
+
+    unsigned h ;
+    unsigned shift ;
+    if( e <= 0 )
+    {
+        if( e < -10 ) return sign ;
+        mant |= 0x800000u ;
+        shift = 14 - e ;
+        h = mant >> shift ;
+    }
+    else
+    {
+        shift = 13 ;
+        h = ( unsigned(e) << 10 ) | ( mant >> shift ) ;
+    }
+    unsigned rem = mant & (( 0x1u << shift ) - 1u ) ;
+    unsigned mid = 0x1u << ( shift - 1 ) ;
+    if( rem > mid || ( rem == mid && ( h & 1u ))) h += 1u ;   // carry into exponent is correct, including to inf
+    return sign | h ;
+}
+
+/**
+sphoton_column::write
+----------------------
+
+Writes the selected fields of *p* into slot *i* of the columns.
+
+**/
+
+SPHOTON_COLUMN_METHOD void sphoton_column::write( unsigned i, const sphoton& p ) const
+{
+    if(col[POS]) ((float3*)col[POS])[i] = p.pos ;
+    if(col[MOM]) ((float3*)col[MOM])[i] = p.mom ;
+    if(col[POL]) ((float3*)col[POL])[i] = p.pol ;
+    if(col[IINDEX])        ((unsigned*)col[IINDEX])[i] = p.iindex ;
+    if(col[IDENTITY])      ((unsigned*)col[IDENTITY])[i] = p.identity ;
+    if(col[BOUNDARY_FLAG]) ((unsigned*)col[BOUNDARY_FLAG])[i] = p.boundary_flag ;
+    if(col[ORIENT_IDX])    ((unsigned*)col[ORIENT_IDX])[i] = p.orient_idx ;
+    if(col[FLAGMASK])      ((unsigned*)col[FLAGMASK])[i] = p.flagmask ;
+
+    bool half = mask & HALF ;
+    if(col[TIME])
+    {
+        if(half) ((unsigned short*)col[TIME])[i] = FloatToHalf(p.time) ;
+        else     ((float*)col[TIME])[i] = p.time ;
+    }
+    if(col[WAVELENGTH])
+    {
+        if(half) ((unsigned short*)col[WAVELENGTH])[i] = FloatToHalf(p.wavelength) ;
+        else     ((float*)col[WAVELENGTH])[i] = p.wavelength ;
+    }
+}
+
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+inline const char* sphoton_column::Name(int f) // static
+{
+    const char* s = nullptr ;
+    switch(f)
+    {
+        case POS:           s = "pos"           ; break ;
+        case MOM:           s = "mom"           ; break ;
+        case POL:           s = "pol"           ; break ;
+        case IINDEX:        s = "iindex"        ; break ;
+        case IDENTITY:      s = "identity"      ; break ;
+        case BOUNDARY_FLAG: s = "boundary_flag" ; break ;
+        case ORIENT_IDX:    s = "orient_idx"    ; break ;
+        case FLAGMASK:      s = "flagmask"      ; break ;
+        case TIME:          s = "time"          ; break ;
+        case WAVELENGTH:    s = "wavelength"    ; break ;
+    }
+    return s ;
+}
+
+inline const char* sphoton_column::DType(unsigned mask, int f) // static
+{
+    if(IsHalf(mask, f)) return "<f2" ;
+    return f == POS || f == MOM || f == POL || f == TIME || f == WAVELENGTH ? "<f4" : "<u4" ;
+}
+
+/**
+sphoton_column::Mask
+----------------------
+
+Parses delimited field names plus the "half" option, eg "pos,time,wavelength,identity,half".
+Unknown names are ignored with a warning. A mask without any field is returned as zero,
+which means the standard 4x4 hit array.
+
+**/
+
+inline unsigned sphoton_column::Mask(const char* names, char delim) // static
+{
+    std::vector<std::string> elem ;
+    if(names) sstr::SplitTrim(names, delim, elem);
+
+    unsigned mask = 0u ;
+    for(unsigned i=0 ; i < elem.size() ; i++)
+    {
+        const char* n = elem[i].c_str() ;
+        if(strlen(n) == 0) continue ;
+        if(strcmp(n, "half") == 0)
+        {
+            mask |= HALF ;
+            continue ;
+        }
+        int f = 0 ;
+        while( f < NUM_FIELD && strcmp(n, Name(f)) != 0 ) f++ ;
+        if( f < NUM_FIELD ) mask |= 0x1u << f ;
+        else std::cerr << "sphoton_column::Mask IGNORING unknown field [" << n << "]" << std::endl ;
+    }
+    return ( mask & ~HALF ) ? mask : 0u ;
+}
+
+inline std::string sphoton_column::Desc(unsigned mask) // static
+{
+    std::stringstream ss ;
+    bool first = true ;
+    for(int f=0 ; f < NUM_FIELD ; f++)
+    {
+        if(!Has(mask, f)) continue ;
+        ss << ( first ? "" : "," ) << Name(f) ;
+        first = false ;
+    }
+    if( mask & HALF ) ss << ( first ? "" : "," ) << "half" ;
+    std::string str = ss.str();
+    return str ;
+}
+
+inline float sphoton_column::HalfToFloat(unsigned short h) // static
+{
+    unsigned sign = unsigned( h & 0x8000u ) << 16 ;
+    unsigned expo = ( h >> 10 ) & 0x1fu ;
+    unsigned mant = h & 0x3ffu ;
+
+    UIF x ;
+    if( expo == 0x1fu )
+    {
+        x.u = sign | 0x7f800000u | ( mant << 13 ) ;
+    }
+    else if( expo == 0u )
+    {
+        x.f = float(mant)*5.9604645e-08f ;  // 2^-24
+        x.u |= sign ;
+    }
+    else
+    {
+        x.u = sign | (( expo - 15u + 127u ) << 23 ) | ( mant << 13 ) ;
+    }
+    return x.f ;
+}
+
+/**
+sphoton_column::add_arrays
+----------------------------
+
+Creates the selected arrays, adds them to *fold* with keys such as "hit_pos"
+and sets the column bases to the array bytes ready for filling.
+
+**/
+
+inline void sphoton_column::add_arrays( NPFold* fold )
+{
+    for(int f=0 ; f < NUM_FIELD ; f++)
+    {
+        col[f] = nullptr ;
+        if(!Has(mask, f)) continue ;
+        NP* a = NumComp(f) == 3 ? new NP(DType(mask, f), num, 3 ) : new NP(DType(mask, f), num ) ;
+        col[f] = a->bytes() ;
+        std::string k = std::string(PREFIX) + Name(f) ;
+        fold->add( k.c_str(), a );
+    }
+}
+
+/**
+sphoton_column::Keys
+----------------------
+
+Delimited fold keys of the selected columns, eg "hit_pos,hit_time"
+
+**/
+
+inline std::string sphoton_column::Keys(unsigned mask) // static
+{
+    std::stringstream ss ;
+    bool first = true ;
+    for(int f=0 ; f < NUM_FIELD ; f++)
+    {
+        if(!Has(mask, f)) continue ;
+        ss << ( first ? "" : "," ) << PREFIX << Name(f) ;
+        first = false ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+sphoton_column::Num
+---------------------
+
+Number of hits from the first selected column array in *fold*, or NPFold::UNDEF when absent.
+
+**/
+
+inline int sphoton_column::Num(const NPFold* fold, unsigned mask) // static
+{
+    int f = 0 ;
+    while( f < NUM_FIELD && !Has(mask, f) ) f++ ;
+    if( f == NUM_FIELD ) return NPFold::UNDEF ;
+    std::string k = std::string(PREFIX) + Name(f) ;
+    return fold->get_num(k.c_str()) ;
+}
+
+inline std::string sphoton_column::desc() const
+{
+    std::stringstream ss ;
+    ss << "sphoton_column::desc"
+       << " mask " << Desc(mask)
+       << " num " << num
+       << " bytes " << Bytes(mask, num)
+       << " full " << size_t(num)*sizeof(sphoton)
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+#endif
+
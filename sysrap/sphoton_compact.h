@@ -0,0 +1,179 @@
+#pragma once
+/**
+sphoton_compact.h : host multi-threaded hit selection by prefix sum over sphoton flagmask
+==========================================================================================
+
+CPU equivalent of the thrust::copy_if stream compaction used by QEvent::gatherHit,
+selecting photons with all bits of a hitmask set in the flagmask
+(as sphoton_selector) from any (n,4,4) float NP of sphoton.
+
+Two passes over contiguous chunks, one chunk per thread:
+
+1. count : each thread counts the selected photons of its chunk for every mask
+2. exclusive prefix sum of the chunk counts gives each chunk its output offset,
+   outputs are allocated with the totals
+3. scatter : each thread copies its selected photons to its offset
+
+As chunks are in photon order and each chunk writes in order the output
+ordering is identical to the serial NP::copy_if and to the GPU path.
+
+Several masks are handled in one pass with Partition, each output
+receiving the photons matching its mask (a photon can go to several outputs).
+
+The number of threads defaults to std::thread::hardware_concurrency,
+override with envvar sphoton_compact__THREADS. Arrays below MIN_PARALLEL
+photons use a single thread.
+
+**/
+
+#include <vector>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+#include "ssys.h"
+#include "sphoton.h"
+#include "NP.hh"
+
+
+struct sphoton_compact
+{
+    static constexpr const char* EKEY_THREADS = "sphoton_compact__THREADS" ;
+    static constexpr const int64_t MIN_PARALLEL = 100000 ;
+
+    static int NumThreads(int num_threads, int64_t num_photon);
+    static void Run(int nt, const std::function<void(int)>& fn);
+
+    static NP*  Select( const NP* photon, unsigned hitmask, int num_threads=0 );
+    static void Partition( std::vector<NP*>& out, const NP* photon, const std::vector<unsigned>& hitmask, int num_threads=0 );
+    static int64_t Count( const NP* photon, unsigned hitmask, int num_threads=0 );
+};
+
+
+inline int sphoton_compact::NumThreads(int num_threads, int64_t num_photon) // static
+{
+    int nt = num_threads > 0 ? num_threads : ssys::getenvint(EKEY_THREADS, 0) ;
+    if( nt <= 0 ) nt = int(std::thread::hardware_concurrency()) ;
+    if( nt < 1 ) nt = 1 ;
+    if( num_photon < MIN_PARALLEL ) nt = 1 ;   // thread overhead not worthwhile for small arrays
+    return nt ;
+}
+
+/**
+sphoton_compact::Run
+----------------------
+
+Runs fn(t) for t in [0,nt) with fn(0) on the calling thread.
+
+**/
+
+inline void sphoton_compact::Run(int nt, const std::function<void(int)>& fn) // static
+{
+    std::vector<std::thread> threads ;
+    for(int t=1 ; t < nt ; t++) threads.emplace_back( fn, t );
+    fn(0) ;
+    for(size_t t=0 ; t < threads.size() ; t++) threads[t].join();
+}
+
+inline NP* sphoton_compact::Select( const NP* photon, unsigned hitmask, int num_threads ) // static
+{
+    std::vector<unsigned> mm(1, hitmask) ;
+    std::vector<NP*> out ;
+    Partition(out, photon, mm, num_threads );
+    return out[0] ;
+}
+
+/**
+sphoton_compact::Partition
+----------------------------
+
+Fills *out* with one (num_select,4,4) float array for each of the *hitmask*.
+
+**/
+
+inline void sphoton_compact::Partition( std::vector<NP*>& out, const NP* photon, const std::vector<unsigned>& hitmask, int num_threads ) // static
+{
+    assert( photon && photon->has_shape(-1,4,4) && photon->uifc == 'f' && photon->ebyte == 4 );
+    const sphoton* pp = (const sphoton*)photon->cvalues<float>() ;
+    int64_t num = photon->shape[0] ;
+    int nm = hitmask.size() ;
+    int nt = NumThreads(num_threads, num) ;
+
+    std::vector<int64_t> count( nt*nm, 0 ) ;   // [t*nm + m]
+
+    auto count_range = [&](int t)
+    {
+        int64_t i0 = num*t/nt ;
+        int64_t i1 = num*(t+1)/nt ;
+        std::vector<int64_t> c(nm, 0) ;   // local to avoid false sharing
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            unsigned fm = pp[i].flagmask ;
+            for(int m=0 ; m < nm ; m++) c[m] += ( fm & hitmask[m] ) == hitmask[m] ;
+        }
+        for(int m=0 ; m < nm ; m++) count[t*nm + m] = c[m] ;
+    };
+
+    std::vector<int64_t> total( nm, 0 ) ;
+    std::vector<int64_t>& offset = count ;   // exclusive prefix sum in place
+
+    out.resize(nm) ;
+    std::vector<sphoton*> oo(nm) ;
+
+    auto scatter_range = [&](int t)
+    {
+        int64_t i0 = num*t/nt ;
+        int64_t i1 = num*(t+1)/nt ;
+        std::vector<sphoton*> dst(nm) ;
+        for(int m=0 ; m < nm ; m++) dst[m] = oo[m] + offset[t*nm + m] ;
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            unsigned fm = pp[i].flagmask ;
+            for(int m=0 ; m < nm ; m++) if(( fm & hitmask[m] ) == hitmask[m] ) *dst[m]++ = pp[i] ;
+        }
+    };
+
+    Run(nt, count_range) ;
+
+    for(int m=0 ; m < nm ; m++)
+    {
+        for(int t=0 ; t < nt ; t++)
+        {
+            int64_t c = count[t*nm + m] ;
+            offset[t*nm + m] = total[m] ;
+            total[m] += c ;
+        }
+        out[m] = NP::Make<float>( int(total[m]), 4, 4 ) ;
+        oo[m] = (sphoton*)out[m]->values<float>() ;
+    }
+
+    Run(nt, scatter_range) ;
+}
+
+inline int64_t sphoton_compact::Count( const NP* photon, unsigned hitmask, int num_threads ) // static
+{
+    assert( photon && photon->has_shape(-1,4,4) );
+    const sphoton* pp = (const sphoton*)photon->cvalues<float>() ;
+    int64_t num = photon->shape[0] ;
+    int nt = NumThreads(num_threads, num) ;
+
+    std::vector<int64_t> count( nt, 0 ) ;
+    auto count_range = [&](int t)
+    {
+        int64_t i0 = num*t/nt ;
+        int64_t i1 = num*(t+1)/nt ;
+        int64_t c = 0 ;
+        for(int64_t i=i0 ; i < i1 ; i++) c += ( pp[i].flagmask & hitmask ) == hitmask ;
+        count[t] = c ;
+    };
+
+    Run(nt, count_range) ;
+
+    int64_t tot = 0 ;
+    for(int t=0 ; t < nt ; t++) tot += count[t] ;
+    return tot ;
+}
+
@@ -416,6 +416,48 @@ struct qat4
         q3.f.w = 1.f ; 
     }
 
+    /**
+    qat4::inverse_affine
+    ----------------------
+
+    Sets *v* to the inverse of this affine transform with the .w column
+    identity info cleared, so the result can be used with left_multiply for normals.
+    With right_multiply the transform maps l -> l*M + t where the rows of M
+    are q0,q1,q2 and t is q3, the inverse maps w -> (w - t)*inv(M).
+    Inverse of the 3x3 is obtained in double from the adjugate.
+    Returns false and leaves *v* untouched when the 3x3 is singular.
+
+    **/
+    QAT4_METHOD bool inverse_affine( qat4& v ) const
+    {
+        const double m00 = q0.f.x, m01 = q0.f.y, m02 = q0.f.z ;
+        const double m10 = q1.f.x, m11 = q1.f.y, m12 = q1.f.z ;
+        const double m20 = q2.f.x, m21 = q2.f.y, m22 = q2.f.z ;
+
+        const double c00 = m11*m22 - m12*m21 ;
+        const double c01 = m12*m20 - m10*m22 ;
+        const double c02 = m10*m21 - m11*m20 ;
+
+        const double det = m00*c00 + m01*c01 + m02*c02 ;
+        if( det == 0. ) return false ;
+        const double id = 1./det ;
+
+        const double i00 = c00*id, i01 = (m02*m21 - m01*m22)*id, i02 = (m01*m12 - m02*m11)*id ;
+        const double i10 = c01*id, i11 = (m00*m22 - m02*m20)*id, i12 = (m02*m10 - m00*m12)*id ;
+        const double i20 = c02*id, i21 = (m01*m20 - m00*m21)*id, i22 = (m00*m11 - m01*m10)*id ;
+
+        const double tx = q3.f.x, ty = q3.f.y, tz = q3.f.z ;
+
+        v.q0.f.x = i00 ; v.q0.f.y = i01 ; v.q0.f.z = i02 ; v.q0.f.w = 0.f ;
+        v.q1.f.x = i10 ; v.q1.f.y = i11 ; v.q1.f.z = i12 ; v.q1.f.w = 0.f ;
+        v.q2.f.x = i20 ; v.q2.f.y = i21 ; v.q2.f.z = i22 ; v.q2.f.w = 0.f ;
+        v.q3.f.x = -( tx*i00 + ty*i10 + tz*i20 ) ;
+        v.q3.f.y = -( tx*i01 + ty*i11 + tz*i21 ) ;
+        v.q3.f.z = -( tx*i02 + ty*i12 + tz*i22 ) ;
+        v.q3.f.w = 1.f ;
+        return true ;
+    }
+
     static QAT4_METHOD bool IsDiff( const qat4& a, const qat4& b )
     {
         return false ; 
@@ -20,10 +20,18 @@ To extend that see::
   
    ~/opticks/qudarap/tests/rng_sequence.sh
 
+Alternatively independent counter based streams keyed on (seed, stream)
+are used after calling the below method, typically with the photon index 
+as stream. As the randoms of each stream do not depend on any other
+this allows photons to be generated in any order or on any thread::
+
+    srng::setStream
+
 **/
 
 #include <random>
 #include "s_seq.h"
+#include "sphilox.h"
 
 struct srng
 {
@@ -32,6 +40,8 @@ struct srng
     std::uniform_real_distribution<double>  ddist ; 
     double                                  fake ; 
     s_seq*                                  seq ; 
+    sphilox                                 philox ; 
+    bool                                    stream ; 
 
 
     srng(unsigned seed_=1); 
@@ -40,6 +50,8 @@ struct srng
     void set_fake(double fake_); 
     void setSequenceIndex(int idx); 
     int  getSequenceIndex() const ; 
+    void setStream(unsigned long long seed, unsigned long long stream_); 
+    void unsetStream(); 
 
     float  generate_float(); 
     double generate_double(); 
@@ -56,7 +68,8 @@ inline srng::srng(unsigned seed_)
     fdist(0,1), 
     ddist(0,1),
     fake(-1.),
-    seq(nullptr)
+    seq(nullptr),
+    stream(false)
 { 
     engine.seed(seed_) ; 
 }
@@ -74,13 +87,13 @@ inline void srng::set_fake(double fake_){ fake = fake_ ; }
 inline float srng::generate_float()
 {
     if( fake >= 0.f ) return fake ; 
-    float u = seq && seq->is_enabled() ? seq->flat() : fdist(engine) ; 
+    float u = seq && seq->is_enabled() ? seq->flat() : ( stream ? philox.generate_float() : fdist(engine) ) ; 
     return u ; 
 } 
 inline double srng::generate_double()
 { 
     if( fake >= 0.f ) return fake ; 
-    double u = seq && seq->is_enabled() ? seq->flat() : ddist(engine) ; 
+    double u = seq && seq->is_enabled() ? seq->flat() : ( stream ? philox.generate_double() : ddist(engine) ) ; 
     return u ; 
 }
 inline void srng::setSequenceIndex(int idx)
@@ -93,6 +106,25 @@ inline int srng::getSequenceIndex() const
     return seq == nullptr ? -2 : seq->getSequenceIndex() ; 
 }
 
+/**
+srng::setStream
+-----------------
+
+Switch to the counter based sphilox stream keyed on (seed, stream_), 
+starting from its first random. 
+
+**/
+
+inline void srng::setStream(unsigned long long seed, unsigned long long stream_)
+{
+    philox.init(seed, stream_); 
+    stream = true ; 
+}
+inline void srng::unsetStream()
+{
+    stream = false ; 
+}
+
 
 
 inline float  srng::uniform(srng* state ){        return state->generate_float() ; } 
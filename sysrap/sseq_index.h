@@ -16,8 +16,19 @@ sseq_index_chi2
    reimplementation of ~/opticks/ana/qcf.py:QCF
 
 
+sseq_index construction defaults to a thread parallel count using
+per-thread open addressing hash tables (sseq_index_hash) keyed on seqhis
+that are merged once all threads complete. The ordering and chi2 output
+is identical to the serial std::map count which can be selected with::
+
+    export sseq_index__MAP=1
+
+The number of threads defaults to std::thread::hardware_concurrency
+and can be changed with sseq_index__THREADS.
+
 **/
 
+#include <thread>
 #include "ssys.h"
 #include "sseq.h"
 #include "NPX.h"
@@ -114,27 +125,162 @@ inline std::string sseq_qab::desc(int absum_min) const
 
 
 
+/**
+sseq_index_hash
+-----------------
+
+Open addressing (linear probing) hash table from the 2x64 bit seqhis of
+an sseq to the index of first occurrence and count. Slots with zero
+count are empty. Capacity is a power of two that doubles to keep the
+load factor below one half.
+
+**/
+
+struct sseq_index_hash
+{
+    typedef unsigned long long ULL ;
+
+    struct slot
+    {
+        ULL              k0 ;
+        ULL              k1 ;
+        sseq_index_count ic ;
+    };
+
+    std::vector<slot> s ;
+    size_t mask ;
+    size_t num ;
+
+    static size_t Hash(ULL k0, ULL k1) ;
+
+    sseq_index_hash(size_t capacity=1024);
+
+    void add( const sseq& q, int index, int count );
+    void grow();
+};
+
+/**
+sseq_index_hash::Hash
+-----------------------
+
+Mixing from the splitmix64 finalizer, needed because seqhis values
+populate only the low nibbles for short histories.
+
+**/
+
+inline size_t sseq_index_hash::Hash(ULL k0, ULL k1)  // static
+{
+    ULL h = k0 ^ ( k1 * 0x9e3779b97f4a7c15ull ) ;
+    h ^= h >> 30 ; h *= 0xbf58476d1ce4e5b9ull ;
+    h ^= h >> 27 ; h *= 0x94d049bb133111ebull ;
+    h ^= h >> 31 ;
+    return h ;
+}
+
+inline sseq_index_hash::sseq_index_hash(size_t capacity)
+    :
+    mask(0),
+    num(0)
+{
+    size_t cap = 16 ;
+    while( cap < capacity ) cap <<= 1 ;
+    s.resize(cap, {0ull, 0ull, {0, 0}} );
+    mask = cap - 1 ;
+}
+
+/**
+sseq_index_hash::add
+-----------------------
+
+When the key is already present the count is incremented and the
+index of first occurrence is the minimum of the two. That makes the
+merge of tables from multiple threads independent of merge order.
+
+**/
+
+inline void sseq_index_hash::add( const sseq& q, int index, int count )
+{
+    if( 2*(num + 1) > s.size() ) grow();
+
+    ULL k0 = q.seqhis[0] ;
+    ULL k1 = q.seqhis[1] ;
+    size_t i = Hash(k0, k1) & mask ;
+    while( s[i].ic.count > 0 )
+    {
+        slot& e = s[i] ;
+        if( e.k0 == k0 && e.k1 == k1 )
+        {
+            e.ic.count += count ;
+            if( index < e.ic.index ) e.ic.index = index ;
+            return ;
+        }
+        i = ( i + 1 ) & mask ;
+    }
+    s[i] = { k0, k1, { index, count } } ;
+    num += 1 ;
+}
+
+inline void sseq_index_hash::grow()
+{
+    std::vector<slot> old ;
+    old.swap(s);
+    s.resize( 2*old.size(), {0ull, 0ull, {0, 0}} );
+    mask = s.size() - 1 ;
+    for(size_t j=0 ; j < old.size() ; j++)
+    {
+        const slot& e = old[j] ;
+        if( e.ic.count == 0 ) continue ;
+        size_t i = Hash(e.k0, e.k1) & mask ;
+        while( s[i].ic.count > 0 ) i = ( i + 1 ) & mask ;
+        s[i] = e ;
+    }
+}
+
+
 struct sseq_index
 {
+    static constexpr const char* MAP_ = "sseq_index__MAP" ;
+    static constexpr const char* THREADS_ = "sseq_index__THREADS" ;
+
     std::vector<sseq> q ;                   // typically large input array 
 
-    std::map<sseq, sseq_index_count> m ;  // map of unique sseq with counts and first indices
+    std::map<sseq, sseq_index_count> m ;  // map of unique sseq with counts and first indices, only with count_unique
     std::vector<sseq_unique> u ;            // descending count ordered vector of sseq_unique 
 
     sseq_index( const NP* seq); 
+    sseq_index( const NP* seq, bool use_map, int num_threads ); 
 
     void load_seq( const NP* seq ); 
+
     void count_unique(); 
     void order_seq();
+
+    void count_unique_hash(int num_threads); 
+    void order_seq_hash(); 
+
     std::string desc(int min_count=0) const; 
 }; 
 
 
 inline sseq_index::sseq_index( const NP* seq)
+    :
+    sseq_index(seq, ssys::getenvbool(MAP_), ssys::getenvint(THREADS_, 0))
+{
+}
+
+inline sseq_index::sseq_index( const NP* seq, bool use_map, int num_threads )
 {
     load_seq(seq); 
-    count_unique(); 
-    order_seq(); 
+    if(use_map)
+    {
+        count_unique(); 
+        order_seq(); 
+    }
+    else
+    {
+        count_unique_hash(num_threads); 
+        order_seq_hash(); 
+    }
 }
 
 
@@ -191,6 +337,94 @@ inline void sseq_index::order_seq()
     std::sort( u.begin(), u.end(), descending_order  ); 
 }
 
+
+/**
+sseq_index::count_unique_hash
+-------------------------------
+
+1. split q into contiguous ranges, one per thread
+2. each thread counts its range into its own sseq_index_hash
+3. merge the per-thread tables into the first
+4. collect the unique entries into u, using the sseq of first occurrence
+   as the map does  
+
+Merging keeps the minimum index so first occurrence indices match
+the serial map count. num_threads <= 0 uses hardware_concurrency.
+
+**/
+
+inline void sseq_index::count_unique_hash(int num_threads)
+{
+    int64_t num = q.size() ; 
+    int nt = num_threads > 0 ? num_threads : int(std::thread::hardware_concurrency()) ; 
+    if( nt < 1 ) nt = 1 ; 
+    if( num < 100000 ) nt = 1 ;   // thread overhead not worthwhile for small arrays 
+
+    std::vector<sseq_index_hash> h(nt) ; 
+
+    auto count_range = [this, &h, num, nt](int t)
+    {
+        int64_t i0 = num*t/nt ; 
+        int64_t i1 = num*(t+1)/nt ; 
+        sseq_index_hash& ht = h[t] ; 
+        for(int64_t i=i0 ; i < i1 ; i++) ht.add( q[i], int(i), 1 ); 
+    };
+
+    if( nt == 1 )
+    {
+        count_range(0); 
+    }
+    else
+    {
+        std::vector<std::thread> threads ; 
+        for(int t=0 ; t < nt ; t++) threads.emplace_back( count_range, t ); 
+        for(int t=0 ; t < nt ; t++) threads[t].join(); 
+    }
+
+    sseq_index_hash& h0 = h[0] ; 
+    for(int t=1 ; t < nt ; t++)
+    {
+        const sseq_index_hash& ht = h[t] ; 
+        for(size_t j=0 ; j < ht.s.size() ; j++)
+        {
+            const sseq_index_hash::slot& e = ht.s[j] ; 
+            if( e.ic.count == 0 ) continue ; 
+            h0.add( q[e.ic.index], e.ic.index, e.ic.count ); 
+        }
+    }
+
+    u.clear(); 
+    u.reserve( h0.num ); 
+    for(size_t j=0 ; j < h0.s.size() ; j++)
+    {
+        const sseq_index_hash::slot& e = h0.s[j] ; 
+        if( e.ic.count == 0 ) continue ; 
+        u.push_back( { q[e.ic.index], e.ic } ); 
+    }
+}
+
+/**
+sseq_index::order_seq_hash
+----------------------------
+
+1. sort u into sseq key order, the order of std::map iteration  
+2. sort u into descending count order
+
+As the first sort gives the same sequence as order_seq
+collects from the map, the second sort gives identical ordering,
+including among equal counts. 
+
+**/
+
+inline void sseq_index::order_seq_hash()
+{
+    auto key_order = [](const sseq_unique& a, const sseq_unique& b) { return a.q < b.q ; } ; 
+    std::sort( u.begin(), u.end(), key_order ); 
+
+    auto descending_order = [](const sseq_unique& a, const sseq_unique& b) { return a.ic.count > b.ic.count ; } ; 
+    std::sort( u.begin(), u.end(), descending_order  ); 
+}
+
 inline std::string sseq_index::desc(int min_count) const
 {
     std::stringstream ss ; 
@@ -0,0 +1,674 @@
+#pragma once
+/**
+stimeline.h : low overhead trace event recorder with Chrome trace JSON and NP export
+=======================================================================================
+
+Complements the sprof.h stamps, SEvt setMetaProf strings and SProfile.h arrays
+which each cost a /proc/self/status read or a metadata string per stamp.
+Here events are appended to per-thread ring buffers with no locks and no
+allocation on the recording path, so the markers can be left in place
+and switched on in production running.
+
+Usage::
+
+    #include "stimeline.h"
+
+    void SEvt::gather()
+    {
+        STIMELINE_SCOPE("SEvt::gather");   // complete event : begin and end ns
+        ...
+    }
+
+    STIMELINE_COUNTER("num_hit", num_hit );    // counter event
+    STIMELINE_INSTANT("SEvt::save", 0 );       // instant event
+
+    stimeline::Save(dir);   // stimeline.npy stimeline_names.txt stimeline.json
+
+Configure with envvars::
+
+    export stimeline__ENABLE=1          # default 0 : markers cost one branch
+    export stimeline__CAPACITY=65536    # events per thread ring, rounded up to power of two
+    export stimeline__SAMPLE_MS=100     # >0 : start /proc sampler thread with this period
+
+Events
+    (t0 ns, t1 ns, name id, thread, kind, value) with times from the system clock,
+    same epoch as sstamp::Now microseconds allowing comparison with sprof stamps.
+    Kinds are COMPLETE (scoped marker), INSTANT and COUNTER.
+
+Rings
+    each recording thread registers a ring on first use (the only lock).
+    Only the owning thread writes, the head is published with release ordering.
+    When full the oldest events are overwritten and counted as dropped.
+    Rings are kept after threads exit so their events can still be exported.
+
+Names
+    string labels are interned into small integer ids under a lock,
+    the STIMELINE_SCOPE, STIMELINE_COUNTER and STIMELINE_INSTANT macros do this
+    once per call site with a function static and then record by id.
+    The const char* Instant and Counter intern on every call, use them only
+    for labels that are not fixed at the call site.
+
+Sampler
+    /proc/self/status reading is too slow for every marker so the optional sampler
+    thread reads it with sproc::Query on its own cadence, recording VmSize and VmRSS
+    counter events and caching the values for stimeline::Proc.
+
+Export
+    Array : (num_event,6) int64 with columns labels and the interned names
+    as NP names, loadable by sreport which summarizes it with stimeline::Summary.
+
+    ChromeJSON : Chrome trace event format viewable with chrome://tracing or https://ui.perfetto.dev
+
+**/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
+#include <algorithm>
+
+#include "sproc.h"
+#include "NP.hh"
+
+
+struct stimeline_event
+{
+    int64_t t0 ;
+    int64_t t1 ;
+    int32_t name ;
+    int16_t tid ;
+    int16_t kind ;
+    int64_t value ;
+};
+
+struct stimeline_ring
+{
+    int                          tid ;
+    uint64_t                     mask ;
+    std::vector<stimeline_event> ev ;
+    std::atomic<uint64_t>        head ;
+
+    stimeline_ring(int tid, uint64_t capacity);
+    void push(const stimeline_event& e);
+    uint64_t num_stored() const ;
+    uint64_t num_dropped() const ;
+};
+
+inline stimeline_ring::stimeline_ring(int tid_, uint64_t capacity)
+    :
+    tid(tid_),
+    mask(capacity - 1),
+    ev(capacity),
+    head(0)
+{
+}
+
+inline void stimeline_ring::push(const stimeline_event& e)
+{
+    uint64_t h = head.load(std::memory_order_relaxed) ;   // only the owning thread writes
+    ev[h & mask] = e ;
+    head.store(h + 1, std::memory_order_release) ;
+}
+
+inline uint64_t stimeline_ring::num_stored() const
+{
+    uint64_t h = head.load(std::memory_order_acquire) ;
+    return std::min( h, mask + 1 ) ;
+}
+
+inline uint64_t stimeline_ring::num_dropped() const
+{
+    uint64_t h = head.load(std::memory_order_acquire) ;
+    return h > mask + 1 ? h - mask - 1 : 0 ;
+}
+
+
+struct stimeline
+{
+    enum { COMPLETE, INSTANT, COUNTER, NUM_KIND } ;
+    static constexpr const char* ENABLE_ = "stimeline__ENABLE" ;
+    static constexpr const char* CAPACITY_ = "stimeline__CAPACITY" ;
+    static constexpr const char* SAMPLE_MS_ = "stimeline__SAMPLE_MS" ;
+    static constexpr const char* NAME = "stimeline.npy" ;
+    static constexpr const char* JSON = "stimeline.json" ;
+    static constexpr const int NUM_COL = 6 ;
+
+    bool                      enabled ;
+    uint64_t                  capacity ;
+    std::mutex                mtx ;          // guards rings and names, not used on the recording path
+    std::vector<stimeline_ring*> rings ;
+    std::vector<std::string>  names ;
+    std::unordered_map<std::string,int32_t> name_index ;
+
+    std::atomic<int32_t>      proc_vm ;     // KB, cached by sampler
+    std::atomic<int32_t>      proc_rs ;
+    std::atomic<bool>         sampler_run ;
+    int                       sampler_period_ms ;
+    std::thread               sampler ;
+    std::mutex                sampler_mtx ;
+    std::condition_variable   sampler_cv ;
+
+    static stimeline* Get();
+    static bool Enabled();
+    static int64_t Now();
+    static const char* KindName(int kind);
+
+    static int32_t Name(const char* label);
+    static void Complete(int32_t name, int64_t t0, int64_t t1, int64_t value=0);
+    static void Instant(int32_t name, int64_t value=0);
+    static void Counter(int32_t name, int64_t value);
+    static void Instant(const char* label, int64_t value=0);
+    static void Counter(const char* label, int64_t value);
+    static void Proc(int32_t& vm, int32_t& rs);
+
+    static NP*  Array();
+    static std::string ChromeJSON();
+    static void Save(const char* dir);
+    static void Clear();
+    static NP*  Summary(const NP* a);
+    static std::string JSONEscape(const std::string& s);
+
+    stimeline();
+    ~stimeline();
+
+    int32_t name(const char* label);
+    stimeline_ring* ring();
+    void push(const stimeline_event& e);
+
+    void start_sampler(int period_ms);
+    int  stop_sampler();
+    void sample();
+
+    NP*  array();
+    std::string chrome_json();
+    std::string desc();
+};
+
+
+struct stimeline_scope
+{
+    int32_t name ;
+    int64_t t0 ;
+    stimeline_scope(int32_t name_) : name(name_), t0(stimeline::Enabled() ? stimeline::Now() : 0) {}
+    ~stimeline_scope(){ if(t0 > 0) stimeline::Complete(name, t0, stimeline::Now()) ; }
+};
+
+#define STIMELINE_CAT_(a,b) a##b
+#define STIMELINE_CAT(a,b) STIMELINE_CAT_(a,b)
+#define STIMELINE_SCOPE(label) \
+    static const int32_t STIMELINE_CAT(stimeline_name_,__LINE__) = stimeline::Name(label) ; \
+    stimeline_scope STIMELINE_CAT(stimeline_scope_,__LINE__)( STIMELINE_CAT(stimeline_name_,__LINE__) )
+#define STIMELINE_COUNTER(label, value) \
+    do { static const int32_t stimeline_name_ = stimeline::Name(label) ; stimeline::Counter( stimeline_name_, (value) ) ; } while(0)
+#define STIMELINE_INSTANT(label, value) \
+    do { static const int32_t stimeline_name_ = stimeline::Name(label) ; stimeline::Instant( stimeline_name_, (value) ) ; } while(0)
+
+
+/**
+stimeline::Get
+----------------
+
+Function static instance, intentionally never deleted so markers
+in static destructors and detached threads remain safe.
+
+**/
+
+inline stimeline* stimeline::Get() // static
+{
+    static stimeline* INSTANCE = new stimeline ;
+    return INSTANCE ;
+}
+
+inline bool stimeline::Enabled() // static
+{
+    return Get()->enabled ;
+}
+
+inline int64_t stimeline::Now() // static
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() ;
+}
+
+inline const char* stimeline::KindName(int kind) // static
+{
+    const char* s = nullptr ;
+    switch(kind)
+    {
+        case COMPLETE: s = "COMPLETE" ; break ;
+        case INSTANT:  s = "INSTANT"  ; break ;
+        case COUNTER:  s = "COUNTER"  ; break ;
+    }
+    return s ;
+}
+
+inline int32_t stimeline::Name(const char* label){ return Get()->name(label) ; } // static
+
+inline void stimeline::Complete(int32_t name, int64_t t0, int64_t t1, int64_t value) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled) return ;
+    stimeline_event e = { t0, t1, name, 0, COMPLETE, value } ;
+    tl->push(e) ;
+}
+
+inline void stimeline::Instant(int32_t name, int64_t value) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled) return ;
+    int64_t t = Now() ;
+    stimeline_event e = { t, t, name, 0, INSTANT, value } ;
+    tl->push(e) ;
+}
+
+inline void stimeline::Counter(int32_t name, int64_t value) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled) return ;
+    int64_t t = Now() ;
+    stimeline_event e = { t, t, name, 0, COUNTER, value } ;
+    tl->push(e) ;
+}
+
+inline void stimeline::Instant(const char* label, int64_t value) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled) return ;
+    Instant( tl->name(label), value );
+}
+
+inline void stimeline::Counter(const char* label, int64_t value) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled) return ;
+    Counter( tl->name(label), value );
+}
+
+/**
+stimeline::Proc
+-----------------
+
+Cached VmSize and VmRSS in KB from the sampler thread, or a direct
+sproc::Query when the sampler is not running.
+
+**/
+
+inline void stimeline::Proc(int32_t& vm, int32_t& rs) // static
+{
+    stimeline* tl = Get() ;
+    if(tl->sampler_run.load())
+    {
+        vm = tl->proc_vm.load(std::memory_order_relaxed) ;
+        rs = tl->proc_rs.load(std::memory_order_relaxed) ;
+    }
+    else
+    {
+        sproc::Query(vm, rs) ;
+    }
+}
+
+inline NP* stimeline::Array(){             return Get()->array() ; } // static
+inline std::string stimeline::ChromeJSON(){ return Get()->chrome_json() ; } // static
+
+/**
+stimeline::Save
+-----------------
+
+Writes stimeline.npy (with names sidecar) and stimeline.json into dir.
+Only intended to be called when recording threads are quiescent, eg EndOfRun.
+The sampler thread is stopped while the rings are read, as it would otherwise
+keep overwriting its ring, and is restarted afterwards.
+
+**/
+
+inline void stimeline::Save(const char* dir) // static
+{
+    stimeline* tl = Get() ;
+    if(!tl->enabled || dir == nullptr) return ;
+    int period_ms = tl->stop_sampler() ;
+
+    NP* a = tl->array() ;
+    a->save(dir, NAME) ;
+    delete a ;
+
+    std::string path = std::string(dir) + "/" + JSON ;
+    std::ofstream fp(path.c_str(), std::ios::out);
+    fp << tl->chrome_json() ;
+    fp.close();
+
+    if(period_ms > 0) tl->start_sampler(period_ms) ;
+}
+
+/**
+stimeline::Clear
+------------------
+
+Discards all recorded events. Only for use when no other thread is recording,
+the lock-free writers do not take the lock which only guards the rings vector.
+The sampler thread is stopped during the reset and restarted afterwards.
+
+**/
+
+inline void stimeline::Clear() // static
+{
+    stimeline* tl = Get() ;
+    int period_ms = tl->stop_sampler() ;
+    {
+        std::lock_guard<std::mutex> lock(tl->mtx) ;
+        for(size_t i=0 ; i < tl->rings.size() ; i++) tl->rings[i]->head.store(0) ;
+    }
+    if(period_ms > 0) tl->start_sampler(period_ms) ;
+}
+
+/**
+stimeline::Summary
+--------------------
+
+Reduces an Array of events into (num_name,4) int64 with columns
+count, total, min, max of the COMPLETE durations in ns
+(or the counter values for COUNTER names) with the names as row labels.
+
+**/
+
+inline NP* stimeline::Summary(const NP* a) // static
+{
+    if(a == nullptr || !a->has_shape(-1, NUM_COL)) return nullptr ;
+    const int64_t* ee = a->cvalues<int64_t>() ;
+    int num_event = a->shape[0] ;
+    int num_name = a->names.size() ;
+
+    NP* s = NP::Make<int64_t>( num_name, 4 ) ;
+    int64_t* ss = s->values<int64_t>() ;
+    for(int n=0 ; n < num_name ; n++)
+    {
+        ss[n*4+0] = 0 ;
+        ss[n*4+1] = 0 ;
+        ss[n*4+2] = INT64_MAX ;
+        ss[n*4+3] = INT64_MIN ;
+    }
+    for(int i=0 ; i < num_event ; i++)
+    {
+        const int64_t* e = ee + i*NUM_COL ;
+        int n = int(e[2]) ;
+        if( n < 0 || n >= num_name || e[4] == INSTANT ) continue ;
+        int64_t v = e[4] == COMPLETE ? e[1] - e[0] : e[5] ;
+        ss[n*4+0] += 1 ;
+        ss[n*4+1] += v ;
+        ss[n*4+2] = std::min( ss[n*4+2], v ) ;
+        ss[n*4+3] = std::max( ss[n*4+3], v ) ;
+    }
+    for(int n=0 ; n < num_name ; n++) if(ss[n*4+0] == 0) ss[n*4+2] = ss[n*4+3] = 0 ;
+
+    s->set_names(a->names) ;
+    s->labels = new std::vector<std::string> { "count", "total", "min", "max" } ;
+    return s ;
+}
+
+
+inline stimeline::stimeline()
+    :
+    enabled(false),
+    capacity(1 << 16),
+    proc_vm(0),
+    proc_rs(0),
+    sampler_run(false),
+    sampler_period_ms(0)
+{
+    const char* en = getenv(ENABLE_) ;
+    enabled = en && strcmp(en, "0") != 0 ;
+
+    const char* cap = getenv(CAPACITY_) ;
+    uint64_t c = cap ? strtoull(cap, nullptr, 10) : 0 ;
+    if( c > 0 )
+    {
+        capacity = 1 ;
+        while( capacity < c ) capacity <<= 1 ;
+    }
+
+    const char* ms = getenv(SAMPLE_MS_) ;
+    int period_ms = ms ? atoi(ms) : 0 ;
+    if( enabled && period_ms > 0 ) start_sampler(period_ms) ;
+}
+
+inline stimeline::~stimeline()
+{
+    stop_sampler();
+    for(size_t i=0 ; i < rings.size() ; i++) delete rings[i] ;
+}
+
+inline int32_t stimeline::name(const char* label)
+{
+    std::string k = label ? label : "" ;
+    std::lock_guard<std::mutex> lock(mtx) ;
+    std::unordered_map<std::string,int32_t>::const_iterator it = name_index.find(k) ;
+    if( it != name_index.end() ) return it->second ;
+    int32_t id = names.size() ;
+    names.push_back(k) ;
+    name_index[k] = id ;
+    return id ;
+}
+
+/**
+stimeline::ring
+-----------------
+
+Ring of the calling thread, registered on first use.
+
+**/
+
+inline stimeline_ring* stimeline::ring()
+{
+    static thread_local stimeline_ring* r = nullptr ;
+    if( r == nullptr )
+    {
+        std::lock_guard<std::mutex> lock(mtx) ;
+        r = new stimeline_ring( int(rings.size()), capacity ) ;
+        rings.push_back(r) ;
+    }
+    return r ;
+}
+
+inline void stimeline::push(const stimeline_event& e_)
+{
+    stimeline_ring* r = ring() ;
+    stimeline_event e = e_ ;
+    e.tid = int16_t(r->tid) ;
+    r->push(e) ;
+}
+
+inline void stimeline::start_sampler(int period_ms)
+{
+    if(sampler_run.load()) return ;
+    sample();   // prime the cache before publishing sampler_run
+    sampler_period_ms = period_ms ;
+    sampler_run.store(true) ;
+    sampler = std::thread( [this, period_ms]()
+    {
+        std::unique_lock<std::mutex> lock(sampler_mtx) ;
+        while(sampler_run.load())
+        {
+            sample();
+            sampler_cv.wait_for( lock, std::chrono::milliseconds(period_ms) ) ;
+        }
+    });
+}
+
+/**
+stimeline::stop_sampler
+-------------------------
+
+Returns the period of the stopped sampler or 0 when it was not running,
+allowing callers to restart it with start_sampler.
+
+**/
+
+inline int stimeline::stop_sampler()
+{
+    if(!sampler_run.load()) return 0 ;
+    {
+        std::lock_guard<std::mutex> lock(sampler_mtx) ;
+        sampler_run.store(false) ;
+    }
+    sampler_cv.notify_all();
+    if(sampler.joinable()) sampler.join();
+    return sampler_period_ms ;
+}
+
+inline void stimeline::sample()
+{
+    static const int32_t VM = name("VmSize") ;
+    static const int32_t RS = name("VmRSS") ;
+    int32_t vm = 0 ;
+    int32_t rs = 0 ;
+    sproc::Query(vm, rs) ;
+    proc_vm.store(vm, std::memory_order_relaxed) ;
+    proc_rs.store(rs, std::memory_order_relaxed) ;
+    if(!enabled) return ;
+    int64_t t = Now() ;
+    stimeline_event e0 = { t, t, VM, 0, COUNTER, vm } ;
+    stimeline_event e1 = { t, t, RS, 0, COUNTER, rs } ;
+    push(e0) ;
+    push(e1) ;
+}
+
+/**
+stimeline::array
+------------------
+
+Events of all rings, ring by ring oldest first.
+
+**/
+
+inline NP* stimeline::array()
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    uint64_t num = 0 ;
+    for(size_t i=0 ; i < rings.size() ; i++) num += rings[i]->num_stored() ;
+
+    NP* a = NP::Make<int64_t>( int(num), NUM_COL ) ;
+    int64_t* aa = a->values<int64_t>() ;
+    uint64_t dropped = 0 ;
+    uint64_t k = 0 ;
+    for(size_t i=0 ; i < rings.size() ; i++)
+    {
+        const stimeline_ring* r = rings[i] ;
+        uint64_t h = r->head.load(std::memory_order_acquire) ;
+        uint64_t n = r->num_stored() ;
+        dropped += r->num_dropped() ;
+        for(uint64_t j=h-n ; j < h ; j++)
+        {
+            const stimeline_event& e = r->ev[j & r->mask] ;
+            int64_t* v = aa + NUM_COL*k++ ;
+            v[0] = e.t0 ;
+            v[1] = e.t1 ;
+            v[2] = e.name ;
+            v[3] = e.tid ;
+            v[4] = e.kind ;
+            v[5] = e.value ;
+        }
+    }
+    a->set_names(names) ;
+    a->labels = new std::vector<std::string> { "t0[ns]", "t1[ns]", "name", "tid", "kind", "value" } ;
+    a->set_meta<int>("num_thread", int(rings.size()) ) ;
+    a->set_meta<uint64_t>("num_dropped", dropped ) ;
+    a->set_meta<uint64_t>("capacity", capacity ) ;
+    return a ;
+}
+
+/**
+stimeline::chrome_json
+------------------------
+
+Chrome trace event format : "X" complete events with microsecond ts and dur,
+"i" instant events, "C" counter events. Times are relative to the first event.
+Names are escaped as runtime labels from Instant and Counter can hold any characters.
+
+**/
+
+inline std::string stimeline::chrome_json()
+{
+    NP* a = array() ;
+    const int64_t* aa = a->cvalues<int64_t>() ;
+    int num = a->shape[0] ;
+    int64_t tmin = INT64_MAX ;
+    for(int i=0 ; i < num ; i++) tmin = std::min( tmin, aa[i*NUM_COL] ) ;
+
+    std::stringstream ss ;
+    ss << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"t0_ns\":" << ( num > 0 ? tmin : 0 ) << "},\"traceEvents\":[" ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const int64_t* e = aa + i*NUM_COL ;
+        const std::string& n = a->names[e[2]] ;   // copy taken under the lock
+        double ts = double(e[0] - tmin)*1e-3 ;
+        ss << ( i == 0 ? "\n" : ",\n" )
+           << "{\"name\":\"" << JSONEscape(n) << "\",\"pid\":0,\"tid\":" << e[3]
+           << ",\"ts\":" << std::fixed << ts
+           ;
+        switch(e[4])
+        {
+            case COMPLETE: ss << ",\"ph\":\"X\",\"dur\":" << double(e[1] - e[0])*1e-3 ; break ;
+            case INSTANT:  ss << ",\"ph\":\"i\",\"s\":\"t\"" ; break ;
+            case COUNTER:  ss << ",\"ph\":\"C\",\"args\":{\"value\":" << e[5] << "}" ; break ;
+        }
+        ss << "}" ;
+    }
+    ss << "\n]}\n" ;
+    delete a ;
+    std::string str = ss.str() ;
+    return str ;
+}
+
+inline std::string stimeline::JSONEscape(const std::string& s) // static
+{
+    std::stringstream ss ;
+    for(size_t i=0 ; i < s.size() ; i++)
+    {
+        unsigned char c = s[i] ;
+        switch(c)
+        {
+            case '"':  ss << "\\\"" ; break ;
+            case '\\': ss << "\\\\" ; break ;
+            case '\n': ss << "\\n"  ; break ;
+            case '\t': ss << "\\t"  ; break ;
+            default:
+                if( c < 0x20 ) ss << "\\u00" << std::hex << std::setw(2) << std::setfill('0') << int(c) << std::dec ;
+                else ss << s[i] ;
+        }
+    }
+    std::string str = ss.str() ;
+    return str ;
+}
+
+inline std::string stimeline::desc()
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    uint64_t num = 0 ;
+    uint64_t dropped = 0 ;
+    for(size_t i=0 ; i < rings.size() ; i++)
+    {
+        num += rings[i]->num_stored() ;
+        dropped += rings[i]->num_dropped() ;
+    }
+    std::stringstream ss ;
+    ss << "stimeline::desc"
+       << " enabled " << ( enabled ? "YES" : "NO " )
+       << " capacity " << capacity
+       << " num_thread " << rings.size()
+       << " num_name " << names.size()
+       << " num_event " << num
+       << " num_dropped " << dropped
+       << " sampler " << ( sampler_run.load() ? "YES" : "NO " )
+       ;
+    std::string str = ss.str() ;
+    return str ;
+}
+
@@ -208,6 +208,7 @@ When SSim not in use can also use::
 #include "scuda.h"
 #include "snode.h"
 #include "sdigest.h"
+#include "sstamp.h"
 #include "sfreq.h"
 #include "sstr.h"
 #include "strid.h"
@@ -480,6 +481,7 @@ struct stree
 
 
     std::string subtree_digest( int nidx ) const ;
+    std::string subtree_digest_merkle( int nidx ) const ;
     static std::string depth_spacer(int depth); 
 
     std::string desc_node_(int nidx, const sfreq* sf ) const ;
@@ -516,6 +518,7 @@ struct stree
 
 
     void classifySubtrees();
+    int  classifySubtrees_check() const ;
     bool is_contained_repeat(const char* sub) const ; 
     void disqualifyContainedRepeats();
     void sortSubtrees(); 
@@ -1947,6 +1950,17 @@ inline int stree::get_first( const char* sub ) const
 }
 
 
+/**
+stree::subtree_digest
+-----------------------
+
+Digest of the lvid of *nidx* and the node digests of all its progeny.
+As every call traverses the whole subtree, calling this for all nodes
+does work proportional to the sum of subtree sizes.
+This is now only used by stree::classifySubtrees_check.
+
+**/
+
 inline std::string stree::subtree_digest(int nidx) const
 {
     std::vector<int> progeny ;
@@ -1958,6 +1972,33 @@ inline std::string stree::subtree_digest(int nidx) const
     return u.finalize() ;
 }
 
+/**
+stree::subtree_digest_merkle
+------------------------------
+
+Digest of the lvid of *nidx*, the node digests of its children
+and the subtree digests of its children, which must already be present
+in the subs vector. The children digests are added before the children
+subtree digests following the layout of the progeny used by stree::subtree_digest.
+
+Nodes have the same merkle digest when their subtrees have the same
+shape with the same node digests, whereas stree::subtree_digest only
+requires the same node digest sequence. As node digests include the lvid
+and nodes with the same lvid have the same daughters these are equivalent,
+which is checked by stree::classifySubtrees_check.
+
+**/
+
+inline std::string stree::subtree_digest_merkle(int nidx) const
+{
+    const snode& nd = nds[nidx] ;
+    sdigest u ;
+    u.add( nd.lvid );
+    for(int ch=nd.first_child ; ch > -1 ; ch=nds[ch].next_sibling ) u.add(digs[ch]) ;
+    for(int ch=nd.first_child ; ch > -1 ; ch=nds[ch].next_sibling ) u.add(subs[ch]) ;  // preorder : ch > nidx
+    return u.finalize() ;
+}
+
 inline std::string stree::depth_spacer(int depth) // static
 {
     std::string spacer(MAXDEPTH, ' ');  
@@ -2381,21 +2422,84 @@ stree::classifySubtrees
 
 This is invoked by stree::factorize
 
-Traverse all nodes, computing and collecting subtree digests and adding them to subs_freq
-to find the top repeaters.  
+1. compute subtree digests for all nodes in a single bottom up pass,
+   as children always have higher node indices than their parent the
+   reverse node order visits children before parents 
+2. add subtree digests to subs_freq in node order to find the top repeaters
+
+The subtree digests are computed with stree::subtree_digest_merkle
+from the already computed subtree digests of the children, so the 
+total work is proportional to the number of nodes. 
+
+For validation of the subtree equivalence classes against the former
+full progeny digests (which is slow for large trees) use::
+
+    export stree__classifySubtrees_CHECK=1
 
 **/
 
 inline void stree::classifySubtrees()
 {
     if(level>0) std::cout << "[ stree::classifySubtrees " << std::endl ;
-    for(int nidx=0 ; nidx < int(nds.size()) ; nidx++)
+    int64_t t0 = sstamp::Now(); 
+
+    int num_nd = nds.size() ; 
+    subs.resize(num_nd) ; 
+    for(int nidx=num_nd-1 ; nidx > -1 ; nidx--) subs[nidx] = subtree_digest_merkle(nidx) ;  
+
+    int64_t t1 = sstamp::Now(); 
+    for(int nidx=0 ; nidx < num_nd ; nidx++) subs_freq->add(subs[nidx].c_str());
+    int64_t t2 = sstamp::Now(); 
+
+    if(level>0) std::cout 
+        << "] stree::classifySubtrees "
+        << " num_nd " << num_nd 
+        << " digest_us " << ( t1 - t0 )
+        << " freq_us " << ( t2 - t1 )
+        << std::endl 
+        ;
+
+    bool check = ssys::getenvbool("stree__classifySubtrees_CHECK") ; 
+    if(check)
     {
-        std::string sub = subtree_digest(nidx) ;
-        subs.push_back(sub) ;
-        subs_freq->add(sub.c_str());
+        int mismatch = classifySubtrees_check() ;  
+        std::cout << "stree::classifySubtrees_check mismatch " << mismatch << std::endl ;  
+        assert( mismatch == 0 ); 
     }
-    if(level>0) std::cout << "] stree::classifySubtrees " << std::endl ;
+}
+
+/**
+stree::classifySubtrees_check
+-------------------------------
+
+Returns the number of nodes for which the equivalence classes 
+from stree::subtree_digest and the subs from stree::subtree_digest_merkle
+differ. The classes match when there is a one-to-one mapping between 
+the two digests.
+
+**/
+
+inline int stree::classifySubtrees_check() const
+{
+    std::map<std::string, std::string> p2m ; 
+    std::map<std::string, std::string> m2p ; 
+
+    int mismatch = 0 ; 
+    int num_nd = nds.size() ; 
+    for(int nidx=0 ; nidx < num_nd ; nidx++)
+    {
+        std::string p = subtree_digest(nidx) ;
+        const std::string& m = subs[nidx] ; 
+
+        auto pm = p2m.find(p) ; 
+        auto mp = m2p.find(m) ; 
+        if( pm == p2m.end() ) p2m[p] = m ; 
+        if( mp == m2p.end() ) m2p[m] = p ; 
+
+        bool ok = ( pm == p2m.end() || pm->second == m ) && ( mp == m2p.end() || mp->second == p ) ; 
+        if(!ok) mismatch += 1 ; 
+    }
+    return mismatch ; 
 }
 
 
@@ -2495,32 +2599,34 @@ inline void stree::disqualifyContainedRepeats()
 stree_subs_freq_ordering
 ------------------------
 
-Used from stree::sortSubtrees ordering (sub, freq) based on:
+Used from stree::sortSubtrees ordering indices into 
+subs_freq (sub, freq) pairs based on:
 
-1. nidx obtained from stree::get_first(sub:subtree_digest)
+1. nidx of first node with the sub:subtree_digest
 2. freq:frequency count 
 
 It is necessary to use two level ordering 
 to ensure that same order is achieved 
 on different machines. 
 
+The first node indices are collected once into *first* 
+by stree::sortSubtrees rather than searching the subs 
+vector from stree::get_first for every comparison. 
+
 **/
 
 struct stree_subs_freq_ordering
 {
-    const stree* st ; 
-    stree_subs_freq_ordering( const stree* st_ ) : st(st_) {} ; 
+    const sfreq::VSU& vsu ; 
+    const std::vector<int>& first ; 
+    stree_subs_freq_ordering( const sfreq::VSU& vsu_, const std::vector<int>& first_ ) : vsu(vsu_), first(first_) {} ; 
 
-    bool operator()(
-        const std::pair<std::string,int>& a, 
-        const std::pair<std::string,int>& b ) const 
+    bool operator()( int a, int b ) const 
     {
-        const char* a_sub = a.first.c_str(); 
-        const char* b_sub = b.first.c_str(); 
-        int a_nidx = st->get_first(a_sub);  
-        int b_nidx = st->get_first(b_sub);  
-        int a_freq = a.second ; 
-        int b_freq = b.second ; 
+        int a_nidx = first[a] ;  
+        int b_nidx = first[b] ;  
+        int a_freq = vsu[a].second ; 
+        int b_freq = vsu[b].second ; 
 
         return a_freq == b_freq ?  b_nidx > a_nidx : a_freq > b_freq ; 
     }
@@ -2539,9 +2645,23 @@ inline void stree::sortSubtrees()  // hmm sortSubtreeDigestFreq would be more ac
 {
     if(level > 0) std::cout << "[ stree::sortSubtrees " << std::endl ;
 
-    stree_subs_freq_ordering ordering(this) ;  
-    sfreq::VSU& vsu = subs_freq->vsu ; 
-    std::sort( vsu.begin(), vsu.end(), ordering );
+    const sfreq::VSU& vsu = subs_freq->vsu ; 
+    int num = vsu.size() ; 
+
+    std::vector<int> first(num, -1) ; 
+    for(int nidx=0 ; nidx < int(subs.size()) ; nidx++)
+    {
+        int idx = subs_freq->find_index(subs[nidx].c_str()) ; 
+        assert( idx > -1 ); 
+        if( first[idx] == -1 ) first[idx] = nidx ; 
+    }
+
+    std::vector<int> order(num) ; 
+    for(int i=0 ; i < num ; i++) order[i] = i ; 
+
+    stree_subs_freq_ordering ordering(vsu, first) ;  
+    std::sort( order.begin(), order.end(), ordering );
+    subs_freq->reorder(order); 
 
     if(level > 0) std::cout << "] stree::sortSubtrees " << std::endl ;
 }
@@ -2702,15 +2822,27 @@ collectRemainderNodes
 inline void stree::factorize()
 {
     if(level>0) std::cout << "[ stree::factorize " << std::endl ;
+    int64_t t0 = sstamp::Now(); 
     classifySubtrees(); 
+    int64_t t1 = sstamp::Now(); 
     disqualifyContainedRepeats();
+    int64_t t2 = sstamp::Now(); 
     sortSubtrees(); 
+    int64_t t3 = sstamp::Now(); 
     enumerateFactors(); 
     labelFactorSubtrees(); 
     collectRemainderNodes(); 
+    int64_t t4 = sstamp::Now(); 
 
     if(level>0) std::cout << desc_factor() << std::endl ;
-    if(level>0) std::cout << "] stree::factorize " << std::endl ;
+    if(level>0) std::cout 
+        << "] stree::factorize "
+        << " classifySubtrees_us " << ( t1 - t0 ) 
+        << " disqualifyContainedRepeats_us " << ( t2 - t1 ) 
+        << " sortSubtrees_us " << ( t3 - t2 ) 
+        << " label_us " << ( t4 - t3 ) 
+        << std::endl 
+        ;
 }
 
 
@@ -0,0 +1,138 @@
+/**
+NPFold_concurrent_test.cc
+===========================
+
+Saves and loads a fold tree of many arrays and nested subfolds sequentially
+and with NPFold::SetThreads, checking that the loaded folds have the same
+keys in the same order with the same array content, with and without index.
+
+::
+
+    ~/opticks/sysrap/tests/NPFold_concurrent_test.sh
+
+**/
+
+#include <chrono>
+#include "NPFold.h"
+
+struct NPFold_concurrent_test
+{
+    static NPFold* Make(int depth, int num_arr, int num_sub, int seed ); 
+    static int Compare_r(const NPFold* a, const NPFold* b, int depth ); 
+    static void RemoveIndex_r(const NPFold* f, const char* base ); 
+    static double Save(const NPFold* f, const char* base, int threads ); 
+    static NPFold* Load(const char* base, int threads, double& ms ); 
+    static int main(); 
+};
+
+NPFold* NPFold_concurrent_test::Make(int depth, int num_arr, int num_sub, int seed )
+{
+    NPFold* f = new NPFold ; 
+    for(int i=0 ; i < num_arr ; i++)
+    {
+        NP* a = NP::Make<float>( 100 + i, 4 ) ; 
+        float* v = a->values<float>() ; 
+        for(size_t j=0 ; j < a->num_values() ; j++) v[j] = float(seed*1000 + i*10 + j) ; 
+        std::string key = U::FormName_("arr_", num_arr - i, ".npy" ) ;  // reverse order to distinguish index from dirlist order 
+        f->add( key.c_str(), a ); 
+    }
+    if( depth > 0 ) for(int i=0 ; i < num_sub ; i++)
+    {
+        std::string key = U::FormName_("sub_", num_sub - i, "" ) ; 
+        f->add_subfold( key.c_str(), Make(depth - 1, num_arr, num_sub, seed*10 + i) ); 
+    }
+    return f ; 
+}
+
+int NPFold_concurrent_test::Compare_r(const NPFold* a, const NPFold* b, int depth )
+{
+    int rc = NPFold::Compare(a, b) == 0 ? 0 : 1 ; 
+    bool same_sub = a->ff == b->ff ; 
+    if(!same_sub) std::cout << "NPFold_concurrent_test::Compare_r subfold keys differ at depth " << depth << std::endl ; 
+    if(!same_sub) return rc + 1 ; 
+    for(unsigned i=0 ; i < a->ff.size() ; i++) rc += Compare_r( a->subfold[i], b->subfold[i], depth + 1 ); 
+    return rc ; 
+}
+
+/**
+NPFold_concurrent_test::RemoveIndex_r
+---------------------------------------
+
+Removes the index and names files so loading uses NPFold::load_dir,
+the names file is removed as it would otherwise be loaded as a txt array.
+
+**/
+
+void NPFold_concurrent_test::RemoveIndex_r(const NPFold* f, const char* base )
+{
+    std::string idx = U::form_path(base, NPFold::INDEX) ; 
+    std::string nam = U::form_path(base, NPFold::NAMES) ; 
+    remove(idx.c_str()); 
+    remove(nam.c_str()); 
+    for(unsigned i=0 ; i < f->ff.size() ; i++) 
+    {
+        std::string sub = U::form_path(base, f->ff[i].c_str()) ; 
+        RemoveIndex_r( f->subfold[i], sub.c_str() ); 
+    }
+}
+
+double NPFold_concurrent_test::Save(const NPFold* f, const char* base, int threads )
+{
+    NPFold::SetThreads(threads); 
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+    const_cast<NPFold*>(f)->save(base); 
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() ; 
+}
+
+NPFold* NPFold_concurrent_test::Load(const char* base, int threads, double& ms )
+{
+    NPFold::SetThreads(threads); 
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+    NPFold* f = NPFold::Load(base); 
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+    ms = std::chrono::duration<double, std::milli>(t1 - t0).count() ; 
+    return f ; 
+}
+
+int NPFold_concurrent_test::main()
+{
+    int threads = U::GetEnvInt("THREADS", 8) ; 
+    const char* fold = U::GetEnv("FOLD", "/tmp/NPFold_concurrent_test") ; 
+    std::string seq = U::form_path(fold, "seq") ; 
+    std::string con = U::form_path(fold, "con") ; 
+
+    NPFold* f = Make( 2, 20, 4, 1 ) ; 
+
+    double seq_save = Save(f, seq.c_str(), 0 ); 
+    double con_save = Save(f, con.c_str(), threads ); 
+
+    int rc = 0 ; 
+    double ms[4] ; 
+    NPFold* a = Load( seq.c_str(), 0, ms[0] ); 
+    NPFold* b = Load( con.c_str(), threads, ms[1] ); 
+    rc += Compare_r( f, a, 0 ); 
+    rc += Compare_r( f, b, 0 ); 
+
+    // without index the order follows the directory listing in both modes
+    RemoveIndex_r( f, con.c_str() ); 
+    NPFold* c = Load( con.c_str(), 0, ms[2] ); 
+    NPFold* d = Load( con.c_str(), threads, ms[3] ); 
+    rc += Compare_r( c, d, 0 ); 
+
+    std::cout 
+        << "NPFold_concurrent_test::main"
+        << " threads " << threads 
+        << " seq_save_ms " << seq_save 
+        << " con_save_ms " << con_save 
+        << " seq_load_ms " << ms[0] 
+        << " con_load_ms " << ms[1] 
+        << " noindex_seq_load_ms " << ms[2] 
+        << " noindex_con_load_ms " << ms[3] 
+        << " rc " << rc 
+        << std::endl 
+        ;
+    return rc ; 
+}
+
+int main(){ return NPFold_concurrent_test::main() ; }
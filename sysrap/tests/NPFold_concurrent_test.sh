@@ -0,0 +1,37 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+NPFold_concurrent_test.sh
+=========================
+
+~/opticks/sysrap/tests/NPFold_concurrent_test.sh 
+THREADS=16 ~/opticks/sysrap/tests/NPFold_concurrent_test.sh 
+
+EOU
+}
+
+name=NPFold_concurrent_test 
+
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cd $(dirname $BASH_SOURCE)
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -lstdc++ -pthread -I.. -o $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi 
+
+exit 0
+
+
@@ -0,0 +1,107 @@
+// ~/opticks/sysrap/tests/NPStream_test.sh
+
+#include "NPStream.h"
+
+struct NPStream_test
+{
+    static int Append(); 
+    static int Flush(); 
+    static int Mismatch(); 
+    static int Main(); 
+};
+
+/**
+NPStream_test::Append
+-----------------------
+
+Appending batches must give the same file as saving the concatenated array. 
+
+**/
+
+inline int NPStream_test::Append()
+{
+    NPStream st ; 
+    int rc = st.open<float>("$FOLD/Append/s.npy", {4,4} ); 
+    assert( rc == 0 ); 
+    st.meta = "creator:NPStream_test::Append\n" ; 
+
+    std::vector<NP*> aa ; 
+    int offset = 0 ; 
+    for(int i=0 ; i < 10 ; i++)
+    {
+        int ni = 1000*(i+1) ; 
+        NP* a = NP::Make<float>(ni, 4, 4 ); 
+        a->_fillIndexFlat<float>(offset) ;  
+        offset += a->num_values() ; 
+        rc = st.append(a); 
+        assert( rc == 0 ); 
+        aa.push_back(a) ; 
+    }
+    std::cout << st.desc() << std::endl ; 
+    rc = st.close(); 
+    assert( rc == 0 ); 
+
+    NP* s = NP::Load("$FOLD/Append/s.npy") ; 
+    NP* c = NP::Concatenate(aa) ; 
+
+    std::cout << " s " << s->sstr() << std::endl ; 
+    std::cout << " c " << c->sstr() << std::endl ; 
+    assert( s->shape == c->shape ); 
+    assert( NP::Memcmp(s, c) == 0 ); 
+    assert( s->meta == st.meta ); 
+    return 0 ; 
+}
+
+/**
+NPStream_test::Flush
+----------------------
+
+After flush the file is loadable with the items appended so far. 
+
+**/
+
+inline int NPStream_test::Flush()
+{
+    NPStream st ; 
+    st.open<int>("$FOLD/Flush/s.npy", {4} ); 
+
+    NP* a = NP::Make<int>(5, 4) ; 
+    a->fillIndexFlat(); 
+    st.append(a); 
+    st.flush(); 
+
+    NP* b = NP::Load("$FOLD/Flush/s.npy") ; 
+    assert( b->shape[0] == 5 ); 
+    assert( NP::Memcmp(a, b) == 0 ); 
+
+    st.append(a); 
+    st.close(); 
+
+    NP* c = NP::Load("$FOLD/Flush/s.npy") ; 
+    assert( c->shape[0] == 10 ); 
+    return 0 ; 
+}
+
+inline int NPStream_test::Mismatch()
+{
+    NPStream st ; 
+    st.open<float>("$FOLD/Mismatch/s.npy", {4,4} ); 
+    NP* a = NP::Make<float>(5, 4) ; 
+    int rc = st.append(a); 
+    assert( rc == 1 ); 
+    st.close(); 
+    return 0 ; 
+}
+
+inline int NPStream_test::Main()
+{
+    const char* TEST = U::GetEnv("TEST", "ALL") ; 
+    bool ALL = strcmp(TEST, "ALL") == 0 ; 
+    int rc = 0 ; 
+    if(ALL || strcmp(TEST, "Append") == 0 )   rc += Append(); 
+    if(ALL || strcmp(TEST, "Flush") == 0 )    rc += Flush(); 
+    if(ALL || strcmp(TEST, "Mismatch") == 0 ) rc += Mismatch(); 
+    return rc ; 
+}
+
+int main(){ return NPStream_test::Main() ; }
@@ -0,0 +1,43 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+NPStream_test.sh
+===================
+
+~/opticks/sysrap/tests/NPStream_test.sh 
+
+Checks NPStream appending of array batches to a .npy file gives
+the same file as saving the concatenated array. 
+
+EOU
+}
+
+name=NPStream_test 
+
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cd $(dirname $BASH_SOURCE)
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+export TEST=${TEST:-ALL}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -lstdc++ -g -I.. -o $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi 
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3
+fi 
+
+exit 0 
@@ -0,0 +1,76 @@
+// ~/opticks/sysrap/tests/NP_large_test.sh
+
+/**
+NP_large_test
+===============
+
+Checks sizes, offsets and header round trip for arrays exceeding 4GB.  
+To avoid needing that much memory the file is written sparse
+(header, then ftruncate, then a single item at the end) and read back 
+with NP::LoadMapped. 
+
+**/
+
+#include "NP.hh"
+
+struct NP_large_test
+{
+    static int Main(); 
+};
+
+inline int NP_large_test::Main()
+{
+    int ni = U::GetEnvInt("NI", 70000000 ) ;  // 70M*64 bytes > 4GB 
+    std::vector<int> shape = { ni, 4, 4 } ; 
+
+    size_t num_values = size_t(ni)*4*4 ; 
+    size_t arr_bytes = num_values*sizeof(float) ; 
+
+    const char* path = U::Resolve("$FOLD/large.npy") ; 
+    U::MakeDirsForFile(path); 
+
+    std::string hdr = NPU::_make_header( shape, "<f4" ); 
+    {
+        std::ofstream fp(path, std::ios::out|std::ios::binary);
+        fp << hdr ; 
+    }
+    int rc = truncate( path, hdr.length() + arr_bytes ); 
+    assert( rc == 0 ); 
+
+    float last[16] ; 
+    for(int i=0 ; i < 16 ; i++) last[i] = float(i) ; 
+    {
+        std::fstream fp(path, std::ios::in|std::ios::out|std::ios::binary);
+        fp.seekp( hdr.length() + arr_bytes - sizeof(last) ); 
+        fp.write( (const char*)last, sizeof(last) ); 
+    }
+
+    NP* a = NP::LoadMapped(path) ; 
+    std::cout << a->desc() << std::endl ; 
+
+    assert( a->mapped ); 
+    assert( a->shape == shape ); 
+    assert( a->num_items() == size_t(ni) ); 
+    assert( a->num_values() == num_values ); 
+    assert( a->arr_bytes() == arr_bytes ); 
+    assert( a->item_bytes() == 64 ); 
+    assert( a->size == int64_t(num_values) ); 
+    assert( a->index(ni-1, 3, 3) == num_values - 1 ); 
+    assert( a->index0(ni-1) == num_values - 16 ); 
+    assert( a->get<float>(ni-1, 3, 3) == 15.f ); 
+    assert( a->get<float>(-1, 2, 1) == 9.f ); 
+    assert( a->get<float>(0, 0, 0) == 0.f ); 
+
+    std::vector<float> sl ; 
+    a->slice(sl, ni-1, 3, -1 );  
+    assert( sl.size() == 4 && sl[3] == 15.f ); 
+
+    NP* b = NP::MakeSelectCopy(a, ni-1) ; 
+    assert( b->num_items() == 1 ); 
+    assert( memcmp( b->bytes(), last, sizeof(last) ) == 0 ); 
+
+    std::cout << "NP_large_test::Main arr_bytes " << a->arr_bytes() << " PASS " << std::endl ; 
+    return 0 ; 
+}
+
+int main(){ return NP_large_test::Main() ; }
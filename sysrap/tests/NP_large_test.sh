@@ -0,0 +1,42 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+NP_large_test.sh
+===================
+
+~/opticks/sysrap/tests/NP_large_test.sh 
+
+Checks arrays larger than 4GB using a sparse file read back
+with NP::LoadMapped, so the test needs little memory or disk.
+
+EOU
+}
+
+name=NP_large_test 
+
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cd $(dirname $BASH_SOURCE)
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -lstdc++ -g -I.. -o $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi 
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3
+fi 
+
+exit 0 
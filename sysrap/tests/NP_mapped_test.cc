@@ -0,0 +1,163 @@
+// ~/opticks/sysrap/tests/NP_mapped_test.sh
+
+#include "sprof.h"
+#include "NPFold.h"
+
+struct NP_mapped_test
+{
+    static constexpr const int M = 1000000 ; 
+
+    static int Load(); 
+    static int LoadFold(); 
+    static int Mutate(); 
+    static int Profile(); 
+
+    static int Main(); 
+};
+
+
+inline int NP_mapped_test::Load()
+{
+    NP* a = NP::Make<float>( 1000, 4, 4 ) ; 
+    a->fillIndexFlat(); 
+    a->set_meta<std::string>("creator", "NP_mapped_test::Load") ; 
+    a->save("$FOLD/Load/a.npy"); 
+
+    NP* b = NP::Load("$FOLD/Load/a.npy") ; 
+    NP* c = NP::LoadMapped("$FOLD/Load/a.npy") ; 
+
+    std::cout << "b " << b->desc() << std::endl ; 
+    std::cout << "c " << c->desc() << std::endl ; 
+
+    assert( b->mapped == false ); 
+    assert( c->mapped == true ); 
+    assert( c->data.size() == 0 ); 
+    assert( NP::Memcmp(b, c) == 0 ); 
+    assert( b->meta == c->meta ); 
+
+    const NP* cc = c ; 
+    const float* vv = cc->cvalues<float>() ; 
+    assert( vv[16*999+15] == float(16*999+15) ); 
+    assert( c->mapped == true ); 
+
+    NP* d = NP::MakeCopy(c) ;  
+    assert( d->mapped == false ); 
+    assert( NP::Memcmp(b, d) == 0 ); 
+
+    return 0 ; 
+}
+
+inline int NP_mapped_test::LoadFold()
+{
+    NPFold* f = new NPFold ; 
+    NPFold* s = new NPFold ; 
+    NP* a = NP::Make<int>(10, 4) ;  a->fillIndexFlat(); 
+    NP* b = NP::Make<double>(5, 2) ; b->fillIndexFlat(); 
+    f->add("a", a); 
+    s->add("b", b); 
+    f->add_subfold("sub", s ); 
+    f->save("$FOLD/LoadFold"); 
+
+    NPFold* g = NPFold::LoadMapped("$FOLD/LoadFold") ; 
+    std::cout << g->desc() << std::endl ; 
+
+    int cf = NPFold::Compare(f, g); 
+    if( cf != 0 ) std::cout << NPFold::DescCompare(f, g) ; 
+    assert( cf == 0 ); 
+
+    const NP* ga = g->get("a") ; 
+    const NP* gb = g->find_array("sub/b.npy") ; 
+    assert( ga && ga->mapped ); 
+    assert( gb && gb->mapped ); 
+    assert( g->mapped ); 
+    return cf ; 
+}
+
+/**
+NP_mapped_test::Mutate
+-------------------------
+
+Mutable access copies the payload into owned data leaving the file untouched. 
+
+**/
+
+inline int NP_mapped_test::Mutate()
+{
+    NP* a = NP::Make<int>(100) ; 
+    a->fillIndexFlat(); 
+    a->save("$FOLD/Mutate/a.npy"); 
+
+    NP* b = NP::LoadMapped("$FOLD/Mutate/a.npy") ; 
+    NP  c = *b ;   // copy shares the mapping  
+
+    int* bb = b->values<int>() ; 
+    assert( b->mapped == false ); 
+    assert( b->data.size() == 100*sizeof(int) ); 
+    bb[0] = 42 ; 
+
+    const NP& cc = c ; 
+    assert( c.mapped == true ); 
+    assert( cc.cvalues<int>()[0] == 0 ); 
+
+    NP* d = NP::Load("$FOLD/Mutate/a.npy") ; 
+    assert( d->cvalues<int>()[0] == 0 ); 
+
+    delete b ; 
+    assert( cc.cvalues<int>()[99] == 99 ); 
+    return 0 ; 
+}
+
+/**
+NP_mapped_test::Profile
+------------------------
+
+Compare time and RSS of ordinary and mapped loads of a large array
+when only touching the first column of every item. 
+
+**/
+
+inline int NP_mapped_test::Profile()
+{
+    int ni = 4*M ; 
+    NP* a = NP::Make<float>( ni, 4, 4 ) ; 
+    a->fillIndexFlat(); 
+    a->save("$FOLD/Profile/a.npy"); 
+    delete a ; 
+
+    sprof p0, p1, p2, p3 ; 
+
+    sprof::Stamp(p0);  
+    NP* b = NP::Load("$FOLD/Profile/a.npy") ; 
+    sprof::Stamp(p1);  
+
+    NP* c = NP::LoadMapped("$FOLD/Profile/a.npy") ; 
+    sprof::Stamp(p2);  
+
+    const NP* cc = c ; 
+    const float* vv = cc->cvalues<float>() ; 
+    double sum = 0. ; 
+    for(int i=0 ; i < ni ; i += 65536 ) sum += vv[i*16] ;   // one item every 4MB 
+    sprof::Stamp(p3);  
+
+    std::cout << " Load       " << sprof::Desc(p0,p1) << std::endl ;  
+    std::cout << " LoadMapped " << sprof::Desc(p1,p2) << std::endl ;  
+    std::cout << " sparse     " << sprof::Desc(p2,p3) << " sum " << sum << std::endl ;  
+
+    delete b ; 
+    delete c ; 
+    return 0 ; 
+}
+
+inline int NP_mapped_test::Main()
+{
+    const char* TEST = U::GetEnv("TEST", "ALL") ; 
+    bool ALL = strcmp(TEST, "ALL") == 0 ; 
+    int rc = 0 ; 
+    if(ALL || strcmp(TEST, "Load") == 0 )     rc += Load(); 
+    if(ALL || strcmp(TEST, "LoadFold") == 0 ) rc += LoadFold(); 
+    if(ALL || strcmp(TEST, "Mutate") == 0 )   rc += Mutate(); 
+    if(ALL || strcmp(TEST, "Profile") == 0 )  rc += Profile(); 
+    return rc ; 
+}
+
+int main(){ return NP_mapped_test::Main() ; }
@@ -0,0 +1,44 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+NP_mapped_test.sh
+===================
+
+~/opticks/sysrap/tests/NP_mapped_test.sh 
+
+Checks NP::LoadMapped and NPFold::LoadMapped give the same 
+arrays as ordinary loads, and profiles time and RSS when 
+sparsely touching a large mapped array.  
+
+EOU
+}
+
+name=NP_mapped_test 
+
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cd $(dirname $BASH_SOURCE)
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+export TEST=${TEST:-ALL}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -lstdc++ -g -I.. -o $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2
+fi 
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3
+fi 
+
+exit 0 
@@ -37,8 +37,10 @@ Obj : ctor/dtor instrumented with pool.add(this)/pool.remove(this)
 
 struct Obj 
 {
-    typedef s_pool<Obj> POOL ;
+    typedef s_pool<Obj,_Obj> POOL ;
     static POOL pool ;
+    static void* operator new(size_t sz){ return POOL::Allocate(&pool, sz) ; } 
+    static void  operator delete(void* p){ POOL::Deallocate(p) ; } 
 
     Obj( int type, Obj* left=nullptr, Obj* right=nullptr ); 
     ~Obj();  
@@ -60,7 +62,8 @@ inline Obj::Obj( int type_, Obj* left_, Obj* right_ )
     pid(pool.add(this)),
     type(type_),
     left(left_),
-    right(right_)
+    right(right_),
+    parent(nullptr)
 {
     if( left && right )
     {
@@ -100,7 +103,7 @@ inline void Obj::Serialize( _Obj& p, const Obj* o ) // static
     p.right  = pool.index(o->right);  
     p.parent = pool.index(o->parent);  
 
-    std::cerr << "Obj::Serialize p " << p.desc() << std::endl ; 
+    if(pool.level > 0) std::cerr << "Obj::Serialize p " << p.desc() << std::endl ; 
 }
 /**
 Obj::Import
@@ -116,7 +119,7 @@ for roots.
 
 inline Obj* Obj::Import( const _Obj* p, const std::vector<_Obj>& buf ) // static
 {
-    std::cerr << "Obj::Import " << p->desc() << std::endl ; 
+    if(pool.level > 0) std::cerr << "Obj::Import " << p->desc() << std::endl ; 
     Obj* root = nullptr ; 
     if(p->parent == -1) root = Import_r(p, buf); 
     return root ; 
@@ -134,7 +137,7 @@ inline Obj* Obj::Import_r( const _Obj* p, const std::vector<_Obj>& buf )
 {
     if(p == nullptr) return nullptr ; 
 
-    std::cerr << "Obj::Import_r " << p->desc() << std::endl ; 
+    if(pool.level > 0) std::cerr << "Obj::Import_r " << p->desc() << std::endl ; 
 
     int type = p->type ;  
     const _Obj* _left  = p->left  > -1 ? &buf[p->left]  : nullptr ;  
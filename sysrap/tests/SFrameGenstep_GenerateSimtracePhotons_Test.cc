@@ -0,0 +1,128 @@
+/**
+SFrameGenstep_GenerateSimtracePhotons_Test.cc
+===============================================
+
+Simtrace photons generated with any number of threads, into the vector,
+into the NP and streamed in chunks are all bytewise identical.
+The timing lines give the speedup over one thread, as each thread starts
+its range without serial positioning of the randoms this should approach 
+the number of threads up to the number of cores.
+
+**/
+
+#include <cstring>
+#include <chrono>
+
+#include "OPTICKS_LOG.hh"
+
+#include "scuda.h"
+#include "squad.h"
+#include "sframe.h"
+#include "SFrameGenstep.hh"
+#include "NP.hh"
+
+double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
+int compare(const NP* a, const NP* b)
+{
+    bool same_shape = a->shape == b->shape ;
+    bool same_bytes = same_shape && memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) == 0 ;
+    return same_bytes ? 0 : 1 ;
+}
+
+int test_threads(const NP* gs)
+{
+    double t0 = now() ;
+    NP* ref = SFrameGenstep::GenerateSimtracePhotons_(gs, 1) ;
+    double t1 = now() ;
+
+    int rc = 0 ;
+    const int nts[5] = { 2, 3, 8, 16, 0 } ;
+    for(int j=0 ; j < 5 ; j++)
+    {
+        double s0 = now() ;
+        NP* st = SFrameGenstep::GenerateSimtracePhotons_(gs, nts[j]) ;
+        double s1 = now() ;
+        int mismatch = compare(st, ref) ;
+        rc += mismatch ;
+        LOG(info)
+            << " num_threads " << nts[j]
+            << " num_photon " << st->shape[0]
+            << " t(1) " << (t1 - t0)
+            << " t " << (s1 - s0)
+            << " speedup " << (t1 - t0)/(s1 - s0)
+            << " ns_per_photon " << 1e9*(s1 - s0)/double(st->shape[0])
+            << " mismatch " << mismatch
+            ;
+        delete st ;
+    }
+
+    std::vector<quad6> genstep(gs->shape[0]) ;
+    memcpy( genstep.data(), gs->bytes(), gs->arr_bytes() );
+    std::vector<quad4> simtrace(ref->shape[0]) ;
+    SFrameGenstep::GenerateSimtracePhotons( simtrace, genstep );
+    int vec_mismatch = memcmp( simtrace.data(), ref->bytes(), ref->arr_bytes() ) == 0 ? 0 : 1 ;
+    LOG(info) << " vec_mismatch " << vec_mismatch ;
+    rc += vec_mismatch ;
+
+    delete ref ;
+    return rc ;
+}
+
+int test_stream(const NP* gs, int64_t chunk)
+{
+    NP* ref = SFrameGenstep::GenerateSimtracePhotons_(gs) ;
+    const quad4* rr = (const quad4*)ref->bytes() ;
+
+    int num_chunk = 0 ;
+    int64_t next = 0 ;
+    int mismatch = 0 ;
+    auto consumer = [&](const quad4* pp, int64_t offset, int64_t num)
+    {
+        mismatch += offset == next ? 0 : 1 ;
+        mismatch += memcmp( pp, rr + offset, num*sizeof(quad4) ) == 0 ? 0 : 1 ;
+        next = offset + num ;
+        num_chunk += 1 ;
+    };
+
+    int64_t num_photon = SFrameGenstep::GenerateSimtracePhotons_stream(gs, consumer, chunk ) ;
+    mismatch += num_photon == ref->shape[0] && next == num_photon ? 0 : 1 ;
+
+    LOG(info)
+        << " chunk " << chunk
+        << " num_chunk " << num_chunk
+        << " num_photon " << num_photon
+        << " mismatch " << mismatch
+        ;
+
+    delete ref ;
+    return mismatch ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    sframe fr ;
+    fr.ce.w = 100.f ;
+
+    NP* gs = SFrameGenstep::MakeCenterExtentGenstep_FromFrame(fr);
+    LOG(info) << " gs " << ( gs ? gs->sstr() : "-" ) ;
+
+    int rc = 0 ;
+    rc += test_threads(gs) ;
+    rc += test_stream(gs, 10000) ;
+    rc += test_stream(gs, 1) ;
+
+    // -ve num_photons gives regular phi wheels without the u0 draw
+    quad6* gg = (quad6*)gs->bytes() ;
+    for(int i=0 ; i < gs->shape[0] ; i += 2 ) gg[i].q0.i.w = -gg[i].q0.i.w ;
+    rc += test_threads(gs) ;
+    rc += test_stream(gs, 10000) ;
+
+    LOG(info) << " rc " << rc ;
+    return rc == 0 ? 0 : 1 ;
+}
@@ -10,6 +10,12 @@ CPU test of CUDA code to generate torch photons using s_mock_curand.h::
    ./SGenerate_test.sh ana
    ./SGenerate_test.sh build_run_ana   # default 
 
+Per-photon streams allow multi-threaded generation with output identical
+for any number of threads::
+
+   SGenerate__GeneratePhotons_RNG_STREAM=1 SGenerate__GeneratePhotons_THREADS=1 ./SGenerate_test.sh run 
+   SGenerate__GeneratePhotons_RNG_STREAM=1 SGenerate__GeneratePhotons_THREADS=0 ./SGenerate_test.sh run 
+
 EOU
 }
 
@@ -0,0 +1,148 @@
+/**
+s_curand_xorwow_test.cc
+=========================
+
+::
+
+   ~/o/sysrap/tests/s_curand_xorwow_test.sh
+
+The expected values are curand_uniform for states from curand_init(0, subsequence, 0)
+as recorded in notes/issues/lifting-the-3M-photon-limitation.rst
+
+**/
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include "ssys.h"
+#include "s_curand_xorwow.h"
+
+/**
+Same
+-----
+
+Compares members rather than bytes as the padding before boxmuller_extra_double is not copied. 
+
+**/
+
+bool Same(const s_curand_xorwow& a, const s_curand_xorwow& b)
+{
+    return a.d == b.d && memcmp( a.v, b.v, sizeof(a.v) ) == 0 
+        && a.boxmuller_flag == b.boxmuller_flag && a.boxmuller_flag_double == b.boxmuller_flag_double 
+        && a.boxmuller_extra == b.boxmuller_extra && a.boxmuller_extra_double == b.boxmuller_extra_double ; 
+}
+
+int test_reference()
+{
+    struct Ref { unsigned long long subsequence ; int num ; double u[16] ; } ;
+    const Ref ref[] = {
+        { 0ull, 16, { 0.7402193546, 0.4384511411, 0.5170126557, 0.1569886208,
+                      0.0713675097, 0.4625083804, 0.2276432663, 0.3293584883,
+                      0.1440653056, 0.1877991110, 0.9153834581, 0.5401248336,
+                      0.9746608734, 0.5474692583, 0.6531602740, 0.2302378118 } },
+        { 1ull, 16, { 0.9209938049, 0.4603644311, 0.3334640563, 0.3725204170,
+                      0.4896024764, 0.5672709346, 0.0799058080, 0.2333681583,
+                      0.5093778372, 0.0889785364, 0.0067097610, 0.9542270899,
+                      0.5467113256, 0.8245469332, 0.5270628929, 0.9301316142 } },
+        { 99999ull, 8, { 0.9140115380, 0.4403249323, 0.9478355646, 0.0900180787,
+                         0.9587481022, 0.9879503846, 0.2274523973, 0.0438494608 } }
+    };
+
+    int rc = 0 ;
+    for(int r=0 ; r < 3 ; r++)
+    {
+        s_curand_xorwow rng(0ull, ref[r].subsequence, 0ull) ;
+        for(int i=0 ; i < ref[r].num ; i++)
+        {
+            float u = rng.generate_float() ;
+            bool match = std::abs( double(u) - ref[r].u[i] ) < 1e-9 ;
+            if(!match) rc += 1 ;
+            if(!match || i < 4) printf("//test_reference subsequence %6llu i %2d u %12.10f ref %12.10f %s\n",
+                  ref[r].subsequence, i, u, ref[r].u[i], match ? "" : "MISMATCH" );
+        }
+    }
+    return rc ;
+}
+
+/**
+test_skipahead
+----------------
+
+Jump results must match stepping, jumps must compose and a subsequence
+must be 2^67 steps.
+
+**/
+
+int test_skipahead()
+{
+    int rc = 0 ;
+    for(unsigned long long n=0 ; n < 1000 ; n += 37 )
+    {
+        s_curand_xorwow a(42ull, 5ull, 0ull) ;
+        for(unsigned long long i=0 ; i < n ; i++) a.generate();
+        s_curand_xorwow b(42ull, 5ull, n) ;
+        if( a.generate() != b.generate() ) rc += 1 ;
+    }
+
+    s_curand_xorwow c(7ull, 0ull, 0ull) ;
+    c.skipahead(123456789ull);
+    c.skipahead(987654321ull);
+    s_curand_xorwow d(7ull, 0ull, 123456789ull + 987654321ull) ;
+    if( c.generate() != d.generate() ) rc += 1 ;
+
+    s_curand_xorwow e(7ull, 0ull, 0ull) ;
+    for(int i=0 ; i < 16 ; i++) e.skipahead(1ull << 63) ;     // 2^67 steps
+    s_curand_xorwow f(7ull, 1ull, 0ull) ;
+    if( e.generate() != f.generate() ) rc += 1 ;
+
+    printf("//test_skipahead rc %d \n", rc );
+    return rc ;
+}
+
+int test_Fill()
+{
+    int num = ssys::getenvint("NUM", 1000000) ;
+    int rc = 0 ;
+
+    std::vector<s_curand_xorwow> aa(num) ;
+    std::vector<s_curand_xorwow> bb(num) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) aa[i].init( 0ull, i, 0ull );
+    auto t1 = std::chrono::high_resolution_clock::now();
+    s_curand_xorwow::Fill( bb.data(), num, 0ull, 0ull, 0ull, 0 );
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    for(int i=0 ; i < num ; i++) if( !Same( aa[i], bb[i] ) ) rc += 1 ;
+
+    s_curand_xorwow_chunked ch(num, 0ull, 0ull, 100000ull) ;
+    for(int i=num-1 ; i >= 0 ; i -= 997 ) if( !Same( ch.get(i), aa[i] ) ) rc += 1 ;
+
+    s_curand_xorwow_chunked cz(num, 0ull, 0ull, 30000ull, 0) ;   // chunk at a time as used by QRng::UploadGenerate
+    for(int c=0 ; c < cz.num_chunk() ; c++)
+    {
+        const s_curand_xorwow* zz = cz.get_chunk(c) ;
+        for(unsigned long long j=0 ; j < cz.chunk_num(c) ; j++) if( !Same( zz[j], aa[c*30000 + j] ) ) rc += 1 ;
+        cz.release_chunk(c) ;
+    }
+    if( cz.num_chunk_created() != 0 ) rc += 1 ;
+
+    printf("//test_Fill num %d init_ms %10.3f Fill_ms %10.3f rc %d \n// %s \n",
+        num,
+        std::chrono::duration<double, std::milli>(t1 - t0).count(),
+        std::chrono::duration<double, std::milli>(t2 - t1).count(),
+        rc,
+        ch.desc().c_str()
+        );
+    return rc ;
+}
+
+int main()
+{
+    static_assert( sizeof(s_curand_xorwow) == 48, "layout must match curandStateXORWOW" );
+    int rc = 0 ;
+    rc += test_reference();
+    rc += test_skipahead();
+    rc += test_Fill();
+    return rc == 0 ? 0 : 1 ;
+}
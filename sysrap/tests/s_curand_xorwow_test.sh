@@ -0,0 +1,30 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+s_curand_xorwow_test.sh
+=========================
+
+Compares host s_curand_xorwow.h randoms with curand_uniform values
+recorded from GPU running and checks skipahead consistency::
+
+   ~/o/sysrap/tests/s_curand_xorwow_test.sh
+   NUM=10000000 ~/o/sysrap/tests/s_curand_xorwow_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=s_curand_xorwow_test 
+
+tmp=/tmp/$USER/opticks
+TMP=${TMP:-$tmp}
+bin=$TMP/$name 
+mkdir -p $TMP
+
+gcc $name.cc -I.. -std=c++11 -lstdc++ -lm -pthread -O2 -o $bin 
+[ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+
+$bin
+[ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+
+exit 0 
@@ -7,11 +7,14 @@ Aim is to be able to use QBnd.hh/qbnd.h in MOCK_CUDA manner on CPU.
 ::
 
    ./s_mock_texture_test.sh
+   TEST=linear ./s_mock_texture_test.sh build_run
+   TEST=bench ./s_mock_texture_test.sh build_run
 
 
 **/
 
 #include <cstdio>
+#include <chrono>
 #include "NPFold.h"
 
 #include "s_mock_texture.h"
@@ -39,7 +42,7 @@ NPFold* test_bnd()
     std::cout << mgr->dump<float>(obj) ; 
     std::cout << mgr->dump<float4>(obj) ; 
 
-    const MockTexture tex = mgr->get(obj) ;  
+    const MockTexture& tex = mgr->get(obj) ;  
     const NP* a = tex.a ;
  
 
@@ -71,7 +74,8 @@ NPFold* test_demo_3()
     cudaTextureObject_t obj = MockTextureManager::Add(a0) ;  ;  
     MockTextureManager* mgr = MockTextureManager::Get();  
 
-    NP* a = mgr->tt[obj].a ; 
+    MockTexture& tex = *mgr->tt[0] ; 
+    NP* a = tex.a ; 
     float4* aa = a->values<float4>() ; 
 
     for(int iy=0 ; iy < ny ; iy++ )
@@ -80,6 +84,7 @@ NPFold* test_demo_3()
         int idx = iy*nx+ix ; 
         aa[idx] = make_float4( iy, ix, 0.f, 0.f );   // slower dimension first 
     }
+    tex.update();  // values changed after adding 
 
     NP* b = NP::MakeLike(a) ; 
     float4* bb = b->values<float4>() ; 
@@ -108,18 +113,12 @@ NPFold* test_demo_5()
     int nl = 100 ; 
     int nn =  4 ; 
 
-    int ny = ni*nj*nk ;  
-    int nx = nl ;
- 
-    int height = ny ; 
-    int width = nx ; 
-
     NP* a0 = NP::Make<float>(ni,nj,nk,nl,nn) ; 
 
     cudaTextureObject_t obj = MockTextureManager::Add(a0) ;  ;  
     MockTextureManager* mgr = MockTextureManager::Get();  
 
-    MockTexture tex = mgr->get(obj) ; 
+    MockTexture& tex = const_cast<MockTexture&>(mgr->get(obj)) ; 
 
     NP* a = const_cast<NP*>(tex.a) ;  // unusual to set the values after adding 
     float4* aa = a->values<float4>() ; 
@@ -132,6 +131,7 @@ NPFold* test_demo_5()
         int idx = i*nj*nk*nl + j*nk*nl + k*nl + l ; 
         aa[idx] = make_float4( i, j, k, l );   // slower dimension first 
     }
+    tex.update(); 
 
     NP* b = NP::MakeLike(a) ; 
     float4* bb = b->values<float4>() ; 
@@ -189,7 +189,7 @@ See::
 
 float4 boundary_lookup(cudaTextureObject_t obj,  float nm, int line, int k ) 
 {
-    MockTexture tex = MockTextureManager::Get(obj) ; 
+    const MockTexture& tex = MockTextureManager::Get(obj) ; 
  
     // follow qbnd::boundary_lookup
     float fx = (nm - tex.dom.x)/tex.dom.z ;   
@@ -206,7 +206,7 @@ float4 boundary_lookup(cudaTextureObject_t obj,  float nm, int line, int k )
 NPFold* test_boundary_lookup()
 {
     cudaTextureObject_t obj = create_boundary_texture(); 
-    MockTexture tex = MockTextureManager::Get(obj) ; 
+    const MockTexture& tex = MockTextureManager::Get(obj) ; 
 
     const std::vector<int>& sh = tex.a->shape ; 
     int nd = sh.size() ; 
@@ -238,8 +238,155 @@ NPFold* test_boundary_lookup()
     return f ; 
 }
 
-int main(int argc, char** argv)
+/**
+test_linear
+-------------
+
+Texture with texel values equal to their x and y texel coordinates 
+in (x,y,x+y,1), so linear filtering within the texture must return 
+the texel coordinates of the lookup position minus 0.5, to within 
+the 1/256 weight quantization. Also checks wrap and clamp at the edges. 
+
+**/
+
+int test_linear()
+{
+    int ny = 16 ; 
+    int nx = 100 ; 
+    NP* a0 = NP::Make<float>(ny, nx, 4) ; 
+    float4* aa = a0->values<float4>() ; 
+    for(int iy=0 ; iy < ny ; iy++ )
+    for(int ix=0 ; ix < nx ; ix++ ) aa[iy*nx+ix] = make_float4( ix, iy, ix+iy, 1.f ); 
+
+    cudaTextureObject_t lw = MockTextureManager::Add(a0, 'L', true, 'W') ;   
+    cudaTextureObject_t lc = MockTextureManager::Add(a0, 'L', true, 'C') ;   
+    cudaTextureObject_t pw = MockTextureManager::Add(a0, 'P', true, 'W') ;   
+
+    int rc = 0 ; 
+    const float tol = 1.f/256.f + 1e-4f ; 
+    for(int i=0 ; i < 10000 ; i++)
+    {
+        float xt = 0.5f + float(nx-1)*float(i)/10000.f ; 
+        float yt = 0.5f + float(ny-1)*float(i % 97)/97.f ; 
+        float x = xt/nx ; 
+        float y = yt/ny ; 
+        float4 v = tex2D<float4>(lw, x, y ); 
+        if( std::abs( v.x - (xt - 0.5f)) > tol*nx || std::abs( v.y - (yt - 0.5f)) > tol*ny || v.w != 1.f ) rc += 1 ; 
+
+        float4 p = tex2D<float4>(pw, x, y ); 
+        if( p.x != floorf(xt) || p.y != floorf(yt) ) rc += 1 ; 
+    }
+
+    float4 w0 = tex2D<float4>(lw, 0.f, 0.5f/ny ) ;          // halfway between last and first texel 
+    float4 c0 = tex2D<float4>(lc, 0.f, 0.5f/ny ) ;          // clamped to first texel 
+    float4 c1 = tex2D<float4>(lc, 1.f, 0.5f/ny ) ;          // clamped to last texel 
+    float4 w1 = tex2D<float4>(lw, 1.25f + 0.5f/nx, 0.5f/ny ) ;   // wraps to texel centre 25 
+    if( w0.x != 0.5f*float(nx-1) ) rc += 1 ; 
+    if( c0.x != 0.f ) rc += 1 ; 
+    if( c1.x != float(nx-1) ) rc += 1 ; 
+    if( w1.x != 25.f ) rc += 1 ; 
+
+    std::cout 
+        << "test_linear"
+        << " w0.x " << w0.x 
+        << " c0.x " << c0.x 
+        << " c1.x " << c1.x 
+        << " w1.x " << w1.x 
+        << " rc " << rc 
+        << std::endl 
+        ;
+    return rc ; 
+}
+
+/**
+test_bench
+------------
+
+Times boundary texture style lookups with the shape of a typical bnd 
+array (52,4,2,761,4) comparing the MockTexture lookup with the 
+former nearest texel implementation that copied the MockTexture 
+from the manager for every fetch.  
+
+**/
+
+struct MockTexture_former
 {
+    const NP* a ; 
+    int width ; 
+    int height ; 
+    float4 dom ; 
+
+    template<typename T> T lookup(float x, float y ) const
+    {
+        const T* vv = a->cvalues<T>() ; 
+        int ix = int(x*float(width)) ; 
+        int iy = int(y*float(height)) ; 
+        return vv[iy*width + ix] ; 
+    }
+};
+
+int test_bench()
+{
+    NP* a0 = NP::Make<float>(52, 4, 2, 761, 4) ; 
+    float* vv = a0->values<float>() ; 
+    for(size_t i=0 ; i < a0->num_values() ; i++) vv[i] = float(i % 1000) ; 
+
+    cudaTextureObject_t obj = MockTextureManager::Add(a0, 'L', true, 'W') ; 
+    cudaTextureObject_t pbj = MockTextureManager::Add(a0, 'P', true, 'W') ; 
+    const MockTexture& tex = MockTextureManager::Get(obj) ; 
+
+    std::vector<MockTexture_former> former(1) ; 
+    former[0] = { tex.a, tex.width, tex.height, tex.dom } ; 
+
+    int num = 10000000 ; 
+    float sum0 = 0.f ; 
+    float sum1 = 0.f ; 
+    float sum2 = 0.f ; 
+
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+    for(int i=0 ; i < num ; i++)
+    {
+        float x = float(i % 7919)/7919.f ; 
+        float y = (float(i % 416) + 0.5f)/416.f ; 
+        MockTexture_former t = former[0] ;   // as former per-fetch copy from manager 
+        sum0 += t.lookup<float4>(x, y).x ; 
+    }
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+    for(int i=0 ; i < num ; i++)
+    {
+        float x = float(i % 7919)/7919.f ; 
+        float y = (float(i % 416) + 0.5f)/416.f ; 
+        sum1 += tex2D<float4>(obj, x, y).x ; 
+    }
+    auto t2 = std::chrono::high_resolution_clock::now(); 
+    for(int i=0 ; i < num ; i++)
+    {
+        float x = float(i % 7919)/7919.f ; 
+        float y = (float(i % 416) + 0.5f)/416.f ; 
+        sum2 += tex2D<float4>(pbj, x, y).x ; 
+    }
+    auto t3 = std::chrono::high_resolution_clock::now(); 
+
+    std::cout 
+        << "test_bench"
+        << " num " << num 
+        << " former_nearest_ms " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+        << " linear_ms " << std::chrono::duration<double, std::milli>(t2 - t1).count()
+        << " nearest_ms " << std::chrono::duration<double, std::milli>(t3 - t2).count()
+        << " sum0 " << sum0 
+        << " sum1 " << sum1 
+        << " sum2 " << sum2 
+        << std::endl 
+        ;
+    return sum0 == sum2 ? 0 : 1 ; 
+}
+
+int main()
+{
+    const char* TEST = getenv("TEST") ; 
+    if( TEST && strcmp(TEST, "linear") == 0 ) return test_linear() ; 
+    if( TEST && strcmp(TEST, "bench") == 0 ) return test_bench() ; 
+
     //NPFold* f = test_demo_3(); 
     //NPFold* f = test_demo_5(); 
     NPFold* f = test_bnd(); 
@@ -248,4 +395,3 @@ int main(int argc, char** argv)
     f->save("$FOLD"); 
     return 0;
 }
-
@@ -8,8 +8,9 @@ s_pool_test.cc
 
 **/
 
+#include <chrono>
 #include "Obj.h"
-Obj::POOL Obj::pool = {} ; 
+Obj::POOL Obj::pool("Obj") ; 
 
 
 void test_stack_Obj()
@@ -77,12 +78,86 @@ void test_roundtrip()
 
         // because Obj deep deletes would get double delete 
         // with a and b on stack 
-        Obj::pool.serialize(buf) ; 
+        Obj::pool.serialize_(buf) ; 
     }
 
     std::cout << " buf.size " << buf.size() << std::endl ; 
 
-    Obj::pool.import(buf); 
+    Obj::pool.import_(buf); 
+}
+
+/**
+test_arena
+------------
+
+Heap Obj are placed into the pool arena. After deleting every third tree
+the indices of remaining Obj must stay contiguous in creation order, 
+and new Obj reuse the freed slots. 
+
+**/
+
+int test_arena()
+{
+    int rc = 0 ; 
+    int num = 30000 ; 
+    int base = Obj::pool.size() ;  // any Obj left by prior tests precede these  
+    std::vector<Obj*> roots ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        Obj* l = new Obj(-1) ;   // sequenced explicitly : argument evaluation order is unspecified 
+        Obj* r = new Obj(-2) ; 
+        roots.push_back( new Obj(i, l, r) ); 
+    }
+
+    const Obj* a = roots[0] ; 
+    const Obj* b = roots[1] ; 
+    bool contiguous = (const char*)b - (const char*)a == 3*s_arena<Obj>::SLOT ; 
+    if(!contiguous) rc += 1 ; 
+
+    for(int i=0 ; i < num ; i += 3 ) 
+    {
+        delete roots[i] ; 
+        roots[i] = nullptr ; 
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+
+    int expect = base ; 
+    for(int i=0 ; i < num ; i++ )
+    {
+        Obj* r = roots[i] ; 
+        if(r == nullptr) continue ; 
+        // creation order is left, right, root  
+        if( Obj::pool.index(r->left) != expect + 0 ) rc += 1 ; 
+        if( Obj::pool.index(r->right) != expect + 1 ) rc += 1 ; 
+        if( Obj::pool.index(r) != expect + 2 ) rc += 1 ; 
+        expect += 3 ; 
+    }
+    if( Obj::pool.size() != expect ) rc += 1 ; 
+
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+
+    int num_slab = Obj::pool.arena.slab.size() ; 
+    Obj* c = new Obj(100) ; 
+    bool reused = int(Obj::pool.arena.slab.size()) == num_slab ; 
+    if(!reused) rc += 1 ; 
+    if( Obj::pool.index(c) != expect ) rc += 1 ; 
+    delete c ; 
+
+    for(int i=0 ; i < num ; i++ ) delete roots[i] ; 
+    if( Obj::pool.size() != base ) rc += 1 ; 
+
+    std::cout 
+        << "test_arena"
+        << " num " << num 
+        << " contiguous " << contiguous 
+        << " reused " << reused 
+        << " index_ms " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+        << " " << Obj::pool.arena.desc() 
+        << " rc " << rc 
+        << std::endl 
+        ; 
+    return rc ; 
 }
 
 
@@ -98,5 +173,5 @@ int main()
     */
     test_roundtrip();
 
-    return 0 ; 
+    return test_arena() ; 
 }
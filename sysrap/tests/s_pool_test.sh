@@ -3,7 +3,7 @@
 name=s_pool_test 
 bin=/tmp/$name
 
-export s_pool_level=1
+export s_pool_level=${s_pool_level:-0}
 
 defarg="build_run"
 arg=${1:-$defarg}
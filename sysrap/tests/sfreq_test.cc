@@ -51,12 +51,70 @@ void test_empty_save_load()
 
 
 
-int main(int argc, char** argv)
+/**
+test_digest_keys
+-------------------
+
+32 char hex digest keys use the 128-bit index, other keys
+the string index. Lookups must survive direct changes to vsu.
+
+**/
+
+void test_digest_keys()
+{
+    const char* d0 = "0123456789abcdef0123456789abcdef" ; 
+    const char* d1 = "fedcba9876543210fedcba9876543210" ; 
+    const char* d2 = "0123456789abcdef0123456789abcdee" ; 
+    const char* u0 = "0123456789ABCDEF0123456789ABCDEF" ;  // upper case is string indexed
+
+    sfreq c ; 
+    for(int i=0 ; i < 3 ; i++) c.add(d0) ; 
+    for(int i=0 ; i < 5 ; i++) c.add(d1) ; 
+    c.add(d2) ; 
+    c.add(u0) ; 
+    c.add(u0) ; 
+    c.add("red") ; 
+
+    assert( c.get_num() == 5 ); 
+    assert( c.dig_index.size() == 3 ); 
+    assert( c.str_index.size() == 2 ); 
+    assert( c.get_freq(d0) == 3 ); 
+    assert( c.get_freq(d1) == 5 ); 
+    assert( c.get_freq(d2) == 1 ); 
+    assert( c.get_freq(u0) == 2 ); 
+    assert( c.get_freq("0123456789abcdef") == -1 ); 
+
+    c.sort(); 
+    assert( strcmp(c.get_key(0), d1) == 0 ); 
+    assert( c.find_index(d1) == 0 ); 
+
+    std::reverse( c.vsu.begin(), c.vsu.end() );   // direct change to vsu, as stree did formerly  
+    assert( strcmp(c.get_key(0), d1) != 0 ); 
+    assert( c.get_freq(d1) == 5 ); 
+    assert( c.find_index(d1) == 4 ); 
+
+    c.set_disqualify(d0); 
+    assert( c.is_disqualify(d0) ); 
+
+    c.save(FOLD, "digest"); 
+    sfreq c2 ; 
+    c2.load(FOLD, "digest"); 
+    assert( c2.get_num() == c.get_num() ); 
+    assert( c2.get_freq(d1) == 5 ); 
+    assert( c2.get_freq("red") == 1 ); 
+    assert( c2.is_disqualify(d0) ); 
+
+    std::cout << "test_digest_keys c2.desc\n" << c2.desc() << std::endl ; 
+}
+
+
+int main()
 {
     /*
     test_add_sort_save_load();
     */ 
     test_empty_save_load();
+    test_digest_keys();
 
     return 0 ; 
 }
@@ -0,0 +1,124 @@
+// ./sgenstep_lookup_test.sh
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "sgenstep_lookup.h"
+
+double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
+/**
+make_numphoton
+----------------
+
+Random numphoton per genstep with a fraction of zero photon gensteps,
+including runs of them at the start and end.
+
+**/
+
+std::vector<int> make_numphoton(int num_genstep, int max_per_genstep, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> n(0, max_per_genstep) ;
+    std::uniform_real_distribution<float> u(0.f, 1.f) ;
+    std::vector<int> np(num_genstep) ;
+    for(int g=0 ; g < num_genstep ; g++) np[g] = u(rng) < 0.2f ? 0 : n(rng) ;
+    for(int g=0 ; g < std::min(3, num_genstep) ; g++) np[g] = 0 ;
+    if( num_genstep > 5 ) np[num_genstep-1] = np[num_genstep-2] = 0 ;
+    return np ;
+}
+
+/**
+test_lookup
+-------------
+
+genstep_id from search and table modes match the seed array
+expanded as SEvent::MakeSeed does, for every photon.
+
+**/
+
+int test_lookup(int num_genstep, int max_per_genstep, unsigned seed)
+{
+    std::vector<int> np = make_numphoton(num_genstep, max_per_genstep, seed) ;
+
+    std::vector<int> offset(num_genstep+1) ;
+    int num_photon = sgenstep_lookup::FillOffset<int>( offset.data(), np.data(), num_genstep, 1, 0 );
+
+    std::vector<int> ref ;   // SEvent::MakeSeed style expansion
+    for(int g=0 ; g < num_genstep ; g++) for(int j=0 ; j < np[g] ; j++) ref.push_back(g) ;
+
+    std::vector<int> expand(num_photon) ;
+    sgenstep_lookup::Expand( expand.data(), offset.data(), num_genstep );
+
+    std::vector<int> table( sgenstep_lookup::NumTable(num_photon) + 1 ) ;
+    sgenstep_lookup::FillTable( table.data(), offset.data(), num_genstep, num_photon );
+
+    int bad = int(ref.size()) == num_photon ? 0 : 1 ;
+    bad += expand == ref ? 0 : 1 ;
+
+    double t0 = now() ;
+    int64_t sum_search = 0 ;
+    for(int i=0 ; i < num_photon ; i++)
+    {
+        int g = sgenstep_lookup::GenstepId( offset.data(), num_genstep, nullptr, i ) ;
+        bad += g == ref[i] ? 0 : 1 ;
+        sum_search += g ;
+    }
+    double t1 = now() ;
+    int64_t sum_table = 0 ;
+    for(int i=0 ; i < num_photon ; i++)
+    {
+        int g = sgenstep_lookup::GenstepId( offset.data(), num_genstep, table.data(), i ) ;
+        bad += g == ref[i] ? 0 : 1 ;
+        sum_table += g ;
+    }
+    double t2 = now() ;
+    int64_t sum_seed = 0 ;
+    for(int i=0 ; i < num_photon ; i++) sum_seed += ref[i] ;
+    double t3 = now() ;
+
+    bad += sum_search == sum_seed && sum_table == sum_seed ? 0 : 1 ;
+
+    std::cout
+        << sgenstep_lookup::Desc( offset.data(), num_genstep, table.data() )
+        << " seed_bytes " << std::setw(10) << sizeof(int)*num_photon
+        << " lookup_bytes " << std::setw(8) << sizeof(int)*(offset.size() + table.size())
+        << " search " << std::fixed << std::setprecision(4) << (t1 - t0)
+        << " table " << (t2 - t1)
+        << " seed " << (t3 - t2)
+        << " bad " << bad
+        << std::endl
+        ;
+    return bad ;
+}
+
+int test_Mode()
+{
+    int rc = 0 ;
+    rc += sgenstep_lookup::Mode(nullptr) == sgenstep_lookup::SEED ? 0 : 1 ;
+    rc += sgenstep_lookup::Mode("search") == sgenstep_lookup::SEARCH ? 0 : 1 ;
+    rc += sgenstep_lookup::Mode("table") == sgenstep_lookup::TABLE ? 0 : 1 ;
+    rc += strcmp( sgenstep_lookup::Name(sgenstep_lookup::TABLE), "table" ) == 0 ? 0 : 1 ;
+    std::cout << "test_Mode rc " << rc << std::endl ;
+    return rc ;
+}
+
+int main()
+{
+    int rc = 0 ;
+    rc += test_Mode();
+    rc += test_lookup(       1,    10, 1 );
+    rc += test_lookup(       7,     3, 2 );
+    rc += test_lookup(    1000,  5000, 3 );
+    rc += test_lookup(  100000,    20, 4 );
+    rc += test_lookup(   20000,  1000, 5 );
+    std::cout << "sgenstep_lookup_test rc " << rc << std::endl ;
+    return rc == 0 ? 0 : 1 ;
+}
+
@@ -0,0 +1,43 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+sgenstep_lookup_test.sh 
+=========================
+
+Checks the seedless photon to genstep mapping of sgenstep_lookup.h 
+("search" and "table" modes) against the per photon seed array 
+expansion, including gensteps with zero photons, with timings::
+
+    ./sgenstep_lookup_test.sh
+
+EOU
+}
+
+REALDIR=$(cd $(dirname $BASH_SOURCE) && pwd )
+name=sgenstep_lookup_test 
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name 
+
+vars="BASH_SOURCE REALDIR FOLD name bin"
+
+if [ "${arg/info}" != "$arg" ]; then 
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done 
+fi 
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $REALDIR/$name.cc -std=c++11 -lstdc++ -lm -O2 -pthread \
+           -I$REALDIR/.. \
+           -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi 
+
+exit 0
@@ -0,0 +1,28 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+sphilox_test.sh
+=================
+
+::
+
+   ~/o/sysrap/tests/sphilox_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sphilox_test 
+
+tmp=/tmp/$USER/opticks
+TMP=${TMP:-$tmp}
+bin=$TMP/$name 
+mkdir -p $TMP
+
+gcc $name.cc -I.. -std=c++11 -lstdc++ -lm -pthread -O2 -o $bin 
+[ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+
+$bin
+[ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+
+exit 0 
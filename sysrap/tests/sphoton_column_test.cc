@@ -0,0 +1,258 @@
+// ./sphoton_column_test.sh
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <random>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sphoton_column.h"
+#include "NP.hh"
+#include "NPFold.h"
+#include "OpticksPhoton.h"
+
+
+/**
+test_FloatToHalf_roundtrip
+----------------------------
+
+Every non-nan binary16 value survives half->float->half unchanged.
+
+**/
+
+int test_FloatToHalf_roundtrip()
+{
+    int mismatch = 0 ;
+    for(unsigned h=0 ; h < 0x10000u ; h++)
+    {
+        bool nan = ( h & 0x7c00u ) == 0x7c00u && ( h & 0x3ffu ) != 0u ;
+        if(nan) continue ;
+        float f = sphoton_column::HalfToFloat(h) ;
+        unsigned short h2 = sphoton_column::FloatToHalf(f) ;
+        if( h2 != h ) mismatch += 1 ;
+    }
+    std::cout << "test_FloatToHalf_roundtrip mismatch " << mismatch << std::endl ;
+    return mismatch ;
+}
+
+/**
+test_FloatToHalf_nearest
+--------------------------
+
+Random floats across the half range convert to the nearest half,
+with ties going to the even half.
+
+**/
+
+int test_FloatToHalf_nearest()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> ue(-26.f, 15.f) ;   // below 32768, overflow to inf checked in specials
+    std::uniform_real_distribution<float> um(1.f, 2.f) ;
+
+    int bad = 0 ;
+    int num = 1000000 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        float x = std::ldexp( um(rng), int(std::floor(ue(rng))) ) ;
+        if( i % 2 ) x = -x ;
+        unsigned short h = sphoton_column::FloatToHalf(x) ;
+        double d = std::fabs( double(sphoton_column::HalfToFloat(h)) - double(x) ) ;
+        double dn = std::fabs( double(sphoton_column::HalfToFloat(h+1)) - double(x) ) ;
+        double dp = h & 0x7fffu ? std::fabs( double(sphoton_column::HalfToFloat(h-1)) - double(x) ) : d ;
+        bool nearest = d <= dn && d <= dp ;
+        bool tie_even = ( d < dn && d < dp ) || ( h & 1u ) == 0u ;
+        if(!nearest || !tie_even) bad += 1 ;
+    }
+
+    bool inf = sphoton_column::FloatToHalf(70000.f) == 0x7c00u ;
+    bool max = sphoton_column::FloatToHalf(65504.f) == 0x7bffu ;
+    bool one = sphoton_column::FloatToHalf(1.f) == 0x3c00u ;
+    bool tiny = sphoton_column::FloatToHalf(std::ldexp(1.f, -24)) == 0x0001u ;
+    bool zero = sphoton_column::FloatToHalf(std::ldexp(1.f, -25)) == 0x0000u ;   // tie to even
+    bool specials = inf && max && one && tiny && zero ;
+
+    std::cout
+        << "test_FloatToHalf_nearest"
+        << " num " << num
+        << " bad " << bad
+        << " specials " << ( specials ? "YES" : "NO" )
+        << std::endl
+        ;
+    return bad + ( specials ? 0 : 1 ) ;
+}
+
+int test_Mask()
+{
+    unsigned m0 = sphoton_column::Mask("pos,time,wavelength,identity,half") ;
+    unsigned m1 = sphoton_column::Mask(" identity , pos ,time,wavelength,half ") ;
+    unsigned m2 = sphoton_column::Mask("half") ;
+    unsigned m3 = sphoton_column::Mask(nullptr) ;
+    unsigned m4 = sphoton_column::Mask("pos,bogus") ;
+
+    std::string d0 = sphoton_column::Desc(m0) ;
+    std::string k0 = sphoton_column::Keys(m0) ;
+
+    std::cout
+        << "test_Mask"
+        << " d0 [" << d0 << "]"
+        << " k0 [" << k0 << "]"
+        << " bytes/hit " << sphoton_column::Bytes(m0, 1)
+        << " sizeof(sphoton) " << sizeof(sphoton)
+        << std::endl
+        ;
+
+    int rc = 0 ;
+    rc += m0 == m1 ? 0 : 1 ;
+    rc += m2 == 0u ? 0 : 1 ;
+    rc += m3 == 0u ? 0 : 1 ;
+    rc += m4 == sphoton_column::Mask("pos") ? 0 : 1 ;
+    rc += d0 == "pos,identity,time,wavelength,half" ? 0 : 1 ;
+    rc += k0 == "hit_pos,hit_identity,hit_time,hit_wavelength" ? 0 : 1 ;
+    rc += sphoton_column::Bytes(m0, 1) == 12 + 4 + 2 + 2 ? 0 : 1 ;
+    return rc ;
+}
+
+/**
+test_init_contiguous
+----------------------
+
+Columns of the single buffer layout follow each other with the
+two byte columns last, keeping four byte alignment.
+
+**/
+
+int test_init_contiguous()
+{
+    unsigned mask = sphoton_column::Mask("wavelength,time,flagmask,pos,half") ;
+    unsigned num = 7 ;
+    std::vector<char> buf( sphoton_column::Bytes(mask, num) ) ;
+
+    sphoton_column c(mask, num) ;
+    c.init_contiguous( buf.data() ) ;
+
+    int rc = 0 ;
+    rc += c.col[sphoton_column::POS] == buf.data() ? 0 : 1 ;
+    rc += c.col[sphoton_column::FLAGMASK] == buf.data() + 12*num ? 0 : 1 ;
+    rc += c.col[sphoton_column::TIME] == buf.data() + 16*num ? 0 : 1 ;
+    rc += c.col[sphoton_column::WAVELENGTH] == buf.data() + 18*num ? 0 : 1 ;
+    rc += c.col[sphoton_column::MOM] == nullptr ? 0 : 1 ;
+    rc += buf.size() == 20*num ? 0 : 1 ;
+
+    std::cout << "test_init_contiguous rc " << rc << std::endl ;
+    return rc ;
+}
+
+/**
+test_columns
+--------------
+
+Columns selected from random photons match the corresponding fields
+of the full 4x4 hits selected with NP::copy_if, as SEvt::gatherHit.
+
+**/
+
+int test_columns(const char* spec)
+{
+    unsigned hitmask = SURFACE_DETECT ;
+    sphoton_selector selector(hitmask) ;
+
+    int num_photon = 10000 ;
+    NP* p = NP::Make<float>( num_photon, 4, 4 ) ;
+    sphoton* pp = (sphoton*)p->values<float>() ;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> u(0.f, 1.f) ;
+    for(int i=0 ; i < num_photon ; i++)
+    {
+        sphoton& q = pp[i] ;
+        q.zero();
+        q.pos = make_float3( 1000.f*u(rng), -1000.f*u(rng), 500.f*u(rng) ) ;
+        q.time = 200.f*u(rng) ;
+        q.mom = make_float3( u(rng), u(rng), u(rng) ) ;
+        q.pol = make_float3( u(rng), u(rng), u(rng) ) ;
+        q.wavelength = 380.f + 420.f*u(rng) ;
+        q.iindex = i % 17 ;
+        q.identity = i*3 ;
+        q.set_idx(i) ;
+        q.set_flag( u(rng) < 0.25f ? SURFACE_DETECT : SURFACE_ABSORB ) ;
+    }
+
+    NP* hit = p->copy_if<float, sphoton>(selector) ;
+    const sphoton* hh = (const sphoton*)hit->cvalues<float>() ;
+    unsigned num_hit = hit->shape[0] ;
+
+    unsigned mask = sphoton_column::Mask(spec) ;
+    bool half = mask & sphoton_column::HALF ;
+
+    NPFold* fold = new NPFold ;
+    sphoton_column column(mask, num_hit) ;
+    column.add_arrays(fold) ;
+    unsigned j = 0 ;
+    for(int i=0 ; i < num_photon ; i++) if(selector(pp[i])) column.write(j++, pp[i]) ;
+
+    int bad = j == num_hit ? 0 : 1 ;
+    bad += sphoton_column::Num(fold, mask) == int(num_hit) ? 0 : 1 ;
+
+    const float3* pos = (const float3*)column.col[sphoton_column::POS] ;
+    const unsigned* identity = (const unsigned*)column.col[sphoton_column::IDENTITY] ;
+    const unsigned* flagmask = (const unsigned*)column.col[sphoton_column::FLAGMASK] ;
+    const char* time = column.col[sphoton_column::TIME] ;
+    const char* wavelength = column.col[sphoton_column::WAVELENGTH] ;
+
+    float max_dt = 0.f ;
+    float max_dw = 0.f ;
+    for(unsigned i=0 ; i < num_hit ; i++)
+    {
+        const sphoton& h = hh[i] ;
+        if(pos) bad += ( pos[i].x == h.pos.x && pos[i].y == h.pos.y && pos[i].z == h.pos.z ) ? 0 : 1 ;
+        if(identity) bad += identity[i] == h.identity ? 0 : 1 ;
+        if(flagmask) bad += flagmask[i] == h.flagmask ? 0 : 1 ;
+
+        float t = half ? sphoton_column::HalfToFloat(((const unsigned short*)time)[i]) : ((const float*)time)[i] ;
+        float w = half ? sphoton_column::HalfToFloat(((const unsigned short*)wavelength)[i]) : ((const float*)wavelength)[i] ;
+        max_dt = std::max( max_dt, std::fabs(t - h.time) ) ;
+        max_dw = std::max( max_dw, std::fabs(w - h.wavelength) ) ;
+    }
+    float tol_t = half ? 0.0625f : 0.f ;   // half ulp at 128-256 ns
+    float tol_w = half ? 0.25f   : 0.f ;   // half ulp at 512-1024 nm
+    bad += max_dt <= tol_t ? 0 : 1 ;
+    bad += max_dw <= tol_w ? 0 : 1 ;
+
+    size_t full_bytes = hit->arr_bytes() ;
+    size_t col_bytes = sphoton_column::Bytes(mask, num_hit) ;
+
+    std::cout
+        << "test_columns"
+        << " spec [" << spec << "]"
+        << " num_hit " << num_hit
+        << " full_bytes " << full_bytes
+        << " col_bytes " << col_bytes
+        << " ratio " << std::fixed << std::setprecision(3) << float(col_bytes)/float(full_bytes)
+        << " max_dt " << max_dt
+        << " max_dw " << max_dw
+        << " bad " << bad
+        << std::endl
+        << fold->desc()
+        << std::endl
+        ;
+
+    return bad ;
+}
+
+
+int main()
+{
+    int rc = 0 ;
+    rc += test_FloatToHalf_roundtrip();
+    rc += test_FloatToHalf_nearest();
+    rc += test_Mask();
+    rc += test_init_contiguous();
+    rc += test_columns("pos,time,wavelength,identity") ;
+    rc += test_columns("pos,time,wavelength,identity,flagmask,half") ;
+    std::cout << "sphoton_column_test rc " << rc << std::endl ;
+    return rc == 0 ? 0 : 1 ;
+}
+
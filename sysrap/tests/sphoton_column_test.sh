@@ -0,0 +1,43 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+sphoton_column_test.sh 
+========================
+
+Checks the columnar hit layout of sphoton_column.h against the full
+4x4 hits selected with NP::copy_if and the binary16 conversion 
+used for the optional half precision time and wavelength columns. 
+
+EOU
+}
+
+REALDIR=$(cd $(dirname $BASH_SOURCE) && pwd )
+name=sphoton_column_test 
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name 
+
+vars="BASH_SOURCE REALDIR FOLD name bin"
+
+if [ "${arg/info}" != "$arg" ]; then 
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done 
+fi 
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $REALDIR/$name.cc -std=c++11 -lstdc++ -lm -O2 \
+           -I$REALDIR/.. \
+           -I/usr/local/cuda/include \
+           -I$OPTICKS_PREFIX/externals/glm/glm \
+           -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi 
+
+exit 0
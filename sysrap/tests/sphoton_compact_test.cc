@@ -0,0 +1,141 @@
+// ./sphoton_compact_test.sh
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sphoton_compact.h"
+#include "NP.hh"
+#include "OpticksPhoton.h"
+
+
+NP* make_photon(int num_photon)
+{
+    NP* p = NP::Make<float>( num_photon, 4, 4 ) ;
+    sphoton* pp = (sphoton*)p->values<float>() ;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> u(0.f, 1.f) ;
+    const unsigned flags[4] = { SURFACE_DETECT, SURFACE_ABSORB, BULK_ABSORB, BOUNDARY_TRANSMIT } ;
+
+    for(int i=0 ; i < num_photon ; i++)
+    {
+        sphoton& q = pp[i] ;
+        q.zero();
+        q.pos = make_float3( u(rng), u(rng), u(rng) ) ;
+        q.time = float(i) ;
+        q.set_idx(i) ;
+        if( u(rng) < 0.5f ) q.set_flag( BOUNDARY_TRANSMIT ) ;
+        q.set_flag( flags[int(4.f*u(rng)) & 3] ) ;
+    }
+    return p ;
+}
+
+int compare(const NP* a, const NP* b)
+{
+    bool same_shape = a->shape == b->shape ;
+    bool same_bytes = same_shape && memcmp( a->bytes(), b->bytes(), a->arr_bytes() ) == 0 ;
+    return same_bytes ? 0 : 1 ;
+}
+
+double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
+/**
+test_Select
+-------------
+
+Compacted hits are bytewise identical to the serial NP::copy_if for all thread counts.
+
+**/
+
+int test_Select(const NP* p)
+{
+    unsigned hitmask = SURFACE_DETECT ;
+    sphoton_selector selector(hitmask) ;
+
+    double t0 = now() ;
+    NP* ref = p->copy_if<float, sphoton>(selector) ;
+    double t1 = now() ;
+
+    int rc = 0 ;
+    const int nts[5] = { 1, 2, 3, 8, 0 } ;
+    for(int j=0 ; j < 5 ; j++)
+    {
+        double s0 = now() ;
+        NP* h = sphoton_compact::Select(p, hitmask, nts[j] ) ;
+        double s1 = now() ;
+        int64_t n = sphoton_compact::Count(p, hitmask, nts[j] ) ;
+        int mismatch = compare(h, ref) + ( n == ref->shape[0] ? 0 : 1 ) ;
+        rc += mismatch ;
+
+        std::cout
+            << "test_Select"
+            << " num_threads " << std::setw(2) << nts[j]
+            << " num_hit " << h->shape[0]
+            << " copy_if " << std::fixed << std::setprecision(4) << (t1 - t0)
+            << " Select " << (s1 - s0)
+            << " mismatch " << mismatch
+            << std::endl
+            ;
+        delete h ;
+    }
+    delete ref ;
+    return rc ;
+}
+
+/**
+test_Partition
+----------------
+
+Several masks in one pass match separate copy_if selections.
+
+**/
+
+int test_Partition(const NP* p)
+{
+    std::vector<unsigned> mm = { SURFACE_DETECT, SURFACE_ABSORB, BULK_ABSORB, BOUNDARY_TRANSMIT | SURFACE_DETECT } ;
+    std::vector<NP*> out ;
+    sphoton_compact::Partition(out, p, mm, 4 );
+
+    int rc = 0 ;
+    for(size_t m=0 ; m < mm.size() ; m++)
+    {
+        sphoton_selector selector(mm[m]) ;
+        NP* ref = p->copy_if<float, sphoton>(selector) ;
+        int mismatch = compare(out[m], ref) ;
+        rc += mismatch ;
+        std::cout
+            << "test_Partition"
+            << " mask 0x" << std::hex << mm[m] << std::dec
+            << " num " << out[m]->shape[0]
+            << " mismatch " << mismatch
+            << std::endl
+            ;
+        delete ref ;
+        delete out[m] ;
+    }
+    return rc ;
+}
+
+int main()
+{
+    NP* p = make_photon(1000000) ;
+    int rc = 0 ;
+    rc += test_Select(p) ;
+    rc += test_Partition(p) ;
+
+    NP* p0 = make_photon(0) ;
+    NP* h0 = sphoton_compact::Select(p0, SURFACE_DETECT) ;
+    rc += h0->shape[0] == 0 ? 0 : 1 ;
+
+    std::cout << "sphoton_compact_test rc " << rc << std::endl ;
+    return rc == 0 ? 0 : 1 ;
+}
+
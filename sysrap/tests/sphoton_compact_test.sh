@@ -0,0 +1,45 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+sphoton_compact_test.sh 
+=========================
+
+Checks the multi-threaded hit compaction of sphoton_compact.h gives 
+bytewise the same hits as the serial NP::copy_if, for single masks 
+and multi-mask Partition. Thread count can be set with::
+
+    sphoton_compact__THREADS=4 ./sphoton_compact_test.sh
+
+EOU
+}
+
+REALDIR=$(cd $(dirname $BASH_SOURCE) && pwd )
+name=sphoton_compact_test 
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name 
+
+vars="BASH_SOURCE REALDIR FOLD name bin"
+
+if [ "${arg/info}" != "$arg" ]; then 
+    for var in $vars ; do printf "%30s : %s \n" "$var" "${!var}" ; done 
+fi 
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $REALDIR/$name.cc -std=c++11 -lstdc++ -lm -O2 -pthread \
+           -I$REALDIR/.. \
+           -I/usr/local/cuda/include \
+           -I$OPTICKS_PREFIX/externals/glm/glm \
+           -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE compile error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi 
+
+exit 0
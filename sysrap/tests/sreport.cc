@@ -43,9 +43,14 @@ Note that this means that can rsync just the small report directory
 and still be able to present the report and make plots on laptop concerning 
 run folders with many large arrays left on the server. 
 
+When the run directory contains stimeline.npy (written at EndOfRun 
+with stimeline__ENABLE) the per-name counts and durations of the 
+trace events are summarized into the "timeline" array of the report. 
+
 **/
 
 #include "NPFold.h"
+#include "stimeline.h"
 
 
 struct sreport
@@ -70,6 +75,7 @@ struct sreport
     NPFold*   submeta ;   
     NPFold*   submeta_NumPhotonCollected ;   
     NPFold*   subcount ;   
+    NP*       timeline ; 
 
     sreport();  
 
@@ -86,6 +92,7 @@ struct sreport
     std::string desc_subprofile() const ;
     std::string desc_submeta() const ;
     std::string desc_subcount() const ;
+    std::string desc_timeline() const ;
 };
 
 inline sreport::sreport()
@@ -98,7 +105,8 @@ inline sreport::sreport()
     subprofile( nullptr ),
     submeta( nullptr ),
     submeta_NumPhotonCollected( nullptr ),
-    subcount( nullptr )
+    subcount( nullptr ),
+    timeline( nullptr )
 {
 }
 inline NPFold* sreport::serialize() const 
@@ -112,6 +120,7 @@ inline NPFold* sreport::serialize() const
     smry->add_subfold("submeta", submeta ) ; 
     smry->add_subfold("submeta_NumPhotonCollected", submeta_NumPhotonCollected ) ; 
     smry->add_subfold("subcount", subcount ) ; 
+    smry->add("timeline", timeline ) ; 
     return smry ; 
 }
 inline void sreport::import(const NPFold* smry) 
@@ -124,6 +133,8 @@ inline void sreport::import(const NPFold* smry)
     submeta = smry->get_subfold("submeta"); 
     submeta_NumPhotonCollected = smry->get_subfold("submeta_NumPhotonCollected"); 
     subcount = smry->get_subfold("subcount"); 
+    const NP* tl = smry->get("timeline") ; 
+    timeline = tl ? tl->copy() : nullptr ; 
 }
 inline void sreport::save(const char* dir) const 
 {
@@ -148,6 +159,7 @@ inline std::string sreport::desc() const
        << desc_substamp()
        << desc_submeta()
        << desc_subcount()
+       << desc_timeline()
        << "]sreport.desc" << std::endl 
        ; 
     std::string str = ss.str() ;
@@ -263,6 +275,17 @@ inline std::string sreport::desc_subcount() const
     std::string str = ss.str() ;
     return str ;  
 }
+inline std::string sreport::desc_timeline() const
+{
+    std::stringstream ss ; 
+    ss << "[sreport.desc_timeline" << std::endl 
+       << ( timeline ? timeline->sstr() : "-" ) << std::endl 
+       << ( timeline ? timeline->descTable<int64_t>(17) : "-" ) << std::endl
+       << "]sreport.desc_timeline" << std::endl 
+       ; 
+    std::string str = ss.str() ;
+    return str ;  
+}
 
 
 
@@ -281,6 +304,7 @@ struct sreport_Creator
     NPFold*    fold ; 
     bool fold_valid ; 
     const NP*  run ; 
+    NP*        timeline ; 
     sreport*   report ; 
 
     sreport_Creator(  const char* dirp_ ); 
@@ -299,6 +323,7 @@ inline sreport_Creator::sreport_Creator( const char* dirp_ )
     fold(NPFold::LoadNoData(dirp)),
     fold_valid(NPFold::IsValid(fold)),
     run(fold_valid ? fold->get("run") : nullptr),
+    timeline(dirp && NP::Exists(dirp, stimeline::NAME) ? NP::Load(dirp, stimeline::NAME) : nullptr),
     report(new sreport)
 {
     std::cout << "[sreport_Creator::sreport_Creator" << std::endl ;
@@ -325,6 +350,8 @@ inline void sreport_Creator::init()
     std::cout << "-sreport_Creator::init.7" << std::endl ; 
     report->subcount   = fold_valid ? fold->subfold_summary("subcount",   ASEL, BSEL) : nullptr ; 
     std::cout << "-sreport_Creator::init.8" << std::endl ; 
+    report->timeline   = stimeline::Summary(timeline) ; 
+    std::cout << "-sreport_Creator::init.9" << std::endl ; 
 }
 
 inline std::string sreport_Creator::desc() const
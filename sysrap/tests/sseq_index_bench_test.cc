@@ -0,0 +1,163 @@
+// ~/opticks/sysrap/tests/sseq_index_bench_test.sh 
+/**
+sseq_index_bench_test.cc
+==========================
+
+Compares the serial std::map sseq_index count with the
+thread parallel hash count using random seq arrays with a
+skewed distribution of histories, checking that the
+ordered uniques and the A-B chi2 are identical.  
+
+**/
+
+#include <random>
+#include <chrono>
+
+#include "NP.hh"
+#include "sseq_index.h"
+
+struct sseq_index_bench_test
+{
+    static NP* MakeSeq(int64_t num, unsigned seed); 
+    static bool Same(const sseq_index& x, const sseq_index& y); 
+    static double Time(sseq_index** idx, const NP* seq, bool use_map, int num_threads); 
+
+    static int Identical(); 
+    static int Bench(); 
+    static int Main(); 
+};
+
+/**
+sseq_index_bench_test::MakeSeq
+--------------------------------
+
+Geometric history lengths and flags give a long tail of rare
+histories with many equal counts, exercising the tie ordering.
+
+**/
+
+inline NP* sseq_index_bench_test::MakeSeq(int64_t num, unsigned seed)
+{
+    std::mt19937_64 rng(seed); 
+    std::geometric_distribution<int> len(0.25); 
+    std::geometric_distribution<int> flag(0.4); 
+
+    NP* seq = NP::Make<unsigned long long>( num, 2, 2 ); 
+    sseq* qq = (sseq*)seq->bytes(); 
+    for(int64_t i=0 ; i < num ; i++)
+    {
+        sseq& q = qq[i] ; 
+        q.zero(); 
+        int n = std::min( 1 + len(rng), int(sseq::SLOTS) ); 
+        for(int j=0 ; j < n ; j++) q.add_nibble( j, 1u << std::min(flag(rng), 15), j ); 
+    }
+    return seq ; 
+}
+
+inline bool sseq_index_bench_test::Same(const sseq_index& x, const sseq_index& y)
+{
+    if( x.u.size() != y.u.size() ) return false ; 
+    for(size_t i=0 ; i < x.u.size() ; i++)
+    {
+        const sseq_unique& a = x.u[i] ; 
+        const sseq_unique& b = y.u[i] ; 
+        bool same = memcmp( &a.q, &b.q, sizeof(sseq) ) == 0 && a.ic.index == b.ic.index && a.ic.count == b.ic.count ; 
+        if(!same) std::cerr << "sseq_index_bench_test::Same DIFF at " << i << std::endl << a.desc() << std::endl << b.desc() << std::endl ; 
+        if(!same) return false ; 
+    }
+    return true ; 
+}
+
+inline double sseq_index_bench_test::Time(sseq_index** idx, const NP* seq, bool use_map, int num_threads)
+{
+    auto t0 = std::chrono::high_resolution_clock::now(); 
+    *idx = new sseq_index(seq, use_map, num_threads); 
+    auto t1 = std::chrono::high_resolution_clock::now(); 
+    std::chrono::duration<double> dt = t1 - t0 ; 
+    return dt.count(); 
+}
+
+inline int sseq_index_bench_test::Identical()
+{
+    NP* a_seq = MakeSeq( 200000, 1u ); 
+    NP* b_seq = MakeSeq( 200000, 2u ); 
+
+    sseq_index a_map(a_seq, true, 0 ); 
+    sseq_index b_map(b_seq, true, 0 ); 
+    sseq_index_ab ab_map(a_map, b_map); 
+
+    int rc = 0 ; 
+    for(int nt=1 ; nt <= 8 ; nt*=2 )
+    {
+        sseq_index a_hash(a_seq, false, nt ); 
+        sseq_index b_hash(b_seq, false, nt ); 
+        sseq_index_ab ab_hash(a_hash, b_hash); 
+
+        bool same_a = Same(a_map, a_hash) ; 
+        bool same_b = Same(b_map, b_hash) ; 
+        bool same_chi2 = ab_map.chi2.sum == ab_hash.chi2.sum && ab_map.chi2.ndf == ab_hash.chi2.ndf ; 
+        bool same_desc = ab_map.desc("ALL") == ab_hash.desc("ALL") ; 
+
+        std::cout 
+            << "sseq_index_bench_test::Identical"
+            << " nt " << nt 
+            << " a.u " << a_hash.u.size()
+            << " b.u " << b_hash.u.size()
+            << " same_a " << same_a 
+            << " same_b " << same_b 
+            << " same_chi2 " << same_chi2
+            << " same_desc " << same_desc
+            << std::endl
+            ;
+        if(!(same_a && same_b && same_chi2 && same_desc)) rc += 1 ; 
+    }
+    std::cout << ab_map.chi2.desc() << std::endl ; 
+    return rc ; 
+}
+
+inline int sseq_index_bench_test::Bench()
+{
+    int64_t num = ssys::getenvint("NUM", 10000000) ; 
+    NP* seq = MakeSeq( num, 1u ); 
+
+    sseq_index* x_map = nullptr ; 
+    double t_map = Time( &x_map, seq, true, 0 ); 
+
+    std::cout << "sseq_index_bench_test::Bench num " << num << " u " << x_map->u.size() << std::endl ; 
+    std::cout << " map        : " << std::fixed << std::setw(10) << std::setprecision(4) << t_map << std::endl ; 
+
+    int rc = 0 ; 
+    int max_threads = std::max( 1u, std::thread::hardware_concurrency() ) ; 
+    for(int nt=1 ; nt <= max_threads ; nt*=2 )
+    {
+        sseq_index* x_hash = nullptr ; 
+        double t_hash = Time( &x_hash, seq, false, nt ); 
+        bool same = Same(*x_map, *x_hash) ; 
+        if(!same) rc += 1 ; 
+        std::cout 
+            << " hash nt " << std::setw(3) << nt 
+            << " : " << std::fixed << std::setw(10) << std::setprecision(4) << t_hash 
+            << " speedup " << std::setw(7) << std::setprecision(2) << t_map/t_hash
+            << " same " << same 
+            << std::endl 
+            ; 
+        delete x_hash ; 
+    }
+    delete x_map ; 
+    return rc ; 
+}
+
+inline int sseq_index_bench_test::Main()
+{
+    const char* TEST = U::GetEnv("TEST", "ALL"); 
+    bool ALL = strcmp(TEST, "ALL") == 0 ; 
+    int rc = 0 ; 
+    if(ALL || strcmp(TEST, "Identical") == 0) rc += Identical(); 
+    if(ALL || strcmp(TEST, "Bench") == 0)     rc += Bench(); 
+    return rc ; 
+}
+
+int main()
+{
+    return sseq_index_bench_test::Main() ; 
+}
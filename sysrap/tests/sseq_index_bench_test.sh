@@ -0,0 +1,42 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+sseq_index_bench_test.sh
+==========================
+
+Compares serial std::map and thread parallel hash sseq_index counting::
+
+    ~/opticks/sysrap/tests/sseq_index_bench_test.sh
+    TEST=Identical ~/opticks/sysrap/tests/sseq_index_bench_test.sh
+    NUM=20000000 TEST=Bench ~/opticks/sysrap/tests/sseq_index_bench_test.sh
+
+EOU
+}
+
+SDIR=$(cd $(dirname $BASH_SOURCE) && pwd)
+CUDA_PREFIX=${CUDA_PREFIX:-/usr/local/cuda}
+
+name=sseq_index_bench_test 
+TMP=${TMP:-/tmp/$USER/opticks}
+export FOLD=$TMP/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $SDIR/$name.cc -std=c++11 -O2 -lstdc++ -lm -pthread -I$SDIR/.. -I$CUDA_PREFIX/include -o $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : build error && exit 1 
+fi
+
+if [ "${arg/run}" != "$arg" ]; then 
+    $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : run error && exit 2 
+fi 
+
+if [ "${arg/dbg}" != "$arg" ]; then 
+    gdb -ex r --args $bin 
+    [ $? -ne 0 ] && echo $BASH_SOURCE : dbg error && exit 3 
+fi 
+
+exit 0 
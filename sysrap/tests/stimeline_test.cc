@@ -0,0 +1,222 @@
+// ./stimeline_test.sh
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+#include "stimeline.h"
+
+
+/**
+test_threads
+--------------
+
+Scoped markers from several threads all land in the array, 
+each ring holding its own thread events in order of their end time. 
+
+**/
+
+int test_threads(int num_thread, int num_per_thread)
+{
+    stimeline::Clear();
+    auto work = [num_per_thread](int /*t*/)
+    {
+        for(int i=0 ; i < num_per_thread ; i++)
+        {
+            STIMELINE_SCOPE("test_threads.work");
+            STIMELINE_COUNTER("test_threads.i", i );
+        }
+    };
+    std::vector<std::thread> threads ;
+    for(int t=0 ; t < num_thread ; t++) threads.emplace_back( work, t );
+    for(int t=0 ; t < num_thread ; t++) threads[t].join();
+
+    NP* a = stimeline::Array() ;
+    NP* s = stimeline::Summary(a) ;
+    const int64_t* aa = a->cvalues<int64_t>() ;
+    int num = a->shape[0] ;
+
+    int bad = 0 ;
+    int count_complete = 0 ;
+    int count_counter = 0 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const int64_t* e = aa + i*stimeline::NUM_COL ;
+        if( e[4] == stimeline::COMPLETE ) count_complete += 1 ;
+        if( e[4] == stimeline::COUNTER && a->names[e[2]] == "test_threads.i" ) count_counter += 1 ;
+        bad += e[1] >= e[0] ? 0 : 1 ;
+        if( i > 0 && e[3] == aa[(i-1)*stimeline::NUM_COL+3] ) bad += e[1] >= aa[(i-1)*stimeline::NUM_COL+1] ? 0 : 1 ;  // recorded at end
+    }
+    bad += count_complete == num_thread*num_per_thread ? 0 : 1 ;
+    bad += count_counter == num_thread*num_per_thread ? 0 : 1 ;
+    bad += a->get_meta<uint64_t>("num_dropped") == 0 ? 0 : 1 ;
+
+    std::cout
+        << "test_threads"
+        << " num_thread " << num_thread
+        << " num_event " << num
+        << " bad " << bad
+        << std::endl
+        << stimeline::Get()->desc()
+        << std::endl
+        << s->descTable<int64_t>(17)
+        << std::endl
+        ;
+    delete a ;
+    delete s ;
+    return bad ;
+}
+
+/**
+test_wrap
+-----------
+
+Recording more than the ring capacity keeps the newest events
+and counts the dropped.
+
+**/
+
+int test_wrap()
+{
+    stimeline::Clear();
+    uint64_t cap = stimeline::Get()->capacity ;
+    int num = int(cap) + 100 ;
+    for(int i=0 ; i < num ; i++) stimeline::Counter("test_wrap", i );
+
+    NP* a = stimeline::Array() ;
+    const int64_t* aa = a->cvalues<int64_t>() ;
+    int bad = a->shape[0] == int(cap) ? 0 : 1 ;
+    bad += aa[5] == 100 ? 0 : 1 ;                              // oldest kept
+    bad += aa[(a->shape[0]-1)*stimeline::NUM_COL+5] == num - 1 ? 0 : 1 ;  // newest
+    bad += a->get_meta<uint64_t>("num_dropped") == 100 ? 0 : 1 ;
+    std::cout << "test_wrap capacity " << cap << " num_dropped " << a->get_meta<uint64_t>("num_dropped") << " bad " << bad << std::endl ;
+    delete a ;
+    return bad ;
+}
+
+/**
+test_overhead
+---------------
+
+Cost per scoped marker enabled and disabled. 
+
+**/
+
+int test_overhead()
+{
+    stimeline::Clear();
+    stimeline* tl = stimeline::Get() ;
+    int num = 1000000 ;
+    int64_t sink = 0 ;
+
+    int64_t t0 = stimeline::Now() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        STIMELINE_SCOPE("test_overhead");
+        sink += i ;
+    }
+    int64_t t1 = stimeline::Now() ;
+
+    tl->enabled = false ;
+    for(int i=0 ; i < num ; i++)
+    {
+        STIMELINE_SCOPE("test_overhead.disabled");
+        sink += i ;
+    }
+    int64_t t2 = stimeline::Now() ;
+    tl->enabled = true ;
+
+    std::cout
+        << "test_overhead"
+        << " ns/marker enabled " << std::fixed << std::setprecision(1) << double(t1 - t0)/num
+        << " disabled " << double(t2 - t1)/num
+        << " sink " << sink
+        << std::endl
+        ;
+    return 0 ;
+}
+
+int test_sampler()
+{
+    stimeline::Clear();
+    stimeline* tl = stimeline::Get() ;
+    tl->start_sampler(5) ;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)) ;
+    int32_t vm = 0 ;
+    int32_t rs = 0 ;
+    stimeline::Proc(vm, rs) ;
+    tl->stop_sampler() ;
+
+    NP* a = stimeline::Array() ;
+    NP* s = stimeline::Summary(a) ;
+    int i_vm = s->get_name_index("VmSize") ;
+    int64_t count_vm = i_vm > -1 ? s->cvalues<int64_t>()[i_vm*4] : 0 ;
+    int bad = vm > 0 && count_vm > 1 ? 0 : 1 ;
+    std::cout << "test_sampler vm " << vm << " rs " << rs << " count_vm " << count_vm << " bad " << bad << std::endl ;
+    delete a ;
+    delete s ;
+    return bad ;
+}
+
+int test_save(const char* dir)
+{
+    stimeline::Clear();
+    {
+        STIMELINE_SCOPE("test_save.outer");
+        STIMELINE_INSTANT("test_save.instant", 0 );
+        STIMELINE_SCOPE("test_save.inner");
+    }
+    stimeline::Save(dir) ;
+    NP* a = NP::Load(dir, stimeline::NAME) ;
+    int bad = a && a->shape[0] == 3 && a->names.size() == stimeline::Get()->names.size() ? 0 : 1 ;
+    std::cout << "test_save " << dir << " " << ( a ? a->sstr() : "-" ) << " bad " << bad << std::endl ;
+    std::cout << stimeline::ChromeJSON() ;
+    return bad ;
+}
+
+/**
+test_save_sampler
+-------------------
+
+Save with the sampler running stops it while reading the rings and
+restarts it, runtime labels with quotes and backslashes are escaped in the JSON.
+
+**/
+
+int test_save_sampler(const char* dir)
+{
+    stimeline::Clear();
+    stimeline* tl = stimeline::Get() ;
+    tl->start_sampler(1) ;
+    stimeline::Counter("test_save_sampler \"quoted\" back\\slash", 1 );
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)) ;
+    stimeline::Save(dir) ;
+    bool restarted = tl->sampler_run.load() ;
+    int period_ms = tl->stop_sampler() ;
+
+    std::string json = stimeline::ChromeJSON() ;
+    bool escaped = json.find("test_save_sampler \\\"quoted\\\" back\\\\slash") != std::string::npos ;
+    int bad = restarted && period_ms == 1 && escaped ? 0 : 1 ;
+    std::cout << "test_save_sampler restarted " << restarted << " period_ms " << period_ms << " escaped " << escaped << " bad " << bad << std::endl ;
+    return bad ;
+}
+
+int main()
+{
+    setenv(stimeline::ENABLE_, "1", 1) ;
+    setenv(stimeline::CAPACITY_, "4000", 1) ;   // rounded up to 4096
+
+    const char* fold = getenv("FOLD") ;
+    int rc = 0 ;
+    rc += test_threads(4, 1000) ;
+    rc += test_wrap() ;
+    rc += test_overhead() ;
+    rc += test_sampler() ;
+    rc += test_save( fold ? fold : "/tmp/stimeline_test" ) ;
+    rc += test_save_sampler( fold ? fold : "/tmp/stimeline_test" ) ;
+    std::cout << "stimeline_test rc " << rc << std::endl ;
+    return rc == 0 ? 0 : 1 ;
+}
+
@@ -64,6 +64,7 @@ controlled via envvar::
 #include "snd.hh"
 #include "sdomain.h"
 #include "ssys.h"
+#include "stimeline.h"
 
 #include "SSimtrace.h"
 #include "SEventConfig.hh"
@@ -200,11 +201,15 @@ inline U4Tree* U4Tree::Create(
     U4SensorIdentifier* sid 
     ) 
 {
+    STIMELINE_SCOPE("U4Tree::Create"); 
     if(st->level > 0) std::cout << "[ U4Tree::Create " << std::endl ; 
 
     U4Tree* tree = new U4Tree(st, top, sid ) ;
 
-    st->factorize(); 
+    {
+        STIMELINE_SCOPE("U4Tree::Create.factorize"); 
+        st->factorize(); 
+    }
 
     tree->identifySensitive(); 
 